@@ -153,7 +153,12 @@ typedef enum PaErrorCode
     paCanNotWriteToAnInputOnlyStream,
     paIncompatibleStreamHostApi,
     paBadBufferPtr,
-    paCanNotInitializeRecursively
+    paCanNotInitializeRecursively,
+    paConverterTierNotSupported,
+    paStreamEventQueueFull,
+    paBufferNotAcquired,
+    paBufferAlreadyAcquired,
+    paConverterTierInUse
 } PaErrorCode;
 
 
@@ -472,8 +477,10 @@ typedef double PaTime;
  The standard formats paFloat32, paInt16, paInt32, paInt24, paInt8
  and paUInt8 are usually implemented by all implementations.
 
- The floating point representation (paFloat32) uses +1.0 and -1.0 as the
- maximum and minimum respectively.
+ The floating point representations (paFloat32 and paFloat64) use +1.0 and
+ -1.0 as the maximum and minimum respectively. paFloat64 is a double precision
+ format, which is less widely supported by host APIs; when it is not supported
+ natively PortAudio converts to and from the closest available format.
 
  paUInt8 is an unsigned 8 bit format where 128 is considered "ground"
 
@@ -483,7 +490,7 @@ typedef double PaTime;
  all channels interleaved.
 
  @see Pa_OpenStream, Pa_OpenDefaultStream, PaDeviceInfo
- @see paFloat32, paInt16, paInt32, paInt24, paInt8
+ @see paFloat32, paFloat64, paInt16, paInt32, paInt24, paInt8
  @see paUInt8, paCustomFormat, paNonInterleaved
 */
 typedef unsigned long PaSampleFormat;
@@ -495,6 +502,7 @@ typedef unsigned long PaSampleFormat;
 #define paInt16          ((PaSampleFormat) 0x00000008) /**< @see PaSampleFormat */
 #define paInt8           ((PaSampleFormat) 0x00000010) /**< @see PaSampleFormat */
 #define paUInt8          ((PaSampleFormat) 0x00000020) /**< @see PaSampleFormat */
+#define paFloat64        ((PaSampleFormat) 0x00000040) /**< @see PaSampleFormat */
 #define paCustomFormat   ((PaSampleFormat) 0x00010000) /**< @see PaSampleFormat */
 
 #define paNonInterleaved ((PaSampleFormat) 0x80000000) /**< @see PaSampleFormat */
@@ -656,7 +664,9 @@ typedef void PaStream;
 
  @see Pa_OpenStream, Pa_OpenDefaultStream
  @see paNoFlag, paClipOff, paDitherOff, paNeverDropInput,
-  paPrimeOutputBuffersUsingStreamCallback, paPlatformSpecificFlags
+  paPrimeOutputBuffersUsingStreamCallback, paNoiseShapedDither,
+  paConvertSampleRate, paSampleRateConversionLowLatency,
+  paSampleRateConversionHighQuality, paBatchUserBuffers, paPlatformSpecificFlags
 */
 typedef unsigned long PaStreamFlags;
 
@@ -692,6 +702,53 @@ typedef unsigned long PaStreamFlags;
 */
 #define   paPrimeOutputBuffersUsingStreamCallback ((PaStreamFlags) 0x00000008)
 
+/** Use noise shaped dither instead of the default triangular dither when
+ converting output samples to paInt16. Noise shaping lowers the noise floor in
+ the frequency range where hearing is most sensitive, at the expense of higher
+ noise close to the Nyquist frequency. This flag has no effect if paDitherOff
+ is also specified, or if output samples are not converted to paInt16.
+
+ @see PaStreamFlags, paDitherOff
+*/
+#define   paNoiseShapedDither ((PaStreamFlags) 0x00000010)
+
+/** Accept a sample rate which the device does not support by opening the
+ device at its default sample rate and converting between the two rates. The
+ conversion adds latency, which is included in the inputLatency and
+ outputLatency fields of PaStreamInfo, and the sampleRate field reports the
+ requested rate. This flag is only valid for callback streams, and has no
+ effect if the device supports the requested rate or the host API does not
+ support conversion.
+
+ @see PaStreamFlags, paSampleRateConversionLowLatency,
+ paSampleRateConversionHighQuality
+*/
+#define   paConvertSampleRate ((PaStreamFlags) 0x00000020)
+
+/** Use shorter sample rate conversion filters, which halve the latency added
+ by paConvertSampleRate at the expense of some aliasing near the Nyquist
+ frequency.
+
+ @see PaStreamFlags, paConvertSampleRate
+*/
+#define   paSampleRateConversionLowLatency ((PaStreamFlags) 0x00000040)
+
+/** Use longer sample rate conversion filters, which double the latency added
+ by paConvertSampleRate but leave negligible aliasing.
+
+ @see PaStreamFlags, paConvertSampleRate
+*/
+#define   paSampleRateConversionHighQuality ((PaStreamFlags) 0x00000080)
+
+/** Allow the user buffers of a host buffer to be passed to the stream in a
+ single call, once a PaStreamBatchCallback has been set with
+ Pa_SetStreamBatchCallback(). This flag is only valid for callback streams
+ with a framesPerBuffer other than paFramesPerBufferUnspecified.
+
+ @see PaStreamFlags, Pa_SetStreamBatchCallback
+*/
+#define   paBatchUserBuffers ((PaStreamFlags) 0x00000100)
+
 /** A mask specifying the platform specific bits.
  @see PaStreamFlags
 */
@@ -1133,6 +1190,432 @@ PaTime Pa_GetStreamTime( PaStream *stream );
 double Pa_GetStreamCpuLoad( PaStream* stream );
 
 
+/** Set the gain applied to one of a stream's output channels.
+
+ The gain is applied by PortAudio while it converts the output samples to the
+ host format, which avoids making a separate pass over the output buffer in
+ the stream callback. Gain changes are applied smoothly, with a short ramp,
+ except when the stream is stopped.
+
+ This function doesn't block, and may be called from any thread, including
+ the stream callback.
+
+ @param stream A pointer to an open stream previously created with Pa_OpenStream().
+
+ @param channel The index of the output channel, from 0 to one less than
+ the number of output channels passed to Pa_OpenStream().
+
+ @param gain The linear gain applied to the channel. The initial gain of every
+ channel is 1.0. Clipping and dithering are applied after the gain, as
+ requested by the stream flags.
+
+ @return paNoError on success, paInvalidChannelCount if the channel index is out
+ of range, paIncompatibleStreamHostApi if the host API doesn't support output
+ gain, or another error code.
+*/
+PaError Pa_SetStreamChannelGain( PaStream* stream, int channel, float gain );
+
+
+/** Retrieve the alignment of the buffers passed to a stream's callback.
+
+ Every input and output buffer pointer passed to the stream callback is a
+ multiple of the returned number of bytes. For non-interleaved buffers this
+ applies to each channel's buffer.
+
+ When PortAudio converts the samples, the buffers are its own and are aligned
+ to at least a cache line, which allows aligned SIMD loads and stores in the
+ callback and prevents channels processed on different cores from sharing a
+ cache line. When the sample format and layout match the device's, the
+ device's buffers are passed to the callback without copying them. PortAudio
+ doesn't know how the host APIs align their buffers, so the alignment is then
+ only the sample size, even if the device's buffers are better aligned;
+ request a different sample format or layout from the device's if a larger
+ alignment is needed. Streams which use Pa_SetStreamRouting() or a
+ different sample rate from the device are only aligned to the sample size.
+
+ @param stream A pointer to an open stream previously created with Pa_OpenStream().
+
+ @return A positive power of two, or a PaErrorCode (which are always negative)
+ if PortAudio is not initialized, an error is encountered, or the host API
+ doesn't provide the guarantee (paIncompatibleStreamHostApi).
+*/
+signed long Pa_GetStreamBufferAlignment( PaStream* stream );
+
+
+/** A connection between a channel of the buffers passed to the stream
+ callback and a channel of the device, with a gain.
+
+ @see PaStreamRoutingInfo
+*/
+typedef struct PaChannelRoute
+{
+    int userChannel;    /**< the channel of the callback buffers, from 0 */
+    int deviceChannel;  /**< the channel of the device, from 0 */
+    float gain;         /**< the gain of the connection, 1.0 for unity gain */
+} PaChannelRoute;
+
+
+/** Describes how the channels of the stream callback buffers are connected
+ to the channels of the device, for Pa_SetStreamRouting().
+
+ A user channel may be connected to several device channels, and several
+ user channels to one device channel, in which case they are summed. Device
+ output channels without a connection are silent, as are user input channels
+ without a connection.
+
+ @see Pa_SetStreamRouting, PaChannelRoute
+*/
+typedef struct PaStreamRoutingInfo
+{
+    unsigned long size;                 /**< sizeof(PaStreamRoutingInfo) */
+    unsigned long version;              /**< 1 */
+
+    /** The number of input channels passed to the callback, or 0 to pass
+     the device input channels unchanged. */
+    int inputChannelCount;
+    /** inputRouteCount routes from device input channels to user channels */
+    const PaChannelRoute *inputRoutes;
+    unsigned long inputRouteCount;
+
+    /** The number of output channels passed to the callback, or 0 to pass
+     the device output channels unchanged. */
+    int outputChannelCount;
+    /** outputRouteCount routes from user channels to device output channels */
+    const PaChannelRoute *outputRoutes;
+    unsigned long outputRouteCount;
+} PaStreamRoutingInfo;
+
+
+/** Connect the channels of the buffers passed to a stream's callback to
+ arbitrary channels of the device.
+
+ The stream is opened with the number of device channels to use, for example
+ four output channels to drive the third and fourth outputs of a device.
+ Device channel 0 is the first channel of the device on every host API.
+ After this call the callback is passed buffers with the number of channels
+ given in routingInfo instead, in the same sample format. When every route
+ has unity gain and no channel appears in more than one route, non-interleaved
+ callback buffers point directly into the buffers of the device channels.
+
+ Gains set by Pa_SetStreamChannelGain() apply to the device channels, and are
+ reset by this function.
+
+ @param stream A pointer to an open callback stream previously created with
+ Pa_OpenStream(). The stream must be stopped.
+
+ @param routingInfo The channel routing. The routes are copied.
+
+ @return paNoError on success, paInvalidChannelCount if a route refers to a
+ channel which doesn't exist, paStreamIsNotStopped if the stream is running,
+ paIncompatibleStreamHostApi if the stream is a blocking stream or the host
+ API doesn't support routing, paInvalidFlag if the stream was opened with
+ paConvertSampleRate or has a batch callback, or another error code.
+
+ @note Migration: ASIO output streams used to skip the first two channels of
+ devices with enough channels, so a stereo stream played on device channels
+ 3 and 4. They now start at channel 1 like on the other host APIs. To keep
+ playing on channels 3 and 4, open four output channels and route the
+ callback's two channels to device channels 2 and 3 with this function.
+*/
+PaError Pa_SetStreamRouting( PaStream* stream, const PaStreamRoutingInfo *routingInfo );
+
+
+/** The time spent in one stage of processing the buffers of a stream.
+
+ @see PaStreamProcessingTimes
+*/
+typedef struct PaStreamStageTime
+{
+    unsigned long count;    /**< the number of host buffers in which the stage ran */
+    PaTime total;           /**< the total time spent in the stage, in seconds */
+    PaTime maximum;         /**< the longest time spent in the stage for one host buffer */
+    PaTime last;            /**< the time spent in the stage for the last host buffer */
+} PaStreamStageTime;
+
+
+/** The time spent in each stage of processing the buffers of a stream, as
+ retrieved by Pa_GetStreamProcessingTimes().
+
+ @see Pa_GetStreamProcessingTimes
+*/
+typedef struct PaStreamProcessingTimes
+{
+    /** converting the host input buffers to the user format */
+    PaStreamStageTime inputConversion;
+    /** the stream callback */
+    PaStreamStageTime callback;
+    /** converting the user output buffers to the host format */
+    PaStreamStageTime outputConversion;
+} PaStreamProcessingTimes;
+
+
+/** Retrieve the time spent converting samples and in the stream callback,
+ measured separately for each host buffer with the CPU's cycle counter or a
+ monotonic clock. The measurement is only performed if PortAudio was built
+ with PA_PROCESS_STAGE_TIMING defined to 1 (the CMake option
+ PA_ENABLE_PROCESS_STAGE_TIMING). This function may be called from any thread
+ while the stream is running, and never blocks the callback.
+
+ @param stream A pointer to an open stream previously created with Pa_OpenStream().
+
+ @param times Receives the times. The times accumulate from when the stream
+ is opened.
+
+ @return paNoError on success, paIncompatibleStreamHostApi if PortAudio was
+ built without stage timing or the host API doesn't support it, or another
+ error code.
+*/
+PaError Pa_GetStreamProcessingTimes( PaStream* stream, PaStreamProcessingTimes *times );
+
+
+/** One of the user buffers passed to a PaStreamBatchCallback.
+
+ @see PaStreamBatchCallback
+*/
+typedef struct PaStreamCallbackBlock
+{
+    /** The input buffer, as the input parameter of a PaStreamCallback. NULL for
+     output-only streams. */
+    const void *input;
+    /** The output buffer, as the output parameter of a PaStreamCallback. NULL
+     for input-only streams. */
+    void *output;
+    /** The time stamps of the buffer. */
+    PaStreamCallbackTimeInfo timeInfo;
+} PaStreamCallbackBlock;
+
+
+/** Functions of type PaStreamBatchCallback are called instead of the
+ PaStreamCallback of a stream opened with paBatchUserBuffers, once
+ Pa_SetStreamBatchCallback() has been called, to process all of the complete
+ user buffers available when a host buffer is processed. The buffers are
+ consecutive, and follow each other in memory, each one padded to the
+ alignment reported by Pa_GetStreamBufferAlignment(): they are not copied
+ between calls.
+
+ @param blocks blockCount buffers of framesPerBlock frames, in the order in
+ which they are recorded or played.
+
+ @param blockCount The number of buffers, at least one.
+
+ @param framesPerBlock The framesPerBuffer passed to Pa_OpenStream().
+
+ @param statusFlags As for a PaStreamCallback, for the first buffer.
+
+ @param userData The userData passed to Pa_OpenStream().
+
+ @return As for a PaStreamCallback. paComplete and paAbort take effect after
+ the last buffer, paAbort discards the output of all of the buffers.
+
+ @see Pa_SetStreamBatchCallback, paBatchUserBuffers, PaStreamCallback
+*/
+typedef int PaStreamBatchCallback(
+    const PaStreamCallbackBlock *blocks, unsigned long blockCount,
+    unsigned long framesPerBlock, PaStreamCallbackFlags statusFlags,
+    void *userData );
+
+
+/** Set a callback which is called with all of the user buffers of a host
+ buffer at once, in place of the stream callback. This avoids calling the
+ stream callback many times in a row when the host buffers are much larger
+ than the user buffers.
+
+ @param stream A pointer to an open callback stream previously created with
+ Pa_OpenStream() with the paBatchUserBuffers flag. The stream must be stopped.
+
+ @param batchCallback The callback, or NULL to call the stream callback for
+ each user buffer again.
+
+ @return paNoError on success, paInvalidFlag if the stream was not opened with
+ paBatchUserBuffers, or was opened with paConvertSampleRate or has routing
+ set by Pa_SetStreamRouting(), paStreamIsNotStopped if the stream is running,
+ paIncompatibleStreamHostApi if the host API doesn't support batching, or
+ another error code.
+*/
+PaError Pa_SetStreamBatchCallback( PaStream* stream, PaStreamBatchCallback *batchCallback );
+
+
+/** A structure describing the simulated device of an offline stream.
+
+ @see Pa_OpenOfflineStream
+*/
+typedef struct PaOfflineStreamInfo
+{
+    unsigned long size;             /**< sizeof(PaOfflineStreamInfo) */
+    unsigned long version;          /**< 1 */
+
+    /** The format of the interleaved input frames passed to
+     Pa_RenderOfflineStream(), or 0 for the sampleFormat of the input
+     parameters without paNonInterleaved. */
+    PaSampleFormat hostInputSampleFormat;
+
+    /** The format of the interleaved output frames returned by
+     Pa_RenderOfflineStream(), or 0 for the sampleFormat of the output
+     parameters without paNonInterleaved. */
+    PaSampleFormat hostOutputSampleFormat;
+
+    /** The number of frames in each buffer of the simulated device, or 0 for
+     framesPerBuffer (or 512 frames if framesPerBuffer is
+     paFramesPerBufferUnspecified). Using a size which isn't a multiple of
+     framesPerBuffer exercises the adaption between host and user buffers. */
+    unsigned long framesPerHostBuffer;
+} PaOfflineStreamInfo;
+
+
+/** Opens a callback stream which isn't connected to a device. The stream is
+ driven by calls to Pa_RenderOfflineStream(), which run the stream callback as
+ fast as the processor allows, and passes through the same sample format
+ conversion and buffer size adaption as a stream opened with Pa_OpenStream().
+ The result only depends on the input and the sequence of calls, so offline
+ streams are suitable for rendering to files and for reproducible tests.
+
+ The stream must be started with Pa_StartStream() before rendering, and
+ supports the other functions which apply to callback streams, such as
+ Pa_SetStreamChannelGain(), Pa_SetStreamRouting() and
+ Pa_SetStreamBatchCallback(). Pa_GetStreamTime() returns the time of the next
+ frame to be rendered, counted from 0, and Pa_GetStreamCpuLoad() the time
+ spent rendering as a fraction of the duration of the audio rendered.
+
+ @param stream, inputParameters, outputParameters, sampleRate,
+ framesPerBuffer, streamFlags, streamCallback, userData As for
+ Pa_OpenStream(), except that the device and hostApiSpecificStreamInfo fields
+ of the parameters are ignored, the suggestedLatency fields are used as the
+ latency of the simulated device, and streamCallback must not be NULL.
+
+ @param offlineStreamInfo Describes the simulated device, or NULL for the
+ defaults.
+
+ @return paNoError on success, paNullCallback if streamCallback is NULL,
+ paInvalidFlag if paConvertSampleRate or a platform specific flag is
+ specified, paIncompatibleHostApiSpecificStreamInfo if the size or version of
+ offlineStreamInfo is wrong, or another error code.
+
+ @see Pa_RenderOfflineStream
+*/
+PaError Pa_OpenOfflineStream( PaStream** stream,
+                              const PaStreamParameters *inputParameters,
+                              const PaStreamParameters *outputParameters,
+                              double sampleRate,
+                              unsigned long framesPerBuffer,
+                              PaStreamFlags streamFlags,
+                              const PaOfflineStreamInfo *offlineStreamInfo,
+                              PaStreamCallback *streamCallback,
+                              void *userData );
+
+
+/** Renders frames of an offline stream. The frames are processed in buffers
+ of the size of the simulated device's buffers, with the stream callback
+ called on the calling thread. The time info passed to the callback is
+ derived from the number of frames rendered since the stream was opened.
+
+ If frames is not a multiple of the simulated buffer size, the last buffer is
+ padded with silence on input and truncated on output, as if the device had
+ been stopped mid-buffer. To render a stream in pieces without gaps, pass a
+ multiple of the buffer size in each call but the last.
+
+ Once the stream callback has returned paComplete or paAbort the stream is no
+ longer active; further calls render what remains of the stream's output,
+ followed by silence.
+
+ @param stream A pointer to a started stream opened with Pa_OpenOfflineStream().
+
+ @param input The interleaved input frames in the host input sample format,
+ or NULL for an output only stream.
+
+ @param output Receives the interleaved output frames in the host output
+ sample format, or NULL for an input only stream.
+
+ @param frames The number of frames to render.
+
+ @return paNoError on success, paStreamIsStopped if the stream has not been
+ started, paBadBufferPtr if input or output is missing,
+ paIncompatibleStreamHostApi if the stream was not opened with
+ Pa_OpenOfflineStream(), or another error code.
+*/
+PaError Pa_RenderOfflineStream( PaStream* stream,
+                                const void *input,
+                                void *output,
+                                unsigned long frames );
+
+
+/** A timestamped message posted to a stream with Pa_PostStreamEvent(), such
+ as a parameter change. Apart from time, the fields are not interpreted by
+ PortAudio.
+
+ @see Pa_PostStreamEvent, PaStreamEventCallback
+*/
+typedef struct PaStreamEvent
+{
+    /** The time at which the event takes effect, on the clock of the time
+     info passed to the stream callback (see Pa_GetStreamTime()). The event
+     applies to the output sample with this DAC time, or for input only
+     streams the input sample with this ADC time. Events with a time which
+     has already passed, such as 0, take effect at the start of the next
+     buffer. */
+    PaTime time;
+
+    unsigned long type;     /**< application defined, e.g. a parameter id */
+    double value;           /**< application defined, e.g. a parameter value */
+    void *data;             /**< application defined */
+} PaStreamEvent;
+
+
+/** Functions of type PaStreamEventCallback are called on the audio thread
+ with each event posted to a stream, immediately before the stream callback
+ for the buffer which contains the event.
+
+ @param event The event. The pointer is only valid during the call.
+
+ @param frameOffset The index of the frame of the next stream callback's
+ buffer at which the event takes effect. If the stream was opened with
+ paFramesPerBufferUnspecified the stream callback's buffers are split at the
+ events, so frameOffset is always 0.
+
+ @param userData The userData parameter supplied to Pa_OpenStream().
+
+ @see Pa_SetStreamEventCallback, Pa_PostStreamEvent
+*/
+typedef void PaStreamEventCallback( const PaStreamEvent *event,
+        unsigned long frameOffset, void *userData );
+
+
+/** Set the callback which receives the events posted to a stream with
+ Pa_PostStreamEvent(), and allocate the queue which holds them. The queue is
+ a lock-free single producer, single consumer FIFO, so the audio thread never
+ blocks on it.
+
+ @param stream A pointer to an open callback stream. The stream must be
+ stopped.
+
+ @param eventCallback The callback, or NULL to stop delivering events and
+ free the queue.
+
+ @param maxPendingEvents The number of events which may be queued at once,
+ which must be at least 1 and less than 2^29.
+
+ @return paNoError on success, paStreamIsNotStopped if the stream is running,
+ paInvalidFlag if the stream converts its sample rate, uses routing or a
+ batch callback, paIncompatibleStreamHostApi if the host API doesn't support
+ events, paBufferTooSmall if maxPendingEvents is 0, paInsufficientMemory if
+ the queue is too large, or another error code.
+*/
+PaError Pa_SetStreamEventCallback( PaStream* stream,
+                                   PaStreamEventCallback *eventCallback,
+                                   unsigned long maxPendingEvents );
+
+
+/** Post an event to a stream, from a single control thread. This doesn't
+ block and may be called while the stream is running. Events are delivered
+ in the order they are posted, so they should be posted in time order: an
+ event is never delivered before the events posted ahead of it.
+
+ @return paNoError on success, paStreamEventQueueFull if the queue is full,
+ paNullCallback if no event callback has been set with
+ Pa_SetStreamEventCallback(), or another error code.
+*/
+PaError Pa_PostStreamEvent( PaStream* stream, const PaStreamEvent *event );
+
+
 /** Read samples from an input stream. The function doesn't return until
  the entire buffer has been filled - this may involve waiting for the operating
  system to supply the data.
@@ -1222,6 +1705,104 @@ signed long Pa_GetStreamReadAvailable( PaStream* stream );
 signed long Pa_GetStreamWriteAvailable( PaStream* stream );
 
 
+/** Borrow the next frames of a blocking input stream's buffer, so that they
+ can be read in place instead of being copied by Pa_ReadStream(). The frames
+ must be returned with Pa_ReleaseReadBuffer() before the next call to
+ Pa_ReadStream(). The function waits until at least one frame is available.
+
+ When the host API can lend its own buffer in the stream's sample format the
+ frames are not copied at all, otherwise they are converted into an
+ intermediate buffer. Stopping the stream discards any borrowed frames.
+
+ @param stream A pointer to an open blocking stream.
+
+ @param buffer Receives a pointer to the frames, in the format and with the
+ number of channels used to open the stream. For paNonInterleaved formats it
+ receives a pointer to an array of buffer pointers, one for each channel.
+
+ @param frames On entry the maximum number of frames wanted, on return the
+ number of frames lent. This is often fewer than were wanted, even when more
+ are available: the frames are lent as one contiguous block, so where the
+ stream's buffer wraps around only the frames before its end are lent. Call
+ Pa_ReleaseReadBuffer() and then Pa_AcquireReadBuffer() again to get the rest.
+
+ @return On success paNoError, or paInputOverflowed as for Pa_ReadStream().
+ paBufferAlreadyAcquired if frames lent by a previous call haven't been
+ released yet, paCanNotReadFromACallbackStream for callback streams,
+ paIncompatibleStreamHostApi if the host API doesn't lend buffers,
+ paSampleFormatNotSupported if it can't lend buffers in the stream's sample
+ format, or another error code.
+
+ @see Pa_ReleaseReadBuffer, Pa_AcquireWriteBuffer
+*/
+PaError Pa_AcquireReadBuffer( PaStream* stream,
+                              const void **buffer,
+                              unsigned long *frames );
+
+
+/** Return frames borrowed with Pa_AcquireReadBuffer(), so that the stream can
+ reuse their space.
+
+ @param frames The number of frames which have been read, from the start of
+ the buffer. The remaining borrowed frames are lent again by the next call to
+ Pa_AcquireReadBuffer().
+
+ @return paNoError on success, paBufferNotAcquired if frames is greater than
+ the number of frames borrowed, or another error code.
+*/
+PaError Pa_ReleaseReadBuffer( PaStream* stream, unsigned long frames );
+
+
+/** Borrow the next frames of a blocking output stream's buffer, so that they
+ can be written in place instead of being copied by Pa_WriteStream(). The
+ frames are played once they are passed to Pa_CommitWriteBuffer(), which must
+ be called before the next call to Pa_WriteStream(). The function waits until
+ at least one frame can be written.
+
+ When the host API can lend its own buffer in the stream's sample format the
+ frames are not copied at all, otherwise they are converted from an
+ intermediate buffer when they are committed. Stopping the stream discards
+ any borrowed frames.
+
+ @param stream A pointer to an open blocking stream.
+
+ @param buffer Receives a pointer to the frames, in the format and with the
+ number of channels used to open the stream. For paNonInterleaved formats it
+ receives a pointer to an array of buffer pointers, one for each channel.
+ The initial contents of the frames are undefined.
+
+ @param frames On entry the maximum number of frames wanted, on return the
+ number of frames lent. This is often fewer than were wanted, even when more
+ can be written: the frames are lent as one contiguous block, so where the
+ stream's buffer wraps around only the frames before its end are lent. Call
+ Pa_CommitWriteBuffer() and then Pa_AcquireWriteBuffer() again to get the
+ rest.
+
+ @return On success paNoError, or paOutputUnderflowed as for Pa_WriteStream().
+ paBufferAlreadyAcquired if frames lent by a previous call haven't been
+ committed yet, paCanNotWriteToACallbackStream for callback streams,
+ paIncompatibleStreamHostApi if the host API doesn't lend buffers,
+ paSampleFormatNotSupported if it can't lend buffers in the stream's sample
+ format, or another error code.
+
+ @see Pa_CommitWriteBuffer, Pa_AcquireReadBuffer
+*/
+PaError Pa_AcquireWriteBuffer( PaStream* stream,
+                               void **buffer,
+                               unsigned long *frames );
+
+
+/** Queue frames written to a buffer borrowed with Pa_AcquireWriteBuffer().
+
+ @param frames The number of frames which have been written, from the start
+ of the buffer. The remaining borrowed frames are discarded.
+
+ @return paNoError on success, paBufferNotAcquired if frames is greater than
+ the number of frames borrowed, or another error code.
+*/
+PaError Pa_CommitWriteBuffer( PaStream* stream, unsigned long frames );
+
+
 /* Miscellaneous utilities */
 
 
@@ -1233,6 +1814,58 @@ signed long Pa_GetStreamWriteAvailable( PaStream* stream );
 PaError Pa_GetSampleSize( PaSampleFormat format );
 
 
+/** Instruction set tiers for which PortAudio provides sample format converters.
+ The Float32 to and from Int32, Int24 and Int16 converters are available in a
+ plain C version and in versions which use the SIMD instructions of the
+ processor. Unless a tier is forced with Pa_SetConverterTier() or the
+ PA_CONVERTER_TIER environment variable, the fastest tier supported by the
+ processor is selected when PortAudio is initialized.
+
+ @see Pa_SetConverterTier, Pa_GetConverterTier
+*/
+typedef enum PaConverterTier
+{
+    paConverterTierDefault = 0, /**< Select the fastest supported tier. */
+    paConverterTierScalar,      /**< Plain C converters. */
+    paConverterTierSSE2,        /**< x86 SSE2 converters. */
+    paConverterTierAVX2,        /**< x86-64 AVX2 converters. */
+    paConverterTierAVX512,      /**< x86-64 AVX-512F converters. */
+    paConverterTierNEON         /**< AArch64 NEON converters. */
+} PaConverterTier;
+
+
+/** Force the sample format converters to a specific instruction set tier.
+ This is intended for testing and benchmarking; applications normally leave
+ the choice to PortAudio. The tier affects streams opened after the call,
+ and may be set before or after Pa_Initialize(), but only while no stream is
+ open: the converter tables are replaced without synchronization, so they
+ must not be in use by another thread.
+
+ The PA_CONVERTER_TIER environment variable may be set to "scalar", "sse2",
+ "avx2", "avx512" or "neon" to force a tier without changing the application.
+ A tier set with this function takes precedence over the environment variable.
+
+ @param tier The tier to use, or paConverterTierDefault to restore automatic
+ selection.
+
+ @return paNoError on success, paConverterTierNotSupported if the tier is
+ not supported by the processor or was not compiled into PortAudio, or
+ paConverterTierInUse if a stream is open.
+
+ @see Pa_GetConverterTier
+*/
+PaError Pa_SetConverterTier( PaConverterTier tier );
+
+
+/** Retrieve the instruction set tier of the sample format converters which
+ are used by streams opened from now on. The result is never
+ paConverterTierDefault.
+
+ @see Pa_SetConverterTier
+*/
+PaConverterTier Pa_GetConverterTier( void );
+
+
 /** Put the caller to sleep for at least 'msec' milliseconds. This function is
  provided only as a convenience for authors of portable code (such as the tests
  and examples in the PortAudio distribution.)
@@ -0,0 +1,465 @@
+/** @file paqa_adapting.c
+    @ingroup qa_src
+    @brief Tests that the adapting buffer processor in pa_process.c passes
+    every frame between the host buffers and the user buffers, in order, for
+    a range of mismatched host and user buffer sizes.
+
+    Link with pa_process.c, pa_resampler.c, pa_dither.c, pa_converters.c and
+    pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (48000.0)
+#define CHANNEL_COUNT       (3)
+#define HOST_BUFFER_COUNT   (40)
+#define MAX_HOST_FRAMES     (2048)
+
+/* The user buffers are paInt32 and the host buffers paInt16, so that the
+    samples are converted exactly in both directions. */
+
+typedef struct SizeTest
+{
+    unsigned long framesPerUserBuffer;
+    unsigned long framesPerHostBuffer;
+    PaUtilHostBufferSizeMode hostBufferSizeMode;
+} SizeTest;
+
+static const SizeTest sizeTests_[] =
+{
+    { 256, 480, paUtilFixedHostBufferSize },
+    { 256, 480, paUtilBoundedHostBufferSize },
+    { 256, 480, paUtilUnknownHostBufferSize },
+    { 512, 441, paUtilFixedHostBufferSize },
+    { 441, 512, paUtilFixedHostBufferSize },
+    { 441, 256, paUtilBoundedHostBufferSize },
+    { 64, 1000, paUtilBoundedHostBufferSize },
+    { 1024, 128, paUtilFixedHostBufferSize },
+    { 96, 0, paUtilUnknownHostBufferSize }
+};
+
+#define SIZE_TEST_COUNT     ((int)(sizeof(sizeTests_) / sizeof(sizeTests_[0])))
+
+
+typedef struct CallbackData
+{
+    int inputChannelCount;
+    int outputChannelCount;
+    int userIsInterleaved;
+    unsigned long alignment;
+    unsigned long initialInputFrames;
+    unsigned long inputFrame;   /* index of the next frame of the user input stream */
+    unsigned long outputFrame;  /* index of the next frame of the user output stream */
+    int callbackCount;
+    int stopCallbackCount;      /* the callback returns stopResult on this call, 0 for never */
+    int stopResult;
+    int inputErrorCount;
+    int alignmentErrorCount;
+} CallbackData;
+
+
+static PaInt16 SampleValue( unsigned long frame, int channel )
+{
+    return (PaInt16)( (long)((frame * 7 + channel * 1001) % 30011) - 15000 );
+}
+
+
+static int IsAligned( const void *p, unsigned long alignment )
+{
+    return ((size_t)p % alignment) == 0;
+}
+
+
+/* Checks the input against the stream of host frames, which follow the
+    initial frames of silence, and writes the next frames of the output stream. */
+static int TestCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    unsigned long i;
+    int c;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    for( c = 0; c < data->inputChannelCount; ++c )
+    {
+        const PaInt32 *samples;
+        int stride;
+
+        if( data->userIsInterleaved )
+        {
+            samples = ((const PaInt32*)input) + c;
+            stride = data->inputChannelCount;
+            if( !IsAligned( input, data->alignment ) )
+                data->alignmentErrorCount++;
+        }
+        else
+        {
+            samples = ((const PaInt32* const*)input)[c];
+            stride = 1;
+            if( !IsAligned( samples, data->alignment ) )
+                data->alignmentErrorCount++;
+        }
+
+        for( i = 0; i < frameCount; ++i )
+        {
+            unsigned long frame = data->inputFrame + i;
+            PaInt32 expected = ( frame < data->initialInputFrames )
+                    ? 0 : ((PaInt32)SampleValue( frame - data->initialInputFrames, c )) * 65536;
+
+            if( samples[i * stride] != expected )
+                data->inputErrorCount++;
+        }
+    }
+    data->inputFrame += frameCount;
+
+    for( c = 0; c < data->outputChannelCount; ++c )
+    {
+        PaInt32 *samples;
+        int stride;
+
+        if( data->userIsInterleaved )
+        {
+            samples = ((PaInt32*)output) + c;
+            stride = data->outputChannelCount;
+            if( !IsAligned( output, data->alignment ) )
+                data->alignmentErrorCount++;
+        }
+        else
+        {
+            samples = ((PaInt32**)output)[c];
+            stride = 1;
+            if( !IsAligned( samples, data->alignment ) )
+                data->alignmentErrorCount++;
+        }
+
+        for( i = 0; i < frameCount; ++i )
+            samples[i * stride] = ((PaInt32)SampleValue( data->outputFrame + i, c )) * 65536;
+    }
+    data->outputFrame += frameCount;
+
+    if( ++data->callbackCount == data->stopCallbackCount )
+        return data->stopResult;
+
+    return paContinue;
+}
+
+
+/* varies the host buffer size for the variable host buffer size modes */
+static unsigned long GetHostFrameCount( const SizeTest *sizeTest, int buffer )
+{
+    static const unsigned long unknownSizes[] = { 480, 1, 2000, 333, 1024, 77, 1500 };
+
+    switch( sizeTest->hostBufferSizeMode )
+    {
+    case paUtilFixedHostBufferSize:
+        return sizeTest->framesPerHostBuffer;
+    case paUtilBoundedHostBufferSize:
+        return sizeTest->framesPerHostBuffer - (buffer * 37) % sizeTest->framesPerHostBuffer;
+    default:
+        return unknownSizes[ buffer % (sizeof(unknownSizes) / sizeof(unknownSizes[0])) ];
+    }
+}
+
+
+/* Sets frameCount frames starting at frame of the host buffers as the 1st
+    host buffer, or as the 2nd host buffer if isSecond is non-zero. */
+static void SetHostBuffers( PaUtilBufferProcessor *bp, int isSecond,
+        int inputChannelCount, PaInt16 *hostInput,
+        int outputChannelCount, PaInt16 *hostOutput,
+        int hostIsInterleaved, unsigned long frame, unsigned long frameCount )
+{
+    int c;
+
+    if( inputChannelCount > 0 )
+    {
+        if( isSecond )
+            PaUtil_Set2ndInputFrameCount( bp, frameCount );
+        else
+            PaUtil_SetInputFrameCount( bp, frameCount );
+
+        for( c = 0; c < inputChannelCount; ++c )
+        {
+            if( hostIsInterleaved )
+            {
+                PaInt16 *data = hostInput + frame * inputChannelCount + c;
+                if( isSecond )
+                    PaUtil_Set2ndInputChannel( bp, c, data, inputChannelCount );
+                else
+                    PaUtil_SetInputChannel( bp, c, data, inputChannelCount );
+            }
+            else
+            {
+                PaInt16 *data = hostInput + c * MAX_HOST_FRAMES + frame;
+                if( isSecond )
+                    PaUtil_Set2ndNonInterleavedInputChannel( bp, c, data );
+                else
+                    PaUtil_SetNonInterleavedInputChannel( bp, c, data );
+            }
+        }
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        if( isSecond )
+            PaUtil_Set2ndOutputFrameCount( bp, frameCount );
+        else
+            PaUtil_SetOutputFrameCount( bp, frameCount );
+
+        for( c = 0; c < outputChannelCount; ++c )
+        {
+            if( hostIsInterleaved )
+            {
+                PaInt16 *data = hostOutput + frame * outputChannelCount + c;
+                if( isSecond )
+                    PaUtil_Set2ndOutputChannel( bp, c, data, outputChannelCount );
+                else
+                    PaUtil_SetOutputChannel( bp, c, data, outputChannelCount );
+            }
+            else
+            {
+                PaInt16 *data = hostOutput + c * MAX_HOST_FRAMES + frame;
+                if( isSecond )
+                    PaUtil_Set2ndNonInterleavedOutputChannel( bp, c, data );
+                else
+                    PaUtil_SetNonInterleavedOutputChannel( bp, c, data );
+            }
+        }
+    }
+}
+
+
+static PaInt16 GetHostSample( const PaInt16 *buffer, int channelCount,
+        int hostIsInterleaved, unsigned long frame, int channel )
+{
+    return hostIsInterleaved ? buffer[frame * channelCount + channel]
+            : buffer[channel * MAX_HOST_FRAMES + frame];
+}
+
+
+/* Passes HOST_BUFFER_COUNT host buffers through a buffer processor and
+    checks that the user input and host output streams are intact. The host
+    output stream starts with the initial frames of silence, and is silent
+    after the callback has returned stopResult. */
+static int TestStreams( const SizeTest *sizeTest, int inputChannelCount, int outputChannelCount,
+        int userIsInterleaved, int hostIsInterleaved, int splitHostBuffers,
+        int stopCallbackCount, int stopResult )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    static PaInt16 hostInput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    static PaInt16 hostOutput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    PaSampleFormat userFormat = paInt32 | (userIsInterleaved ? 0 : paNonInterleaved);
+    PaSampleFormat hostFormat = paInt16 | (hostIsInterleaved ? 0 : paNonInterleaved);
+    CallbackData data;
+    unsigned long hostFrame = 0; /* index of the next host frame of the streams */
+    unsigned long initialOutputFrames, outputFramesExpected;
+    unsigned long frameCount, firstFrameCount, framesProcessed, i;
+    int buffer, c, callbackResult = paContinue;
+    int outputErrorCount = 0, frameCountErrorCount = 0;
+
+    memset( &data, 0, sizeof(data) );
+    data.inputChannelCount = inputChannelCount;
+    data.outputChannelCount = outputChannelCount;
+    data.userIsInterleaved = userIsInterleaved;
+    data.stopCallbackCount = stopCallbackCount;
+    data.stopResult = stopResult;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            inputChannelCount, userFormat, hostFormat,
+            outputChannelCount, userFormat, hostFormat,
+            SAMPLE_RATE, paClipOff | paDitherOff, sizeTest->framesPerUserBuffer,
+            sizeTest->framesPerHostBuffer, sizeTest->hostBufferSizeMode,
+            TestCallback, &data ) );
+
+    data.alignment = PaUtil_GetBufferProcessorBufferAlignment( &bufferProcessor );
+    data.initialInputFrames = PaUtil_GetBufferProcessorInputLatencyFrames( &bufferProcessor );
+    initialOutputFrames = PaUtil_GetBufferProcessorOutputLatencyFrames( &bufferProcessor );
+    /* after the callback has stopped, only the frames of the previous callbacks are output */
+    outputFramesExpected = initialOutputFrames + (stopCallbackCount > 0
+            ? (stopCallbackCount - (stopResult == paAbort ? 1 : 0)) * sizeTest->framesPerUserBuffer
+            : HOST_BUFFER_COUNT * MAX_HOST_FRAMES);
+
+    for( buffer = 0; buffer < HOST_BUFFER_COUNT; ++buffer )
+    {
+        frameCount = GetHostFrameCount( sizeTest, buffer );
+
+        for( i = 0; i < frameCount; ++i )
+        {
+            for( c = 0; c < inputChannelCount; ++c )
+            {
+                if( hostIsInterleaved )
+                    hostInput[i * inputChannelCount + c] = SampleValue( hostFrame + i, c );
+                else
+                    hostInput[c * MAX_HOST_FRAMES + i] = SampleValue( hostFrame + i, c );
+            }
+        }
+        memset( hostOutput, 0x55, sizeof(hostOutput) );
+
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+
+        /* split the host buffer as if it wrapped around a ring buffer */
+        firstFrameCount = ( splitHostBuffers && frameCount > 1 ) ? frameCount / 3 + 1 : frameCount;
+        SetHostBuffers( &bufferProcessor, 0, inputChannelCount, hostInput,
+                outputChannelCount, hostOutput, hostIsInterleaved, 0, firstFrameCount );
+        if( firstFrameCount < frameCount )
+        {
+            SetHostBuffers( &bufferProcessor, 1, inputChannelCount, hostInput,
+                    outputChannelCount, hostOutput, hostIsInterleaved,
+                    firstFrameCount, frameCount - firstFrameCount );
+        }
+
+        framesProcessed = PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+        if( framesProcessed != frameCount )
+            frameCountErrorCount++;
+
+        for( i = 0; i < frameCount; ++i )
+        {
+            unsigned long frame = hostFrame + i;
+
+            for( c = 0; c < outputChannelCount; ++c )
+            {
+                PaInt16 expected = ( frame < initialOutputFrames || frame >= outputFramesExpected )
+                        ? 0 : SampleValue( frame - initialOutputFrames, c );
+
+                if( GetHostSample( hostOutput, outputChannelCount, hostIsInterleaved, i, c ) != expected )
+                    outputErrorCount++;
+            }
+        }
+
+        hostFrame += frameCount;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    if( outputErrorCount || data.inputErrorCount || data.alignmentErrorCount || frameCountErrorCount )
+    {
+        printf( "  user %lu host %lu mode %d, %d in %d out, user %sinterleaved, host %sinterleaved%s%s\n",
+                sizeTest->framesPerUserBuffer, sizeTest->framesPerHostBuffer,
+                (int)sizeTest->hostBufferSizeMode, inputChannelCount, outputChannelCount,
+                userIsInterleaved ? "" : "non-", hostIsInterleaved ? "" : "non-",
+                splitHostBuffers ? ", split" : "",
+                stopCallbackCount ? (stopResult == paAbort ? ", abort" : ", complete") : "" );
+    }
+
+    EXPECT_EQ( 0, frameCountErrorCount );
+    EXPECT_EQ( 0, data.inputErrorCount );
+    EXPECT_EQ( 0, outputErrorCount );
+    EXPECT_EQ( 0, data.alignmentErrorCount );
+
+    /* all of the input reached the callback */
+    if( inputChannelCount > 0 && stopCallbackCount == 0 )
+        EXPECT_GT( (int)sizeTest->framesPerUserBuffer, (int)(data.initialInputFrames + hostFrame - data.inputFrame) );
+    if( stopCallbackCount > 0 )
+        EXPECT_EQ( stopCallbackCount, data.callbackCount );
+
+    return 0;
+
+error:
+    return -1;
+}
+
+
+static void TestAllSizes( void )
+{
+    int s, direction, userIsInterleaved, hostIsInterleaved, split;
+
+    printf( "Testing the streams for mismatched buffer sizes.\n" );
+
+    for( s = 0; s < SIZE_TEST_COUNT; ++s )
+    {
+        for( direction = 0; direction < 3; ++direction )
+        {
+            int inputChannelCount = ( direction != 1 ) ? CHANNEL_COUNT : 0;
+            int outputChannelCount = ( direction != 0 ) ? CHANNEL_COUNT : 0;
+
+            for( userIsInterleaved = 0; userIsInterleaved < 2; ++userIsInterleaved )
+                for( hostIsInterleaved = 0; hostIsInterleaved < 2; ++hostIsInterleaved )
+                    for( split = 0; split < 2; ++split )
+                        TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                                userIsInterleaved, hostIsInterleaved, split, 0, paContinue );
+        }
+    }
+}
+
+
+static void TestStoppingCallback( void )
+{
+    int s, direction;
+
+    printf( "Testing paComplete and paAbort.\n" );
+
+    for( s = 0; s < SIZE_TEST_COUNT; ++s )
+    {
+        for( direction = 0; direction < 3; ++direction )
+        {
+            int inputChannelCount = ( direction != 1 ) ? CHANNEL_COUNT : 0;
+            int outputChannelCount = ( direction != 0 ) ? CHANNEL_COUNT : 0;
+
+            TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                    1, 1, 1, 5, paComplete );
+            TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                    0, 1, 0, 5, paAbort );
+        }
+    }
+}
+
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestAllSizes();
+    TestStoppingCallback();
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
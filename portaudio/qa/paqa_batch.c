@@ -0,0 +1,676 @@
+/** @file paqa_batch.c
+    @ingroup qa_src
+    @brief Tests the batched stream callback of the buffer processor in
+    pa_process.c (see paBatchUserBuffers).
+
+    Link with pa_process.c, pa_resampler.c, pa_dither.c, pa_converters.c and
+    pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (48000.0)
+#define CHANNEL_COUNT       (2)
+#define HOST_BUFFER_COUNT   (24)
+#define MAX_HOST_FRAMES     (2048)
+#define STREAM_FRAMES       (HOST_BUFFER_COUNT * MAX_HOST_FRAMES)
+
+#define INT24_CHANNEL_COUNT (3)
+#define INT24_USER_FRAMES   (50)    /* 450 bytes per user buffer */
+#define INT24_HOST_FRAMES   (800)
+
+/* The user buffers are paInt32 and the host buffers paInt16, so that the
+    samples are converted exactly in both directions. */
+
+typedef struct SizeTest
+{
+    unsigned long framesPerUserBuffer;
+    unsigned long framesPerHostBuffer;
+    PaUtilHostBufferSizeMode hostBufferSizeMode;
+    unsigned long expectedBlockCount; /* blocks in every batch, 0 if it varies */
+} SizeTest;
+
+static const SizeTest sizeTests_[] =
+{
+    { 64, 2048, paUtilFixedHostBufferSize, 32 },
+    { 256, 1024, paUtilFixedHostBufferSize, 4 },
+    { 256, 480, paUtilFixedHostBufferSize, 0 },
+    { 256, 480, paUtilBoundedHostBufferSize, 0 },
+    { 441, 512, paUtilFixedHostBufferSize, 0 },
+    { 33, 1056, paUtilFixedHostBufferSize, 32 }, /* user buffers which aren't a multiple of the alignment */
+    { 96, 0, paUtilUnknownHostBufferSize, 0 }
+};
+
+#define SIZE_TEST_COUNT     ((int)(sizeof(sizeTests_) / sizeof(sizeTests_[0])))
+
+
+typedef struct CallbackData
+{
+    int inputChannelCount;
+    int outputChannelCount;
+    int userIsInterleaved;
+    unsigned long alignment;    /* of the user buffers, from PaUtil_GetBufferProcessorBufferAlignment() */
+    unsigned long initialInputFrames;
+    unsigned long inputFrame;   /* index of the next frame of the user input stream */
+    unsigned long outputFrame;  /* index of the next frame of the user output stream */
+    unsigned long stopOutputFrame; /* length of the user output stream which is played */
+    int batchCount;
+    int streamCallbackCount;
+    unsigned long minBlockCount;
+    unsigned long maxBlockCount;
+    int stopBatchCount;         /* the callback returns stopResult on this call, 0 for never */
+    int stopResult;
+    int inputErrorCount;
+    int layoutErrorCount;       /* blocks which aren't consecutive or aligned, or have the wrong time info */
+} CallbackData;
+
+
+static PaInt16 SampleValue( unsigned long frame, int channel )
+{
+    return (PaInt16)( (long)((frame * 7 + channel * 1001) % 30011) - 15000 );
+}
+
+
+/* returns the address of the 1st sample of channel in a user buffer */
+static PaInt32 *GetChannel( const CallbackData *data, const void *buffer, int channel )
+{
+    if( data->userIsInterleaved )
+        return ((PaInt32*)buffer) + channel;
+    else
+        return ((PaInt32* const*)buffer)[channel];
+}
+
+
+/* checks the input of a user buffer and writes its output, like a
+    PaStreamCallback */
+static void ProcessBlock( CallbackData *data, const void *input, void *output,
+        unsigned long frameCount )
+{
+    int inputStride = data->userIsInterleaved ? data->inputChannelCount : 1;
+    int outputStride = data->userIsInterleaved ? data->outputChannelCount : 1;
+    unsigned long i;
+    int c;
+
+    for( c = 0; c < data->inputChannelCount; ++c )
+    {
+        const PaInt32 *samples = GetChannel( data, input, c );
+
+        for( i = 0; i < frameCount; ++i )
+        {
+            unsigned long frame = data->inputFrame + i;
+            PaInt32 expected = ( frame < data->initialInputFrames )
+                    ? 0 : ((PaInt32)SampleValue( frame - data->initialInputFrames, c )) * 65536;
+
+            if( samples[i * inputStride] != expected )
+                data->inputErrorCount++;
+        }
+    }
+    data->inputFrame += frameCount;
+
+    for( c = 0; c < data->outputChannelCount; ++c )
+    {
+        PaInt32 *samples = GetChannel( data, output, c );
+
+        for( i = 0; i < frameCount; ++i )
+            samples[i * outputStride] = ((PaInt32)SampleValue( data->outputFrame + i, c )) * 65536;
+    }
+    data->outputFrame += frameCount;
+}
+
+
+/* returns non-zero if each channel of a user buffer is aligned */
+static int IsAligned( const CallbackData *data, const void *buffer, int channelCount )
+{
+    int c;
+
+    for( c = 0; c < (data->userIsInterleaved ? 1 : channelCount); ++c )
+    {
+        if( (size_t)GetChannel( data, buffer, c ) % data->alignment != 0 )
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/* returns non-zero if the user buffer b follows on from the user buffer a
+    in memory, after the padding which keeps each user buffer aligned */
+static int IsContiguous( const CallbackData *data, const void *a, const void *b,
+        int channelCount, unsigned long frameCount )
+{
+    unsigned long stride = frameCount * sizeof(PaInt32) * (data->userIsInterleaved ? channelCount : 1);
+    int c;
+
+    stride = (stride + data->alignment - 1) / data->alignment * data->alignment;
+
+    for( c = 0; c < channelCount; ++c )
+    {
+        if( (const unsigned char*)GetChannel( data, a, c ) + stride
+                != (const unsigned char*)GetChannel( data, b, c ) )
+            return 0;
+    }
+
+    return 1;
+}
+
+
+static int TestBatchCallback( const PaStreamCallbackBlock *blocks, unsigned long blockCount,
+        unsigned long framesPerBlock, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    PaTime blockDuration = framesPerBlock / SAMPLE_RATE;
+    unsigned long i;
+    (void)statusFlags;
+
+    if( data->batchCount == 0 || blockCount < data->minBlockCount )
+        data->minBlockCount = blockCount;
+    if( blockCount > data->maxBlockCount )
+        data->maxBlockCount = blockCount;
+
+    for( i = 0; i < blockCount; ++i )
+    {
+        const PaStreamCallbackBlock *block = &blocks[i];
+
+        if( (data->inputChannelCount > 0) != (block->input != NULL)
+                || (data->outputChannelCount > 0) != (block->output != NULL) )
+        {
+            data->layoutErrorCount++;
+            continue;
+        }
+
+        if( (data->inputChannelCount > 0 && !IsAligned( data, block->input, data->inputChannelCount ))
+                || (data->outputChannelCount > 0 && !IsAligned( data, block->output, data->outputChannelCount )) )
+            data->layoutErrorCount++;
+
+        /* the blocks of a batch are consecutive user buffers, in place */
+        if( i > 0 )
+        {
+            if( data->inputChannelCount > 0 && !IsContiguous( data, blocks[i-1].input,
+                    block->input, data->inputChannelCount, framesPerBlock ) )
+                data->layoutErrorCount++;
+
+            if( data->outputChannelCount > 0 && !IsContiguous( data, blocks[i-1].output,
+                    block->output, data->outputChannelCount, framesPerBlock ) )
+                data->layoutErrorCount++;
+        }
+
+        if( data->inputChannelCount > 0 )
+        {
+            if( fabs( block->timeInfo.inputBufferAdcTime
+                    - (blocks[0].timeInfo.inputBufferAdcTime + i * blockDuration) ) > 1e-9 )
+                data->layoutErrorCount++;
+        }
+        else if( block->timeInfo.inputBufferAdcTime != 0 )
+        {
+            data->layoutErrorCount++;
+        }
+
+        if( data->outputChannelCount > 0 )
+        {
+            if( fabs( block->timeInfo.outputBufferDacTime
+                    - (blocks[0].timeInfo.outputBufferDacTime + i * blockDuration) ) > 1e-9 )
+                data->layoutErrorCount++;
+        }
+        else if( block->timeInfo.outputBufferDacTime != 0 )
+        {
+            data->layoutErrorCount++;
+        }
+
+        ProcessBlock( data, block->input, block->output, framesPerBlock );
+    }
+
+    if( ++data->batchCount == data->stopBatchCount )
+    {
+        /* the output of an aborted batch is discarded */
+        data->stopOutputFrame = ( data->stopResult == paAbort )
+                ? data->outputFrame - blockCount * framesPerBlock : data->outputFrame;
+        return data->stopResult;
+    }
+
+    return paContinue;
+}
+
+
+static int TestStreamCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    ProcessBlock( data, input, output, frameCount );
+    data->streamCallbackCount++;
+
+    return paContinue;
+}
+
+
+/* varies the host buffer size for the variable host buffer size modes */
+static unsigned long GetHostFrameCount( const SizeTest *sizeTest, int buffer )
+{
+    static const unsigned long unknownSizes[] = { 480, 1, 2000, 333, 1024, 77, 1500 };
+
+    switch( sizeTest->hostBufferSizeMode )
+    {
+    case paUtilFixedHostBufferSize:
+        return sizeTest->framesPerHostBuffer;
+    case paUtilBoundedHostBufferSize:
+        return sizeTest->framesPerHostBuffer - (buffer * 37) % sizeTest->framesPerHostBuffer;
+    default:
+        return unknownSizes[ buffer % (sizeof(unknownSizes) / sizeof(unknownSizes[0])) ];
+    }
+}
+
+
+/* Sets frameCount interleaved frames of the host buffers, starting at frame,
+    as the 1st host buffer, or as the 2nd host buffer if isSecond is non-zero. */
+static void SetHostBuffers( PaUtilBufferProcessor *bp, int isSecond,
+        int inputChannelCount, PaInt16 *hostInput,
+        int outputChannelCount, PaInt16 *hostOutput,
+        unsigned long frame, unsigned long frameCount )
+{
+    int c;
+
+    if( inputChannelCount > 0 )
+    {
+        if( isSecond )
+            PaUtil_Set2ndInputFrameCount( bp, frameCount );
+        else
+            PaUtil_SetInputFrameCount( bp, frameCount );
+
+        for( c = 0; c < inputChannelCount; ++c )
+        {
+            PaInt16 *data = hostInput + frame * inputChannelCount + c;
+            if( isSecond )
+                PaUtil_Set2ndInputChannel( bp, c, data, inputChannelCount );
+            else
+                PaUtil_SetInputChannel( bp, c, data, inputChannelCount );
+        }
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        if( isSecond )
+            PaUtil_Set2ndOutputFrameCount( bp, frameCount );
+        else
+            PaUtil_SetOutputFrameCount( bp, frameCount );
+
+        for( c = 0; c < outputChannelCount; ++c )
+        {
+            PaInt16 *data = hostOutput + frame * outputChannelCount + c;
+            if( isSecond )
+                PaUtil_Set2ndOutputChannel( bp, c, data, outputChannelCount );
+            else
+                PaUtil_SetOutputChannel( bp, c, data, outputChannelCount );
+        }
+    }
+}
+
+
+/* Passes HOST_BUFFER_COUNT host buffers through a buffer processor with a
+    batched callback and checks that the user input and host output streams
+    are intact. The host output stream starts with the initial frames of
+    silence, and is silent after the callback has returned stopResult. */
+static int TestStreams( const SizeTest *sizeTest, int inputChannelCount, int outputChannelCount,
+        int userIsInterleaved, int splitHostBuffers, int stopBatchCount, int stopResult )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    static PaInt16 hostInput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    static PaInt16 hostOutput[STREAM_FRAMES * CHANNEL_COUNT];
+    PaSampleFormat userFormat = paInt32 | (userIsInterleaved ? 0 : paNonInterleaved);
+    CallbackData data;
+    unsigned long hostFrame = 0; /* index of the next host frame of the streams */
+    unsigned long initialOutputFrames, outputFramesExpected;
+    unsigned long frameCount, firstFrameCount, framesProcessed, i;
+    int buffer, c, callbackResult = paContinue;
+    int outputErrorCount = 0, frameCountErrorCount = 0;
+
+    memset( &data, 0, sizeof(data) );
+    data.inputChannelCount = inputChannelCount;
+    data.outputChannelCount = outputChannelCount;
+    data.userIsInterleaved = userIsInterleaved;
+    data.stopBatchCount = stopBatchCount;
+    data.stopResult = stopResult;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            inputChannelCount, userFormat, paInt16,
+            outputChannelCount, userFormat, paInt16,
+            SAMPLE_RATE, paClipOff | paDitherOff | paBatchUserBuffers,
+            sizeTest->framesPerUserBuffer, sizeTest->framesPerHostBuffer,
+            sizeTest->hostBufferSizeMode, TestStreamCallback, &data ) );
+    ASSERT_EQ( paNoError, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor,
+            TestBatchCallback ) );
+
+    data.alignment = PaUtil_GetBufferProcessorBufferAlignment( &bufferProcessor );
+    data.initialInputFrames = PaUtil_GetBufferProcessorInputLatencyFrames( &bufferProcessor );
+    initialOutputFrames = PaUtil_GetBufferProcessorOutputLatencyFrames( &bufferProcessor );
+    memset( hostOutput, 0x55, sizeof(hostOutput) );
+
+    for( buffer = 0; buffer < HOST_BUFFER_COUNT; ++buffer )
+    {
+        frameCount = GetHostFrameCount( sizeTest, buffer );
+
+        for( i = 0; i < frameCount; ++i )
+        {
+            for( c = 0; c < inputChannelCount; ++c )
+                hostInput[i * inputChannelCount + c] = SampleValue( hostFrame + i, c );
+        }
+
+        timeInfo.inputBufferAdcTime = hostFrame / SAMPLE_RATE;
+        timeInfo.outputBufferDacTime = hostFrame / SAMPLE_RATE + 1.;
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+
+        /* split the host buffer as if it wrapped around a ring buffer */
+        firstFrameCount = ( splitHostBuffers && frameCount > 1 ) ? frameCount / 3 + 1 : frameCount;
+        SetHostBuffers( &bufferProcessor, 0, inputChannelCount, hostInput,
+                outputChannelCount, hostOutput + hostFrame * outputChannelCount,
+                0, firstFrameCount );
+        if( firstFrameCount < frameCount )
+        {
+            SetHostBuffers( &bufferProcessor, 1, inputChannelCount, hostInput,
+                    outputChannelCount, hostOutput + hostFrame * outputChannelCount,
+                    firstFrameCount, frameCount - firstFrameCount );
+        }
+
+        framesProcessed = PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+        if( framesProcessed != frameCount )
+            frameCountErrorCount++;
+
+        hostFrame += frameCount;
+    }
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    outputFramesExpected = initialOutputFrames
+            + ( stopBatchCount > 0 ? data.stopOutputFrame : hostFrame );
+
+    for( i = 0; i < hostFrame; ++i )
+    {
+        for( c = 0; c < outputChannelCount; ++c )
+        {
+            PaInt16 expected = ( i < initialOutputFrames || i >= outputFramesExpected )
+                    ? 0 : SampleValue( i - initialOutputFrames, c );
+
+            if( hostOutput[i * outputChannelCount + c] != expected )
+                outputErrorCount++;
+        }
+    }
+
+    if( outputErrorCount || data.inputErrorCount || data.layoutErrorCount || frameCountErrorCount )
+    {
+        printf( "  user %lu host %lu mode %d, %d in %d out, user %sinterleaved%s%s\n",
+                sizeTest->framesPerUserBuffer, sizeTest->framesPerHostBuffer,
+                (int)sizeTest->hostBufferSizeMode, inputChannelCount, outputChannelCount,
+                userIsInterleaved ? "" : "non-", splitHostBuffers ? ", split" : "",
+                stopBatchCount ? (stopResult == paAbort ? ", abort" : ", complete") : "" );
+    }
+
+    EXPECT_EQ( 0, frameCountErrorCount );
+    EXPECT_EQ( 0, data.inputErrorCount );
+    EXPECT_EQ( 0, outputErrorCount );
+    EXPECT_EQ( 0, data.layoutErrorCount );
+    EXPECT_EQ( 0, data.streamCallbackCount );
+    EXPECT_GT( data.batchCount, 0 );
+
+    /* host buffers which hold whole user buffers are passed in one batch each */
+    if( sizeTest->expectedBlockCount > 0 && stopBatchCount == 0 )
+    {
+        EXPECT_EQ( HOST_BUFFER_COUNT, data.batchCount );
+        EXPECT_EQ( (int)sizeTest->expectedBlockCount, (int)data.minBlockCount );
+        EXPECT_EQ( (int)sizeTest->expectedBlockCount, (int)data.maxBlockCount );
+    }
+    if( stopBatchCount > 0 )
+        EXPECT_EQ( stopBatchCount, data.batchCount );
+
+    return 0;
+
+error:
+    return -1;
+}
+
+
+static void TestAllSizes( void )
+{
+    int s, direction, userIsInterleaved, split;
+
+    printf( "Testing the streams of batched callbacks.\n" );
+
+    for( s = 0; s < SIZE_TEST_COUNT; ++s )
+    {
+        for( direction = 0; direction < 3; ++direction )
+        {
+            int inputChannelCount = ( direction != 1 ) ? CHANNEL_COUNT : 0;
+            int outputChannelCount = ( direction != 0 ) ? CHANNEL_COUNT : 0;
+
+            for( userIsInterleaved = 0; userIsInterleaved < 2; ++userIsInterleaved )
+                for( split = 0; split < 2; ++split )
+                    TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                            userIsInterleaved, split, 0, paContinue );
+
+            TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                    1, 1, 3, paComplete );
+            TestStreams( &sizeTests_[s], inputChannelCount, outputChannelCount,
+                    0, 0, 3, paAbort );
+        }
+    }
+}
+
+
+/* Checks when the batch callback can be set, and that clearing it restores
+    the stream callback. */
+static int TestSetBatchCallback( void )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    static PaInt16 hostOutput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    CallbackData data;
+    int callbackResult = paContinue;
+
+    printf( "Testing PaUtil_SetBufferProcessorBatchCallback().\n" );
+
+    memset( &data, 0, sizeof(data) );
+    data.outputChannelCount = CHANNEL_COUNT;
+    data.userIsInterleaved = 1;
+
+    /* without paBatchUserBuffers */
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paInt32, paInt16, CHANNEL_COUNT, paInt32, paInt16,
+            SAMPLE_RATE, paClipOff | paDitherOff, 64, 2048,
+            paUtilFixedHostBufferSize, TestStreamCallback, &data ) );
+    EXPECT_EQ( paInvalidFlag, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor,
+            TestBatchCallback ) );
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    /* with paBatchUserBuffers but with any user buffer size */
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paInt32, paInt16, CHANNEL_COUNT, paInt32, paInt16,
+            SAMPLE_RATE, paClipOff | paDitherOff | paBatchUserBuffers, 0, 2048,
+            paUtilFixedHostBufferSize, TestStreamCallback, &data ) );
+    EXPECT_EQ( paInvalidFlag, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor,
+            TestBatchCallback ) );
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paInt32, paInt16, CHANNEL_COUNT, paInt32, paInt16,
+            SAMPLE_RATE, paClipOff | paDitherOff | paBatchUserBuffers, 64, 2048,
+            paUtilFixedHostBufferSize, TestStreamCallback, &data ) );
+    EXPECT_EQ( paNoError, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor,
+            TestBatchCallback ) );
+    data.alignment = PaUtil_GetBufferProcessorBufferAlignment( &bufferProcessor );
+
+    /* routing changes the user buffers behind the batch callback's back */
+    EXPECT_EQ( paInvalidFlag, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 0, NULL, 0 ) );
+
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    SetHostBuffers( &bufferProcessor, 0, 0, NULL, CHANNEL_COUNT, hostOutput, 0, 2048 );
+    PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+    EXPECT_EQ( 1, data.batchCount );
+    EXPECT_EQ( 32, (int)data.maxBlockCount );
+    EXPECT_EQ( 0, data.streamCallbackCount );
+
+    EXPECT_EQ( paNoError, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor, NULL ) );
+
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    SetHostBuffers( &bufferProcessor, 0, 0, NULL, CHANNEL_COUNT, hostOutput, 0, 2048 );
+    PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+    EXPECT_EQ( 1, data.batchCount );
+    EXPECT_EQ( 32, data.streamCallbackCount );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    return 0;
+
+error:
+    return -1;
+}
+
+
+/* Copies the packed Int24 input of each block to its output. */
+static int CopyInt24BatchCallback( const PaStreamCallbackBlock *blocks, unsigned long blockCount,
+        unsigned long framesPerBlock, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    unsigned long i;
+    (void)statusFlags;
+
+    ++data->batchCount;
+    if( data->batchCount == 1 || blockCount < data->minBlockCount )
+        data->minBlockCount = blockCount;
+    if( blockCount > data->maxBlockCount )
+        data->maxBlockCount = blockCount;
+
+    for( i = 0; i < blockCount; ++i )
+    {
+        if( (size_t)blocks[i].input % data->alignment != 0
+                || (size_t)blocks[i].output % data->alignment != 0 )
+            data->layoutErrorCount++;
+
+        memcpy( blocks[i].output, blocks[i].input, framesPerBlock * INT24_CHANNEL_COUNT * 3 );
+    }
+
+    return paContinue;
+}
+
+
+/* Checks that user buffers whose size isn't a multiple of the alignment, of
+    3 channels of packed Int24, are still passed in batches of every user
+    buffer in the host buffer. */
+static int TestUnalignedInt24Batches( void )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    static unsigned char hostInput[INT24_HOST_FRAMES * INT24_CHANNEL_COUNT * 3];
+    static unsigned char hostOutput[INT24_HOST_FRAMES * INT24_CHANNEL_COUNT * 3];
+    CallbackData data;
+    unsigned long i;
+    int buffer, callbackResult = paContinue, outputErrorCount = 0;
+
+    printf( "Testing batches of unaligned Int24 user buffers.\n" );
+
+    memset( &data, 0, sizeof(data) );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            INT24_CHANNEL_COUNT, paInt24, paInt24, INT24_CHANNEL_COUNT, paInt24, paInt24,
+            SAMPLE_RATE, paClipOff | paDitherOff | paBatchUserBuffers,
+            INT24_USER_FRAMES, INT24_HOST_FRAMES, paUtilFixedHostBufferSize,
+            TestStreamCallback, &data ) );
+    ASSERT_EQ( paNoError, PaUtil_SetBufferProcessorBatchCallback( &bufferProcessor,
+            CopyInt24BatchCallback ) );
+    data.alignment = PaUtil_GetBufferProcessorBufferAlignment( &bufferProcessor );
+    EXPECT_TRUE( (INT24_USER_FRAMES * INT24_CHANNEL_COUNT * 3) % data.alignment != 0 );
+
+    for( buffer = 0; buffer < HOST_BUFFER_COUNT; ++buffer )
+    {
+        for( i = 0; i < sizeof(hostInput); ++i )
+            hostInput[i] = (unsigned char)(i * 13 + buffer * 7);
+        memset( hostOutput, 0x55, sizeof(hostOutput) );
+
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bufferProcessor, INT24_HOST_FRAMES );
+        PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, hostInput, INT24_CHANNEL_COUNT );
+        PaUtil_SetOutputFrameCount( &bufferProcessor, INT24_HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bufferProcessor, 0, hostOutput, INT24_CHANNEL_COUNT );
+        EXPECT_EQ( INT24_HOST_FRAMES, (int)PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult ) );
+
+        if( memcmp( hostInput, hostOutput, sizeof(hostInput) ) != 0 )
+            outputErrorCount++;
+    }
+
+    EXPECT_EQ( 0, outputErrorCount );
+    EXPECT_EQ( 0, data.layoutErrorCount );
+    EXPECT_EQ( 0, data.streamCallbackCount );
+    EXPECT_EQ( HOST_BUFFER_COUNT, data.batchCount );
+    EXPECT_EQ( INT24_HOST_FRAMES / INT24_USER_FRAMES, (int)data.minBlockCount );
+    EXPECT_EQ( INT24_HOST_FRAMES / INT24_USER_FRAMES, (int)data.maxBlockCount );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    return 0;
+
+error:
+    return -1;
+}
+
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestAllSizes();
+    TestSetBatchCallback();
+    TestUnalignedInt24Batches();
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,232 @@
+/** @file paqa_buffer_alignment.c
+    @ingroup qa_src
+    @brief Tests the alignment of the buffers which the buffer processor in
+    pa_process.c passes to the stream callback.
+
+    Link with pa_process.c, pa_dither.c, pa_converters.c and pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (44100.0)
+#define CHANNEL_COUNT       (3)
+#define MAX_FRAMES          (8192)
+
+/* room to move the host buffers to any offset from a cache line */
+#define HOST_BUFFER_PADDING (32)
+
+typedef struct AlignmentTestData
+{
+    unsigned long alignment;
+    const char *hostInputBegin;
+    const char *hostInputEnd;
+    int callbackCount;
+    int misalignedCount;
+    int directCount;
+} AlignmentTestData;
+
+static int IsAligned( const void *p, unsigned long alignment )
+{
+    return ((size_t)p & (alignment - 1)) == 0;
+}
+
+/* Return the first address in buffer which is offsetBytes past a cache line. */
+static float *OffsetFromCacheLine( float *buffer, unsigned long offsetBytes )
+{
+    char *p = (char*)buffer;
+    p += (64 - ((size_t)p & 63)) & 63;
+    return (float*)(p + offsetBytes);
+}
+
+/* Check that every non-interleaved channel pointer is aligned, count the
+ callbacks which were passed the host buffers directly, and copy the input to
+ the output. */
+static int CheckAlignmentCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    AlignmentTestData *data = (AlignmentTestData*)userData;
+    const float **in = (const float**)input;
+    float **out = (float**)output;
+    int c;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    for( c = 0; c < CHANNEL_COUNT; ++c )
+    {
+        if( !IsAligned( in[c], data->alignment ) || !IsAligned( out[c], data->alignment ) )
+            ++data->misalignedCount;
+
+        memcpy( out[c], in[c], frameCount * sizeof(float) );
+    }
+
+    if( (const char*)in[0] >= data->hostInputBegin && (const char*)in[0] < data->hostInputEnd )
+        ++data->directCount;
+
+    ++data->callbackCount;
+    return paContinue;
+}
+
+/* Process full-duplex non-interleaved Float32 buffers through the buffer
+ processor. When hostFormat is paFloat32 the host buffers are passed to the
+ callback directly whatever their alignment, so they are placed
+ hostOffsetBytes past a cache line. The reported alignment must be expectedAlignment, and
+ must hold for every buffer passed to the callback. */
+static int TestAlignment( PaSampleFormat hostFormat, unsigned long framesPerUserBuffer,
+        unsigned long framesPerHostBuffer, unsigned long hostOffsetBytes, unsigned long expectedAlignment )
+{
+    static float hostInputBuffer[CHANNEL_COUNT][MAX_FRAMES + HOST_BUFFER_PADDING];
+    static float hostOutputBuffer[CHANNEL_COUNT][MAX_FRAMES + HOST_BUFFER_PADDING];
+    static PaInt16 hostInput16[CHANNEL_COUNT][MAX_FRAMES];
+    static PaInt16 hostOutput16[CHANNEL_COUNT][MAX_FRAMES];
+    float *hostInput[CHANNEL_COUNT];
+    float *hostOutput[CHANNEL_COUNT];
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    AlignmentTestData data;
+    int callbackResult = paContinue;
+    int c, bpInitialized = 0;
+    unsigned long i, mismatches = 0;
+
+    printf( "Testing alignment with host format 0x%02lx, %lu user frames, %lu host frames, host offset %lu.\n",
+            (unsigned long)hostFormat, framesPerUserBuffer, framesPerHostBuffer, hostOffsetBytes );
+
+    memset( &data, 0, sizeof(data) );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            CHANNEL_COUNT, paFloat32 | paNonInterleaved, hostFormat | paNonInterleaved,
+            CHANNEL_COUNT, paFloat32 | paNonInterleaved, hostFormat | paNonInterleaved,
+            SAMPLE_RATE, paClipOff | paDitherOff, framesPerUserBuffer, framesPerHostBuffer,
+            paUtilFixedHostBufferSize, CheckAlignmentCallback, &data ) );
+    bpInitialized = 1;
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    data.alignment = PaUtil_GetBufferProcessorBufferAlignment( &bufferProcessor );
+    EXPECT_EQ( (int)expectedAlignment, (int)data.alignment );
+    EXPECT_EQ( 0, (int)(data.alignment & (data.alignment - 1)) );
+
+    data.hostInputBegin = (const char*)hostInputBuffer;
+    data.hostInputEnd = (const char*)hostInputBuffer + sizeof(hostInputBuffer);
+
+    for( c = 0; c < CHANNEL_COUNT; ++c )
+    {
+        hostInput[c] = OffsetFromCacheLine( hostInputBuffer[c], hostOffsetBytes );
+        hostOutput[c] = OffsetFromCacheLine( hostOutputBuffer[c], hostOffsetBytes );
+
+        for( i = 0; i < framesPerHostBuffer; ++i )
+        {
+            hostInput[c][i] = (float)(c * MAX_FRAMES + i) / (float)(CHANNEL_COUNT * MAX_FRAMES);
+            hostInput16[c][i] = (PaInt16)(c * 1000 + i);
+        }
+    }
+
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetInputFrameCount( &bufferProcessor, framesPerHostBuffer );
+    PaUtil_SetOutputFrameCount( &bufferProcessor, framesPerHostBuffer );
+    for( c = 0; c < CHANNEL_COUNT; ++c )
+    {
+        if( hostFormat == paFloat32 )
+        {
+            PaUtil_SetNonInterleavedInputChannel( &bufferProcessor, c, hostInput[c] );
+            PaUtil_SetNonInterleavedOutputChannel( &bufferProcessor, c, hostOutput[c] );
+        }
+        else
+        {
+            PaUtil_SetNonInterleavedInputChannel( &bufferProcessor, c, hostInput16[c] );
+            PaUtil_SetNonInterleavedOutputChannel( &bufferProcessor, c, hostOutput16[c] );
+        }
+    }
+    PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+
+    EXPECT_TRUE( data.callbackCount > 0 );
+    EXPECT_EQ( 0, data.misalignedCount );
+    /* matching host buffers are never copied, whatever their alignment */
+    EXPECT_EQ( hostFormat == paFloat32 ? data.callbackCount : 0, data.directCount );
+
+    /* the samples must pass through unchanged, apart from the rounding of
+        the Int16 to Float32 to Int16 round trip */
+    for( c = 0; c < CHANNEL_COUNT; ++c )
+    {
+        for( i = 0; i < framesPerHostBuffer; ++i )
+        {
+            if( hostFormat == paFloat32 ? hostOutput[c][i] != hostInput[c][i]
+                    : abs( hostOutput16[c][i] - hostInput16[c][i] ) > 1 )
+                ++mismatches;
+        }
+    }
+    EXPECT_EQ( 0, (int)mismatches );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    /* temp buffer channels of an odd size */
+    TestAlignment( paInt16, 0, 100, 0, 64 );
+    TestAlignment( paInt16, 37, 111, 0, 64 );
+    /* large enough to be page aligned */
+    TestAlignment( paInt16, 0, MAX_FRAMES, 0, 64 );
+    /* host buffers passed to the callback are only aligned to their samples,
+        even when they happen to be better aligned */
+    TestAlignment( paFloat32, 0, 100, 4, 4 );
+    TestAlignment( paFloat32, 25, 100, 4, 4 );
+    TestAlignment( paFloat32, 32, 128, 0, 4 );
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,415 @@
+/** @file paqa_converter_tiers.c
+    @ingroup qa_src
+    @brief Tests that the SIMD converter tiers in pa_converters_simd.c
+    produce the same output as the scalar converters in pa_converters.c.
+
+    Link with pa_dither.c, pa_converters.c and pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_converters_simd.h"
+#include "pa_dither.h"
+#include "pa_endianness.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define MAX_SAMPLES     (300)
+#define MAX_STRIDE      (3)
+#define BUFFER_BYTES    (MAX_SAMPLES * MAX_STRIDE * 4)
+
+typedef struct ConversionSpec
+{
+    PaSampleFormat sourceFormat;
+    PaSampleFormat destinationFormat;
+    PaStreamFlags flags;
+    const char *name;
+} ConversionSpec;
+
+/* the conversions which have SIMD implementations */
+static const ConversionSpec conversions_[] =
+{
+    { paFloat32, paInt32, paClipOff | paDitherOff, "Float32_To_Int32" },
+    { paFloat32, paInt32, paClipOff, "Float32_To_Int32_Dither" },
+    { paFloat32, paInt32, paDitherOff, "Float32_To_Int32_Clip" },
+    { paFloat32, paInt32, paNoFlag, "Float32_To_Int32_DitherClip" },
+    { paFloat32, paInt24, paClipOff | paDitherOff, "Float32_To_Int24" },
+    { paFloat32, paInt24, paClipOff, "Float32_To_Int24_Dither" },
+    { paFloat32, paInt24, paDitherOff, "Float32_To_Int24_Clip" },
+    { paFloat32, paInt24, paNoFlag, "Float32_To_Int24_DitherClip" },
+    { paFloat32, paInt16, paClipOff | paDitherOff, "Float32_To_Int16" },
+    { paFloat32, paInt16, paClipOff, "Float32_To_Int16_Dither" },
+    { paFloat32, paInt16, paDitherOff, "Float32_To_Int16_Clip" },
+    { paFloat32, paInt16, paNoFlag, "Float32_To_Int16_DitherClip" },
+    { paInt32, paFloat32, paNoFlag, "Int32_To_Float32" },
+    { paInt24, paFloat32, paNoFlag, "Int24_To_Float32" },
+    { paInt16, paFloat32, paNoFlag, "Int16_To_Float32" }
+};
+
+#define NUM_CONVERSIONS     ((int)(sizeof(conversions_) / sizeof(conversions_[0])))
+
+static const PaConverterTier tiers_[] =
+{
+    paConverterTierSSE2, paConverterTierAVX2, paConverterTierAVX512, paConverterTierNEON
+};
+
+#define NUM_TIERS       ((int)(sizeof(tiers_) / sizeof(tiers_[0])))
+
+static const char *GetTierName( PaConverterTier tier )
+{
+    switch( tier )
+    {
+    case paConverterTierScalar: return "scalar";
+    case paConverterTierSSE2: return "SSE2";
+    case paConverterTierAVX2: return "AVX2";
+    case paConverterTierAVX512: return "AVX-512";
+    case paConverterTierNEON: return "NEON";
+    default: return "?";
+    }
+}
+
+/* Fill the source buffer with random samples. Float samples range from
+ -1.5 to +1.5 so that the clipping paths are exercised. */
+static void FillSource( unsigned char *buffer, PaSampleFormat format )
+{
+    PaUint32 seed = 22222;
+    int i;
+
+    if( format == paFloat32 )
+    {
+        float *samples = (float*)buffer;
+        for( i = 0; i < BUFFER_BYTES / 4; ++i )
+        {
+            seed = (seed * 196314165) + 907633515;
+            samples[i] = ((float)(seed >> 8) / (float)(1 << 24)) * 3.0f - 1.5f;
+        }
+        /* make sure the extreme values are hit */
+        samples[0] = 1.0f;
+        samples[1] = -1.0f;
+        samples[2] = 0.0f;
+    }
+    else
+    {
+        for( i = 0; i < BUFFER_BYTES; ++i )
+        {
+            seed = (seed * 196314165) + 907633515;
+            buffer[i] = (unsigned char)(seed >> 24);
+        }
+    }
+}
+
+static void Convert( PaUtilConverter *converter, const ConversionSpec *spec,
+        unsigned char *destination, int destinationStride,
+        unsigned char *source, int sourceStride, unsigned int count )
+{
+    PaUtilTriangularDitherGenerator ditherGenerator;
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+    memset( destination, 0xA5, BUFFER_BYTES );
+    FillSource( source, spec->sourceFormat );
+
+    (*converter)( destination, destinationStride, source, sourceStride, count, &ditherGenerator );
+}
+
+/* The scalar frame converters must only be selected for the installed tier
+ where they are faster than one call of the tier's converter per channel. */
+static void TestFrameConverterSelection( PaConverterTier tier )
+{
+    int c, interleave;
+
+    for( c = 0; c < NUM_CONVERSIONS; ++c )
+    {
+        const ConversionSpec *spec = &conversions_[c];
+        int int24 = spec->sourceFormat == paInt24 || spec->destinationFormat == paInt24;
+        int expectFrameConverter = tier == paConverterTierScalar
+                || (int24 && (tier == paConverterTierSSE2 || tier == paConverterTierNEON));
+
+        for( interleave = 0; interleave < 2; ++interleave )
+        {
+            PaUtilFrameConverter *frameConverter = PaUtil_SelectFrameConverter(
+                    spec->sourceFormat | (interleave ? paNonInterleaved : 0),
+                    spec->destinationFormat | (interleave ? 0 : paNonInterleaved), spec->flags );
+
+            EXPECT_EQ( expectFrameConverter, frameConverter != NULL );
+        }
+    }
+
+    /* copies are always done with a frame converter */
+    EXPECT_TRUE( PaUtil_SelectFrameConverter( paInt16 | paNonInterleaved, paInt16, paNoFlag ) != NULL );
+    EXPECT_TRUE( PaUtil_SelectFrameConverter( paFloat32, paFloat32 | paNonInterleaved, paNoFlag ) != NULL );
+}
+
+/* Compare the converters of a tier with the scalar converters for a range of
+ strides and counts, which cover the vector loops and the scalar tails. */
+static int TestTier( PaConverterTier tier, PaUtilConverter **scalarConverters )
+{
+    static unsigned char source[BUFFER_BYTES];
+    static unsigned char expected[BUFFER_BYTES];
+    static unsigned char actual[BUFFER_BYTES];
+    static const unsigned int counts[] = { 1, 3, 4, 7, 8, 15, 16, 17, 33, 63, 64, 65, 100, 129, 257, MAX_SAMPLES };
+    static const int strides[][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 3, 2 } };
+    int c, s, n;
+
+    printf( "Testing %s converters.\n", GetTierName( tier ) );
+
+    ASSERT_EQ( paNoError, PaUtil_SetConverterTier( tier ) );
+    ASSERT_EQ( (int)tier, (int)PaUtil_GetConverterTier() );
+
+    for( c = 0; c < NUM_CONVERSIONS; ++c )
+    {
+        const ConversionSpec *spec = &conversions_[c];
+        PaUtilConverter *converter = PaUtil_SelectConverter( spec->sourceFormat,
+                spec->destinationFormat, spec->flags );
+        int mismatches = 0;
+
+        ASSERT_TRUE( converter != NULL );
+
+        for( s = 0; s < (int)(sizeof(strides) / sizeof(strides[0])); ++s )
+        {
+            for( n = 0; n < (int)(sizeof(counts) / sizeof(counts[0])); ++n )
+            {
+                Convert( scalarConverters[c], spec, expected, strides[s][1],
+                        source, strides[s][0], counts[n] );
+                Convert( converter, spec, actual, strides[s][1],
+                        source, strides[s][0], counts[n] );
+
+                if( memcmp( expected, actual, BUFFER_BYTES ) != 0 )
+                {
+                    if( mismatches++ == 0 )
+                    {
+                        printf( "  %s differs from scalar, source stride %d, destination stride %d, count %u\n",
+                                spec->name, strides[s][0], strides[s][1], counts[n] );
+                    }
+                }
+            }
+        }
+
+        EXPECT_EQ( 0, mismatches );
+    }
+
+    TestFrameConverterSelection( tier );
+
+    return 0;
+error:
+    return -1;
+}
+
+static void TestTierSelection( void )
+{
+    PaConverterTier bestTier;
+    int t;
+
+    printf( "Testing converter tier selection.\n" );
+
+    EXPECT_EQ( paNoError, PaUtil_SetConverterTier( paConverterTierDefault ) );
+    bestTier = PaUtil_GetConverterTier();
+    EXPECT_TRUE( bestTier != paConverterTierDefault );
+    EXPECT_TRUE( PaUtil_IsConverterTierSupported( bestTier ) );
+    printf( "  default tier is %s\n", GetTierName( bestTier ) );
+
+    EXPECT_TRUE( PaUtil_IsConverterTierSupported( paConverterTierScalar ) );
+    EXPECT_TRUE( !PaUtil_IsConverterTierSupported( paConverterTierDefault ) );
+
+    for( t = 0; t < NUM_TIERS; ++t )
+    {
+        if( !PaUtil_IsConverterTierSupported( tiers_[t] ) )
+        {
+            EXPECT_EQ( paConverterTierNotSupported, PaUtil_SetConverterTier( tiers_[t] ) );
+            EXPECT_EQ( (int)bestTier, (int)PaUtil_GetConverterTier() );
+        }
+    }
+
+    EXPECT_EQ( paConverterTierNotSupported, PaUtil_SetConverterTier( (PaConverterTier)1000 ) );
+
+    /* converters installed by a host API must be preserved */
+    {
+        PaUtilConverter *original = paConverters.Float32_To_Int16;
+        paConverters.Float32_To_Int16 = paConverters.Copy_16_To_16;
+        EXPECT_EQ( paNoError, PaUtil_SetConverterTier( paConverterTierScalar ) );
+        EXPECT_TRUE( paConverters.Float32_To_Int16 == paConverters.Copy_16_To_16 );
+        EXPECT_EQ( paNoError, PaUtil_SetConverterTier( paConverterTierDefault ) );
+        EXPECT_TRUE( paConverters.Float32_To_Int16 == paConverters.Copy_16_To_16 );
+        paConverters.Float32_To_Int16 = original;
+    }
+}
+
+/* Compare the scalar Int24 converters, which have packed fast paths for unit
+ strides, with byte-wise little endian reference conversions. */
+static void TestInt24PackedPaths( void )
+{
+    static unsigned char source[BUFFER_BYTES];
+    static unsigned char actual[BUFFER_BYTES];
+    static unsigned char expected[BUFFER_BYTES];
+    static const unsigned int counts[] = { 1, 3, 4, 5, 8, 13, 64, 255 };
+    static const int strides[][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 } };
+    PaUtilConverter *int24ToInt32, *int16ToInt24, *float32ToInt24, *copy24;
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int s, n, mismatches = 0;
+    unsigned int i;
+
+    printf( "Testing packed Int24 converters.\n" );
+
+    PaUtil_SetConverterTier( paConverterTierScalar );
+    int24ToInt32 = PaUtil_SelectConverter( paInt24, paInt32, paNoFlag );
+    int16ToInt24 = PaUtil_SelectConverter( paInt16, paInt24, paNoFlag );
+    float32ToInt24 = PaUtil_SelectConverter( paFloat32, paInt24, paClipOff | paDitherOff );
+    copy24 = PaUtil_SelectConverter( paInt24, paInt24, paNoFlag );
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+
+    for( s = 0; s < (int)(sizeof(strides) / sizeof(strides[0])); ++s )
+    {
+        int sourceStride = strides[s][0], destinationStride = strides[s][1];
+
+        for( n = 0; n < (int)(sizeof(counts) / sizeof(counts[0])); ++n )
+        {
+            unsigned int count = counts[n];
+
+            /* Int24 to Int32 */
+            FillSource( source, paInt24 );
+            memset( actual, 0xA5, BUFFER_BYTES );
+            memset( expected, 0xA5, BUFFER_BYTES );
+            (*int24ToInt32)( actual, destinationStride, source, sourceStride, count, &ditherGenerator );
+            for( i = 0; i < count; ++i )
+            {
+                const unsigned char *src = &source[i * sourceStride * 3];
+                PaInt32 temp = (PaInt32)(((PaUint32)src[0] << 8) | ((PaUint32)src[1] << 16) | ((PaUint32)src[2] << 24));
+                memcpy( &expected[i * destinationStride * 4], &temp, 4 );
+            }
+            if( memcmp( expected, actual, BUFFER_BYTES ) != 0 )
+                ++mismatches;
+
+            /* Int16 to Int24 */
+            memset( actual, 0xA5, BUFFER_BYTES );
+            memset( expected, 0xA5, BUFFER_BYTES );
+            (*int16ToInt24)( actual, destinationStride, source, sourceStride, count, &ditherGenerator );
+            for( i = 0; i < count; ++i )
+            {
+                unsigned char *dest = &expected[i * destinationStride * 3];
+                PaInt16 temp;
+                memcpy( &temp, &source[i * sourceStride * 2], 2 );
+                dest[0] = 0;
+                dest[1] = (unsigned char)temp;
+                dest[2] = (unsigned char)(temp >> 8);
+            }
+            if( memcmp( expected, actual, BUFFER_BYTES ) != 0 )
+                ++mismatches;
+
+            /* Copy Int24 */
+            memset( actual, 0xA5, BUFFER_BYTES );
+            memset( expected, 0xA5, BUFFER_BYTES );
+            (*copy24)( actual, destinationStride, source, sourceStride, count, &ditherGenerator );
+            for( i = 0; i < count; ++i )
+                memcpy( &expected[i * destinationStride * 3], &source[i * sourceStride * 3], 3 );
+            if( memcmp( expected, actual, BUFFER_BYTES ) != 0 )
+                ++mismatches;
+
+            /* Float32 to Int24 */
+            FillSource( source, paFloat32 );
+            memset( actual, 0xA5, BUFFER_BYTES );
+            memset( expected, 0xA5, BUFFER_BYTES );
+            (*float32ToInt24)( actual, destinationStride, source, sourceStride, count, &ditherGenerator );
+            for( i = 0; i < count; ++i )
+            {
+                unsigned char *dest = &expected[i * destinationStride * 3];
+                float sample = ((float*)source)[i * sourceStride];
+                PaInt32 temp;
+                if( sample > 1.0f || sample < -1.0f )
+                {
+                    /* out of range samples are undefined without clipping */
+                    memcpy( dest, &actual[i * destinationStride * 3], 3 );
+                    continue;
+                }
+                temp = (PaInt32)((double)sample * 2147483647.0);
+                dest[0] = (unsigned char)(temp >> 8);
+                dest[1] = (unsigned char)(temp >> 16);
+                dest[2] = (unsigned char)(temp >> 24);
+            }
+            if( memcmp( expected, actual, BUFFER_BYTES ) != 0 )
+                ++mismatches;
+        }
+    }
+
+    EXPECT_EQ( 0, mismatches );
+
+    PaUtil_SetConverterTier( paConverterTierDefault );
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    PaUtilConverter *scalarConverters[NUM_CONVERSIONS];
+    int c, t;
+    (void)argc;
+    (void)argv;
+
+    TestTierSelection();
+#if defined(PA_LITTLE_ENDIAN)
+    TestInt24PackedPaths();
+#endif
+
+    ASSERT_EQ( paNoError, PaUtil_SetConverterTier( paConverterTierScalar ) );
+    for( c = 0; c < NUM_CONVERSIONS; ++c )
+    {
+        scalarConverters[c] = PaUtil_SelectConverter( conversions_[c].sourceFormat,
+                conversions_[c].destinationFormat, conversions_[c].flags );
+        ASSERT_TRUE( scalarConverters[c] != NULL );
+    }
+    TestFrameConverterSelection( paConverterTierScalar );
+
+    for( t = 0; t < NUM_TIERS; ++t )
+    {
+        if( PaUtil_IsConverterTierSupported( tiers_[t] ) )
+            TestTier( tiers_[t], scalarConverters );
+        else
+            printf( "Skipping %s converters, not supported.\n", GetTierName( tiers_[t] ) );
+    }
+
+    PaUtil_SetConverterTier( paConverterTierDefault );
+
+error:
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -459,11 +459,167 @@ int TestAllDitherClipping( void )
     return 0;
 }
 
+#define BLOCK_TEST_NUM_SAMPLES (4 * 1024)
+/**
+ * Check that the block dither generators produce exactly the same reproducible
+ * sequence as the single value generators, for any mix of block sizes.
+ */
+int TestDitherBlockGenerator( void )
+{
+    static const unsigned long kBlockSizes[] = { 1, 3, 7, 8, 9, 63, 64, 65, 200 };
+    const int kNumBlockSizes = sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+    PaUtilTriangularDitherGenerator serialState;
+    PaUtilTriangularDitherGenerator blockState;
+    PaInt32 expected16[BLOCK_TEST_NUM_SAMPLES];
+    PaInt32 actual16[BLOCK_TEST_NUM_SAMPLES];
+    float expectedFloat[BLOCK_TEST_NUM_SAMPLES];
+    float actualFloat[BLOCK_TEST_NUM_SAMPLES];
+    int mismatches16 = 0;
+    int mismatchesFloat = 0;
+    int i, blockSizeIndex = 0;
+    unsigned long position = 0;
+
+    printf(" ============= Block dither generator ============== \n");
+
+    PaUtil_InitializeTriangularDitherState( &serialState );
+    for (i = 0; i < BLOCK_TEST_NUM_SAMPLES; i++) {
+        expected16[i] = PaUtil_Generate16BitTriangularDither( &serialState );
+    }
+    for (i = 0; i < BLOCK_TEST_NUM_SAMPLES; i++) {
+        expectedFloat[i] = PaUtil_GenerateFloatTriangularDither( &serialState );
+    }
+
+    /* Generate the same sequence using a mix of block sizes, interleaved with
+     * single value calls. */
+    PaUtil_InitializeTriangularDitherState( &blockState );
+    while (position < BLOCK_TEST_NUM_SAMPLES) {
+        unsigned long count = kBlockSizes[blockSizeIndex++ % kNumBlockSizes];
+        if (count > BLOCK_TEST_NUM_SAMPLES - position) {
+            count = BLOCK_TEST_NUM_SAMPLES - position;
+        }
+        PaUtil_Generate16BitTriangularDitherBlock( &blockState, &actual16[position], count );
+        position += count;
+        if (position < BLOCK_TEST_NUM_SAMPLES) {
+            actual16[position++] = PaUtil_Generate16BitTriangularDither( &blockState );
+        }
+    }
+    PaUtil_GenerateFloatTriangularDitherBlock( &blockState, actualFloat, BLOCK_TEST_NUM_SAMPLES );
+
+    for (i = 0; i < BLOCK_TEST_NUM_SAMPLES; i++) {
+        if (actual16[i] != expected16[i]) mismatches16++;
+        if (actualFloat[i] != expectedFloat[i]) mismatchesFloat++;
+    }
+    EXPECT_EQ(mismatches16, 0);
+    EXPECT_EQ(mismatchesFloat, 0);
+    return 0;
+}
+
+#define NOISE_SHAPING_NUM_SAMPLES (16 * 1024)
+#define NOISE_SHAPING_WINDOW 16
+/**
+ * Convert a slow sine wave to paInt16 and return the power of the
+ * requantization error after averaging over NOISE_SHAPING_WINDOW samples,
+ * which is a rough measure of the noise floor at low frequencies.
+ * The overall mean error is returned in *meanError.
+ */
+static double MeasureLowFrequencyNoise(PaSampleFormat sourceFormat,
+                                       PaStreamFlags streamFlags,
+                                       double *meanError) {
+    static char source[NOISE_SHAPING_NUM_SAMPLES * sizeof(PaInt32)];
+    static PaInt16 destination[NOISE_SHAPING_NUM_SAMPLES];
+    static double expected[NOISE_SHAPING_NUM_SAMPLES];
+    PaUtilTriangularDitherGenerator ditherState;
+    PaUtilConverter *converter;
+    double windowPower = 0.0;
+    double errorSum = 0.0;
+    int numWindows = 0;
+
+    for (int i = 0; i < NOISE_SHAPING_NUM_SAMPLES; i++) {
+        double value = 0.3 * sin(i * 0.001);
+        switch (sourceFormat) {
+            case paFloat32:
+                ((float *)source)[i] = (float)value;
+                expected[i] = ((float *)source)[i] * 32767.0;
+                break;
+            case paInt32:
+                ((PaInt32 *)source)[i] = (PaInt32)(value * 2147483647.0);
+                expected[i] = ((PaInt32 *)source)[i] / 65536.0;
+                break;
+            case paInt24: {
+                PaInt32 sample = (PaInt32)(value * 8388607.0);
+                unsigned char *dest = (unsigned char *)source + (i * 3);
+#if defined(PA_LITTLE_ENDIAN)
+                dest[0] = (unsigned char)sample;
+                dest[1] = (unsigned char)(sample >> 8);
+                dest[2] = (unsigned char)(sample >> 16);
+#elif defined(PA_BIG_ENDIAN)
+                dest[0] = (unsigned char)(sample >> 16);
+                dest[1] = (unsigned char)(sample >> 8);
+                dest[2] = (unsigned char)sample;
+#endif
+                expected[i] = sample / 256.0;
+                break;
+            }
+        }
+    }
+
+    PaUtil_InitializeTriangularDitherState( &ditherState );
+    converter = PaUtil_SelectConverter( sourceFormat, paInt16, streamFlags );
+    (*converter)( destination, 1, source, 1, NOISE_SHAPING_NUM_SAMPLES, &ditherState );
+
+    for (int i = 0; i + NOISE_SHAPING_WINDOW <= NOISE_SHAPING_NUM_SAMPLES; i += NOISE_SHAPING_WINDOW) {
+        double windowSum = 0.0;
+        for (int j = i; j < i + NOISE_SHAPING_WINDOW; j++) {
+            windowSum += destination[j] - expected[j];
+        }
+        errorSum += windowSum;
+        windowSum /= NOISE_SHAPING_WINDOW;
+        windowPower += windowSum * windowSum;
+        numWindows++;
+    }
+    *meanError = errorSum / (numWindows * NOISE_SHAPING_WINDOW);
+    return windowPower / numWindows;
+}
+
+/**
+ * Check that noise shaped dither lowers the low frequency noise floor
+ * compared to triangular dither, without introducing a DC offset.
+ */
+static int TestNoiseShapedDither(PaSampleFormat sourceFormat) {
+    double triangularMean, shapedMean;
+    double triangularNoise, shapedNoise;
+
+    printf(" ============= Noise shaping: %9s => %7s ============== \n",
+           MyPa_GetFormatName(sourceFormat), MyPa_GetFormatName(paInt16));
+
+    triangularNoise = MeasureLowFrequencyNoise(sourceFormat, paNoFlag, &triangularMean);
+    shapedNoise = MeasureLowFrequencyNoise(sourceFormat, paNoiseShapedDither, &shapedMean);
+    printf("triangular: noise = %f, mean = %f; noise shaped: noise = %f, mean = %f\n",
+           triangularNoise, triangularMean, shapedNoise, shapedMean);
+    EXPECT_TRUE((shapedNoise < (triangularNoise * 0.5)));
+    EXPECT_TRUE((fabs(shapedMean) < 0.01));
+    return 0;
+}
+
+int TestAllNoiseShapedDither( void )
+{
+    TestNoiseShapedDither(paFloat32);
+    TestNoiseShapedDither(paInt32);
+    TestNoiseShapedDither(paInt24);
+
+    /* noise shaping requires per-channel state, so it must not use a frame converter */
+    EXPECT_TRUE(PaUtil_SelectFrameConverter(paFloat32 | paNonInterleaved, paInt16,
+                                            paNoiseShapedDither) == NULL);
+    return 0;
+}
+
 int main( int argc, const char **argv )
 {
     ShowDitherDistribution();
+    TestDitherBlockGenerator();
     TestAllDitherScaling();
     TestAllDitherClipping();
+    TestAllNoiseShapedDither();
 
     PAQA_PRINT_RESULT;
     return PAQA_EXIT_RESULT;
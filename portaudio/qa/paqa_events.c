@@ -0,0 +1,404 @@
+/** @file paqa_events.c
+    @ingroup qa_src
+    @brief Tests the delivery of events posted with Pa_PostStreamEvent(),
+    using offline streams.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (48000.0)
+#define CHANNEL_COUNT       (2)
+#define HOST_BUFFER_FRAMES  (480)
+#define MAX_EVENTS          (16)
+
+
+typedef struct EventTestData
+{
+    long streamFrame;               /* the first frame of the next stream callback */
+    unsigned long callbackCount;
+    unsigned long pendingCount;     /* events delivered before the next stream callback */
+    unsigned long pendingOffsets[MAX_EVENTS];
+    unsigned long eventCount;
+    long eventFrames[MAX_EVENTS];   /* the frame each event was delivered at */
+    double eventValues[MAX_EVENTS];
+    unsigned long nonZeroOffsetCount;
+    long callbackFrames[64];        /* the first frame of each stream callback */
+} EventTestData;
+
+
+static void EventCallback( const PaStreamEvent *event, unsigned long frameOffset, void *userData )
+{
+    EventTestData *data = (EventTestData*)userData;
+
+    if( data->pendingCount < MAX_EVENTS && data->eventCount + data->pendingCount < MAX_EVENTS )
+    {
+        data->eventValues[data->eventCount + data->pendingCount] = event->value;
+        data->pendingOffsets[data->pendingCount++] = frameOffset;
+    }
+
+    if( frameOffset != 0 )
+        data->nonZeroOffsetCount++;
+}
+
+
+/* resolves the offsets of the events delivered since the last call against
+    the DAC time of this buffer */
+static int StreamCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    EventTestData *data = (EventTestData*)userData;
+    long bufferFrame = (long)floor( timeInfo->outputBufferDacTime * SAMPLE_RATE + .5 );
+    unsigned long i;
+    (void)input;
+    (void)statusFlags;
+
+    for( i = 0; i < data->pendingCount; ++i )
+        data->eventFrames[data->eventCount++] = bufferFrame + (long)data->pendingOffsets[i];
+    data->pendingCount = 0;
+
+    if( data->callbackCount < 64 )
+        data->callbackFrames[data->callbackCount] = bufferFrame;
+    data->callbackCount++;
+
+    memset( output, 0, frameCount * CHANNEL_COUNT * sizeof(float) );
+
+    return paContinue;
+}
+
+
+static PaError OpenStream( PaStream **stream, unsigned long framesPerBuffer,
+        PaStreamFlags flags, EventTestData *data )
+{
+    PaStreamParameters outputParameters;
+    PaOfflineStreamInfo streamInfo;
+
+    outputParameters.device = paNoDevice;
+    outputParameters.channelCount = CHANNEL_COUNT;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency = 0.;
+    outputParameters.hostApiSpecificStreamInfo = NULL;
+
+    streamInfo.size = sizeof(PaOfflineStreamInfo);
+    streamInfo.version = 1;
+    streamInfo.hostInputSampleFormat = paFloat32;
+    streamInfo.hostOutputSampleFormat = paFloat32;
+    streamInfo.framesPerHostBuffer = HOST_BUFFER_FRAMES;
+
+    memset( data, 0, sizeof(*data) );
+
+    return Pa_OpenOfflineStream( stream, NULL, &outputParameters, SAMPLE_RATE,
+            framesPerBuffer, flags, &streamInfo, StreamCallback, data );
+}
+
+
+static PaError PostEvent( PaStream *stream, long frame, double value )
+{
+    PaStreamEvent event;
+
+    event.time = frame / SAMPLE_RATE;
+    event.type = 0;
+    event.value = value;
+    event.data = NULL;
+
+    return Pa_PostStreamEvent( stream, &event );
+}
+
+
+static PaError Render( PaStream *stream, unsigned long frameCount )
+{
+    static float output[4096 * CHANNEL_COUNT];
+
+    return Pa_RenderOfflineStream( stream, NULL, output, frameCount );
+}
+
+
+/* With a fixed buffer size, events are delivered before the buffer they fall
+    in, with their offset into it. Events posted while the stream is stopped
+    are delivered once it is started. */
+static int TestFixedBufferOffsets( void )
+{
+    static const long eventFrames[] = { 0, 100, 255, 256, 300, 1000, 1023, 2000 };
+    const int eventCount = sizeof(eventFrames) / sizeof(eventFrames[0]);
+    PaStream *stream = NULL;
+    EventTestData data;
+    int i;
+
+    printf( "Testing event offsets with a fixed buffer size.\n" );
+
+    ASSERT_EQ( paNoError, OpenStream( &stream, 256, paNoFlag, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+
+    for( i = 0; i < eventCount; ++i )
+        ASSERT_EQ( paNoError, PostEvent( stream, eventFrames[i], i ) );
+
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    ASSERT_EQ( paNoError, Render( stream, 4096 ) );
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+
+    ASSERT_EQ( eventCount, (int)data.eventCount );
+    for( i = 0; i < eventCount; ++i )
+    {
+        EXPECT_EQ( (int)eventFrames[i], (int)data.eventFrames[i] );
+        EXPECT_EQ( i, (int)data.eventValues[i] );
+    }
+    EXPECT_GT( (int)data.nonZeroOffsetCount, 0 );
+
+    for( i = 0; i < 16; ++i )
+        EXPECT_EQ( i * 256, (int)data.callbackFrames[i] );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/* With paFramesPerBufferUnspecified the buffers are split at the events, so
+    each event is delivered at the start of a buffer. */
+static int TestUnspecifiedBufferSplitting( void )
+{
+    static const long eventFrames[] = { 100, 100, 479, 480, 700, 1500 };
+    const int eventCount = sizeof(eventFrames) / sizeof(eventFrames[0]);
+    PaStream *stream = NULL;
+    EventTestData data;
+    unsigned long i, j;
+
+    printf( "Testing buffer splitting with an unspecified buffer size.\n" );
+
+    ASSERT_EQ( paNoError, OpenStream( &stream, paFramesPerBufferUnspecified, paNoFlag, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+
+    for( i = 0; i < (unsigned long)eventCount; ++i )
+        ASSERT_EQ( paNoError, PostEvent( stream, eventFrames[i], (double)i ) );
+
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    ASSERT_EQ( paNoError, Render( stream, 4 * HOST_BUFFER_FRAMES ) );
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+
+    ASSERT_EQ( eventCount, (int)data.eventCount );
+    EXPECT_EQ( 0, (int)data.nonZeroOffsetCount );
+    for( i = 0; i < (unsigned long)eventCount; ++i )
+        EXPECT_EQ( (int)eventFrames[i], (int)data.eventFrames[i] );
+
+    /* the host buffers at 0, 480, 960 and 1440 are split at 100, 479, 700
+        and 1500 */
+    EXPECT_EQ( 8, (int)data.callbackCount );
+    for( i = 0; i < (unsigned long)eventCount; ++i )
+    {
+        int found = 0;
+        for( j = 0; j < data.callbackCount; ++j )
+        {
+            if( data.callbackFrames[j] == eventFrames[i] )
+                found = 1;
+        }
+        EXPECT_EQ( 1, found );
+    }
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/* Events whose time has passed are delivered at the start of the next buffer. */
+static int TestLateEvents( void )
+{
+    PaStream *stream = NULL;
+    EventTestData data;
+
+    printf( "Testing late events.\n" );
+
+    ASSERT_EQ( paNoError, OpenStream( &stream, 256, paNoFlag, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    ASSERT_EQ( paNoError, Render( stream, 1024 ) );
+
+    ASSERT_EQ( paNoError, PostEvent( stream, 0, 1. ) );
+    ASSERT_EQ( paNoError, PostEvent( stream, 500, 2. ) );
+    ASSERT_EQ( paNoError, Render( stream, 1024 ) );
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+
+    ASSERT_EQ( 2, (int)data.eventCount );
+    EXPECT_EQ( 0, (int)data.nonZeroOffsetCount );
+    EXPECT_EQ( (int)data.eventFrames[0], (int)data.eventFrames[1] );
+    EXPECT_GT( (int)data.eventFrames[0], 500 );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+static int TestQueueFull( void )
+{
+    PaStream *stream = NULL;
+    EventTestData data;
+    int i;
+
+    printf( "Testing a full event queue.\n" );
+
+    ASSERT_EQ( paNoError, OpenStream( &stream, 256, paNoFlag, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, 3 ) );
+
+    for( i = 0; i < 3; ++i )
+        EXPECT_EQ( paNoError, PostEvent( stream, 0, i ) );
+    EXPECT_EQ( paStreamEventQueueFull, PostEvent( stream, 0, 3. ) );
+
+    /* delivering the events makes room for more */
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    ASSERT_EQ( paNoError, Render( stream, 512 ) );
+    EXPECT_EQ( 3, (int)data.eventCount );
+    EXPECT_EQ( paNoError, PostEvent( stream, 0, 4. ) );
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+static int BatchCallback( const PaStreamCallbackBlock *blocks, unsigned long blockCount,
+        unsigned long framesPerBlock, PaStreamCallbackFlags statusFlags, void *userData )
+{
+    (void)blocks;
+    (void)blockCount;
+    (void)framesPerBlock;
+    (void)statusFlags;
+    (void)userData;
+
+    return paContinue;
+}
+
+
+static int TestErrors( void )
+{
+    PaStream *stream = NULL;
+    EventTestData data;
+
+    printf( "Testing event errors.\n" );
+
+    ASSERT_EQ( paNoError, OpenStream( &stream, 256, paNoFlag, &data ) );
+    EXPECT_EQ( paNullCallback, PostEvent( stream, 0, 0. ) );
+    EXPECT_EQ( paBadBufferPtr, Pa_PostStreamEvent( stream, NULL ) );
+
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    EXPECT_EQ( paStreamIsNotStopped, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+
+    /* queue sizes are checked rather than clamped */
+    EXPECT_EQ( paBufferTooSmall, Pa_SetStreamEventCallback( stream, EventCallback, 0 ) );
+    EXPECT_EQ( paInsufficientMemory, Pa_SetStreamEventCallback( stream, EventCallback, 0x20000000UL ) );
+    EXPECT_EQ( paInsufficientMemory, Pa_SetStreamEventCallback( stream, EventCallback, (unsigned long)-1 ) );
+    EXPECT_EQ( paNullCallback, PostEvent( stream, 0, 0. ) );
+
+    /* removing the callback frees the queue */
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, NULL, 0 ) );
+    EXPECT_EQ( paNullCallback, PostEvent( stream, 0, 0. ) );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+    stream = NULL;
+
+    /* events can't be combined with a batch callback */
+    ASSERT_EQ( paNoError, OpenStream( &stream, 256, paBatchUserBuffers, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamBatchCallback( stream, BatchCallback ) );
+    EXPECT_EQ( paInvalidFlag, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamBatchCallback( stream, NULL ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamEventCallback( stream, EventCallback, MAX_EVENTS ) );
+    EXPECT_EQ( paInvalidFlag, Pa_SetStreamBatchCallback( stream, BatchCallback ) );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    ASSERT_EQ( paNoError, Pa_Initialize() );
+
+    TestFixedBufferOffsets();
+    TestUnspecifiedBufferSplitting();
+    TestLateEvents();
+    TestQueueFull();
+    TestErrors();
+
+    ASSERT_EQ( paNoError, Pa_Terminate() );
+
+error:
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,307 @@
+/** @file paqa_float64.c
+    @ingroup qa_src
+    @brief Tests the paFloat64 sample format support in pa_converters.c
+    and Pa_GetSampleSize().
+
+    Link with pa_dither.c, pa_converters.c and pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_dither.h"
+#include "pa_endianness.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define NUM_SAMPLES     (200)
+
+static const PaSampleFormat formats_[] =
+{
+    paFloat32, paInt32, paInt24, paInt16, paInt8, paUInt8
+};
+
+#define NUM_FORMATS     ((int)(sizeof(formats_) / sizeof(formats_[0])))
+
+static const PaStreamFlags flags_[] =
+{
+    paNoFlag, paClipOff, paDitherOff, paClipOff | paDitherOff, paNoiseShapedDither
+};
+
+#define NUM_FLAGS       ((int)(sizeof(flags_) / sizeof(flags_[0])))
+
+/* Return sample i of buffer as an integer, or scaled to the 32 bit range for
+ paFloat32. */
+static double GetSample( const void *buffer, PaSampleFormat format, int i )
+{
+    const unsigned char *p;
+
+    switch( format )
+    {
+    case paFloat32: return ((const float*)buffer)[i] * 2147483648.0;
+    case paInt32: return ((const PaInt32*)buffer)[i];
+    case paInt24:
+        p = (const unsigned char*)buffer + i * 3;
+#if defined(PA_LITTLE_ENDIAN)
+        return (PaInt32)(((PaUint32)p[0] << 8) | ((PaUint32)p[1] << 16) | ((PaUint32)p[2] << 24)) >> 8;
+#else
+        return (PaInt32)(((PaUint32)p[0] << 24) | ((PaUint32)p[1] << 16) | ((PaUint32)p[2] << 8)) >> 8;
+#endif
+    case paInt16: return ((const PaInt16*)buffer)[i];
+    case paInt8: return ((const signed char*)buffer)[i];
+    case paUInt8: return ((const unsigned char*)buffer)[i];
+    default: return 0;
+    }
+}
+
+static void FillSource( unsigned char *buffer, int bytes )
+{
+    PaUint32 seed = 22222;
+    int i;
+
+    for( i = 0; i < bytes; ++i )
+    {
+        seed = (seed * 196314165) + 907633515;
+        buffer[i] = (unsigned char)(seed >> 24);
+    }
+}
+
+static void TestSampleSize( void )
+{
+    printf( "Testing Pa_GetSampleSize.\n" );
+
+    EXPECT_EQ( 8, Pa_GetSampleSize( paFloat64 ) );
+    EXPECT_EQ( 8, Pa_GetSampleSize( paFloat64 | paNonInterleaved ) );
+    EXPECT_EQ( 4, Pa_GetSampleSize( paFloat32 ) );
+}
+
+static void TestClosestAvailableFormat( void )
+{
+    printf( "Testing PaUtil_SelectClosestAvailableFormat.\n" );
+
+    EXPECT_EQ( paFloat64, PaUtil_SelectClosestAvailableFormat( paFloat64 | paInt16, paFloat64 ) );
+    EXPECT_EQ( paFloat32, PaUtil_SelectClosestAvailableFormat( paFloat32 | paInt16, paFloat64 ) );
+    EXPECT_EQ( paInt32, PaUtil_SelectClosestAvailableFormat( paInt32 | paInt16, paFloat64 ) );
+    EXPECT_EQ( paInt16, PaUtil_SelectClosestAvailableFormat( paInt16, paFloat64 | paNonInterleaved ) );
+
+    /* paFloat64 is better than any other format */
+    EXPECT_EQ( paFloat64, PaUtil_SelectClosestAvailableFormat( paFloat64 | paInt8, paFloat32 ) );
+    EXPECT_EQ( paFloat64, PaUtil_SelectClosestAvailableFormat( paFloat64 | paInt8, paInt16 ) );
+    EXPECT_EQ( paFloat32, PaUtil_SelectClosestAvailableFormat( paFloat64 | paFloat32, paInt16 ) );
+    EXPECT_EQ( paFloat64, PaUtil_SelectClosestAvailableFormat( paFloat64, paUInt8 ) );
+}
+
+static void TestConverterSelection( void )
+{
+    int f, g;
+
+    printf( "Testing paFloat64 converter selection.\n" );
+
+    for( f = 0; f < NUM_FORMATS; ++f )
+    {
+        for( g = 0; g < NUM_FLAGS; ++g )
+        {
+            EXPECT_TRUE( PaUtil_SelectConverter( paFloat64, formats_[f], flags_[g] ) != NULL );
+            EXPECT_TRUE( PaUtil_SelectConverter( formats_[f], paFloat64, flags_[g] ) != NULL );
+        }
+
+        /* there are no paFloat64 frame converters */
+        EXPECT_TRUE( PaUtil_SelectFrameConverter( paFloat64 | paNonInterleaved, formats_[f], paNoFlag ) == NULL );
+        EXPECT_TRUE( PaUtil_SelectFrameConverter( formats_[f] | paNonInterleaved, paFloat64, paNoFlag ) == NULL );
+    }
+
+    EXPECT_TRUE( PaUtil_SelectConverter( paFloat64, paFloat64, paNoFlag ) == paConverters.Copy_64_To_64 );
+    EXPECT_TRUE( PaUtil_SelectConverter( paFloat64, paInt16, paNoiseShapedDither )
+            == paConverters.Float64_To_Int16_NoiseShaped );
+    EXPECT_TRUE( PaUtil_SelectZeroer( paFloat64 ) == paZeroers.Zero64 );
+}
+
+/* Convert each format to paFloat64 and back again. The result must be within
+ one LSB of the source, or three with dither, the same as the paFloat32
+ conversions. */
+static void TestRoundTrip( void )
+{
+    static unsigned char source[NUM_SAMPLES * 4];
+    static double intermediate[NUM_SAMPLES];
+    static unsigned char result[NUM_SAMPLES * 4];
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int f, g, i;
+
+    printf( "Testing paFloat64 round trip conversions.\n" );
+
+    for( f = 0; f < NUM_FORMATS; ++f )
+    {
+        PaSampleFormat format = formats_[f];
+        PaUtilConverter *toFloat64 = PaUtil_SelectConverter( format, paFloat64, paNoFlag );
+
+        FillSource( source, sizeof(source) );
+        if( format == paFloat32 )
+        {
+            /* random bit patterns aren't valid Float32 samples, so use a
+                16 bit signal converted to Float32 */
+            static PaInt16 int16Source[NUM_SAMPLES];
+            memcpy( int16Source, source, sizeof(int16Source) );
+            PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+            (*PaUtil_SelectConverter( paInt16, paFloat32, paNoFlag ))( source, 1, int16Source, 1, NUM_SAMPLES, &ditherGenerator );
+        }
+
+        PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+        (*toFloat64)( intermediate, 1, source, 1, NUM_SAMPLES, &ditherGenerator );
+
+        for( i = 0; i < NUM_SAMPLES; ++i )
+        {
+            if( intermediate[i] < -1.0 || intermediate[i] >= 1.0 )
+            {
+                EXPECT_TRUE( intermediate[i] >= -1.0 && intermediate[i] < 1.0 );
+                break;
+            }
+        }
+
+        for( g = 0; g < NUM_FLAGS; ++g )
+        {
+            PaUtilConverter *fromFloat64 = PaUtil_SelectConverter( paFloat64, format, flags_[g] );
+            double lsb = (format == paFloat32) ? 2147483648.0 / 32768.0 : 1.0;
+            double tolerance = (flags_[g] & paDitherOff) ? lsb : 3 * lsb;
+            int mismatches = 0;
+
+            if( format == paFloat32 )
+                tolerance = 0.; /* exact for samples which came from Float32 */
+
+            memset( result, 0, sizeof(result) );
+            PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+            (*fromFloat64)( result, 1, intermediate, 1, NUM_SAMPLES, &ditherGenerator );
+
+            for( i = 0; i < NUM_SAMPLES; ++i )
+            {
+                double difference = GetSample( result, format, i ) - GetSample( source, format, i );
+                if( difference > tolerance || difference < -tolerance )
+                {
+                    if( mismatches++ == 0 )
+                    {
+                        printf( "  format 0x%02lx flags 0x%02lx sample %d differs by %g\n",
+                                (unsigned long)format, (unsigned long)flags_[g], i, difference );
+                    }
+                }
+            }
+
+            EXPECT_EQ( 0, mismatches );
+        }
+    }
+}
+
+static void TestClipping( void )
+{
+    static const double source[] = { 1.5, -1.5, 1.0, -1.0, 0.0 };
+    static const double expected16[] = { 32767., -32768., 32767., -32767., 0. };
+    static const double expected8[] = { 127., -128., 127., -127., 0. };
+    static const double expectedU8[] = { 255., 0., 255., 1., 128. };
+    unsigned char result[sizeof(source) / sizeof(source[0]) * 4];
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int i, n = (int)(sizeof(source) / sizeof(source[0]));
+
+    printf( "Testing paFloat64 clipping.\n" );
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+
+    (*PaUtil_SelectConverter( paFloat64, paInt16, paDitherOff ))( result, 1, (void*)source, 1, n, &ditherGenerator );
+    for( i = 0; i < n; ++i )
+        EXPECT_EQ( (int)expected16[i], (int)GetSample( result, paInt16, i ) );
+
+    (*PaUtil_SelectConverter( paFloat64, paInt8, paDitherOff ))( result, 1, (void*)source, 1, n, &ditherGenerator );
+    for( i = 0; i < n; ++i )
+        EXPECT_EQ( (int)expected8[i], (int)GetSample( result, paInt8, i ) );
+
+    (*PaUtil_SelectConverter( paFloat64, paUInt8, paDitherOff ))( result, 1, (void*)source, 1, n, &ditherGenerator );
+    for( i = 0; i < n; ++i )
+        EXPECT_EQ( (int)expectedU8[i], (int)GetSample( result, paUInt8, i ) );
+
+    (*PaUtil_SelectConverter( paFloat64, paInt32, paDitherOff ))( result, 1, (void*)source, 1, n, &ditherGenerator );
+    EXPECT_TRUE( GetSample( result, paInt32, 0 ) == 2147483647. );
+    EXPECT_TRUE( GetSample( result, paInt32, 1 ) == -2147483648. );
+
+    (*PaUtil_SelectConverter( paFloat64, paInt24, paDitherOff ))( result, 1, (void*)source, 1, n, &ditherGenerator );
+    EXPECT_EQ( 8388607, (int)GetSample( result, paInt24, 0 ) );
+    EXPECT_EQ( -8388608, (int)GetSample( result, paInt24, 1 ) );
+}
+
+static void TestCopyAndZero( void )
+{
+    double source[8], destination[8];
+    int i;
+
+    printf( "Testing paFloat64 copy and zero.\n" );
+
+    for( i = 0; i < 8; ++i )
+    {
+        source[i] = i + 0.25;
+        destination[i] = -1.0;
+    }
+
+    /* copy every second sample of source into the start of destination */
+    (*paConverters.Copy_64_To_64)( destination, 1, source, 2, 4, NULL );
+    for( i = 0; i < 4; ++i )
+        EXPECT_TRUE( destination[i] == source[i * 2] );
+    EXPECT_TRUE( destination[4] == -1.0 );
+
+    (*PaUtil_SelectZeroer( paFloat64 ))( destination, 2, 4 );
+    for( i = 0; i < 8; ++i )
+        EXPECT_TRUE( destination[i] == ((i & 1) ? ((i < 4) ? source[i * 2] : -1.0) : 0.0) );
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestSampleSize();
+    TestClosestAvailableFormat();
+    TestConverterSelection();
+    TestRoundTrip();
+    TestClipping();
+    TestCopyAndZero();
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,325 @@
+/** @file paqa_framequeue.c
+    @ingroup qa_src
+    @brief Tests the reservations and regions of PaUtilFrameQueue, and
+    stresses it with many concurrent writers.
+
+    Link with pa_framequeue.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "pa_framequeue.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+/* an odd capacity, so that reservations wrap at varying positions */
+#define ELEMENT_COUNT       (1000)
+
+#define STRESS_WRITER_COUNT     (16)
+#define STRESS_ELEMENTS_PER_WRITER (20000)
+
+/* Elements identify the writer and its sequence number, so that the reader
+ can check that nothing was lost, duplicated or reordered. */
+typedef struct Element
+{
+    int writer;
+    int sequence;
+}Element;
+
+static Element data_[ELEMENT_COUNT];
+static ring_buffer_size_t commits_[ELEMENT_COUNT];
+
+
+static void FillRegion( void *data, ring_buffer_size_t size, int writer, int *sequence )
+{
+    ring_buffer_size_t i;
+    for( i = 0; i < size; ++i )
+    {
+        ((Element*)data)[i].writer = writer;
+        ((Element*)data)[i].sequence = (*sequence)++;
+    }
+}
+
+/* Returns the number of elements in the region which continue writer's sequence. */
+static ring_buffer_size_t CheckRegion( const void *data, ring_buffer_size_t size, int writer, int *sequence )
+{
+    ring_buffer_size_t i;
+    for( i = 0; i < size; ++i )
+    {
+        if( ((const Element*)data)[i].writer != writer || ((const Element*)data)[i].sequence != *sequence )
+            break;
+        ++(*sequence);
+    }
+    return i;
+}
+
+/* Reservations are clamped to the free space, and wrap around the end of
+ the buffer in two regions. */
+static int TestReservations( void )
+{
+    PaUtilFrameQueue queue;
+    PaUtilFrameQueueReservation reservation;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    int sequence = 0, expected = 0, transfer, wrapCount = 0;
+
+    printf( "Testing frame queue reservations.\n" );
+
+    EXPECT_EQ( -1, (int)PaUtil_InitializeFrameQueue( &queue, sizeof(Element), 0, data_, commits_ ) );
+    ASSERT_EQ( 0, (int)PaUtil_InitializeFrameQueue( &queue, sizeof(Element), ELEMENT_COUNT, data_, commits_ ) );
+
+    /* 17 transfers of 300 elements wrap 4 times */
+    for( transfer = 0; transfer < 17; ++transfer )
+    {
+        ASSERT_EQ( 300, (int)PaUtil_ReserveFrameQueueWrite( &queue, 300, &reservation,
+                &data1, &size1, &data2, &size2 ) );
+        if( size2 > 0 )
+            ++wrapCount;
+        EXPECT_EQ( 300, (int)(size1 + size2) );
+        FillRegion( data1, size1, 0, &sequence );
+        FillRegion( data2, size2, 0, &sequence );
+        PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+
+        ASSERT_EQ( 300, (int)PaUtil_GetFrameQueueReadRegions( &queue, 300, &data1, &size1, &data2, &size2 ) );
+        EXPECT_EQ( (int)size1, (int)CheckRegion( data1, size1, 0, &expected ) );
+        EXPECT_EQ( (int)size2, (int)CheckRegion( data2, size2, 0, &expected ) );
+        PaUtil_AdvanceFrameQueueReadIndex( &queue, 300 );
+    }
+    EXPECT_EQ( 4, wrapCount );
+
+    /* a full queue clamps the reservation, and further reservations are empty */
+    ASSERT_EQ( 600, (int)PaUtil_ReserveFrameQueueWrite( &queue, 600, &reservation, &data1, &size1, &data2, &size2 ) );
+    PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+    EXPECT_EQ( 400, (int)PaUtil_ReserveFrameQueueWrite( &queue, 600, &reservation, &data1, &size1, &data2, &size2 ) );
+    PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+    EXPECT_EQ( 0, (int)PaUtil_ReserveFrameQueueWrite( &queue, 1, &reservation, &data1, &size1, &data2, &size2 ) );
+    EXPECT_EQ( 0, (int)reservation.elementCount );
+    PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+    EXPECT_EQ( ELEMENT_COUNT, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+
+    /* reading part of a reservation frees room for writers */
+    PaUtil_AdvanceFrameQueueReadIndex( &queue, 100 );
+    EXPECT_EQ( 100, (int)PaUtil_ReserveFrameQueueWrite( &queue, 200, &reservation, &data1, &size1, &data2, &size2 ) );
+    PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+
+    PaUtil_FlushFrameQueue( &queue );
+    EXPECT_EQ( 0, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    EXPECT_EQ( 5, (int)PaUtil_ReserveFrameQueueWrite( &queue, 5, &reservation, &data1, &size1, &data2, &size2 ) );
+    PaUtil_CommitFrameQueueWrite( &queue, &reservation );
+    EXPECT_EQ( 5, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    return 0;
+
+error:
+    return -1;
+}
+
+/* The reader only sees elements up to the first reservation which hasn't
+ been committed, however the later reservations were committed. */
+static int TestCommitOrder( void )
+{
+    PaUtilFrameQueue queue;
+    PaUtilFrameQueueReservation first, second, third;
+    Element values[ELEMENT_COUNT];
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    int sequences[3] = { 0, 0, 0 }, expected;
+
+    printf( "Testing frame queue commit order.\n" );
+
+    ASSERT_EQ( 0, (int)PaUtil_InitializeFrameQueue( &queue, sizeof(Element), ELEMENT_COUNT, data_, commits_ ) );
+
+    ASSERT_EQ( 10, (int)PaUtil_ReserveFrameQueueWrite( &queue, 10, &first, &data1, &size1, &data2, &size2 ) );
+    FillRegion( data1, size1, 0, &sequences[0] );
+    ASSERT_EQ( 20, (int)PaUtil_ReserveFrameQueueWrite( &queue, 20, &second, &data1, &size1, &data2, &size2 ) );
+    FillRegion( data1, size1, 1, &sequences[1] );
+    ASSERT_EQ( 30, (int)PaUtil_ReserveFrameQueueWrite( &queue, 30, &third, &data1, &size1, &data2, &size2 ) );
+    FillRegion( data1, size1, 2, &sequences[2] );
+
+    PaUtil_CommitFrameQueueWrite( &queue, &third );
+    PaUtil_CommitFrameQueueWrite( &queue, &second );
+    EXPECT_EQ( 0, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    EXPECT_EQ( 0, (int)PaUtil_ReadFrameQueue( &queue, values, ELEMENT_COUNT ) );
+
+    PaUtil_CommitFrameQueueWrite( &queue, &first );
+    EXPECT_EQ( 60, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    ASSERT_EQ( 60, (int)PaUtil_ReadFrameQueue( &queue, values, ELEMENT_COUNT ) );
+    expected = 0;
+    EXPECT_EQ( 10, (int)CheckRegion( &values[0], 10, 0, &expected ) );
+    expected = 0;
+    EXPECT_EQ( 20, (int)CheckRegion( &values[10], 20, 1, &expected ) );
+    expected = 0;
+    EXPECT_EQ( 30, (int)CheckRegion( &values[30], 30, 2, &expected ) );
+
+    /* copying writes and reads go through the same reservations */
+    EXPECT_EQ( 60, (int)PaUtil_WriteFrameQueue( &queue, values, 60 ) );
+    EXPECT_EQ( 60, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    return 0;
+
+error:
+    return -1;
+}
+
+#if !defined(_WIN32)
+
+typedef struct StressWriter
+{
+    PaUtilFrameQueue *queue;
+    int writer;
+}StressWriter;
+
+/* Writes STRESS_ELEMENTS_PER_WRITER elements in reservations of varying
+ size, sometimes yielding before committing so that later reservations are
+ committed first. */
+static void *StressWriterThread( void *userData )
+{
+    StressWriter *stressWriter = (StressWriter*)userData;
+    PaUtilFrameQueueReservation reservation;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, wanted, reserved;
+    int sequence = 0, chunk = 0;
+
+    while( sequence < STRESS_ELEMENTS_PER_WRITER )
+    {
+        wanted = 1 + ( chunk * 7 + stressWriter->writer ) % 37;
+        if( wanted > STRESS_ELEMENTS_PER_WRITER - sequence )
+            wanted = STRESS_ELEMENTS_PER_WRITER - sequence;
+        reserved = PaUtil_ReserveFrameQueueWrite( stressWriter->queue, wanted, &reservation,
+                &data1, &size1, &data2, &size2 );
+        FillRegion( data1, size1, stressWriter->writer, &sequence );
+        FillRegion( data2, size2, stressWriter->writer, &sequence );
+        if( reserved == 0 || chunk % 5 == 0 )
+            sched_yield();
+        PaUtil_CommitFrameQueueWrite( stressWriter->queue, &reservation );
+        ++chunk;
+    }
+    return NULL;
+}
+
+static int TestConcurrentWriters( void )
+{
+    PaUtilFrameQueue queue;
+    StressWriter stressWriters[STRESS_WRITER_COUNT];
+    pthread_t threads[STRESS_WRITER_COUNT];
+    int sequences[STRESS_WRITER_COUNT];
+    int threadCount = 0, total = 0, errors = 0, w;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, available, i;
+
+    printf( "Testing frame queue with %d concurrent writers.\n", STRESS_WRITER_COUNT );
+
+    ASSERT_EQ( 0, (int)PaUtil_InitializeFrameQueue( &queue, sizeof(Element), ELEMENT_COUNT, data_, commits_ ) );
+
+    for( w = 0; w < STRESS_WRITER_COUNT; ++w )
+    {
+        sequences[w] = 0;
+        stressWriters[w].queue = &queue;
+        stressWriters[w].writer = w;
+        ASSERT_EQ( 0, pthread_create( &threads[w], NULL, StressWriterThread, &stressWriters[w] ) );
+        ++threadCount;
+    }
+
+    while( total < STRESS_WRITER_COUNT * STRESS_ELEMENTS_PER_WRITER )
+    {
+        available = PaUtil_GetFrameQueueReadRegions( &queue, ELEMENT_COUNT, &data1, &size1, &data2, &size2 );
+        if( available == 0 )
+        {
+            sched_yield();
+            continue;
+        }
+        /* each writer's elements must continue its own sequence */
+        for( i = 0; i < available; ++i )
+        {
+            const Element *element = ( i < size1 ) ? &((Element*)data1)[i] : &((Element*)data2)[i - size1];
+            if( element->writer < 0 || element->writer >= STRESS_WRITER_COUNT
+                    || element->sequence != sequences[element->writer] )
+                ++errors;
+            else
+                ++sequences[element->writer];
+        }
+        PaUtil_AdvanceFrameQueueReadIndex( &queue, available );
+        total += (int)available;
+    }
+
+    for( w = 0; w < threadCount; ++w )
+        pthread_join( threads[w], NULL );
+    EXPECT_EQ( 0, errors );
+    for( w = 0; w < STRESS_WRITER_COUNT; ++w )
+        EXPECT_EQ( STRESS_ELEMENTS_PER_WRITER, sequences[w] );
+    EXPECT_EQ( 0, (int)PaUtil_GetFrameQueueReadAvailable( &queue ) );
+    return 0;
+
+error:
+    /* keep reading, so that the writers can finish before the queue goes out of scope */
+    while( total < threadCount * STRESS_ELEMENTS_PER_WRITER )
+    {
+        available = PaUtil_GetFrameQueueReadRegions( &queue, ELEMENT_COUNT, &data1, &size1, &data2, &size2 );
+        if( available == 0 )
+            sched_yield();
+        PaUtil_AdvanceFrameQueueReadIndex( &queue, available );
+        total += (int)available;
+    }
+    for( w = 0; w < threadCount; ++w )
+        pthread_join( threads[w], NULL );
+    return -1;
+}
+
+#endif /* _WIN32 */
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestReservations();
+    TestCommitOrder();
+#if !defined(_WIN32)
+    TestConcurrentWriters();
+#endif
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
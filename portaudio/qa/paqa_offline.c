@@ -0,0 +1,521 @@
+/** @file paqa_offline.c
+    @ingroup qa_src
+    @brief Tests offline streams opened with Pa_OpenOfflineStream(), which
+    render a callback stream without a device.
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (48000.0)
+#define CHANNEL_COUNT       (2)
+#define STREAM_FRAMES       (48000)
+#define TIME_TOLERANCE      (1e-9)
+
+
+typedef struct CallbackData
+{
+    unsigned long frameIndex;   /* frames passed to the callback */
+    int callbackCount;
+    int stopCallbackCount;      /* the callback returns paComplete on this call, 0 for never */
+    int finishedCount;
+    PaTime firstCurrentTime;
+    PaTime firstAdcTime;
+    PaTime firstDacTime;
+} CallbackData;
+
+
+static short InputSample( unsigned long frame, int channel )
+{
+    return (short)( (long)((frame * 13 + channel * 3001) % 60011) - 30000 );
+}
+
+
+/* a callback whose output depends on the input, if any, and on the frames
+    rendered so far, so that any change in the buffering changes the output */
+static int ProcessCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    const float *in = (const float*)input;
+    float *out = (float*)output;
+    unsigned long i;
+    int c;
+    (void)statusFlags;
+
+    if( data->callbackCount == 0 )
+    {
+        data->firstCurrentTime = timeInfo->currentTime;
+        data->firstAdcTime = timeInfo->inputBufferAdcTime;
+        data->firstDacTime = timeInfo->outputBufferDacTime;
+    }
+
+    for( i = 0; i < frameCount; ++i )
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+        {
+            out[i * CHANNEL_COUNT + c] = 0.25f * (float)sin( (data->frameIndex + i) * 0.01 * (c + 1) );
+            if( in )
+                out[i * CHANNEL_COUNT + c] += 0.5f * in[i * CHANNEL_COUNT + (CHANNEL_COUNT - 1 - c)];
+        }
+    }
+    data->frameIndex += frameCount;
+
+    if( ++data->callbackCount == data->stopCallbackCount )
+        return paComplete;
+
+    return paContinue;
+}
+
+
+/* copies the input to the output */
+static int CopyCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    memcpy( output, input, frameCount * CHANNEL_COUNT * sizeof(int) );
+    data->callbackCount++;
+
+    return paContinue;
+}
+
+
+static void StreamFinished( void *userData )
+{
+    CallbackData *data = (CallbackData*)userData;
+
+    data->finishedCount++;
+}
+
+
+static void InitializeParameters( PaStreamParameters *parameters, PaSampleFormat sampleFormat,
+        PaTime latency )
+{
+    parameters->device = paNoDevice;
+    parameters->channelCount = CHANNEL_COUNT;
+    parameters->sampleFormat = sampleFormat;
+    parameters->suggestedLatency = latency;
+    parameters->hostApiSpecificStreamInfo = NULL;
+}
+
+
+static void InitializeStreamInfo( PaOfflineStreamInfo *streamInfo, PaSampleFormat hostSampleFormat,
+        unsigned long framesPerHostBuffer )
+{
+    streamInfo->size = sizeof(PaOfflineStreamInfo);
+    streamInfo->version = 1;
+    streamInfo->hostInputSampleFormat = hostSampleFormat;
+    streamInfo->hostOutputSampleFormat = hostSampleFormat;
+    streamInfo->framesPerHostBuffer = framesPerHostBuffer;
+}
+
+
+/* Renders frameCount frames of input, in pieces of at most chunkFrames, with
+    a Float32 callback at 256 frames per buffer and 480 frame Int16 host
+    buffers. */
+static int RenderStream( const short *input, short *output, unsigned long frameCount,
+        unsigned long chunkFrames, CallbackData *data )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters inputParameters, outputParameters;
+    PaOfflineStreamInfo streamInfo;
+    unsigned long frame, chunk;
+
+    InitializeParameters( &inputParameters, paFloat32, 0. );
+    InitializeParameters( &outputParameters, paFloat32, 0. );
+    InitializeStreamInfo( &streamInfo, paInt16, 480 );
+
+    memset( data, 0, sizeof(*data) );
+
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, &inputParameters, &outputParameters,
+            SAMPLE_RATE, 256, paNoFlag, &streamInfo, ProcessCallback, data ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+
+    for( frame = 0; frame < frameCount; frame += chunk )
+    {
+        chunk = ( frameCount - frame < chunkFrames ) ? frameCount - frame : chunkFrames;
+
+        ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, input + frame * CHANNEL_COUNT,
+                output + frame * CHANNEL_COUNT, chunk ) );
+    }
+
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/* The output only depends on the input and the host buffer boundaries, so
+    renders of the same input are bit identical, including renders in pieces
+    which are multiples of the host buffer size. */
+static int TestDeterminism( void )
+{
+    static short input[STREAM_FRAMES * CHANNEL_COUNT];
+    static short output[3][STREAM_FRAMES * CHANNEL_COUNT];
+    CallbackData data;
+    unsigned long i;
+    int c, silent = 1;
+
+    printf( "Testing that renders are reproducible.\n" );
+
+    for( i = 0; i < STREAM_FRAMES; ++i )
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+            input[i * CHANNEL_COUNT + c] = InputSample( i, c );
+
+    memset( output, 0, sizeof(output) );
+
+    ASSERT_EQ( 0, RenderStream( input, output[0], STREAM_FRAMES, STREAM_FRAMES, &data ) );
+    EXPECT_GT( (int)data.frameIndex, STREAM_FRAMES - 512 );
+
+    ASSERT_EQ( 0, RenderStream( input, output[1], STREAM_FRAMES, STREAM_FRAMES, &data ) );
+    ASSERT_EQ( 0, RenderStream( input, output[2], STREAM_FRAMES, 480 * 7, &data ) );
+
+    EXPECT_EQ( 0, memcmp( output[0], output[1], sizeof(output[0]) ) );
+    EXPECT_EQ( 0, memcmp( output[0], output[2], sizeof(output[0]) ) );
+
+    for( i = 0; i < STREAM_FRAMES * CHANNEL_COUNT; ++i )
+    {
+        if( output[0][i] != 0 )
+            silent = 0;
+    }
+    EXPECT_EQ( 0, silent );
+
+    return 0;
+
+error:
+    return -1;
+}
+
+
+/* With matching buffer sizes and exact conversions the output is the input. */
+static int TestPassThrough( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters inputParameters, outputParameters;
+    PaOfflineStreamInfo streamInfo;
+    static short input[1000 * CHANNEL_COUNT];
+    static short output[1024 * CHANNEL_COUNT];
+    CallbackData data;
+    int i, errorCount = 0;
+
+    printf( "Testing pass through and partial host buffers.\n" );
+
+    for( i = 0; i < 1000 * CHANNEL_COUNT; ++i )
+        input[i] = InputSample( i / CHANNEL_COUNT, i % CHANNEL_COUNT );
+    for( i = 0; i < 1024 * CHANNEL_COUNT; ++i )
+        output[i] = 0x5555;
+
+    memset( &data, 0, sizeof(data) );
+    InitializeParameters( &inputParameters, paInt32, 0. );
+    InitializeParameters( &outputParameters, paInt32, 0. );
+    InitializeStreamInfo( &streamInfo, paInt16, 256 );
+
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, &inputParameters, &outputParameters,
+            SAMPLE_RATE, 256, paClipOff | paDitherOff, &streamInfo, CopyCallback, &data ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+
+    /* the last host buffer is padded on input and truncated on output */
+    ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, input, output, 1000 ) );
+    EXPECT_EQ( 4, data.callbackCount );
+    EXPECT_TRUE( fabs( Pa_GetStreamTime( stream ) - 1024 / SAMPLE_RATE ) < TIME_TOLERANCE );
+
+    for( i = 0; i < 1000 * CHANNEL_COUNT; ++i )
+    {
+        if( output[i] != input[i] )
+            errorCount++;
+    }
+    for( i = 1000 * CHANNEL_COUNT; i < 1024 * CHANNEL_COUNT; ++i )
+    {
+        if( output[i] != 0x5555 )
+            errorCount++;
+    }
+    EXPECT_EQ( 0, errorCount );
+
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/* The time info is simulated from the frames rendered and the latencies. */
+static int TestTimeInfo( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters inputParameters, outputParameters;
+    static short input[1024 * CHANNEL_COUNT];
+    static short output[1024 * CHANNEL_COUNT];
+    const PaStreamInfo *info;
+    CallbackData data;
+
+    printf( "Testing the time info.\n" );
+
+    memset( input, 0, sizeof(input) );
+    memset( &data, 0, sizeof(data) );
+    InitializeParameters( &inputParameters, paFloat32, 0.01 );
+    InitializeParameters( &outputParameters, paFloat32, 0.02 );
+
+    /* the host buffers default to framesPerBuffer, in the user format */
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, &inputParameters, &outputParameters,
+            SAMPLE_RATE, 512, paNoFlag, NULL, ProcessCallback, &data ) );
+
+    info = Pa_GetStreamInfo( stream );
+    ASSERT_TRUE( info != NULL );
+    EXPECT_TRUE( fabs( info->inputLatency - 0.01 ) < TIME_TOLERANCE );
+    EXPECT_TRUE( fabs( info->outputLatency - 0.02 ) < TIME_TOLERANCE );
+    EXPECT_TRUE( info->sampleRate == SAMPLE_RATE );
+
+    EXPECT_EQ( paStreamIsStopped, Pa_RenderOfflineStream( stream, input, output, 512 ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    EXPECT_EQ( paBadBufferPtr, Pa_RenderOfflineStream( stream, input, NULL, 512 ) );
+
+    ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, input, output, 512 ) );
+    EXPECT_TRUE( fabs( data.firstCurrentTime ) < TIME_TOLERANCE );
+    EXPECT_TRUE( fabs( data.firstAdcTime + 0.01 ) < TIME_TOLERANCE );
+    EXPECT_TRUE( fabs( data.firstDacTime - 0.02 ) < TIME_TOLERANCE );
+
+    ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, input, output, 512 ) );
+    EXPECT_EQ( 2, data.callbackCount );
+    EXPECT_TRUE( fabs( Pa_GetStreamTime( stream ) - 1024 / SAMPLE_RATE ) < TIME_TOLERANCE );
+    EXPECT_TRUE( Pa_GetStreamCpuLoad( stream ) >= 0. );
+
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+/* paComplete makes the stream inactive and the rest of the output silent. */
+static int TestComplete( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters outputParameters;
+    static float output[2048 * CHANNEL_COUNT];
+    static float silence[2048 * CHANNEL_COUNT];
+    CallbackData data;
+
+    printf( "Testing paComplete.\n" );
+
+    memset( &data, 0, sizeof(data) );
+    memset( silence, 0, sizeof(silence) );
+    data.stopCallbackCount = 3;
+    InitializeParameters( &outputParameters, paFloat32, 0. );
+
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, NULL, &outputParameters,
+            SAMPLE_RATE, 256, paNoFlag, NULL, ProcessCallback, &data ) );
+    ASSERT_EQ( paNoError, Pa_SetStreamFinishedCallback( stream, StreamFinished ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+    EXPECT_EQ( 1, Pa_IsStreamActive( stream ) );
+
+    ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, NULL, output, 1024 ) );
+    EXPECT_EQ( 3, data.callbackCount );
+    EXPECT_EQ( 1, data.finishedCount );
+    EXPECT_EQ( 0, Pa_IsStreamActive( stream ) );
+    EXPECT_EQ( 0, Pa_IsStreamStopped( stream ) );
+    EXPECT_EQ( 0, memcmp( output + 768 * CHANNEL_COUNT, silence, 256 * CHANNEL_COUNT * sizeof(float) ) );
+
+    ASSERT_EQ( paNoError, Pa_RenderOfflineStream( stream, NULL, output, 2048 ) );
+    EXPECT_EQ( 3, data.callbackCount );
+    EXPECT_EQ( 0, memcmp( output, silence, sizeof(output) ) );
+
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+    EXPECT_EQ( 1, data.finishedCount );
+    EXPECT_EQ( 1, Pa_IsStreamStopped( stream ) );
+
+    /* left open, to be closed by Pa_Terminate() */
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    return -1;
+}
+
+
+static void TestOpenErrors( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters outputParameters;
+    PaOfflineStreamInfo streamInfo;
+    CallbackData data;
+
+    printf( "Testing Pa_OpenOfflineStream() errors.\n" );
+
+    InitializeParameters( &outputParameters, paFloat32, 0. );
+    InitializeStreamInfo( &streamInfo, paInt16, 0 );
+
+    EXPECT_EQ( paNullCallback, Pa_OpenOfflineStream( &stream, NULL, &outputParameters,
+            SAMPLE_RATE, 256, paNoFlag, NULL, NULL, &data ) );
+    EXPECT_EQ( paInvalidChannelCount, Pa_OpenOfflineStream( &stream, NULL, NULL,
+            SAMPLE_RATE, 256, paNoFlag, NULL, ProcessCallback, &data ) );
+    EXPECT_EQ( paInvalidFlag, Pa_OpenOfflineStream( &stream, NULL, &outputParameters,
+            SAMPLE_RATE, 256, paConvertSampleRate, NULL, ProcessCallback, &data ) );
+    EXPECT_EQ( paInvalidFlag, Pa_OpenOfflineStream( &stream, NULL, &outputParameters,
+            SAMPLE_RATE, paFramesPerBufferUnspecified, paBatchUserBuffers, NULL, ProcessCallback, &data ) );
+
+    streamInfo.version = 2;
+    EXPECT_EQ( paIncompatibleHostApiSpecificStreamInfo, Pa_OpenOfflineStream( &stream, NULL,
+            &outputParameters, SAMPLE_RATE, 256, paNoFlag, &streamInfo, ProcessCallback, &data ) );
+
+    streamInfo.version = 1;
+    streamInfo.hostOutputSampleFormat = paInt16 | paNonInterleaved;
+    EXPECT_EQ( paSampleFormatNotSupported, Pa_OpenOfflineStream( &stream, NULL,
+            &outputParameters, SAMPLE_RATE, 256, paNoFlag, &streamInfo, ProcessCallback, &data ) );
+}
+
+
+/* Offline streams are callback streams, so they don't lend buffers. */
+static void TestBufferLending( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters inputParameters, outputParameters;
+    CallbackData data;
+    const void *readBuffer;
+    void *writeBuffer;
+    unsigned long frames = 256;
+
+    printf( "Testing buffer lending errors.\n" );
+
+    InitializeParameters( &inputParameters, paFloat32, 0. );
+    InitializeParameters( &outputParameters, paFloat32, 0. );
+
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, &inputParameters, &outputParameters,
+            SAMPLE_RATE, 256, paNoFlag, NULL, ProcessCallback, &data ) );
+    ASSERT_EQ( paNoError, Pa_StartStream( stream ) );
+
+    EXPECT_EQ( paCanNotReadFromACallbackStream, Pa_AcquireReadBuffer( stream, &readBuffer, &frames ) );
+    EXPECT_EQ( paCanNotWriteToACallbackStream, Pa_AcquireWriteBuffer( stream, &writeBuffer, &frames ) );
+    EXPECT_EQ( paBadBufferPtr, Pa_AcquireWriteBuffer( stream, NULL, &frames ) );
+    EXPECT_EQ( paBufferNotAcquired, Pa_ReleaseReadBuffer( stream, 1 ) );
+    EXPECT_EQ( paBufferNotAcquired, Pa_CommitWriteBuffer( stream, 1 ) );
+    EXPECT_EQ( paNoError, Pa_CommitWriteBuffer( stream, 0 ) );
+
+    ASSERT_EQ( paNoError, Pa_StopStream( stream ) );
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+    return;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+}
+
+
+/* The converter tier can only be changed while no stream is open. */
+static void TestConverterTierWhileOpen( void )
+{
+    PaStream *stream = NULL;
+    PaStreamParameters outputParameters;
+    CallbackData data;
+    PaConverterTier tier = Pa_GetConverterTier();
+
+    printf( "Testing Pa_SetConverterTier() with an open stream.\n" );
+
+    InitializeParameters( &outputParameters, paFloat32, 0. );
+
+    ASSERT_EQ( paNoError, Pa_OpenOfflineStream( &stream, NULL, &outputParameters,
+            SAMPLE_RATE, 256, paNoFlag, NULL, ProcessCallback, &data ) );
+
+    EXPECT_EQ( paConverterTierInUse, Pa_SetConverterTier( paConverterTierScalar ) );
+    EXPECT_EQ( (int)tier, (int)Pa_GetConverterTier() );
+
+    ASSERT_EQ( paNoError, Pa_CloseStream( stream ) );
+    stream = NULL;
+
+    EXPECT_EQ( paNoError, Pa_SetConverterTier( paConverterTierScalar ) );
+    EXPECT_EQ( (int)paConverterTierScalar, (int)Pa_GetConverterTier() );
+    EXPECT_EQ( paNoError, Pa_SetConverterTier( paConverterTierDefault ) );
+    EXPECT_EQ( (int)tier, (int)Pa_GetConverterTier() );
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+}
+
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    ASSERT_EQ( paNoError, Pa_Initialize() );
+
+    TestConverterTierWhileOpen(); /* before TestComplete() leaves a stream open */
+    TestDeterminism();
+    TestPassThrough();
+    TestTimeInfo();
+    TestComplete();
+    TestOpenErrors();
+    TestBufferLending();
+
+    ASSERT_EQ( paNoError, Pa_Terminate() );
+
+error:
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
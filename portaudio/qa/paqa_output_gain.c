@@ -0,0 +1,233 @@
+/** @file paqa_output_gain.c
+    @ingroup qa_src
+    @brief Tests the output channel gain applied by the buffer processor in
+    pa_process.c.
+
+    Link with pa_process.c, pa_dither.c, pa_converters.c and pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (44100.0)
+#define FRAMES_PER_BUFFER   (256)
+#define CHANNEL_COUNT       (2)
+#define SIGNAL_LEVEL        (0.5)
+
+/* with a 5 millisecond ramp at 44100 Hz */
+#define RAMP_FRAMES         (220)
+
+typedef struct GainTestData
+{
+    PaSampleFormat userFormat;
+} GainTestData;
+
+/* Fill each user output channel with a constant level. */
+static int ConstantCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    GainTestData *data = (GainTestData*)userData;
+    unsigned long i;
+    int c;
+    (void)input;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    if( data->userFormat & paNonInterleaved )
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+        {
+            for( i = 0; i < frameCount; ++i )
+                ((float**)output)[c][i] = (float)SIGNAL_LEVEL;
+        }
+        return paContinue;
+    }
+
+    for( i = 0; i < frameCount * CHANNEL_COUNT; ++i )
+    {
+        switch( data->userFormat )
+        {
+        case paFloat32: ((float*)output)[i] = (float)SIGNAL_LEVEL; break;
+        case paFloat64: ((double*)output)[i] = SIGNAL_LEVEL; break;
+        case paInt32: ((PaInt32*)output)[i] = (PaInt32)(SIGNAL_LEVEL * 2147483647.0); break;
+        case paInt16: ((PaInt16*)output)[i] = (PaInt16)(SIGNAL_LEVEL * 32767.0); break;
+        default: break;
+        }
+    }
+
+    return paContinue;
+}
+
+/* Return sample i of an interleaved host buffer, scaled to +/-1.0 */
+static double GetHostSample( const void *buffer, PaSampleFormat format, int i )
+{
+    switch( format )
+    {
+    case paFloat32: return ((const float*)buffer)[i];
+    case paInt32: return ((const PaInt32*)buffer)[i] / 2147483648.0;
+    case paInt16: return ((const PaInt16*)buffer)[i] / 32768.0;
+    default: return 0.0;
+    }
+}
+
+static void ProcessBuffer( PaUtilBufferProcessor *bufferProcessor, void *hostBuffer )
+{
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    int callbackResult = paContinue;
+
+    PaUtil_BeginBufferProcessing( bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetOutputFrameCount( bufferProcessor, FRAMES_PER_BUFFER );
+    PaUtil_SetInterleavedOutputChannels( bufferProcessor, 0, hostBuffer, CHANNEL_COUNT );
+    PaUtil_EndBufferProcessing( bufferProcessor, &callbackResult );
+}
+
+/* Check the ramp from unity gain to a gain of 0.5 on the second channel, for
+ one combination of user and host formats. */
+static int TestGainRamp( PaSampleFormat userFormat, PaSampleFormat hostFormat )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    GainTestData data;
+    static unsigned char hostBuffer[FRAMES_PER_BUFFER * CHANNEL_COUNT * 8];
+    double tolerance = (hostFormat == paInt16) ? 4.0 / 32768.0 : 1e-6;
+    double previous, sample;
+    int i, buffer, bpInitialized = 0;
+    int rampMismatches = 0, levelMismatches = 0;
+
+    printf( "Testing output gain from format 0x%02lx to format 0x%02lx.\n",
+            (unsigned long)userFormat, (unsigned long)hostFormat );
+
+    data.userFormat = userFormat;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            CHANNEL_COUNT, userFormat, hostFormat,
+            SAMPLE_RATE, paDitherOff, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, ConstantCallback, &data ) );
+    bpInitialized = 1;
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    /* unity gain */
+    ProcessBuffer( &bufferProcessor, hostBuffer );
+    EXPECT_TRUE( fabs( GetHostSample( hostBuffer, hostFormat, 1 ) - SIGNAL_LEVEL ) <= tolerance );
+
+    EXPECT_EQ( paInvalidChannelCount, PaUtil_SetBufferProcessorOutputGain( &bufferProcessor, CHANNEL_COUNT, 0.5f ) );
+    ASSERT_EQ( paNoError, PaUtil_SetBufferProcessorOutputGain( &bufferProcessor, 1, 0.5f ) );
+
+    /* the second channel ramps down to half the level, the first is unchanged */
+    previous = SIGNAL_LEVEL;
+    for( buffer = 0; buffer < 2; ++buffer )
+    {
+        ProcessBuffer( &bufferProcessor, hostBuffer );
+
+        for( i = 0; i < FRAMES_PER_BUFFER; ++i )
+        {
+            int frame = buffer * FRAMES_PER_BUFFER + i;
+
+            if( fabs( GetHostSample( hostBuffer, hostFormat, i * CHANNEL_COUNT ) - SIGNAL_LEVEL ) > tolerance )
+                ++levelMismatches;
+
+            sample = GetHostSample( hostBuffer, hostFormat, i * CHANNEL_COUNT + 1 );
+            if( frame < RAMP_FRAMES )
+            {
+                if( sample > previous + tolerance || sample < SIGNAL_LEVEL * 0.5 - tolerance )
+                    ++rampMismatches;
+            }
+            else if( fabs( sample - SIGNAL_LEVEL * 0.5 ) > tolerance )
+            {
+                ++levelMismatches;
+            }
+            previous = sample;
+        }
+
+        if( buffer == 0 )
+        {
+            /* half way through the ramp */
+            sample = GetHostSample( hostBuffer, hostFormat, (RAMP_FRAMES / 2) * CHANNEL_COUNT + 1 );
+            EXPECT_TRUE( fabs( sample - SIGNAL_LEVEL * 0.75 ) < 0.01 );
+        }
+    }
+
+    EXPECT_EQ( 0, rampMismatches );
+    EXPECT_EQ( 0, levelMismatches );
+
+    /* gains set while the stream is stopped apply without a ramp */
+    ASSERT_EQ( paNoError, PaUtil_SetBufferProcessorOutputGain( &bufferProcessor, 0, 0.0f ) );
+    ASSERT_EQ( paNoError, PaUtil_SetBufferProcessorOutputGain( &bufferProcessor, 1, 2.0f ) );
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+    ProcessBuffer( &bufferProcessor, hostBuffer );
+    EXPECT_TRUE( GetHostSample( hostBuffer, hostFormat, 0 ) == 0.0 );
+    EXPECT_TRUE( fabs( GetHostSample( hostBuffer, hostFormat, 1 ) - SIGNAL_LEVEL * 2.0 ) <= tolerance );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    /* user and host formats equal, which would otherwise write directly to
+        the host buffer */
+    TestGainRamp( paFloat32, paFloat32 );
+    TestGainRamp( paFloat32, paInt16 );
+    TestGainRamp( paInt16, paInt16 );
+    TestGainRamp( paInt32, paInt32 );
+    TestGainRamp( paFloat64, paFloat32 );
+    TestGainRamp( paFloat32 | paNonInterleaved, paInt32 );
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,450 @@
+/** @file paqa_resampler.c
+    @ingroup qa_src
+    @brief Tests the sample rate converter in pa_resampler.c and the
+    resampling stage of the buffer processor in pa_process.c.
+
+    Link with pa_process.c, pa_resampler.c, pa_dither.c, pa_converters.c and
+    pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_resampler.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+#define SINE_FREQUENCY      (1000.0)
+#define SINE_AMPLITUDE      (0.5)
+#define WRITE_FRAMES        (256)
+#define INPUT_FRAMES        (8192)
+#define MAX_OUTPUT_FRAMES   (INPUT_FRAMES * 4)
+
+#define HOST_SAMPLE_RATE    (48000.0)
+#define USER_SAMPLE_RATE    (44100.0)
+#define HOST_FRAMES         (256)
+#define USER_FRAMES         (256)
+#define HOST_BUFFER_COUNT   (64)
+#define CHANNEL_COUNT       (2)
+#define INPUT_HOST_FRAMES   (32768) /* host frames processed by the input only test */
+#define MAX_CAPTURE_FRAMES  (INPUT_HOST_FRAMES)
+
+static float gInput[INPUT_FRAMES];
+static float gOutput[MAX_OUTPUT_FRAMES];
+static float gCapture[MAX_CAPTURE_FRAMES * CHANNEL_COUNT];
+
+/* Resample a sine wave and compare the output with the ideal sine. Output
+ frame i is the input interpolated at position i * step. */
+static int TestResamplerSine( double inputRate, double outputRate,
+        PaUtilResamplerQuality quality, double tolerance )
+{
+    PaUtilResampler resampler;
+    int initialized = 0;
+    unsigned long written = 0, read = 0, n, i, settleFrames;
+    double step = inputRate / outputRate;
+    double latency, maxError = 0.;
+
+    printf( "Testing resampling from %g Hz to %g Hz with quality %d.\n",
+            inputRate, outputRate, (int)quality );
+
+    for( i = 0; i < INPUT_FRAMES; ++i )
+        gInput[i] = (float)(SINE_AMPLITUDE * sin( 2. * M_PI * SINE_FREQUENCY * i / inputRate ));
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeResampler( &resampler, 1,
+            inputRate, outputRate, quality, WRITE_FRAMES ) );
+    initialized = 1;
+    PaUtil_ResetResampler( &resampler );
+
+    latency = PaUtil_GetResamplerLatencyFrames( &resampler );
+    EXPECT_TRUE( latency > 0. );
+
+    while( written < INPUT_FRAMES )
+    {
+        const float *channels[1];
+        float *outputChannels[1];
+
+        channels[0] = gInput + written;
+        n = PaUtil_WriteResamplerInput( &resampler, channels, WRITE_FRAMES );
+        ASSERT_EQ( WRITE_FRAMES, n );
+        written += n;
+
+        EXPECT_TRUE( PaUtil_GetResamplerInputFramesNeeded( &resampler,
+                PaUtil_GetResamplerOutputFramesAvailable( &resampler ) ) == 0 );
+
+        outputChannels[0] = gOutput + read;
+        n = PaUtil_ReadResamplerOutput( &resampler, outputChannels, MAX_OUTPUT_FRAMES - read );
+        EXPECT_EQ( 0, (int)PaUtil_GetResamplerOutputFramesAvailable( &resampler ) );
+        read += n;
+    }
+
+    /* all the input has been converted, apart from the filter delay */
+    EXPECT_TRUE( fabs( read - (INPUT_FRAMES - latency) / step ) < 2. );
+
+    /* skip the output which depends on the silence before the first frame */
+    settleFrames = (unsigned long)(2. * latency / step) + 1;
+    for( i = settleFrames; i < read; ++i )
+    {
+        double expected = SINE_AMPLITUDE * sin( 2. * M_PI * SINE_FREQUENCY * i * step / inputRate );
+        double error = fabs( gOutput[i] - expected );
+        if( error > maxError )
+            maxError = error;
+    }
+
+    printf( "  maximum error %g\n", maxError );
+    EXPECT_TRUE( maxError < tolerance );
+
+    PaUtil_TerminateResampler( &resampler );
+    return 0;
+
+error:
+    if( initialized )
+        PaUtil_TerminateResampler( &resampler );
+    return -1;
+}
+
+
+typedef struct StageTestData
+{
+    unsigned long callbackCount;
+    unsigned long badFrameCounts;
+    PaStreamCallbackFlags statusFlags;
+    double phase;
+    unsigned long framesPerBuffer;  /**< expected by CaptureCallback */
+    unsigned long capturedFrames;
+} StageTestData;
+
+/* Copy the Int16 input to the output. */
+static int PassThroughCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StageTestData *data = (StageTestData*)userData;
+    (void)timeInfo;
+
+    if( frameCount != USER_FRAMES )
+        ++data->badFrameCounts;
+
+    data->statusFlags |= statusFlags;
+    ++data->callbackCount;
+
+    memcpy( output, input, frameCount * CHANNEL_COUNT * sizeof(PaInt16) );
+    return paContinue;
+}
+
+/* Generate a sine wave at the user sample rate. */
+static int SineCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StageTestData *data = (StageTestData*)userData;
+    unsigned long i;
+    int c;
+    (void)input;
+    (void)timeInfo;
+
+    if( frameCount != USER_FRAMES )
+        ++data->badFrameCounts;
+    data->statusFlags |= statusFlags;
+    ++data->callbackCount;
+
+    for( i = 0; i < frameCount; ++i )
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+            ((float**)output)[c][i] = (float)(SINE_AMPLITUDE * sin( data->phase ));
+        data->phase += 2. * M_PI * SINE_FREQUENCY / USER_SAMPLE_RATE;
+    }
+
+    return paContinue;
+}
+
+/* Append the interleaved Float32 input to gCapture. */
+static int CaptureCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    StageTestData *data = (StageTestData*)userData;
+    (void)output;
+    (void)timeInfo;
+
+    if( frameCount != data->framesPerBuffer )
+        ++data->badFrameCounts;
+    data->statusFlags |= statusFlags;
+    ++data->callbackCount;
+
+    if( data->capturedFrames + frameCount <= MAX_CAPTURE_FRAMES )
+    {
+        memcpy( gCapture + data->capturedFrames * CHANNEL_COUNT, input,
+                frameCount * CHANNEL_COUNT * sizeof(float) );
+        data->capturedFrames += frameCount;
+    }
+
+    return paContinue;
+}
+
+/* Return the frequency of an interleaved host signal from its rising zero
+ crossings, and its peak level. */
+static double MeasureFrequency( const float *buffer, unsigned long frameCount, double sampleRate,
+        double *peak )
+{
+    unsigned long i, first = 0, last = 0, crossings = 0;
+
+    *peak = 0.;
+    for( i = 1; i < frameCount; ++i )
+    {
+        float previous = buffer[(i - 1) * CHANNEL_COUNT];
+        float sample = buffer[i * CHANNEL_COUNT];
+
+        if( fabs( sample ) > *peak )
+            *peak = fabs( sample );
+
+        if( previous < 0.f && sample >= 0.f )
+        {
+            if( crossings == 0 )
+                first = i;
+            last = i;
+            ++crossings;
+        }
+    }
+
+    if( crossings < 2 )
+        return 0.;
+
+    return (crossings - 1) * sampleRate / (last - first);
+}
+
+/* Process buffers from a host running at 48000 Hz with a callback at 44100 Hz. */
+static int TestResamplingStage( int fullDuplex )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    StageTestData data;
+    static float hostInput[HOST_FRAMES * CHANNEL_COUNT];
+    static float hostOutput[HOST_BUFFER_COUNT * HOST_FRAMES * CHANNEL_COUNT];
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    double frequency, peak, expectedCallbacks;
+    unsigned long i, sampleIndex = 0;
+    int buffer, c, callbackResult, bpInitialized = 0;
+
+    printf( "Testing %s resampling stage.\n", fullDuplex ? "full duplex" : "output only" );
+
+    memset( &data, 0, sizeof(data) );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            fullDuplex ? CHANNEL_COUNT : 0, paInt16, paFloat32,
+            CHANNEL_COUNT, fullDuplex ? paInt16 : paFloat32 | paNonInterleaved, paFloat32,
+            HOST_SAMPLE_RATE, paNoFlag, USER_FRAMES, HOST_FRAMES,
+            paUtilFixedHostBufferSize, fullDuplex ? PassThroughCallback : SineCallback, &data ) );
+    bpInitialized = 1;
+
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorResampling( &bufferProcessor,
+            USER_SAMPLE_RATE, USER_FRAMES, paUtilResamplerQualityMedium ) );
+    EXPECT_EQ( paInvalidSampleRate, PaUtil_EnableBufferProcessorResampling( &bufferProcessor,
+            USER_SAMPLE_RATE, USER_FRAMES, paUtilResamplerQualityMedium ) );
+
+    EXPECT_TRUE( PaUtil_GetBufferProcessorResamplingOutputLatency( &bufferProcessor ) > 0. );
+    if( fullDuplex )
+        EXPECT_TRUE( PaUtil_GetBufferProcessorResamplingInputLatency( &bufferProcessor ) > 0. );
+    else
+        EXPECT_TRUE( PaUtil_GetBufferProcessorResamplingInputLatency( &bufferProcessor ) == 0. );
+
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    for( buffer = 0; buffer < HOST_BUFFER_COUNT; ++buffer )
+    {
+        float *output = hostOutput + buffer * HOST_FRAMES * CHANNEL_COUNT;
+
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+
+        if( fullDuplex )
+        {
+            for( i = 0; i < HOST_FRAMES; ++i, ++sampleIndex )
+            {
+                for( c = 0; c < CHANNEL_COUNT; ++c )
+                {
+                    hostInput[i * CHANNEL_COUNT + c] = (float)(SINE_AMPLITUDE *
+                            sin( 2. * M_PI * SINE_FREQUENCY * sampleIndex / HOST_SAMPLE_RATE ));
+                }
+            }
+
+            PaUtil_SetInputFrameCount( &bufferProcessor, HOST_FRAMES );
+            PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, hostInput, CHANNEL_COUNT );
+        }
+
+        PaUtil_SetOutputFrameCount( &bufferProcessor, HOST_FRAMES );
+        PaUtil_SetInterleavedOutputChannels( &bufferProcessor, 0, output, CHANNEL_COUNT );
+
+        callbackResult = paContinue;
+        EXPECT_EQ( HOST_FRAMES, (int)PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult ) );
+        EXPECT_EQ( paContinue, callbackResult );
+    }
+
+    EXPECT_EQ( 0, (int)data.badFrameCounts );
+    EXPECT_EQ( 0, (int)data.statusFlags );
+
+    /* the callback runs at the user rate */
+    expectedCallbacks = HOST_BUFFER_COUNT * HOST_FRAMES * USER_SAMPLE_RATE / HOST_SAMPLE_RATE / USER_FRAMES;
+    EXPECT_TRUE( fabs( data.callbackCount - expectedCallbacks ) <= 3. );
+
+    /* the last half of the output is a sine at the original frequency */
+    frequency = MeasureFrequency( hostOutput + (HOST_BUFFER_COUNT / 2) * HOST_FRAMES * CHANNEL_COUNT,
+            (HOST_BUFFER_COUNT / 2) * HOST_FRAMES, HOST_SAMPLE_RATE, &peak );
+    printf( "  frequency %g Hz, peak %g\n", frequency, peak );
+    EXPECT_TRUE( fabs( frequency - SINE_FREQUENCY ) < 2. );
+    EXPECT_TRUE( fabs( peak - SINE_AMPLITUDE ) < 0.01 );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/* Process input only buffers from a host running at 48000 Hz with a callback
+ at 44100 Hz. No host input may be dropped, even when the user buffer is much
+ larger than the host buffer. */
+static int TestInputOnlyResamplingStage( unsigned long hostFrames, unsigned long userFrames )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    StageTestData data;
+    static float hostInput[INPUT_HOST_FRAMES * CHANNEL_COUNT];
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    double frequency, peak, expectedCallbacks;
+    unsigned long i, sampleIndex = 0, skipFrames;
+    int c, callbackResult, bpInitialized = 0;
+
+    printf( "Testing input only resampling stage with %lu host frames and %lu user frames.\n",
+            hostFrames, userFrames );
+
+    memset( &data, 0, sizeof(data) );
+    data.framesPerBuffer = userFrames;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            0, 0, 0,
+            HOST_SAMPLE_RATE, paNoFlag, userFrames, hostFrames,
+            paUtilFixedHostBufferSize, CaptureCallback, &data ) );
+    bpInitialized = 1;
+
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorResampling( &bufferProcessor,
+            USER_SAMPLE_RATE, userFrames, paUtilResamplerQualityMedium ) );
+    EXPECT_TRUE( PaUtil_GetBufferProcessorResamplingInputLatency( &bufferProcessor ) > 0. );
+
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    while( sampleIndex + hostFrames <= INPUT_HOST_FRAMES )
+    {
+        float *input = hostInput + sampleIndex * CHANNEL_COUNT;
+
+        for( i = 0; i < hostFrames; ++i, ++sampleIndex )
+        {
+            for( c = 0; c < CHANNEL_COUNT; ++c )
+            {
+                input[i * CHANNEL_COUNT + c] = (float)(SINE_AMPLITUDE *
+                        sin( 2. * M_PI * SINE_FREQUENCY * sampleIndex / HOST_SAMPLE_RATE ));
+            }
+        }
+
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bufferProcessor, hostFrames );
+        PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, input, CHANNEL_COUNT );
+
+        callbackResult = paContinue;
+        EXPECT_EQ( (int)hostFrames, (int)PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult ) );
+        EXPECT_EQ( paContinue, callbackResult );
+    }
+
+    EXPECT_EQ( 0, (int)data.badFrameCounts );
+    EXPECT_EQ( 0, (int)data.statusFlags );
+
+    /* all the host input reaches the callback, apart from the last partial
+        user buffer and the filter delay */
+    expectedCallbacks = sampleIndex * USER_SAMPLE_RATE / HOST_SAMPLE_RATE / userFrames;
+    printf( "  %lu callbacks, expected about %g\n", data.callbackCount, expectedCallbacks );
+    EXPECT_TRUE( data.callbackCount >= 1 );
+    EXPECT_TRUE( fabs( data.callbackCount - expectedCallbacks ) <= 1. );
+
+    /* skip the start of the capture, which contains the filter's response to
+        the silence before the first frame */
+    skipFrames = data.capturedFrames / 4;
+    frequency = MeasureFrequency( gCapture + skipFrames * CHANNEL_COUNT,
+            data.capturedFrames - skipFrames, USER_SAMPLE_RATE, &peak );
+    printf( "  frequency %g Hz, peak %g\n", frequency, peak );
+    EXPECT_TRUE( fabs( frequency - SINE_FREQUENCY ) < 2. );
+    EXPECT_TRUE( fabs( peak - SINE_AMPLITUDE ) < 0.01 );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestResamplerSine( 44100., 48000., paUtilResamplerQualityLow, 1e-4 );
+    TestResamplerSine( 44100., 48000., paUtilResamplerQualityMedium, 1e-4 );
+    TestResamplerSine( 44100., 48000., paUtilResamplerQualityHigh, 1e-4 );
+    TestResamplerSine( 48000., 44100., paUtilResamplerQualityMedium, 1e-4 );
+    TestResamplerSine( 96000., 44100., paUtilResamplerQualityHigh, 1e-4 );
+
+    TestResamplingStage( 1 );
+    TestResamplingStage( 0 );
+    TestInputOnlyResamplingStage( 512, 512 );
+    TestInputOnlyResamplingStage( 256, 4096 );
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,354 @@
+/** @file paqa_ringbuffer.c
+    @ingroup qa_src
+    @brief Tests the regions returned by PaUtilRingBuffer, for client
+    allocated and mirrored buffers, and waiting for a ring buffer on Linux.
+
+    Link with pa_ringbuffer.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "pa_ringbuffer.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+/* 64 KiB of ints, a multiple of all common page sizes */
+#define ELEMENT_COUNT       (16384)
+#define TRANSFER_COUNT      (5000)
+
+
+/* Write and read back 20 transfers of TRANSFER_COUNT elements, which wrap
+ around the end of the buffer at a different place each time. A mirrored
+ buffer never returns a second region. */
+static int TransferSequences( PaUtilRingBuffer *rbuf, int expectContiguous, int expectedWrapCount )
+{
+    int sequence = 0, expected = 0;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, i;
+    int transfer, wrapCount = 0;
+
+    for( transfer = 0; transfer < 20; ++transfer )
+    {
+        ASSERT_EQ( TRANSFER_COUNT, (int)PaUtil_GetRingBufferWriteRegions( rbuf, TRANSFER_COUNT,
+                &data1, &size1, &data2, &size2 ) );
+        if( size2 > 0 )
+            ++wrapCount;
+        if( expectContiguous )
+        {
+            EXPECT_EQ( TRANSFER_COUNT, (int)size1 );
+            EXPECT_EQ( 0, (int)size2 );
+            EXPECT_TRUE( data2 == NULL );
+        }
+        for( i = 0; i < size1; ++i )
+            ((int*)data1)[i] = sequence++;
+        for( i = 0; i < size2; ++i )
+            ((int*)data2)[i] = sequence++;
+        PaUtil_AdvanceRingBufferWriteIndex( rbuf, TRANSFER_COUNT );
+
+        ASSERT_EQ( TRANSFER_COUNT, (int)PaUtil_GetRingBufferReadRegions( rbuf, TRANSFER_COUNT,
+                &data1, &size1, &data2, &size2 ) );
+        if( expectContiguous )
+        {
+            EXPECT_EQ( TRANSFER_COUNT, (int)size1 );
+            EXPECT_EQ( 0, (int)size2 );
+        }
+        for( i = 0; i < size1; ++i )
+            if( ((int*)data1)[i] != expected++ )
+                break;
+        EXPECT_EQ( (int)size1, (int)i );
+        for( i = 0; i < size2; ++i )
+            if( ((int*)data2)[i] != expected++ )
+                break;
+        EXPECT_EQ( (int)size2, (int)i );
+        PaUtil_AdvanceRingBufferReadIndex( rbuf, TRANSFER_COUNT );
+    }
+
+    EXPECT_EQ( expectedWrapCount, wrapCount );
+    return 0;
+
+error:
+    return -1;
+}
+
+static int TestClientBuffer( void )
+{
+    static int data[ELEMENT_COUNT];
+    PaUtilRingBuffer rbuf;
+
+    printf( "Testing a client allocated ring buffer.\n" );
+
+    EXPECT_EQ( -1, (int)PaUtil_InitializeRingBuffer( &rbuf, sizeof(int), 0, data ) );
+    EXPECT_EQ( -1, (int)PaUtil_InitializeRingBuffer( &rbuf, sizeof(int), PA_RINGBUFFER_MAX_ELEMENT_COUNT + 1, data ) );
+    ASSERT_EQ( 0, (int)PaUtil_InitializeRingBuffer( &rbuf, sizeof(int), ELEMENT_COUNT, data ) );
+    EXPECT_EQ( 0, rbuf.isMirrored );
+
+    /* 20 transfers of 5000 elements wrap a 16384 element buffer 6 times */
+    return TransferSequences( &rbuf, 0, 6 );
+
+error:
+    return -1;
+}
+
+/* A capacity which isn't a power of 2 holds exactly that many elements. */
+static int TestOddCapacity( void )
+{
+    static int data[ELEMENT_COUNT];
+    static int values[ELEMENT_COUNT];
+    PaUtilRingBuffer rbuf;
+    ring_buffer_size_t capacity = 6000;
+    int i, round;
+
+    printf( "Testing a ring buffer of %ld elements.\n", (long)capacity );
+
+    for( i = 0; i < ELEMENT_COUNT; ++i )
+        values[i] = i;
+
+    ASSERT_EQ( 0, (int)PaUtil_InitializeRingBuffer( &rbuf, sizeof(int), capacity, data ) );
+    EXPECT_EQ( (int)capacity, (int)PaUtil_GetRingBufferWriteAvailable( &rbuf ) );
+
+    /* fill and drain from each of a few starting positions */
+    for( round = 0; round < 5; ++round )
+    {
+        EXPECT_EQ( 1234, (int)PaUtil_WriteRingBuffer( &rbuf, values, 1234 ) );
+        EXPECT_EQ( 1234, (int)PaUtil_ReadRingBuffer( &rbuf, data + capacity, 1234 ) );
+
+        EXPECT_EQ( (int)capacity, (int)PaUtil_WriteRingBuffer( &rbuf, values, ELEMENT_COUNT ) );
+        EXPECT_EQ( 0, (int)PaUtil_GetRingBufferWriteAvailable( &rbuf ) );
+        EXPECT_EQ( (int)capacity, (int)PaUtil_GetRingBufferReadAvailable( &rbuf ) );
+
+        EXPECT_EQ( (int)capacity, (int)PaUtil_ReadRingBuffer( &rbuf, data + capacity, ELEMENT_COUNT ) );
+        for( i = 0; i < capacity; ++i )
+            if( data[capacity + i] != i )
+                break;
+        EXPECT_EQ( (int)capacity, i );
+        EXPECT_EQ( 0, (int)PaUtil_GetRingBufferReadAvailable( &rbuf ) );
+    }
+
+    /* starting from element 170, 20 transfers of 5000 elements wrap 16 times */
+    return TransferSequences( &rbuf, 0, 16 );
+
+error:
+    return -1;
+}
+
+static int TestMirroredBuffer( void )
+{
+    PaUtilRingBuffer rbuf;
+    int i;
+
+    printf( "Testing a mirrored ring buffer.\n" );
+
+    EXPECT_EQ( -1, (int)PaUtil_InitializeMirroredRingBuffer( &rbuf, sizeof(int), 0 ) );
+    EXPECT_EQ( -1, (int)PaUtil_InitializeMirroredRingBuffer( &rbuf, sizeof(int), ELEMENT_COUNT - 1 ) ); /* not a whole page */
+
+    if( PaUtil_InitializeMirroredRingBuffer( &rbuf, sizeof(int), ELEMENT_COUNT ) != 0 )
+    {
+#if defined(__linux__)
+        EXPECT_TRUE( !"mirrored ring buffers should be supported on Linux" );
+#else
+        printf( "Mirrored ring buffers are not supported, skipping.\n" );
+#endif
+        return 0;
+    }
+    EXPECT_EQ( 1, rbuf.isMirrored );
+
+    /* the buffer is zeroed, and writes are visible in both mappings */
+    for( i = 0; i < ELEMENT_COUNT * 2; ++i )
+        if( ((int*)rbuf.buffer)[i] != 0 )
+            break;
+    EXPECT_EQ( ELEMENT_COUNT * 2, i );
+    ((int*)rbuf.buffer)[ELEMENT_COUNT + 7] = 42;
+    EXPECT_EQ( 42, ((int*)rbuf.buffer)[7] );
+
+    TransferSequences( &rbuf, 1, 0 );
+
+    PaUtil_TerminateMirroredRingBuffer( &rbuf );
+    EXPECT_TRUE( rbuf.buffer == NULL );
+    EXPECT_EQ( 0, rbuf.isMirrored );
+    return 0;
+}
+
+/* Buffers sized by PaUtil_GetMirroredRingBufferElementCount() are mirrored,
+ whatever the size of their elements, like the FIFOs of blocking streams
+ which hold whole frames. */
+static int TestMirroredElementCounts( void )
+{
+    static const ring_buffer_size_t elementSizes[] = { 1, 2, 8, 12, 24, 4096, 6000 };
+    static const ring_buffer_size_t elementCounts[] = { 1, 33, 1000, 3000 };
+    PaUtilRingBuffer rbuf;
+    int s, c, mirrored = 0;
+
+    printf( "Testing mirrored ring buffer element counts.\n" );
+
+    for( s = 0; s < (int)(sizeof(elementSizes) / sizeof(elementSizes[0])); ++s )
+    {
+        for( c = 0; c < (int)(sizeof(elementCounts) / sizeof(elementCounts[0])); ++c )
+        {
+            ring_buffer_size_t count = PaUtil_GetMirroredRingBufferElementCount(
+                    elementSizes[s], elementCounts[c] );
+
+            EXPECT_TRUE( count >= elementCounts[c] );
+
+            if( PaUtil_InitializeMirroredRingBuffer( &rbuf, elementSizes[s], count ) == 0 )
+            {
+                EXPECT_EQ( 1, rbuf.isMirrored );
+                EXPECT_EQ( (int)count, (int)rbuf.bufferSize );
+                PaUtil_TerminateMirroredRingBuffer( &rbuf );
+                ++mirrored;
+            }
+#if defined(__linux__)
+            else
+            {
+                printf( "  %ld elements of %ld bytes are not mirrored\n",
+                        (long)count, (long)elementSizes[s] );
+                EXPECT_TRUE( !"the rounded element count should be mirrored" );
+            }
+#endif
+        }
+    }
+
+#if !defined(__linux__)
+    if( mirrored == 0 )
+        printf( "Mirrored ring buffers are not supported, skipping.\n" );
+#endif
+    (void)mirrored;
+    return 0;
+}
+
+#if defined(__linux__)
+
+#define WAIT_CHUNK          (100)
+#define WAIT_CHUNK_COUNT    (50)
+
+/* Writes WAIT_CHUNK_COUNT chunks, pausing between them, while waiting for
+ space whenever the buffer is full. */
+static void *WaitingWriter( void *userData )
+{
+    PaUtilRingBuffer *rbuf = (PaUtilRingBuffer*)userData;
+    int chunk[WAIT_CHUNK];
+    int sequence = 0, c, i;
+
+    for( c = 0; c < WAIT_CHUNK_COUNT; ++c )
+    {
+        for( i = 0; i < WAIT_CHUNK; ++i )
+            chunk[i] = sequence++;
+        PaUtil_WaitForRingBufferWriteAvailable( rbuf, WAIT_CHUNK, -1 );
+        PaUtil_WriteRingBuffer( rbuf, chunk, WAIT_CHUNK );
+        usleep( 200 );
+    }
+    return NULL;
+}
+
+static int TestWaiting( void )
+{
+    static int data[1000];
+    static int values[1000];
+    PaUtilRingBuffer rbuf;
+    pthread_t thread;
+    int threadStarted = 0;
+    int expected = 0, total = WAIT_CHUNK * WAIT_CHUNK_COUNT;
+    ring_buffer_size_t available, i;
+
+    printf( "Testing waiting for a ring buffer.\n" );
+
+    ASSERT_EQ( 0, (int)PaUtil_InitializeRingBuffer( &rbuf, sizeof(int), 1000, data ) );
+
+    /* without waiting enabled, waits return immediately */
+    EXPECT_EQ( 0, (int)PaUtil_WaitForRingBufferReadAvailable( &rbuf, 1, -1 ) );
+
+    ASSERT_EQ( 0, PaUtil_EnableRingBufferWaiting( &rbuf ) );
+
+    /* a wait which can't be satisfied times out */
+    EXPECT_EQ( 0, (int)PaUtil_WaitForRingBufferReadAvailable( &rbuf, 1, 20 ) );
+    EXPECT_EQ( 1000, (int)PaUtil_WaitForRingBufferWriteAvailable( &rbuf, 2000, 20 ) );
+
+    ASSERT_EQ( 0, pthread_create( &thread, NULL, WaitingWriter, &rbuf ) );
+    threadStarted = 1;
+
+    /* wait for more than one chunk at a time, so that the writer fills the
+     buffer and has to wait for the reader as well */
+    while( expected < total )
+    {
+        ring_buffer_size_t wanted = ( total - expected < 750 ) ? total - expected : 750;
+        available = PaUtil_WaitForRingBufferReadAvailable( &rbuf, wanted, 5000 );
+        ASSERT_TRUE( available >= wanted );
+        ASSERT_EQ( (int)available, (int)PaUtil_ReadRingBuffer( &rbuf, values, available ) );
+        for( i = 0; i < available; ++i )
+            if( values[i] != expected++ )
+                break;
+        EXPECT_EQ( (int)available, (int)i );
+        usleep( 5000 );
+    }
+
+    pthread_join( thread, NULL );
+    EXPECT_EQ( 0, (int)PaUtil_GetRingBufferReadAvailable( &rbuf ) );
+    return 0;
+
+error:
+    if( threadStarted )
+        pthread_join( thread, NULL );
+    return -1;
+}
+
+#endif /* __linux__ */
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestClientBuffer();
+    TestOddCapacity();
+    TestMirroredBuffer();
+    TestMirroredElementCounts();
+#if defined(__linux__)
+    TestWaiting();
+#endif
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
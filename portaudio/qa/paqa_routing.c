@@ -0,0 +1,441 @@
+/** @file paqa_routing.c
+    @ingroup qa_src
+    @brief Tests the channel routing of the buffer processor in pa_process.c.
+
+    Link with pa_process.c, pa_resampler.c, pa_dither.c, pa_converters.c and
+    pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (44100.0)
+#define FRAMES_PER_BUFFER   (64)
+#define HOST_CHANNELS       (4)
+#define MAX_USER_CHANNELS   (4)
+#define TOLERANCE           (1.0 / 16384.0)
+
+typedef struct RoutingTestData
+{
+    PaSampleFormat userFormat;
+    int userChannelCount;
+    const void *output;     /**< the output buffer passed to the last callback */
+    double input[MAX_USER_CHANNELS]; /**< the last input sample of each channel */
+} RoutingTestData;
+
+/* The level written to user output channel c, and to host input channel c. */
+static double ChannelLevel( int c )
+{
+    return 0.125 * (c + 1);
+}
+
+static double GetSample( const void *buffer, PaSampleFormat format, int channelCount,
+        int channel, unsigned long frame )
+{
+    unsigned long i = frame;
+
+    if( format & paNonInterleaved )
+        buffer = ((const void* const*)buffer)[channel];
+    else
+        i = frame * channelCount + channel;
+
+    switch( format & ~paNonInterleaved )
+    {
+    case paFloat32: return ((const float*)buffer)[i];
+    case paInt32: return ((const PaInt32*)buffer)[i] / 2147483648.0;
+    case paInt16: return ((const PaInt16*)buffer)[i] / 32768.0;
+    default: return 0.0;
+    }
+}
+
+static void SetSample( void *buffer, PaSampleFormat format, int channelCount,
+        int channel, unsigned long frame, double value )
+{
+    unsigned long i = frame;
+
+    if( format & paNonInterleaved )
+        buffer = ((void**)buffer)[channel];
+    else
+        i = frame * channelCount + channel;
+
+    switch( format & ~paNonInterleaved )
+    {
+    case paFloat32: ((float*)buffer)[i] = (float)value; break;
+    case paInt32: ((PaInt32*)buffer)[i] = (PaInt32)(value * 2147483648.0); break;
+    case paInt16: ((PaInt16*)buffer)[i] = (PaInt16)(value * 32768.0); break;
+    default: break;
+    }
+}
+
+static int RoutingCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    RoutingTestData *data = (RoutingTestData*)userData;
+    unsigned long i;
+    int c;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    data->output = output;
+
+    for( c = 0; c < data->userChannelCount; ++c )
+    {
+        if( input )
+            data->input[c] = GetSample( input, data->userFormat, data->userChannelCount, c, frameCount - 1 );
+
+        if( output )
+        {
+            for( i = 0; i < frameCount; ++i )
+                SetSample( output, data->userFormat, data->userChannelCount, c, i, ChannelLevel( c ) );
+        }
+    }
+
+    return paContinue;
+}
+
+/* Process one host buffer of output with the host channels at hostBuffer.
+ For non-interleaved host formats hostBuffer is an array of channel pointers. */
+static void ProcessOutput( PaUtilBufferProcessor *bufferProcessor, void *hostBuffer,
+        PaSampleFormat hostFormat )
+{
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    int c, callbackResult = paContinue;
+
+    PaUtil_BeginBufferProcessing( bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetOutputFrameCount( bufferProcessor, FRAMES_PER_BUFFER );
+    if( hostFormat & paNonInterleaved )
+    {
+        for( c = 0; c < HOST_CHANNELS; ++c )
+            PaUtil_SetNonInterleavedOutputChannel( bufferProcessor, c, ((void**)hostBuffer)[c] );
+    }
+    else
+    {
+        PaUtil_SetInterleavedOutputChannels( bufferProcessor, 0, hostBuffer, HOST_CHANNELS );
+    }
+    PaUtil_EndBufferProcessing( bufferProcessor, &callbackResult );
+}
+
+/* Route userChannelCount output channels to the HOST_CHANNELS host channels,
+ and check that each host channel holds expected[c] times the level. */
+static int TestOutputRouting( PaSampleFormat userFormat, PaSampleFormat hostFormat,
+        int userChannelCount, const PaChannelRoute *routes, unsigned long routeCount,
+        const double *expected )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    RoutingTestData data;
+    static float hostStorage[HOST_CHANNELS * FRAMES_PER_BUFFER + 16];
+    void *hostChannels[HOST_CHANNELS];
+    void *hostBuffer = hostStorage;
+    int c, bpInitialized = 0, mismatches = 0;
+    unsigned long i;
+
+    printf( "Testing output routing of %d channels from format 0x%08lx to format 0x%08lx.\n",
+            userChannelCount, (unsigned long)userFormat, (unsigned long)hostFormat );
+
+    memset( &data, 0, sizeof(data) );
+    data.userFormat = userFormat;
+    data.userChannelCount = userChannelCount;
+
+    for( i = 0; i < sizeof(hostStorage) / sizeof(hostStorage[0]); ++i )
+        hostStorage[i] = 1.f; /* not silence */
+
+    if( hostFormat & paNonInterleaved )
+    {
+        /* aligned channels are passed to the callback directly */
+        float *aligned = hostStorage;
+        while( ((size_t)aligned & 63) != 0 )
+            ++aligned;
+        for( c = 0; c < HOST_CHANNELS; ++c )
+            hostChannels[c] = aligned + c * FRAMES_PER_BUFFER;
+        hostBuffer = hostChannels;
+    }
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            HOST_CHANNELS, userFormat, hostFormat,
+            SAMPLE_RATE, paClipOff | paDitherOff, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, RoutingCallback, &data ) );
+    bpInitialized = 1;
+
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, userChannelCount, routes, routeCount ) );
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    ProcessOutput( &bufferProcessor, hostBuffer, hostFormat );
+
+    for( c = 0; c < HOST_CHANNELS; ++c )
+    {
+        for( i = 0; i < FRAMES_PER_BUFFER; ++i )
+        {
+            if( fabs( GetSample( hostBuffer, hostFormat, HOST_CHANNELS, c, i ) - expected[c] ) > TOLERANCE )
+                ++mismatches;
+        }
+    }
+    EXPECT_EQ( 0, mismatches );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/* Route the HOST_CHANNELS host input channels, each holding its ChannelLevel(),
+ to userChannelCount channels, and check the input of each user channel. */
+static int TestInputRouting( PaSampleFormat userFormat, PaSampleFormat hostFormat,
+        int userChannelCount, const PaChannelRoute *routes, unsigned long routeCount,
+        const double *expected )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    RoutingTestData data;
+    static float hostStorage[HOST_CHANNELS * FRAMES_PER_BUFFER];
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    int c, bpInitialized = 0, callbackResult = paContinue;
+    unsigned long i;
+
+    printf( "Testing input routing of %d channels from format 0x%08lx to format 0x%08lx.\n",
+            userChannelCount, (unsigned long)hostFormat, (unsigned long)userFormat );
+
+    memset( &data, 0, sizeof(data) );
+    data.userFormat = userFormat;
+    data.userChannelCount = userChannelCount;
+    for( c = 0; c < MAX_USER_CHANNELS; ++c )
+        data.input[c] = -1.;
+
+    for( c = 0; c < HOST_CHANNELS; ++c )
+    {
+        for( i = 0; i < FRAMES_PER_BUFFER; ++i )
+            SetSample( hostStorage, hostFormat, HOST_CHANNELS, c, i, ChannelLevel( c ) );
+    }
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            HOST_CHANNELS, userFormat, hostFormat,
+            0, paFloat32, paFloat32,
+            SAMPLE_RATE, paClipOff | paDitherOff, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, RoutingCallback, &data ) );
+    bpInitialized = 1;
+
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            userChannelCount, routes, routeCount, 0, NULL, 0 ) );
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetInputFrameCount( &bufferProcessor, FRAMES_PER_BUFFER );
+    PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, hostStorage, HOST_CHANNELS );
+    PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+
+    for( c = 0; c < userChannelCount; ++c )
+        EXPECT_TRUE( fabs( data.input[c] - expected[c] ) <= TOLERANCE );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/* A non-interleaved permutation passes the host channels to the callback. */
+static int TestZeroCopyPermutation( void )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    RoutingTestData data;
+    static float hostStorage[HOST_CHANNELS * FRAMES_PER_BUFFER + 16];
+    void *hostChannels[HOST_CHANNELS];
+    float *aligned = hostStorage;
+    PaChannelRoute routes[2] = { { 0, 2, 1.f }, { 1, 3, 1.f } };
+    int c, bpInitialized = 0;
+
+    printf( "Testing zero copy output routing.\n" );
+
+    memset( &data, 0, sizeof(data) );
+    data.userFormat = paFloat32 | paNonInterleaved;
+    data.userChannelCount = 2;
+
+    while( ((size_t)aligned & 63) != 0 )
+        ++aligned;
+    for( c = 0; c < HOST_CHANNELS; ++c )
+        hostChannels[c] = aligned + c * FRAMES_PER_BUFFER;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            HOST_CHANNELS, paFloat32 | paNonInterleaved, paFloat32 | paNonInterleaved,
+            SAMPLE_RATE, paNoFlag, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, RoutingCallback, &data ) );
+    bpInitialized = 1;
+
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, routes, 2 ) );
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    ProcessOutput( &bufferProcessor, hostChannels, paFloat32 | paNonInterleaved );
+
+    ASSERT_TRUE( data.output != NULL );
+    EXPECT_TRUE( ((void* const*)data.output)[0] == hostChannels[2] );
+    EXPECT_TRUE( ((void* const*)data.output)[1] == hostChannels[3] );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/* Invalid routes, blocking streams and changing the routing. */
+static int TestRoutingErrors( void )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    RoutingTestData data;
+    static float hostBuffer[HOST_CHANNELS * FRAMES_PER_BUFFER];
+    PaChannelRoute badUserChannel = { 2, 0, 1.f };
+    PaChannelRoute badHostChannel = { 0, HOST_CHANNELS, 1.f };
+    PaChannelRoute routes[2] = { { 0, 0, 1.f }, { 1, 1, 1.f } };
+    int bpInitialized = 0;
+
+    printf( "Testing routing errors.\n" );
+
+    memset( &data, 0, sizeof(data) );
+    data.userFormat = paFloat32;
+    data.userChannelCount = 2;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            HOST_CHANNELS, paFloat32, paFloat32,
+            SAMPLE_RATE, paNoFlag, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, NULL, &data ) );
+    EXPECT_EQ( paIncompatibleStreamHostApi, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, routes, 2 ) );
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            HOST_CHANNELS, paFloat32, paFloat32,
+            SAMPLE_RATE, paNoFlag, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, RoutingCallback, &data ) );
+    bpInitialized = 1;
+
+    EXPECT_EQ( paInvalidChannelCount, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, &badUserChannel, 1 ) );
+    EXPECT_EQ( paInvalidChannelCount, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, &badHostChannel, 1 ) );
+    EXPECT_EQ( paInvalidChannelCount, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            2, routes, 2, 0, NULL, 0 ) );
+
+    /* route to the first pair, then change the routing to the second pair */
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, routes, 2 ) );
+    routes[0].deviceChannel = 2;
+    routes[1].deviceChannel = 3;
+    ASSERT_EQ( paNoError, PaUtil_EnableBufferProcessorRouting( &bufferProcessor,
+            0, NULL, 0, 2, routes, 2 ) );
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    ProcessOutput( &bufferProcessor, hostBuffer, paFloat32 );
+    EXPECT_TRUE( hostBuffer[0] == 0.f );
+    EXPECT_TRUE( hostBuffer[1] == 0.f );
+    EXPECT_TRUE( hostBuffer[2] == (float)ChannelLevel( 0 ) );
+    EXPECT_TRUE( hostBuffer[3] == (float)ChannelLevel( 1 ) );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    /* stereo to the third and fourth channels */
+    PaChannelRoute thirdPair[2] = { { 0, 2, 1.f }, { 1, 3, 1.f } };
+    double thirdPairLevels[HOST_CHANNELS] = { 0., 0., 0.125, 0.25 };
+    /* swapped and spread */
+    PaChannelRoute swapped[2] = { { 0, 3, 1.f }, { 1, 1, 1.f } };
+    double swappedLevels[HOST_CHANNELS] = { 0., 0.25, 0., 0.125 };
+    /* mono to every channel, with different gains */
+    PaChannelRoute fanOut[4] = { { 0, 0, 1.f }, { 0, 1, 1.f }, { 0, 2, 0.5f }, { 0, 3, -1.f } };
+    double fanOutLevels[HOST_CHANNELS] = { 0.125, 0.125, 0.0625, -0.125 };
+    /* two channels summed into the first, the second unchanged */
+    PaChannelRoute summed[3] = { { 0, 0, 1.f }, { 1, 0, 0.5f }, { 1, 1, 1.f } };
+    double summedLevels[HOST_CHANNELS] = { 0.25, 0.25, 0., 0. };
+    /* input: the fourth and first channels, with an unrouted third channel */
+    PaChannelRoute inputSelect[2] = { { 0, 3, 1.f }, { 1, 0, 1.f } };
+    double inputSelectLevels[3] = { 0.5, 0.125, 0. };
+    /* input: a mono mix of the first two channels */
+    PaChannelRoute inputMix[2] = { { 0, 0, 0.5f }, { 0, 1, 0.5f } };
+    double inputMixLevels[1] = { 0.1875 };
+
+    (void)argc;
+    (void)argv;
+
+    TestOutputRouting( paFloat32 | paNonInterleaved, paFloat32, 2, thirdPair, 2, thirdPairLevels );
+    TestOutputRouting( paFloat32 | paNonInterleaved, paFloat32 | paNonInterleaved, 2, thirdPair, 2, thirdPairLevels );
+    TestOutputRouting( paInt16, paInt16, 2, thirdPair, 2, thirdPairLevels );
+    TestOutputRouting( paInt16, paFloat32, 2, swapped, 2, swappedLevels );
+    TestOutputRouting( paFloat32, paInt32, 1, fanOut, 4, fanOutLevels );
+    TestOutputRouting( paInt16 | paNonInterleaved, paInt16, 2, summed, 3, summedLevels );
+
+    TestInputRouting( paFloat32 | paNonInterleaved, paFloat32, 3, inputSelect, 2, inputSelectLevels );
+    TestInputRouting( paInt16, paInt32, 3, inputSelect, 2, inputSelectLevels );
+    TestInputRouting( paInt32, paFloat32, 1, inputMix, 2, inputMixLevels );
+    TestInputRouting( paFloat32 | paNonInterleaved, paInt16, 1, inputMix, 2, inputMixLevels );
+
+    TestZeroCopyPermutation();
+    TestRoutingErrors();
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,176 @@
+/** @file paqa_stage_timing.c
+    @ingroup qa_src
+    @brief Tests the per stage timing of the buffer processor in pa_process.c.
+    The timing is only checked if PortAudio was built with
+    PA_PROCESS_STAGE_TIMING set to 1.
+
+    Link with pa_process.c, pa_resampler.c, pa_dither.c, pa_converters.c and
+    pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (44100.0)
+#define FRAMES_PER_BUFFER   (256)
+#define CHANNEL_COUNT       (2)
+#define BUFFER_COUNT        (20)
+
+static volatile double gSink;
+
+/* Copy the input to the output, and spend some time computing. */
+static int BusyCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    double sum = 0.;
+    int i;
+    (void)timeInfo;
+    (void)statusFlags;
+    (void)userData;
+
+    memcpy( output, input, frameCount * CHANNEL_COUNT * sizeof(float) );
+
+    for( i = 0; i < 20000; ++i )
+        sum += sin( i * 0.001 );
+    gSink = sum;
+
+    return paContinue;
+}
+
+static int CheckStageTime( const PaStreamStageTime *stageTime, unsigned long count )
+{
+    EXPECT_EQ( (int)count, (int)stageTime->count );
+    EXPECT_TRUE( stageTime->last >= 0. );
+    EXPECT_TRUE( stageTime->maximum >= stageTime->last );
+    EXPECT_TRUE( stageTime->total >= stageTime->maximum );
+    /* less than a second per buffer */
+    EXPECT_TRUE( stageTime->maximum < 1. );
+    return 0;
+}
+
+static int TestStageTiming( void )
+{
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamProcessingTimes times;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    static PaInt16 hostInput[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    static PaInt16 hostOutput[FRAMES_PER_BUFFER * CHANNEL_COUNT];
+    int buffer, callbackResult, bpInitialized = 0;
+    PaError result;
+
+    printf( "Testing stage timing.\n" );
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            CHANNEL_COUNT, paFloat32, paInt16,
+            CHANNEL_COUNT, paFloat32, paInt16,
+            SAMPLE_RATE, paNoFlag, FRAMES_PER_BUFFER, FRAMES_PER_BUFFER,
+            paUtilFixedHostBufferSize, BusyCallback, NULL ) );
+    bpInitialized = 1;
+
+    memset( &times, 0xFF, sizeof(times) );
+    result = PaUtil_GetBufferProcessorStageTimes( &bufferProcessor, &times );
+    if( result == paIncompatibleStreamHostApi )
+    {
+        printf( "  PA_PROCESS_STAGE_TIMING is 0, only checking the result is cleared.\n" );
+        EXPECT_EQ( 0, (int)times.callback.count );
+        EXPECT_TRUE( times.callback.total == 0. );
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+        return 0;
+    }
+    ASSERT_EQ( paNoError, result );
+    EXPECT_EQ( 0, (int)times.inputConversion.count );
+    EXPECT_EQ( 0, (int)times.callback.count );
+    EXPECT_EQ( 0, (int)times.outputConversion.count );
+
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    for( buffer = 0; buffer < BUFFER_COUNT; ++buffer )
+    {
+        PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+        PaUtil_SetInputFrameCount( &bufferProcessor, FRAMES_PER_BUFFER );
+        PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, hostInput, CHANNEL_COUNT );
+        PaUtil_SetOutputFrameCount( &bufferProcessor, FRAMES_PER_BUFFER );
+        PaUtil_SetInterleavedOutputChannels( &bufferProcessor, 0, hostOutput, CHANNEL_COUNT );
+        callbackResult = paContinue;
+        PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+    }
+
+    ASSERT_EQ( paNoError, PaUtil_GetBufferProcessorStageTimes( &bufferProcessor, &times ) );
+    printf( "  input conversion %g s, callback %g s, output conversion %g s\n",
+            times.inputConversion.total, times.callback.total, times.outputConversion.total );
+
+    CheckStageTime( &times.inputConversion, BUFFER_COUNT );
+    CheckStageTime( &times.callback, BUFFER_COUNT );
+    CheckStageTime( &times.outputConversion, BUFFER_COUNT );
+
+    /* the callback does far more work than converting a buffer */
+    EXPECT_TRUE( times.callback.total > times.inputConversion.total );
+    EXPECT_TRUE( times.callback.total > times.outputConversion.total );
+    EXPECT_TRUE( times.callback.total > 0. );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestStageTiming();
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
@@ -0,0 +1,261 @@
+/** @file paqa_zero_copy.c
+    @ingroup qa_src
+    @brief Tests that the buffer processor in pa_process.c passes matching host
+    buffers to the stream callback without copying them.
+
+    Link with pa_process.c, pa_dither.c, pa_converters.c and pa_converters_simd.c
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h> /* for EXIT_SUCCESS and EXIT_FAILURE */
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "paqa_macros.h"
+
+PAQA_INSTANTIATE_GLOBALS
+
+#define SAMPLE_RATE         (44100.0)
+#define CHANNEL_COUNT       (2)
+#define FIRST_FRAMES        (64)
+#define SECOND_FRAMES       (32)
+#define TOTAL_FRAMES        (FIRST_FRAMES + SECOND_FRAMES)
+#define ALIGNMENT           (64)
+
+typedef struct ZeroCopyTestData
+{
+    int interleaved;
+    int callbackCount;
+    const void *outputs[4][CHANNEL_COUNT]; /* output pointers seen by each callback */
+    unsigned long frameCounts[4];
+    float nextValue;
+} ZeroCopyTestData;
+
+static int RecordingCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    ZeroCopyTestData *data = (ZeroCopyTestData*)userData;
+    unsigned long i;
+    int c;
+    (void)input;
+    (void)timeInfo;
+    (void)statusFlags;
+
+    if( output && data->callbackCount < 4 )
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+            data->outputs[data->callbackCount][c] = data->interleaved ? output : ((void**)output)[c];
+        data->frameCounts[data->callbackCount] = frameCount;
+    }
+    ++data->callbackCount;
+
+    if( !output )
+        return paContinue;
+
+    for( i = 0; i < frameCount; ++i )
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+        {
+            float value = data->nextValue + (float)c * 0.5f;
+            if( data->interleaved )
+                ((float*)output)[i * CHANNEL_COUNT + c] = value;
+            else
+                ((float**)output)[c][i] = value;
+        }
+        data->nextValue += 1.0f / 1024.0f;
+    }
+
+    return paContinue;
+}
+
+/* Return a pointer within buffer aligned to ALIGNMENT bytes. */
+static float *AlignPointer( float *buffer )
+{
+    unsigned char *p = (unsigned char*)buffer;
+    return (float*)(p + ((ALIGNMENT - ((size_t)p & (ALIGNMENT - 1))) & (ALIGNMENT - 1)));
+}
+
+/* Process Float32 output split across two host buffer segments, and check
+ that the callback wrote directly into both segments. */
+static int TestOutputSegments( int interleaved )
+{
+    static float storage[CHANNEL_COUNT][TOTAL_FRAMES * CHANNEL_COUNT + ALIGNMENT];
+    float *host[CHANNEL_COUNT];
+    PaSampleFormat format = paFloat32 | (interleaved ? 0 : paNonInterleaved);
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    ZeroCopyTestData data;
+    int callbackResult = paContinue;
+    int c, bpInitialized = 0, mismatches = 0;
+    unsigned long i;
+
+    printf( "Testing %s output segments.\n", interleaved ? "interleaved" : "non-interleaved" );
+
+    memset( &data, 0, sizeof(data) );
+    data.interleaved = interleaved;
+
+    for( c = 0; c < CHANNEL_COUNT; ++c )
+    {
+        host[c] = AlignPointer( storage[c] );
+        memset( host[c], 0, TOTAL_FRAMES * CHANNEL_COUNT * sizeof(float) );
+    }
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            0, paFloat32, paFloat32,
+            CHANNEL_COUNT, format, format,
+            SAMPLE_RATE, paClipOff | paDitherOff, 0, TOTAL_FRAMES,
+            paUtilBoundedHostBufferSize, RecordingCallback, &data ) );
+    bpInitialized = 1;
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    /* the second segment is the start of the host buffer, as with a ring
+        buffer which wraps around */
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetOutputFrameCount( &bufferProcessor, FIRST_FRAMES );
+    PaUtil_Set2ndOutputFrameCount( &bufferProcessor, SECOND_FRAMES );
+    if( interleaved )
+    {
+        PaUtil_SetInterleavedOutputChannels( &bufferProcessor, 0,
+                host[0] + SECOND_FRAMES * CHANNEL_COUNT, CHANNEL_COUNT );
+        PaUtil_Set2ndInterleavedOutputChannels( &bufferProcessor, 0, host[0], CHANNEL_COUNT );
+    }
+    else
+    {
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+        {
+            PaUtil_SetNonInterleavedOutputChannel( &bufferProcessor, c, host[c] + SECOND_FRAMES );
+            PaUtil_Set2ndNonInterleavedOutputChannel( &bufferProcessor, c, host[c] );
+        }
+    }
+    EXPECT_EQ( TOTAL_FRAMES, (int)PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult ) );
+
+    ASSERT_EQ( 2, data.callbackCount );
+    EXPECT_EQ( FIRST_FRAMES, (int)data.frameCounts[0] );
+    EXPECT_EQ( SECOND_FRAMES, (int)data.frameCounts[1] );
+    for( c = 0; c < (interleaved ? 1 : CHANNEL_COUNT); ++c )
+    {
+        EXPECT_TRUE( data.outputs[0][c] == (interleaved ? host[c] + SECOND_FRAMES * CHANNEL_COUNT : host[c] + SECOND_FRAMES) );
+        EXPECT_TRUE( data.outputs[1][c] == host[c] );
+    }
+
+    /* check the samples, in the order they were generated */
+    for( i = 0; i < TOTAL_FRAMES; ++i )
+    {
+        unsigned long frame = (i + SECOND_FRAMES) % TOTAL_FRAMES;
+        for( c = 0; c < CHANNEL_COUNT; ++c )
+        {
+            float expected = (float)i / 1024.0f + (float)c * 0.5f;
+            float actual = interleaved ? host[0][frame * CHANNEL_COUNT + c] : host[c][frame];
+            if( actual != expected )
+                ++mismatches;
+        }
+    }
+    EXPECT_EQ( 0, mismatches );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/* A full-duplex stream without output buffers must not pass a NULL output
+ buffer to the callback. */
+static int TestNoOutput( int interleaved )
+{
+    static float input[TOTAL_FRAMES * CHANNEL_COUNT];
+    PaSampleFormat format = paFloat32 | (interleaved ? 0 : paNonInterleaved);
+    PaUtilBufferProcessor bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    ZeroCopyTestData data;
+    int callbackResult = paContinue;
+    int c, bpInitialized = 0;
+
+    printf( "Testing %s output without host buffers.\n", interleaved ? "interleaved" : "non-interleaved" );
+
+    memset( &data, 0, sizeof(data) );
+    data.interleaved = interleaved;
+
+    ASSERT_EQ( paNoError, PaUtil_InitializeBufferProcessor( &bufferProcessor,
+            CHANNEL_COUNT, paFloat32, paFloat32,
+            CHANNEL_COUNT, format, format,
+            SAMPLE_RATE, paClipOff | paDitherOff, 0, TOTAL_FRAMES,
+            paUtilBoundedHostBufferSize, RecordingCallback, &data ) );
+    bpInitialized = 1;
+    PaUtil_ResetBufferProcessor( &bufferProcessor );
+
+    PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+    PaUtil_SetInputFrameCount( &bufferProcessor, TOTAL_FRAMES );
+    PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, input, CHANNEL_COUNT );
+    PaUtil_SetOutputFrameCount( &bufferProcessor, TOTAL_FRAMES );
+    PaUtil_SetNoOutput( &bufferProcessor );
+    EXPECT_EQ( TOTAL_FRAMES, (int)PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult ) );
+
+    ASSERT_EQ( 1, data.callbackCount );
+    for( c = 0; c < (interleaved ? 1 : CHANNEL_COUNT); ++c )
+        EXPECT_TRUE( data.outputs[0][c] != NULL );
+
+    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return 0;
+
+error:
+    if( bpInitialized )
+        PaUtil_TerminateBufferProcessor( &bufferProcessor );
+    return -1;
+}
+
+/*******************************************************************/
+int main( int argc, const char **argv )
+{
+    (void)argc;
+    (void)argv;
+
+    TestOutputSegments( 1 );
+    TestOutputSegments( 0 );
+    TestNoOutput( 1 );
+    TestNoOutput( 0 );
+
+    PAQA_PRINT_RESULT;
+    return PAQA_EXIT_RESULT;
+}
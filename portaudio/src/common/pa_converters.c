@@ -59,7 +59,12 @@
 */
 
 
+#include <stdlib.h> /* getenv() */
+#include <string.h> /* strcmp() */
+
 #include "pa_converters.h"
+#include "pa_converters_simd.h"
+#include "pa_debugprint.h"
 #include "pa_dither.h"
 #include "pa_endianness.h"
 #include "pa_types.h"
@@ -79,8 +84,14 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
             descending order of quality - ie best quality is 0
             FIXME: should write an assert which checks that all of the
             known constants conform to that requirement.
+
+            paFloat64 is the exception: it was added after the other
+            constants, so it is treated as being better than paFloat32.
         */
 
+        if( format == paFloat64 )
+            return PaUtil_SelectClosestAvailableFormat( availableFormats, paFloat32 );
+
         if( format != 0x01 )
         {
             /* scan for better formats */
@@ -96,6 +107,11 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
             result = 0;
         }
 
+        if( result == 0 && (availableFormats & paFloat64) ){
+            /* no better format than paFloat64 */
+            result = paFloat64;
+        }
+
         if( result == 0 ){
             /* scan for worse formats */
             result = format;
@@ -118,8 +134,10 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 
 /* -------------------------------------------------------------------------- */
 
-#define PA_SELECT_FORMAT_( format, float32, int32, int24, int16, int8, uint8 ) \
+#define PA_SELECT_FORMAT_( format, float64, float32, int32, int24, int16, int8, uint8 ) \
     switch( format & ~paNonInterleaved ){                                      \
+    case paFloat64:                                                            \
+        float64                                                                \
     case paFloat32:                                                            \
         float32                                                                \
     case paInt32:                                                              \
@@ -163,6 +181,14 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 
 /* -------------------------------------------------------------------------- */
 
+#define PA_SELECT_NOISE_SHAPED_CONVERTER_( flags, source, destination )        \
+    if( (flags & paNoiseShapedDither) && !(flags & paDitherOff)                \
+            && paConverters. source ## _To_ ## destination ## _NoiseShaped ){  \
+        return paConverters. source ## _To_ ## destination ## _NoiseShaped;    \
+    }
+
+/* -------------------------------------------------------------------------- */
+
 #define PA_USE_CONVERTER_( source, destination )\
     return paConverters. source ## _To_ ## destination;
 
@@ -173,39 +199,66 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 
 /* -------------------------------------------------------------------------- */
 
+#ifndef PA_NO_STANDARD_CONVERTERS
+static void EnsureConverterTierInstalled( void );
+static int IsFrameConverterFaster( PaSampleFormat sourceFormat, PaSampleFormat destinationFormat );
+#endif
+
 PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags )
 {
+#ifndef PA_NO_STANDARD_CONVERTERS
+    EnsureConverterTierInstalled();
+#endif
+
     PA_SELECT_FORMAT_( sourceFormat,
+                       /* paFloat64: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_UNITY_CONVERSION_( 64 ),
+                                          /* paFloat32: */        PA_USE_CONVERTER_( Float64, Float32 ),
+                                          /* paInt32: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int32 ),
+                                          /* paInt24: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int24 ),
+                                          /* paInt16: */          PA_SELECT_NOISE_SHAPED_CONVERTER_( flags, Float64, Int16 )
+                                                                PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int16 ),
+                                          /* paInt8: */           PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, Int8 ),
+                                          /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float64, UInt8 )
+                                        ),
                        /* paFloat32: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Float32, Float64 ),
                                           /* paFloat32: */        PA_UNITY_CONVERSION_( 32 ),
                                           /* paInt32: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int32 ),
                                           /* paInt24: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int24 ),
-                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int16 ),
+                                          /* paInt16: */          PA_SELECT_NOISE_SHAPED_CONVERTER_( flags, Float32, Int16 )
+                                                                PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, Int8 ),
                                           /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_CLIP_( flags, Float32, UInt8 )
                                         ),
                        /* paInt32: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int32, Float64 ),
                                           /* paFloat32: */        PA_USE_CONVERTER_( Int32, Float32 ),
                                           /* paInt32: */          PA_UNITY_CONVERSION_( 32 ),
                                           /* paInt24: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int24 ),
-                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int16 ),
+                                          /* paInt16: */          PA_SELECT_NOISE_SHAPED_CONVERTER_( flags, Int32, Int16 )
+                                                                PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int32, Int8 ),
                                           /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int32, UInt8 )
                                         ),
                        /* paInt24: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int24, Float64 ),
                                           /* paFloat32: */        PA_USE_CONVERTER_( Int24, Float32 ),
                                           /* paInt32: */          PA_USE_CONVERTER_( Int24, Int32 ),
                                           /* paInt24: */          PA_UNITY_CONVERSION_( 24 ),
-                                          /* paInt16: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24, Int16 ),
+                                          /* paInt16: */          PA_SELECT_NOISE_SHAPED_CONVERTER_( flags, Int24, Int16 )
+                                                                PA_SELECT_CONVERTER_DITHER_( flags, Int24, Int16 ),
                                           /* paInt8: */           PA_SELECT_CONVERTER_DITHER_( flags, Int24, Int8 ),
                                           /* paUInt8: */          PA_SELECT_CONVERTER_DITHER_( flags, Int24, UInt8 )
                                         ),
                        /* paInt16: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int16, Float64 ),
                                           /* paFloat32: */        PA_USE_CONVERTER_( Int16, Float32 ),
                                           /* paInt32: */          PA_USE_CONVERTER_( Int16, Int32 ),
                                           /* paInt24: */          PA_USE_CONVERTER_( Int16, Int24 ),
@@ -215,6 +268,7 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                         ),
                        /* paInt8: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( Int8, Float64 ),
                                           /* paFloat32: */        PA_USE_CONVERTER_( Int8, Float32 ),
                                           /* paInt32: */          PA_USE_CONVERTER_( Int8, Int32 ),
                                           /* paInt24: */          PA_USE_CONVERTER_( Int8, Int24 ),
@@ -224,6 +278,7 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
                                         ),
                        /* paUInt8: */
                        PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_USE_CONVERTER_( UInt8, Float64 ),
                                           /* paFloat32: */        PA_USE_CONVERTER_( UInt8, Float32 ),
                                           /* paInt32: */          PA_USE_CONVERTER_( UInt8, Int32 ),
                                           /* paInt24: */          PA_USE_CONVERTER_( UInt8, Int24 ),
@@ -236,6 +291,114 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
 
 /* -------------------------------------------------------------------------- */
 
+#define PA_SELECT_FRAME_CONVERTER_DITHER_CLIP_( table, flags, source, destination ) \
+    if( flags & paClipOff ){ /* no clip */                                     \
+        if( flags & paDitherOff ){ /* no dither */                             \
+            return table-> source ## _To_ ## destination;                      \
+        }else{ /* dither */                                                    \
+            return table-> source ## _To_ ## destination ## _Dither;           \
+        }                                                                      \
+    }else{ /* clip */                                                          \
+        if( flags & paDitherOff ){ /* no dither */                             \
+            return table-> source ## _To_ ## destination ## _Clip;             \
+        }else{ /* dither */                                                    \
+            return table-> source ## _To_ ## destination ## _DitherClip;       \
+        }                                                                      \
+    }
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_USE_FRAME_CONVERTER_( table, source, destination )\
+    return table-> source ## _To_ ## destination;
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_UNITY_FRAME_CONVERSION_( table, wordlength )\
+    return table-> Copy_ ## wordlength ## _To_ ## wordlength;
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_NO_FRAME_CONVERTER_\
+    return 0;
+
+/* -------------------------------------------------------------------------- */
+
+PaUtilFrameConverter* PaUtil_SelectFrameConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags )
+{
+    PaUtilFrameConverterTable *table;
+
+    /* noise shaping keeps separate state for each channel, which a frame
+        converter can't do */
+    if( (flags & paNoiseShapedDither) && !(flags & paDitherOff)
+            && (destinationFormat & ~paNonInterleaved) == paInt16 )
+        return 0;
+
+    if( (sourceFormat & paNonInterleaved) && !(destinationFormat & paNonInterleaved) )
+        table = &paInterleavingConverters;
+    else if( !(sourceFormat & paNonInterleaved) && (destinationFormat & paNonInterleaved) )
+        table = &paDeinterleavingConverters;
+    else
+        return 0;
+
+#ifndef PA_NO_STANDARD_CONVERTERS
+    EnsureConverterTierInstalled();
+    if( !IsFrameConverterFaster( sourceFormat, destinationFormat ) )
+        return 0;
+#endif
+
+    PA_SELECT_FORMAT_( sourceFormat,
+                       /* paFloat64: */
+                       PA_NO_FRAME_CONVERTER_,
+                       /* paFloat32: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_NO_FRAME_CONVERTER_,
+                                          /* paFloat32: */        PA_UNITY_FRAME_CONVERSION_( table, 32 ),
+                                          /* paInt32: */          PA_SELECT_FRAME_CONVERTER_DITHER_CLIP_( table, flags, Float32, Int32 ),
+                                          /* paInt24: */          PA_SELECT_FRAME_CONVERTER_DITHER_CLIP_( table, flags, Float32, Int24 ),
+                                          /* paInt16: */          PA_SELECT_FRAME_CONVERTER_DITHER_CLIP_( table, flags, Float32, Int16 ),
+                                          /* paInt8: */           PA_NO_FRAME_CONVERTER_,
+                                          /* paUInt8: */          PA_NO_FRAME_CONVERTER_
+                                        ),
+                       /* paInt32: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_NO_FRAME_CONVERTER_,
+                                          /* paFloat32: */        PA_USE_FRAME_CONVERTER_( table, Int32, Float32 ),
+                                          /* paInt32: */          PA_UNITY_FRAME_CONVERSION_( table, 32 ),
+                                          /* paInt24: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt16: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt8: */           PA_NO_FRAME_CONVERTER_,
+                                          /* paUInt8: */          PA_NO_FRAME_CONVERTER_
+                                        ),
+                       /* paInt24: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_NO_FRAME_CONVERTER_,
+                                          /* paFloat32: */        PA_USE_FRAME_CONVERTER_( table, Int24, Float32 ),
+                                          /* paInt32: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt24: */          PA_UNITY_FRAME_CONVERSION_( table, 24 ),
+                                          /* paInt16: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt8: */           PA_NO_FRAME_CONVERTER_,
+                                          /* paUInt8: */          PA_NO_FRAME_CONVERTER_
+                                        ),
+                       /* paInt16: */
+                       PA_SELECT_FORMAT_( destinationFormat,
+                                          /* paFloat64: */        PA_NO_FRAME_CONVERTER_,
+                                          /* paFloat32: */        PA_USE_FRAME_CONVERTER_( table, Int16, Float32 ),
+                                          /* paInt32: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt24: */          PA_NO_FRAME_CONVERTER_,
+                                          /* paInt16: */          PA_UNITY_FRAME_CONVERSION_( table, 16 ),
+                                          /* paInt8: */           PA_NO_FRAME_CONVERTER_,
+                                          /* paUInt8: */          PA_NO_FRAME_CONVERTER_
+                                        ),
+                       /* paInt8: */
+                       PA_NO_FRAME_CONVERTER_,
+                       /* paUInt8: */
+                       PA_NO_FRAME_CONVERTER_
+                     )
+}
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef PA_NO_STANDARD_CONVERTERS
 
 /* -------------------------------------------------------------------------- */
@@ -255,6 +418,7 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Float32_To_Int16_Dither; */
     0, /* PaUtilConverter *Float32_To_Int16_Clip; */
     0, /* PaUtilConverter *Float32_To_Int16_DitherClip; */
+    0, /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
 
     0, /* PaUtilConverter *Float32_To_Int8; */
     0, /* PaUtilConverter *Float32_To_Int8_Dither; */
@@ -271,6 +435,7 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Int32_To_Int24_Dither; */
     0, /* PaUtilConverter *Int32_To_Int16; */
     0, /* PaUtilConverter *Int32_To_Int16_Dither; */
+    0, /* PaUtilConverter *Int32_To_Int16_NoiseShaped; */
     0, /* PaUtilConverter *Int32_To_Int8; */
     0, /* PaUtilConverter *Int32_To_Int8_Dither; */
     0, /* PaUtilConverter *Int32_To_UInt8; */
@@ -280,6 +445,7 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Int24_To_Int32; */
     0, /* PaUtilConverter *Int24_To_Int16; */
     0, /* PaUtilConverter *Int24_To_Int16_Dither; */
+    0, /* PaUtilConverter *Int24_To_Int16_NoiseShaped; */
     0, /* PaUtilConverter *Int24_To_Int8; */
     0, /* PaUtilConverter *Int24_To_Int8_Dither; */
     0, /* PaUtilConverter *Int24_To_UInt8; */
@@ -305,14 +471,102 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *UInt8_To_Int16; */
     0, /* PaUtilConverter *UInt8_To_Int8; */
 
+    0, /* PaUtilConverter *Float32_To_Float64; */
+    0, /* PaUtilConverter *Float64_To_Float32; */
+
+    0, /* PaUtilConverter *Float64_To_Int32; */
+    0, /* PaUtilConverter *Float64_To_Int32_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int32_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int32_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int24; */
+    0, /* PaUtilConverter *Float64_To_Int24_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int24_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int24_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_Int16; */
+    0, /* PaUtilConverter *Float64_To_Int16_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int16_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int16_DitherClip; */
+    0, /* PaUtilConverter *Float64_To_Int16_NoiseShaped; */
+
+    0, /* PaUtilConverter *Float64_To_Int8; */
+    0, /* PaUtilConverter *Float64_To_Int8_Dither; */
+    0, /* PaUtilConverter *Float64_To_Int8_Clip; */
+    0, /* PaUtilConverter *Float64_To_Int8_DitherClip; */
+
+    0, /* PaUtilConverter *Float64_To_UInt8; */
+    0, /* PaUtilConverter *Float64_To_UInt8_Dither; */
+    0, /* PaUtilConverter *Float64_To_UInt8_Clip; */
+    0, /* PaUtilConverter *Float64_To_UInt8_DitherClip; */
+
+    0, /* PaUtilConverter *Int32_To_Float64; */
+    0, /* PaUtilConverter *Int24_To_Float64; */
+    0, /* PaUtilConverter *Int16_To_Float64; */
+    0, /* PaUtilConverter *Int8_To_Float64; */
+    0, /* PaUtilConverter *UInt8_To_Float64; */
+
     0, /* PaUtilConverter *Copy_8_To_8; */
     0, /* PaUtilConverter *Copy_16_To_16; */
     0, /* PaUtilConverter *Copy_24_To_24; */
-    0  /* PaUtilConverter *Copy_32_To_32; */
+    0, /* PaUtilConverter *Copy_32_To_32; */
+    0  /* PaUtilConverter *Copy_64_To_64; */
 };
 
 /* -------------------------------------------------------------------------- */
 
+/* -------------------------------------------------------------------------- */
+
+PaUtilFrameConverterTable paInterleavingConverters = {
+    0, /* PaUtilFrameConverter *Float32_To_Int32; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Float32_To_Int24; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Float32_To_Int16; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Int32_To_Float32; */
+    0, /* PaUtilFrameConverter *Int24_To_Float32; */
+    0, /* PaUtilFrameConverter *Int16_To_Float32; */
+
+    0, /* PaUtilFrameConverter *Copy_16_To_16; */
+    0, /* PaUtilFrameConverter *Copy_24_To_24; */
+    0  /* PaUtilFrameConverter *Copy_32_To_32; */
+};
+
+PaUtilFrameConverterTable paDeinterleavingConverters = {
+    0, /* PaUtilFrameConverter *Float32_To_Int32; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int32_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Float32_To_Int24; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int24_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Float32_To_Int16; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_Dither; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_Clip; */
+    0, /* PaUtilFrameConverter *Float32_To_Int16_DitherClip; */
+
+    0, /* PaUtilFrameConverter *Int32_To_Float32; */
+    0, /* PaUtilFrameConverter *Int24_To_Float32; */
+    0, /* PaUtilFrameConverter *Int16_To_Float32; */
+
+    0, /* PaUtilFrameConverter *Copy_16_To_16; */
+    0, /* PaUtilFrameConverter *Copy_24_To_24; */
+    0  /* PaUtilFrameConverter *Copy_32_To_32; */
+};
+
 #else /* PA_NO_STANDARD_CONVERTERS is not defined */
 
 /* -------------------------------------------------------------------------- */
@@ -320,6 +574,61 @@ PaUtilConverterTable paConverters = {
 #define PA_CLIP_( val, min, max )\
     { val = ((val) < (min)) ? (min) : (((val) > (max)) ? (max) : (val)); }
 
+/* Load and store a packed 24 bit sample, held in the most significant bits
+ of a PaInt32. */
+#if defined(PA_LITTLE_ENDIAN)
+#define PA_LOAD_INT24_( src )\
+    ((((PaInt32)(src)[0]) << 8) | (((PaInt32)(src)[1]) << 16) | (((PaInt32)(src)[2]) << 24))
+#define PA_STORE_INT24_( dest, temp )\
+    { (dest)[0] = (unsigned char)((temp) >> 8); (dest)[1] = (unsigned char)((temp) >> 16); (dest)[2] = (unsigned char)((temp) >> 24); }
+#elif defined(PA_BIG_ENDIAN)
+#define PA_LOAD_INT24_( src )\
+    ((((PaInt32)(src)[0]) << 24) | (((PaInt32)(src)[1]) << 16) | (((PaInt32)(src)[2]) << 8))
+#define PA_STORE_INT24_( dest, temp )\
+    { (dest)[0] = (unsigned char)((temp) >> 24); (dest)[1] = (unsigned char)((temp) >> 16); (dest)[2] = (unsigned char)((temp) >> 8); }
+#endif
+
+/* Pack and unpack 4 contiguous 24 bit samples as 3 whole 32 bit words, with
+ the samples held in the most significant bits of a PaInt32 as above. These
+ are used by the Int24 converters when the packed side has unit stride. */
+static void PackInt24x4_( unsigned char *dest, const PaInt32 *block )
+{
+    PaUint32 words[3];
+    PaUint32 s0 = (PaUint32)block[0], s1 = (PaUint32)block[1];
+    PaUint32 s2 = (PaUint32)block[2], s3 = (PaUint32)block[3];
+
+#if defined(PA_LITTLE_ENDIAN)
+    words[0] = (s0 >> 8) | ((s1 & 0x0000FF00) << 16);
+    words[1] = (s1 >> 16) | ((s2 & 0x00FFFF00) << 8);
+    words[2] = (s2 >> 24) | (s3 & 0xFFFFFF00);
+#elif defined(PA_BIG_ENDIAN)
+    words[0] = (s0 & 0xFFFFFF00) | (s1 >> 24);
+    words[1] = ((s1 << 8) & 0xFFFF0000) | (s2 >> 16);
+    words[2] = ((s2 << 16) & 0xFF000000) | (s3 >> 8);
+#endif
+
+    memcpy( dest, words, 12 );
+}
+
+static void UnpackInt24x4_( PaInt32 *block, const unsigned char *src )
+{
+    PaUint32 words[3];
+
+    memcpy( words, src, 12 );
+
+#if defined(PA_LITTLE_ENDIAN)
+    block[0] = (PaInt32)(words[0] << 8);
+    block[1] = (PaInt32)(((words[0] >> 16) & 0x0000FF00) | (words[1] << 16));
+    block[2] = (PaInt32)(((words[1] >> 8) & 0x00FFFF00) | (words[2] << 24));
+    block[3] = (PaInt32)(words[2] & 0xFFFFFF00);
+#elif defined(PA_BIG_ENDIAN)
+    block[0] = (PaInt32)(words[0] & 0xFFFFFF00);
+    block[1] = (PaInt32)((words[0] << 24) | ((words[1] >> 8) & 0x00FFFF00));
+    block[2] = (PaInt32)((words[1] << 16) | ((words[2] >> 16) & 0x0000FF00));
+    block[3] = (PaInt32)(words[2] << 8);
+#endif
+}
+
 
 static const float const_1_div_128_ = 1.0f / 128.0f;  /* 8 bit multiplier */
 
@@ -358,17 +667,26 @@ static void Float32_To_Int32_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        *dest = (PaInt32) dithered;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            /* REVIEW */
+            double dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither;
+            *dest = (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -404,18 +722,27 @@ static void Float32_To_Int32_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
-        *dest = (PaInt32) dithered;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            /* REVIEW */
+            double dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither;
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
+            *dest = (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -432,6 +759,24 @@ static void Float32_To_Int24(
 
     (void) ditherGenerator; /* unused parameter */
 
+    if( destinationStride == 1 )
+    {
+        PaInt32 block[4];
+
+        while( count >= 4 )
+        {
+            block[0] = (PaInt32) ((double)src[0] * 2147483647.0);
+            block[1] = (PaInt32) ((double)src[sourceStride] * 2147483647.0);
+            block[2] = (PaInt32) ((double)src[sourceStride * 2] * 2147483647.0);
+            block[3] = (PaInt32) ((double)src[sourceStride * 3] * 2147483647.0);
+            PackInt24x4_( dest, block );
+
+            src += sourceStride * 4;
+            dest += 12;
+            count -= 4;
+        }
+    }
+
     while( count-- )
     {
         /* convert to 32 bit and drop the low 8 bits */
@@ -463,29 +808,38 @@ static void Float32_To_Int24_Dither(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
 
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
+            double dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither;
 
-        temp = (PaInt32) dithered;
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
     }
 }
 
@@ -534,30 +888,39 @@ static void Float32_To_Int24_DitherClip(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
+
+            double dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither;
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
 
-        temp = (PaInt32) dithered;
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
     }
 }
 
@@ -591,18 +954,27 @@ static void Float32_To_Int16_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
+        for( i=0; i<blockCount; ++i )
+        {
 
-        *dest = (PaInt16) dithered;
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither;
 
-        src += sourceStride;
-        dest += destinationStride;
+            *dest = (PaInt16) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -638,21 +1010,104 @@ static void Float32_To_Int16_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither;
+            PaInt32 samp = (PaInt32) dithered;
+            PA_CLIP_( samp, -0x8000, 0x7FFF );
+            *dest = (PaInt16) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
+/* Requantize samples, given in units of 16 bit LSBs, to 16 bits using highpass
+ triangular dither with 2nd order error feedback noise shaping, after the
+ algorithm by Paul Kellett quoted in pa_dither.c. The error feedback is
+ recursive, so samples are processed one at a time, but the dither is
+ generated a block at a time. The error state is kept in ditherGenerator,
+ which must therefore not be shared between channels. Always clips, because
+ the shaped noise may push full scale samples out of range.
+*/
+static void NoiseShapeToInt16( PaInt16 *dest, signed int destinationStride,
+        const float *samples, unsigned int count,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float dither[PA_DITHER_BLOCK_SIZE];
+    float error1 = ditherGenerator->noiseShapingError1;
+    float error2 = ditherGenerator->noiseShapingError2;
+    unsigned int i;
+
+    PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, count );
+
+    for( i=0; i<count; ++i )
+    {
+        float shaped = samples[i] + error1 - (0.5f * error2);
+        float dithered = shaped + dither[i] + 0.5f; /* + 0.5 to round to nearest */
         PaInt32 samp = (PaInt32) dithered;
+        if( dithered < (float)samp ) /* floor() negative values */
+            --samp;
+
+        error2 = error1;
+        error1 = shaped - (float)samp;
+
         PA_CLIP_( samp, -0x8000, 0x7FFF );
         *dest = (PaInt16) samp;
 
-        src += sourceStride;
         dest += destinationStride;
     }
+
+    /* don't let non-finite input samples disable noise shaping for good */
+    if( !(error1 > -16.0f && error1 < 16.0f && error2 > -16.0f && error2 < 16.0f) )
+        error1 = error2 = 0.0f;
+
+    ditherGenerator->noiseShapingError1 = error1;
+    ditherGenerator->noiseShapingError2 = error2;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    float samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            samples[i] = *src * (32767.0f);
+            src += sourceStride;
+        }
+
+        NoiseShapeToInt16( dest, destinationStride, samples, blockCount, ditherGenerator );
+
+        dest += blockCount * destinationStride;
+        count -= blockCount;
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -685,17 +1140,26 @@ static void Float32_To_Int8_Dither(
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        *dest = (signed char) samp;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither;
+            PaInt32 samp = (PaInt32) dithered;
+            *dest = (signed char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -730,19 +1194,27 @@ static void Float32_To_Int8_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x80, 0x7F );
-        *dest = (signed char) samp;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither;
+            PaInt32 samp = (PaInt32) dithered;
+            PA_CLIP_( samp, -0x80, 0x7F );
+            *dest = (signed char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -776,17 +1248,26 @@ static void Float32_To_UInt8_Dither(
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        *dest = (unsigned char) (128 + samp);
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither;
+            PaInt32 samp = (PaInt32) dithered;
+            *dest = (unsigned char) (128 + samp);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -821,19 +1302,27 @@ static void Float32_To_UInt8_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = 128 + (PaInt32) dithered;
-        PA_CLIP_( samp, 0x0000, 0x00FF );
-        *dest = (unsigned char) samp;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            float dither  = ditherBlock[i];
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither;
+            PaInt32 samp = 128 + (PaInt32) dithered;
+            PA_CLIP_( samp, 0x0000, 0x00FF );
+            *dest = (unsigned char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -931,25 +1420,63 @@ static void Int32_To_Int16_Dither(
     PaInt32 *src = (PaInt32*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
     PaInt32 dither;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator );
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* REVIEW */
+            dither = ditherBlock[i];
 #if 1
-        *dest = (PaInt16) ((((*src)>>1) + dither) >> 15);
+            *dest = (PaInt16) ((((*src)>>1) + dither) >> 15);
 #else
-        /* EXPERIMENTAL force clip after dither. see ticket #112
-           Clip the intermediate value because adding the dither could cause
-           a numeric wraparound when shifting.
-        */
-        PaInt32 temp = (((*src)>>1) + dither);
-        PA_CLIP_(temp, (PaInt32) 0xC0000000, (PaInt32) 0x3FFFFFFF);
-        *dest = (PaInt16) (temp >> 15);
+            /* EXPERIMENTAL force clip after dither. see ticket #112
+               Clip the intermediate value because adding the dither could cause
+               a numeric wraparound when shifting.
+            */
+            PaInt32 temp = (((*src)>>1) + dither);
+            PA_CLIP_(temp, (PaInt32) 0xC0000000, (PaInt32) 0x3FFFFFFF);
+            *dest = (PaInt16) (temp >> 15);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    float samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            samples[i] = (float)*src * (1.0f / 65536.0f);
+            src += sourceStride;
+        }
+
+        NoiseShapeToInt16( dest, destinationStride, samples, blockCount, ditherGenerator );
+
+        dest += blockCount * destinationStride;
+        count -= blockCount;
     }
 }
 
@@ -983,17 +1510,26 @@ static void Int32_To_Int8_Dither(
     PaInt32 *src = (PaInt32*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
     PaInt32 dither;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit */
-        *dest = (signed char) ((((*src) >> 1) + dither) >> 23);
+        for( i=0; i<blockCount; ++i )
+        {
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        src += sourceStride;
-        dest += destinationStride;
+            /* apply dither, truncate resulting 32-bit value to 8-bit */
+            *dest = (signed char) ((((*src) >> 1) + dither) >> 23);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1026,19 +1562,28 @@ static void Int32_To_UInt8_Dither(
 {
     PaInt32 *src = (PaInt32*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 dither;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
-        *dest = (unsigned char) ((((src[0] >> 1) + dither) >> 23) + 128);
+            /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
+            *dest = (unsigned char) ((((src[0] >> 1) + dither) >> 23) + 128);
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1088,16 +1633,48 @@ static void Int24_To_Int32(
 
     (void) ditherGenerator; /* unused parameter */
 
-    while( count-- )
+    if( sourceStride == 1 )
     {
+        PaInt32 block[4];
 
-#if defined(PA_LITTLE_ENDIAN)
-        temp = (((PaInt32)src[0]) << 8);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 24);
-#elif defined(PA_BIG_ENDIAN)
-        temp = (((PaInt32)src[0]) << 24);
-        temp = temp | (((PaInt32)src[1]) << 16);
+        if( destinationStride == 1 )
+        {
+            while( count >= 4 )
+            {
+                UnpackInt24x4_( dest, src );
+
+                src += 12;
+                dest += 4;
+                count -= 4;
+            }
+        }
+        else
+        {
+            while( count >= 4 )
+            {
+                UnpackInt24x4_( block, src );
+                dest[0] = block[0];
+                dest[destinationStride] = block[1];
+                dest[destinationStride * 2] = block[2];
+                dest[destinationStride * 3] = block[3];
+
+                src += 12;
+                dest += destinationStride * 4;
+                count -= 4;
+            }
+        }
+    }
+
+    while( count-- )
+    {
+
+#if defined(PA_LITTLE_ENDIAN)
+        temp = (((PaInt32)src[0]) << 8);
+        temp = temp | (((PaInt32)src[1]) << 16);
+        temp = temp | (((PaInt32)src[2]) << 24);
+#elif defined(PA_BIG_ENDIAN)
+        temp = (((PaInt32)src[0]) << 24);
+        temp = temp | (((PaInt32)src[1]) << 16);
         temp = temp | (((PaInt32)src[2]) << 8);
 #endif
 
@@ -1151,28 +1728,76 @@ static void Int24_To_Int16_Dither(
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 temp, dither;
 
-    while( count-- )
+    while( count > 0 )
     {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
 
 #if defined(PA_LITTLE_ENDIAN)
-        temp = (((PaInt32)src[0]) << 8);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 24);
+            temp = (((PaInt32)src[0]) << 8);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 24);
 #elif defined(PA_BIG_ENDIAN)
-        temp = (((PaInt32)src[0]) << 24);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 8);
+            temp = (((PaInt32)src[0]) << 24);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 8);
 #endif
 
-        /* REVIEW */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator );
-        *dest = (PaInt16) (((temp >> 1) + dither) >> 15);
+            /* REVIEW */
+            dither = ditherBlock[i];
+            *dest = (PaInt16) (((temp >> 1) + dither) >> 15);
 
-        src  += sourceStride * 3;
-        dest += destinationStride;
+            src  += sourceStride * 3;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int24_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+    PaInt32 temp;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        for( i=0; i<blockCount; ++i )
+        {
+#if defined(PA_LITTLE_ENDIAN)
+            temp = (((PaInt32)src[0]) << 8);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 24);
+#elif defined(PA_BIG_ENDIAN)
+            temp = (((PaInt32)src[0]) << 24);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 8);
+#endif
+            samples[i] = (float)temp * (1.0f / 65536.0f);
+            src += sourceStride * 3;
+        }
+
+        NoiseShapeToInt16( dest, destinationStride, samples, blockCount, ditherGenerator );
+
+        dest += blockCount * destinationStride;
+        count -= blockCount;
     }
 }
 
@@ -1215,30 +1840,39 @@ static void Int24_To_Int8_Dither(
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     signed char  *dest = (signed char*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 temp, dither;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert 24-bit to 32-bit value */
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert 24-bit to 32-bit value */
 #if defined(PA_LITTLE_ENDIAN)
-        temp = (((PaInt32)src[0]) << 8);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 24);
+            temp = (((PaInt32)src[0]) << 8);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 24);
 #elif defined(PA_BIG_ENDIAN)
-        temp = (((PaInt32)src[0]) << 24);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 8);
+            temp = (((PaInt32)src[0]) << 24);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 8);
 #endif
 
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit */
-        *dest = (signed char) (((temp >> 1) + dither) >> 23);
+            /* apply dither, truncate resulting 32-bit value to 8-bit */
+            *dest = (signed char) (((temp >> 1) + dither) >> 23);
 
-        src += sourceStride * 3;
-        dest += destinationStride;
+            src += sourceStride * 3;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1281,30 +1915,39 @@ static void Int24_To_UInt8_Dither(
 {
     unsigned char *src = (unsigned char*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 temp, dither;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert 24-bit to 32-bit value */
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert 24-bit to 32-bit value */
 #if defined(PA_LITTLE_ENDIAN)
-        temp = (((PaInt32)src[0]) << 8);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 24);
+            temp = (((PaInt32)src[0]) << 8);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 24);
 #elif defined(PA_BIG_ENDIAN)
-        temp = (((PaInt32)src[0]) << 24);
-        temp = temp | (((PaInt32)src[1]) << 16);
-        temp = temp | (((PaInt32)src[2]) << 8);
+            temp = (((PaInt32)src[0]) << 24);
+            temp = temp | (((PaInt32)src[1]) << 16);
+            temp = temp | (((PaInt32)src[2]) << 8);
 #endif
 
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
-        *dest = (unsigned char) ((((temp >> 1) + dither) >> 23) + 128);
+            /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
+            *dest = (unsigned char) ((((temp >> 1) + dither) >> 23) + 128);
 
-        src += sourceStride * 3;
-        dest += destinationStride;
+            src += sourceStride * 3;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1366,6 +2009,24 @@ static void Int16_To_Int24(
 
     (void) ditherGenerator; /* unused parameter */
 
+    if( destinationStride == 1 )
+    {
+        PaInt32 block[4];
+
+        while( count >= 4 )
+        {
+            block[0] = (PaInt32)(((PaUint32)(PaUint16)src[0]) << 16);
+            block[1] = (PaInt32)(((PaUint32)(PaUint16)src[sourceStride]) << 16);
+            block[2] = (PaInt32)(((PaUint32)(PaUint16)src[sourceStride * 2]) << 16);
+            block[3] = (PaInt32)(((PaUint32)(PaUint16)src[sourceStride * 3]) << 16);
+            PackInt24x4_( dest, block );
+
+            src += sourceStride * 4;
+            dest += 12;
+            count -= 4;
+        }
+    }
+
     while( count-- )
     {
         temp = *src;
@@ -1414,22 +2075,31 @@ static void Int16_To_Int8_Dither(
 {
     PaInt16 *src = (PaInt16*)sourceBuffer;
     signed char *dest = (signed char*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 temp, dither;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert 16-bit to 32-bit value */
-        temp = ((PaInt32)src[0]) << 16;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert 16-bit to 32-bit value */
+            temp = ((PaInt32)src[0]) << 16;
 
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit */
-        *dest = (signed char) (((temp >> 1) + dither) >> 23);
+            /* apply dither, truncate resulting 32-bit value to 8-bit */
+            *dest = (signed char) (((temp >> 1) + dither) >> 23);
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1462,22 +2132,31 @@ static void Int16_To_UInt8_Dither(
 {
     PaInt16 *src = (PaInt16*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
     PaInt32 temp, dither;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert 16-bit to 32-bit value */
-        temp = ((PaInt32)src[0]) << 16;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_Generate16BitTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
-        dither = PaUtil_Generate16BitTriangularDither( ditherGenerator ) << 8;
+        for( i=0; i<blockCount; ++i )
+        {
+            /* convert 16-bit to 32-bit value */
+            temp = ((PaInt32)src[0]) << 16;
 
-        /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
-        *dest = (unsigned char) ((((temp >> 1) + dither) >> 23) + 128);
+            /* increase dither scale to 24-bit value so that it would not be truncated completely when applied */
+            dither = ditherBlock[i] << 8;
 
-        src += sourceStride;
-        dest += destinationStride;
+            /* apply dither, truncate resulting 32-bit value to 8-bit and convert to unsigned */
+            *dest = (unsigned char) ((((temp >> 1) + dither) >> 23) + 128);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
@@ -1755,6 +2434,12 @@ static void Copy_24_To_24(
 
     (void) ditherGenerator; /* unused parameter */
 
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        memcpy( dest, src, count * 3 );
+        return;
+    }
+
     while( count-- )
     {
         dest[0] = src[0];
@@ -1789,169 +2474,1328 @@ static void Copy_32_To_32(
 
 /* -------------------------------------------------------------------------- */
 
-PaUtilConverterTable paConverters = {
-    Float32_To_Int32,              /* PaUtilConverter *Float32_To_Int32; */
-    Float32_To_Int32_Dither,       /* PaUtilConverter *Float32_To_Int32_Dither; */
-    Float32_To_Int32_Clip,         /* PaUtilConverter *Float32_To_Int32_Clip; */
-    Float32_To_Int32_DitherClip,   /* PaUtilConverter *Float32_To_Int32_DitherClip; */
-
-    Float32_To_Int24,              /* PaUtilConverter *Float32_To_Int24; */
-    Float32_To_Int24_Dither,       /* PaUtilConverter *Float32_To_Int24_Dither; */
-    Float32_To_Int24_Clip,         /* PaUtilConverter *Float32_To_Int24_Clip; */
-    Float32_To_Int24_DitherClip,   /* PaUtilConverter *Float32_To_Int24_DitherClip; */
-
-    Float32_To_Int16,              /* PaUtilConverter *Float32_To_Int16; */
-    Float32_To_Int16_Dither,       /* PaUtilConverter *Float32_To_Int16_Dither; */
-    Float32_To_Int16_Clip,         /* PaUtilConverter *Float32_To_Int16_Clip; */
-    Float32_To_Int16_DitherClip,   /* PaUtilConverter *Float32_To_Int16_DitherClip; */
-
-    Float32_To_Int8,               /* PaUtilConverter *Float32_To_Int8; */
-    Float32_To_Int8_Dither,        /* PaUtilConverter *Float32_To_Int8_Dither; */
-    Float32_To_Int8_Clip,          /* PaUtilConverter *Float32_To_Int8_Clip; */
-    Float32_To_Int8_DitherClip,    /* PaUtilConverter *Float32_To_Int8_DitherClip; */
-
-    Float32_To_UInt8,              /* PaUtilConverter *Float32_To_UInt8; */
-    Float32_To_UInt8_Dither,       /* PaUtilConverter *Float32_To_UInt8_Dither; */
-    Float32_To_UInt8_Clip,         /* PaUtilConverter *Float32_To_UInt8_Clip; */
-    Float32_To_UInt8_DitherClip,   /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
-
-    Int32_To_Float32,              /* PaUtilConverter *Int32_To_Float32; */
-    Int32_To_Int24,                /* PaUtilConverter *Int32_To_Int24; */
-    Int32_To_Int24_Dither,         /* PaUtilConverter *Int32_To_Int24_Dither; */
-    Int32_To_Int16,                /* PaUtilConverter *Int32_To_Int16; */
-    Int32_To_Int16_Dither,         /* PaUtilConverter *Int32_To_Int16_Dither; */
-    Int32_To_Int8,                 /* PaUtilConverter *Int32_To_Int8; */
-    Int32_To_Int8_Dither,          /* PaUtilConverter *Int32_To_Int8_Dither; */
-    Int32_To_UInt8,                /* PaUtilConverter *Int32_To_UInt8; */
-    Int32_To_UInt8_Dither,         /* PaUtilConverter *Int32_To_UInt8_Dither; */
-
-    Int24_To_Float32,              /* PaUtilConverter *Int24_To_Float32; */
-    Int24_To_Int32,                /* PaUtilConverter *Int24_To_Int32; */
-    Int24_To_Int16,                /* PaUtilConverter *Int24_To_Int16; */
-    Int24_To_Int16_Dither,         /* PaUtilConverter *Int24_To_Int16_Dither; */
-    Int24_To_Int8,                 /* PaUtilConverter *Int24_To_Int8; */
-    Int24_To_Int8_Dither,          /* PaUtilConverter *Int24_To_Int8_Dither; */
-    Int24_To_UInt8,                /* PaUtilConverter *Int24_To_UInt8; */
-    Int24_To_UInt8_Dither,         /* PaUtilConverter *Int24_To_UInt8_Dither; */
-
-    Int16_To_Float32,              /* PaUtilConverter *Int16_To_Float32; */
-    Int16_To_Int32,                /* PaUtilConverter *Int16_To_Int32; */
-    Int16_To_Int24,                /* PaUtilConverter *Int16_To_Int24; */
-    Int16_To_Int8,                 /* PaUtilConverter *Int16_To_Int8; */
-    Int16_To_Int8_Dither,          /* PaUtilConverter *Int16_To_Int8_Dither; */
-    Int16_To_UInt8,                /* PaUtilConverter *Int16_To_UInt8; */
-    Int16_To_UInt8_Dither,         /* PaUtilConverter *Int16_To_UInt8_Dither; */
-
-    Int8_To_Float32,               /* PaUtilConverter *Int8_To_Float32; */
-    Int8_To_Int32,                 /* PaUtilConverter *Int8_To_Int32; */
-    Int8_To_Int24,                 /* PaUtilConverter *Int8_To_Int24 */
-    Int8_To_Int16,                 /* PaUtilConverter *Int8_To_Int16; */
-    Int8_To_UInt8,                 /* PaUtilConverter *Int8_To_UInt8; */
-
-    UInt8_To_Float32,              /* PaUtilConverter *UInt8_To_Float32; */
-    UInt8_To_Int32,                /* PaUtilConverter *UInt8_To_Int32; */
-    UInt8_To_Int24,                /* PaUtilConverter *UInt8_To_Int24; */
-    UInt8_To_Int16,                /* PaUtilConverter *UInt8_To_Int16; */
-    UInt8_To_Int8,                 /* PaUtilConverter *UInt8_To_Int8; */
-
-    Copy_8_To_8,                   /* PaUtilConverter *Copy_8_To_8; */
-    Copy_16_To_16,                 /* PaUtilConverter *Copy_16_To_16; */
-    Copy_24_To_24,                 /* PaUtilConverter *Copy_24_To_24; */
-    Copy_32_To_32                  /* PaUtilConverter *Copy_32_To_32; */
-};
-
-/* -------------------------------------------------------------------------- */
-
-#endif /* PA_NO_STANDARD_CONVERTERS */
+static void Float32_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
 
-/* -------------------------------------------------------------------------- */
+    while( count-- )
+    {
+        *dest = *src;
 
-PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
-{
-    switch( destinationFormat & ~paNonInterleaved ){
-    case paFloat32:
-        return paZeroers.Zero32;
-    case paInt32:
-        return paZeroers.Zero32;
-    case paInt24:
-        return paZeroers.Zero24;
-    case paInt16:
-        return paZeroers.Zero16;
-    case paInt8:
-        return paZeroers.Zero8;
-    case paUInt8:
-        return paZeroers.ZeroU8;
-    default: return 0;
+        src += sourceStride;
+        dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-#ifdef PA_NO_STANDARD_ZEROERS
-
-/* -------------------------------------------------------------------------- */
-
-PaUtilZeroerTable paZeroers = {
-    0,  /* PaUtilZeroer *ZeroU8; */
-    0,  /* PaUtilZeroer *Zero8; */
-    0,  /* PaUtilZeroer *Zero16; */
-    0,  /* PaUtilZeroer *Zero24; */
-    0,  /* PaUtilZeroer *Zero32; */
-};
-
-/* -------------------------------------------------------------------------- */
-
-#else /* PA_NO_STANDARD_ZEROERS is not defined */
-
-/* -------------------------------------------------------------------------- */
-
-static void ZeroU8( void *destinationBuffer, signed int destinationStride,
-        unsigned int count )
+static void Float64_To_Float32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *dest = (unsigned char*)destinationBuffer;
+    double *src = (double*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        *dest = 128;
+        *dest = (float) *src;
 
+        src += sourceStride;
         dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Zero8( void *destinationBuffer, signed int destinationStride,
-        unsigned int count )
+static void Float64_To_Int32(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    unsigned char *dest = (unsigned char*)destinationBuffer;
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
 
     while( count-- )
     {
-        *dest = 0;
+        double scaled = *src * 2147483647.0;
+        *dest = (PaInt32) scaled;
 
+        src += sourceStride;
         dest += destinationStride;
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Zero16( void *destinationBuffer, signed int destinationStride,
-        unsigned int count )
+static void Float64_To_Int32_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
 {
-    PaUint16 *dest = (PaUint16 *)destinationBuffer;
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        *dest = 0;
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
 
-        dest += destinationStride;
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 2147483646.0) + ditherBlock[i];
+            *dest = (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
     }
 }
 
 /* -------------------------------------------------------------------------- */
 
-static void Zero24( void *destinationBuffer, signed int destinationStride,
-        unsigned int count )
+static void Float64_To_Int32_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 2147483647.0;
+        PA_CLIP_( scaled, -2147483648., 2147483647. );
+        *dest = (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int32_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 2147483646.0) + ditherBlock[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647. );
+            *dest = (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 2147483647.0;
+        temp = (PaInt32) scaled;
+        PA_STORE_INT24_( dest, temp );
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            PaInt32 temp;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 2147483646.0) + ditherBlock[i];
+            temp = (PaInt32) dithered;
+            PA_STORE_INT24_( dest, temp );
+
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaInt32 temp;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 2147483647.0;
+        PA_CLIP_( scaled, -2147483648., 2147483647. );
+        temp = (PaInt32) scaled;
+        PA_STORE_INT24_( dest, temp );
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int24_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            PaInt32 temp;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 2147483646.0) + ditherBlock[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647. );
+            temp = (PaInt32) dithered;
+            PA_STORE_INT24_( dest, temp );
+
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 32767.0;
+        *dest = (PaInt16) (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 32766.0) + ditherBlock[i];
+            *dest = (PaInt16) (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 32767.0;
+        PA_CLIP_( scaled, -32768., 32767. );
+        *dest = (PaInt16) (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 32766.0) + ditherBlock[i];
+            PA_CLIP_( dithered, -32768., 32767. );
+            *dest = (PaInt16) (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            samples[i] = (float) (*src * 32767.0);
+            src += sourceStride;
+        }
+
+        NoiseShapeToInt16( dest, destinationStride, samples, blockCount, ditherGenerator );
+
+        dest += blockCount * destinationStride;
+        count -= blockCount;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 127.0;
+        *dest = (signed char) (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 126.0) + ditherBlock[i];
+            *dest = (signed char) (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 127.0;
+        PA_CLIP_( scaled, -128., 127. );
+        *dest = (signed char) (PaInt32) scaled;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_Int8_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    signed char *dest = (signed char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 126.0) + ditherBlock[i];
+            PA_CLIP_( dithered, -128., 127. );
+            *dest = (signed char) (PaInt32) dithered;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 127.0;
+        *dest = (unsigned char) (128 + (PaInt32) scaled);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8_Dither(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 126.0) + ditherBlock[i];
+            *dest = (unsigned char) (128 + (PaInt32) dithered);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8_Clip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        double scaled = *src * 127.0;
+        PA_CLIP_( scaled, -128., 127. );
+        *dest = (unsigned char) (128 + (PaInt32) scaled);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float64_To_UInt8_DitherClip(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double *src = (double*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, blockCount );
+        count -= blockCount;
+
+        for( i=0; i<blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = (*src * 126.0) + ditherBlock[i];
+            PA_CLIP_( dithered, -128., 127. );
+            *dest = (unsigned char) (128 + (PaInt32) dithered);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (double)*src * const_1_div_2147483648_;
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int24_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        PaInt32 temp = PA_LOAD_INT24_( src );
+        *dest = (double)temp * const_1_div_2147483648_;
+
+        src += sourceStride * 3;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * (1.0 / 32768.0);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Int8_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    signed char *src = (signed char*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = *src * (1.0 / 128.0);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void UInt8_To_Float64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    double *dest = (double*)destinationBuffer;
+    (void)ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        *dest = (*src - 128) * (1.0 / 128.0);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Copy_64_To_64(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    /* copied as two 32 bit words, so that no floating point registers can
+        alter signalling NaNs */
+    PaUint32 *dest = (PaUint32 *)destinationBuffer;
+    PaUint32 *src = (PaUint32 *)sourceBuffer;
+
+    (void) ditherGenerator; /* unused parameter */
+
+    while( count-- )
+    {
+        dest[0] = src[0];
+        dest[1] = src[1];
+
+        src += sourceStride * 2;
+        dest += destinationStride * 2;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+PaUtilConverterTable paConverters = {
+    Float32_To_Int32,              /* PaUtilConverter *Float32_To_Int32; */
+    Float32_To_Int32_Dither,       /* PaUtilConverter *Float32_To_Int32_Dither; */
+    Float32_To_Int32_Clip,         /* PaUtilConverter *Float32_To_Int32_Clip; */
+    Float32_To_Int32_DitherClip,   /* PaUtilConverter *Float32_To_Int32_DitherClip; */
+
+    Float32_To_Int24,              /* PaUtilConverter *Float32_To_Int24; */
+    Float32_To_Int24_Dither,       /* PaUtilConverter *Float32_To_Int24_Dither; */
+    Float32_To_Int24_Clip,         /* PaUtilConverter *Float32_To_Int24_Clip; */
+    Float32_To_Int24_DitherClip,   /* PaUtilConverter *Float32_To_Int24_DitherClip; */
+
+    Float32_To_Int16,              /* PaUtilConverter *Float32_To_Int16; */
+    Float32_To_Int16_Dither,       /* PaUtilConverter *Float32_To_Int16_Dither; */
+    Float32_To_Int16_Clip,         /* PaUtilConverter *Float32_To_Int16_Clip; */
+    Float32_To_Int16_DitherClip,   /* PaUtilConverter *Float32_To_Int16_DitherClip; */
+    Float32_To_Int16_NoiseShaped,  /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
+
+    Float32_To_Int8,               /* PaUtilConverter *Float32_To_Int8; */
+    Float32_To_Int8_Dither,        /* PaUtilConverter *Float32_To_Int8_Dither; */
+    Float32_To_Int8_Clip,          /* PaUtilConverter *Float32_To_Int8_Clip; */
+    Float32_To_Int8_DitherClip,    /* PaUtilConverter *Float32_To_Int8_DitherClip; */
+
+    Float32_To_UInt8,              /* PaUtilConverter *Float32_To_UInt8; */
+    Float32_To_UInt8_Dither,       /* PaUtilConverter *Float32_To_UInt8_Dither; */
+    Float32_To_UInt8_Clip,         /* PaUtilConverter *Float32_To_UInt8_Clip; */
+    Float32_To_UInt8_DitherClip,   /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
+
+    Int32_To_Float32,              /* PaUtilConverter *Int32_To_Float32; */
+    Int32_To_Int24,                /* PaUtilConverter *Int32_To_Int24; */
+    Int32_To_Int24_Dither,         /* PaUtilConverter *Int32_To_Int24_Dither; */
+    Int32_To_Int16,                /* PaUtilConverter *Int32_To_Int16; */
+    Int32_To_Int16_Dither,         /* PaUtilConverter *Int32_To_Int16_Dither; */
+    Int32_To_Int16_NoiseShaped,    /* PaUtilConverter *Int32_To_Int16_NoiseShaped; */
+    Int32_To_Int8,                 /* PaUtilConverter *Int32_To_Int8; */
+    Int32_To_Int8_Dither,          /* PaUtilConverter *Int32_To_Int8_Dither; */
+    Int32_To_UInt8,                /* PaUtilConverter *Int32_To_UInt8; */
+    Int32_To_UInt8_Dither,         /* PaUtilConverter *Int32_To_UInt8_Dither; */
+
+    Int24_To_Float32,              /* PaUtilConverter *Int24_To_Float32; */
+    Int24_To_Int32,                /* PaUtilConverter *Int24_To_Int32; */
+    Int24_To_Int16,                /* PaUtilConverter *Int24_To_Int16; */
+    Int24_To_Int16_Dither,         /* PaUtilConverter *Int24_To_Int16_Dither; */
+    Int24_To_Int16_NoiseShaped,    /* PaUtilConverter *Int24_To_Int16_NoiseShaped; */
+    Int24_To_Int8,                 /* PaUtilConverter *Int24_To_Int8; */
+    Int24_To_Int8_Dither,          /* PaUtilConverter *Int24_To_Int8_Dither; */
+    Int24_To_UInt8,                /* PaUtilConverter *Int24_To_UInt8; */
+    Int24_To_UInt8_Dither,         /* PaUtilConverter *Int24_To_UInt8_Dither; */
+
+    Int16_To_Float32,              /* PaUtilConverter *Int16_To_Float32; */
+    Int16_To_Int32,                /* PaUtilConverter *Int16_To_Int32; */
+    Int16_To_Int24,                /* PaUtilConverter *Int16_To_Int24; */
+    Int16_To_Int8,                 /* PaUtilConverter *Int16_To_Int8; */
+    Int16_To_Int8_Dither,          /* PaUtilConverter *Int16_To_Int8_Dither; */
+    Int16_To_UInt8,                /* PaUtilConverter *Int16_To_UInt8; */
+    Int16_To_UInt8_Dither,         /* PaUtilConverter *Int16_To_UInt8_Dither; */
+
+    Int8_To_Float32,               /* PaUtilConverter *Int8_To_Float32; */
+    Int8_To_Int32,                 /* PaUtilConverter *Int8_To_Int32; */
+    Int8_To_Int24,                 /* PaUtilConverter *Int8_To_Int24 */
+    Int8_To_Int16,                 /* PaUtilConverter *Int8_To_Int16; */
+    Int8_To_UInt8,                 /* PaUtilConverter *Int8_To_UInt8; */
+
+    UInt8_To_Float32,              /* PaUtilConverter *UInt8_To_Float32; */
+    UInt8_To_Int32,                /* PaUtilConverter *UInt8_To_Int32; */
+    UInt8_To_Int24,                /* PaUtilConverter *UInt8_To_Int24; */
+    UInt8_To_Int16,                /* PaUtilConverter *UInt8_To_Int16; */
+    UInt8_To_Int8,                 /* PaUtilConverter *UInt8_To_Int8; */
+
+    Float32_To_Float64,            /* PaUtilConverter *Float32_To_Float64; */
+    Float64_To_Float32,            /* PaUtilConverter *Float64_To_Float32; */
+
+    Float64_To_Int32,              /* PaUtilConverter *Float64_To_Int32; */
+    Float64_To_Int32_Dither,       /* PaUtilConverter *Float64_To_Int32_Dither; */
+    Float64_To_Int32_Clip,         /* PaUtilConverter *Float64_To_Int32_Clip; */
+    Float64_To_Int32_DitherClip,   /* PaUtilConverter *Float64_To_Int32_DitherClip; */
+
+    Float64_To_Int24,              /* PaUtilConverter *Float64_To_Int24; */
+    Float64_To_Int24_Dither,       /* PaUtilConverter *Float64_To_Int24_Dither; */
+    Float64_To_Int24_Clip,         /* PaUtilConverter *Float64_To_Int24_Clip; */
+    Float64_To_Int24_DitherClip,   /* PaUtilConverter *Float64_To_Int24_DitherClip; */
+
+    Float64_To_Int16,              /* PaUtilConverter *Float64_To_Int16; */
+    Float64_To_Int16_Dither,       /* PaUtilConverter *Float64_To_Int16_Dither; */
+    Float64_To_Int16_Clip,         /* PaUtilConverter *Float64_To_Int16_Clip; */
+    Float64_To_Int16_DitherClip,   /* PaUtilConverter *Float64_To_Int16_DitherClip; */
+    Float64_To_Int16_NoiseShaped,  /* PaUtilConverter *Float64_To_Int16_NoiseShaped; */
+
+    Float64_To_Int8,               /* PaUtilConverter *Float64_To_Int8; */
+    Float64_To_Int8_Dither,        /* PaUtilConverter *Float64_To_Int8_Dither; */
+    Float64_To_Int8_Clip,          /* PaUtilConverter *Float64_To_Int8_Clip; */
+    Float64_To_Int8_DitherClip,    /* PaUtilConverter *Float64_To_Int8_DitherClip; */
+
+    Float64_To_UInt8,              /* PaUtilConverter *Float64_To_UInt8; */
+    Float64_To_UInt8_Dither,       /* PaUtilConverter *Float64_To_UInt8_Dither; */
+    Float64_To_UInt8_Clip,         /* PaUtilConverter *Float64_To_UInt8_Clip; */
+    Float64_To_UInt8_DitherClip,   /* PaUtilConverter *Float64_To_UInt8_DitherClip; */
+
+    Int32_To_Float64,              /* PaUtilConverter *Int32_To_Float64; */
+    Int24_To_Float64,              /* PaUtilConverter *Int24_To_Float64; */
+    Int16_To_Float64,              /* PaUtilConverter *Int16_To_Float64; */
+    Int8_To_Float64,               /* PaUtilConverter *Int8_To_Float64; */
+    UInt8_To_Float64,              /* PaUtilConverter *UInt8_To_Float64; */
+
+    Copy_8_To_8,                   /* PaUtilConverter *Copy_8_To_8; */
+    Copy_16_To_16,                 /* PaUtilConverter *Copy_16_To_16; */
+    Copy_24_To_24,                 /* PaUtilConverter *Copy_24_To_24; */
+    Copy_32_To_32,                 /* PaUtilConverter *Copy_32_To_32; */
+    Copy_64_To_64                  /* PaUtilConverter *Copy_64_To_64; */
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* Apply op to each converter which has SIMD implementations. */
+#define PA_FOR_EACH_SIMD_CONVERTER_( op )\
+    op( Float32_To_Int32 )\
+    op( Float32_To_Int32_Dither )\
+    op( Float32_To_Int32_Clip )\
+    op( Float32_To_Int32_DitherClip )\
+    op( Float32_To_Int24 )\
+    op( Float32_To_Int24_Dither )\
+    op( Float32_To_Int24_Clip )\
+    op( Float32_To_Int24_DitherClip )\
+    op( Float32_To_Int16 )\
+    op( Float32_To_Int16_Dither )\
+    op( Float32_To_Int16_Clip )\
+    op( Float32_To_Int16_DitherClip )\
+    op( Int32_To_Float32 )\
+    op( Int24_To_Float32 )\
+    op( Int16_To_Float32 )
+
+#define PA_SET_STANDARD_CONVERTER_( name )\
+    tierConverters. name = name;
+
+#define PA_SET_INSTALLED_STANDARD_CONVERTER_( name )\
+    installedConverters_. name = name;
+
+/* Only replace a converter if it is still the one installed for the previous
+ tier, so that converters installed by host APIs (eg.
+ PaUtil_InitializeX86PlainConverters) are preserved. */
+#define PA_INSTALL_TIER_CONVERTER_( name )\
+    if( paConverters. name == installedConverters_. name ) paConverters. name = tierConverters. name;\
+    installedConverters_. name = tierConverters. name;
+
+/* the tier requested with PaUtil_SetConverterTier() */
+static PaConverterTier requestedConverterTier_ = paConverterTierDefault;
+
+/* the tier whose converters are in paConverters, paConverterTierDefault
+ until the first tier has been installed */
+static PaConverterTier installedConverterTier_ = paConverterTierDefault;
+
+/* the converters installed for installedConverterTier_, only the
+ PA_FOR_EACH_SIMD_CONVERTER_ entries are used */
+static PaUtilConverterTable installedConverters_;
+
+
+static void InstallConverterTier( PaConverterTier tier )
+{
+    PaUtilConverterTable tierConverters;
+
+    if( installedConverterTier_ == paConverterTierDefault )
+    {
+        /* nothing has been installed yet, so the standard converters are */
+        PA_FOR_EACH_SIMD_CONVERTER_( PA_SET_INSTALLED_STANDARD_CONVERTER_ )
+    }
+
+    PA_FOR_EACH_SIMD_CONVERTER_( PA_SET_STANDARD_CONVERTER_ )
+    PaUtil_InitializeSimdConverters( &tierConverters, tier );
+
+    PA_FOR_EACH_SIMD_CONVERTER_( PA_INSTALL_TIER_CONVERTER_ )
+
+    installedConverterTier_ = tier;
+}
+
+
+static PaConverterTier ParseConverterTier( const char *name )
+{
+    if( strcmp( name, "scalar" ) == 0 )
+        return paConverterTierScalar;
+    else if( strcmp( name, "sse2" ) == 0 )
+        return paConverterTierSSE2;
+    else if( strcmp( name, "avx2" ) == 0 )
+        return paConverterTierAVX2;
+    else if( strcmp( name, "avx512" ) == 0 )
+        return paConverterTierAVX512;
+    else if( strcmp( name, "neon" ) == 0 )
+        return paConverterTierNEON;
+    else
+        return paConverterTierDefault;
+}
+
+
+/* Returns the tier requested with PaUtil_SetConverterTier() or the
+ PA_CONVERTER_TIER environment variable if it is supported, otherwise the
+ fastest tier supported by the processor. */
+static PaConverterTier ChooseConverterTier( void )
+{
+    static const PaConverterTier fastestFirst[] = {
+        paConverterTierAVX512, paConverterTierAVX2, paConverterTierSSE2, paConverterTierNEON
+    };
+    const char *environmentTier;
+    int i;
+
+    if( requestedConverterTier_ != paConverterTierDefault )
+        return requestedConverterTier_;
+
+    environmentTier = getenv( "PA_CONVERTER_TIER" );
+    if( environmentTier != NULL && environmentTier[0] != '\0' )
+    {
+        PaConverterTier tier = ParseConverterTier( environmentTier );
+        if( tier != paConverterTierDefault && PaUtil_IsConverterTierSupported( tier ) )
+            return tier;
+
+        PA_DEBUG(( "PA_CONVERTER_TIER=%s is not supported, ignoring it\n", environmentTier ));
+    }
+
+    for( i = 0; i < (int)(sizeof(fastestFirst) / sizeof(fastestFirst[0])); ++i )
+    {
+        if( PaUtil_IsConverterTierSupported( fastestFirst[i] ) )
+            return fastestFirst[i];
+    }
+
+    return paConverterTierScalar;
+}
+
+
+static void EnsureConverterTierInstalled( void )
+{
+    if( installedConverterTier_ == paConverterTierDefault )
+        InstallConverterTier( ChooseConverterTier() );
+}
+
+
+/* The frame converters are scalar. Calling a SIMD converter once per channel
+ is faster, even though it reads (or writes) the interleaved buffer with a
+ stride, except for Int24 on the 4 wide tiers, which gather and scatter
+ strided Int24 samples a byte at a time. Returns non-zero if the frame
+ converter between the given formats should be used with the installed
+ tier. */
+static int IsFrameConverterFaster( PaSampleFormat sourceFormat, PaSampleFormat destinationFormat )
+{
+    sourceFormat &= ~paNonInterleaved;
+    destinationFormat &= ~paNonInterleaved;
+
+    if( installedConverterTier_ == paConverterTierScalar || sourceFormat == destinationFormat )
+        return 1;
+
+    if( sourceFormat != paFloat32 && destinationFormat != paFloat32 )
+        return 1; /* no SIMD converter */
+
+    if( sourceFormat == paInt24 || destinationFormat == paInt24 )
+        return installedConverterTier_ == paConverterTierSSE2 || installedConverterTier_ == paConverterTierNEON;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Frame converters. Each PA_FRAME_CONVERT_ macro converts one sample from
+ src to dest, using the same arithmetic as the corresponding converter above.
+ The dithering macros take their dither from the block filled by
+ PA_FRAME_CONVERTER_NEXT_DITHER_BLOCK_. */
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT32_( dest, src )\
+    { double scaled = (double)*(src) * 0x7FFFFFFF; *(dest) = (PaInt32) scaled; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT32_DITHER_( dest, src )\
+    { double dither = ditherBlock[ditherIndex++];\
+      double dithered = ((double)*(src) * (2147483646.0)) + dither;\
+      *(dest) = (PaInt32) dithered; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT32_CLIP_( dest, src )\
+    { double scaled = (double)*(src) * 0x7FFFFFFF;\
+      PA_CLIP_( scaled, -2147483648., 2147483647. );\
+      *(dest) = (PaInt32) scaled; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT32_DITHERCLIP_( dest, src )\
+    { double dither = ditherBlock[ditherIndex++];\
+      double dithered = ((double)*(src) * (2147483646.0)) + dither;\
+      PA_CLIP_( dithered, -2147483648., 2147483647. );\
+      *(dest) = (PaInt32) dithered; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT24_( dest, src )\
+    { double scaled = (double)*(src) * 2147483647.0; PaInt32 temp = (PaInt32) scaled;\
+      PA_STORE_INT24_( dest, temp ); }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT24_DITHER_( dest, src )\
+    { double dither = ditherBlock[ditherIndex++];\
+      double dithered = ((double)*(src) * (2147483646.0)) + dither;\
+      PaInt32 temp = (PaInt32) dithered;\
+      PA_STORE_INT24_( dest, temp ); }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT24_CLIP_( dest, src )\
+    { double scaled = (double)*(src) * 0x7FFFFFFF; PaInt32 temp;\
+      PA_CLIP_( scaled, -2147483648., 2147483647. );\
+      temp = (PaInt32) scaled;\
+      PA_STORE_INT24_( dest, temp ); }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT24_DITHERCLIP_( dest, src )\
+    { double dither = ditherBlock[ditherIndex++];\
+      double dithered = ((double)*(src) * (2147483646.0)) + dither; PaInt32 temp;\
+      PA_CLIP_( dithered, -2147483648., 2147483647. );\
+      temp = (PaInt32) dithered;\
+      PA_STORE_INT24_( dest, temp ); }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT16_( dest, src )\
+    { *(dest) = (short) (*(src) * (32767.0f)); }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT16_DITHER_( dest, src )\
+    { float dither = ditherBlock[ditherIndex++];\
+      float dithered = (*(src) * (32766.0f)) + dither;\
+      *(dest) = (PaInt16) dithered; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT16_CLIP_( dest, src )\
+    { long samp = (PaInt32) (*(src) * (32767.0f));\
+      PA_CLIP_( samp, -0x8000, 0x7FFF );\
+      *(dest) = (PaInt16) samp; }
+
+#define PA_FRAME_CONVERT_FLOAT32_TO_INT16_DITHERCLIP_( dest, src )\
+    { float dither = ditherBlock[ditherIndex++];\
+      float dithered = (*(src) * (32766.0f)) + dither;\
+      PaInt32 samp = (PaInt32) dithered;\
+      PA_CLIP_( samp, -0x8000, 0x7FFF );\
+      *(dest) = (PaInt16) samp; }
+
+#define PA_FRAME_CONVERT_INT32_TO_FLOAT32_( dest, src )\
+    { *(dest) = (float) ((double)*(src) * const_1_div_2147483648_); }
+
+#define PA_FRAME_CONVERT_INT24_TO_FLOAT32_( dest, src )\
+    { PaInt32 temp = PA_LOAD_INT24_( src );\
+      *(dest) = (float) ((double)temp * const_1_div_2147483648_); }
+
+#define PA_FRAME_CONVERT_INT16_TO_FLOAT32_( dest, src )\
+    { *(dest) = *(src) * const_1_div_32768_; }
+
+#define PA_FRAME_COPY_16_( dest, src )\
+    { *(dest) = *(src); }
+
+#define PA_FRAME_COPY_24_( dest, src )\
+    { (dest)[0] = (src)[0]; (dest)[1] = (src)[1]; (dest)[2] = (src)[2]; }
+
+#define PA_FRAME_COPY_32_( dest, src )\
+    { *(dest) = *(src); }
+
+/* -------------------------------------------------------------------------- */
+
+/* Refill the dither block of a dithering frame converter once it has been
+ used up, generating no more values than the remaining samples need. */
+#define PA_FRAME_CONVERTER_NEXT_DITHER_BLOCK_                                  \
+    if( ditherIndex == ditherCount )                                           \
+    {                                                                          \
+        ditherCount = (ditherRemaining < PA_DITHER_BLOCK_SIZE)                 \
+                ? (unsigned int)ditherRemaining : PA_DITHER_BLOCK_SIZE;        \
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, ditherBlock, ditherCount ); \
+        ditherRemaining -= ditherCount;                                        \
+        ditherIndex = 0;                                                       \
+    }
+
+/* Define an interleaving and a deinterleaving frame converter named
+ name_Interleave and name_Deinterleave. sourceWidth and destinationWidth are
+ the sample sizes in units of sourceType and destinationType respectively.
+ dithering is non-zero if convert uses dither. */
+#define PA_DEFINE_FRAME_CONVERTERS_( name, sourceType, sourceWidth, destinationType, destinationWidth, convert, dithering )\
+static void name ## _Interleave(                                               \
+    void *interleavedBuffer, void **channelBuffers,                            \
+    unsigned int channelCount, unsigned int frameCount,                        \
+    struct PaUtilTriangularDitherGenerator *ditherGenerator )                  \
+{                                                                              \
+    destinationType *dest = (destinationType*)interleavedBuffer;              \
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];                                   \
+    unsigned int ditherIndex = 0, ditherCount = 0;                             \
+    unsigned long ditherRemaining = (unsigned long)frameCount * channelCount;  \
+    unsigned int frame, channel;                                               \
+    (void)ditherGenerator; /* unused by non-dithering converters */            \
+                                                                               \
+    for( frame = 0; frame < frameCount; ++frame )                              \
+    {                                                                          \
+        for( channel = 0; channel < channelCount; ++channel )                  \
+        {                                                                      \
+            sourceType *src = ((sourceType*)channelBuffers[channel]) + frame * (sourceWidth); \
+            if( dithering )                                                    \
+                PA_FRAME_CONVERTER_NEXT_DITHER_BLOCK_                          \
+            convert( dest, src )                                               \
+            dest += (destinationWidth);                                        \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static void name ## _Deinterleave(                                             \
+    void *interleavedBuffer, void **channelBuffers,                            \
+    unsigned int channelCount, unsigned int frameCount,                        \
+    struct PaUtilTriangularDitherGenerator *ditherGenerator )                  \
+{                                                                              \
+    sourceType *src = (sourceType*)interleavedBuffer;                          \
+    float ditherBlock[PA_DITHER_BLOCK_SIZE];                                   \
+    unsigned int ditherIndex = 0, ditherCount = 0;                             \
+    unsigned long ditherRemaining = (unsigned long)frameCount * channelCount;  \
+    unsigned int frame, channel;                                               \
+    (void)ditherGenerator; /* unused by non-dithering converters */            \
+                                                                               \
+    for( frame = 0; frame < frameCount; ++frame )                              \
+    {                                                                          \
+        for( channel = 0; channel < channelCount; ++channel )                  \
+        {                                                                      \
+            destinationType *dest = ((destinationType*)channelBuffers[channel]) + frame * (destinationWidth); \
+            if( dithering )                                                    \
+                PA_FRAME_CONVERTER_NEXT_DITHER_BLOCK_                          \
+            convert( dest, src )                                               \
+            src += (sourceWidth);                                              \
+        }                                                                      \
+    }                                                                          \
+}
+
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int32_Frames, float, 1, PaInt32, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT32_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int32_Dither_Frames, float, 1, PaInt32, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT32_DITHER_, 1 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int32_Clip_Frames, float, 1, PaInt32, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT32_CLIP_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int32_DitherClip_Frames, float, 1, PaInt32, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT32_DITHERCLIP_, 1 )
+
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int24_Frames, float, 1, unsigned char, 3, PA_FRAME_CONVERT_FLOAT32_TO_INT24_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int24_Dither_Frames, float, 1, unsigned char, 3, PA_FRAME_CONVERT_FLOAT32_TO_INT24_DITHER_, 1 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int24_Clip_Frames, float, 1, unsigned char, 3, PA_FRAME_CONVERT_FLOAT32_TO_INT24_CLIP_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int24_DitherClip_Frames, float, 1, unsigned char, 3, PA_FRAME_CONVERT_FLOAT32_TO_INT24_DITHERCLIP_, 1 )
+
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int16_Frames, float, 1, PaInt16, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT16_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int16_Dither_Frames, float, 1, PaInt16, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT16_DITHER_, 1 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int16_Clip_Frames, float, 1, PaInt16, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT16_CLIP_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Float32_To_Int16_DitherClip_Frames, float, 1, PaInt16, 1, PA_FRAME_CONVERT_FLOAT32_TO_INT16_DITHERCLIP_, 1 )
+
+PA_DEFINE_FRAME_CONVERTERS_( Int32_To_Float32_Frames, PaInt32, 1, float, 1, PA_FRAME_CONVERT_INT32_TO_FLOAT32_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Int24_To_Float32_Frames, unsigned char, 3, float, 1, PA_FRAME_CONVERT_INT24_TO_FLOAT32_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Int16_To_Float32_Frames, PaInt16, 1, float, 1, PA_FRAME_CONVERT_INT16_TO_FLOAT32_, 0 )
+
+PA_DEFINE_FRAME_CONVERTERS_( Copy_16_To_16_Frames, PaInt16, 1, PaInt16, 1, PA_FRAME_COPY_16_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Copy_24_To_24_Frames, unsigned char, 3, unsigned char, 3, PA_FRAME_COPY_24_, 0 )
+PA_DEFINE_FRAME_CONVERTERS_( Copy_32_To_32_Frames, PaInt32, 1, PaInt32, 1, PA_FRAME_COPY_32_, 0 )
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_FRAME_CONVERTER_TABLE_( direction ) {                                                   \
+    Float32_To_Int32_Frames_ ## direction,            /* PaUtilFrameConverter *Float32_To_Int32; */ \
+    Float32_To_Int32_Dither_Frames_ ## direction,     /* PaUtilFrameConverter *Float32_To_Int32_Dither; */ \
+    Float32_To_Int32_Clip_Frames_ ## direction,       /* PaUtilFrameConverter *Float32_To_Int32_Clip; */ \
+    Float32_To_Int32_DitherClip_Frames_ ## direction, /* PaUtilFrameConverter *Float32_To_Int32_DitherClip; */ \
+                                                                                                   \
+    Float32_To_Int24_Frames_ ## direction,            /* PaUtilFrameConverter *Float32_To_Int24; */ \
+    Float32_To_Int24_Dither_Frames_ ## direction,     /* PaUtilFrameConverter *Float32_To_Int24_Dither; */ \
+    Float32_To_Int24_Clip_Frames_ ## direction,       /* PaUtilFrameConverter *Float32_To_Int24_Clip; */ \
+    Float32_To_Int24_DitherClip_Frames_ ## direction, /* PaUtilFrameConverter *Float32_To_Int24_DitherClip; */ \
+                                                                                                   \
+    Float32_To_Int16_Frames_ ## direction,            /* PaUtilFrameConverter *Float32_To_Int16; */ \
+    Float32_To_Int16_Dither_Frames_ ## direction,     /* PaUtilFrameConverter *Float32_To_Int16_Dither; */ \
+    Float32_To_Int16_Clip_Frames_ ## direction,       /* PaUtilFrameConverter *Float32_To_Int16_Clip; */ \
+    Float32_To_Int16_DitherClip_Frames_ ## direction, /* PaUtilFrameConverter *Float32_To_Int16_DitherClip; */ \
+                                                                                                   \
+    Int32_To_Float32_Frames_ ## direction,            /* PaUtilFrameConverter *Int32_To_Float32; */ \
+    Int24_To_Float32_Frames_ ## direction,            /* PaUtilFrameConverter *Int24_To_Float32; */ \
+    Int16_To_Float32_Frames_ ## direction,            /* PaUtilFrameConverter *Int16_To_Float32; */ \
+                                                                                                   \
+    Copy_16_To_16_Frames_ ## direction,               /* PaUtilFrameConverter *Copy_16_To_16; */ \
+    Copy_24_To_24_Frames_ ## direction,               /* PaUtilFrameConverter *Copy_24_To_24; */ \
+    Copy_32_To_32_Frames_ ## direction                /* PaUtilFrameConverter *Copy_32_To_32; */ \
+    }
+
+PaUtilFrameConverterTable paInterleavingConverters = PA_FRAME_CONVERTER_TABLE_( Interleave );
+
+PaUtilFrameConverterTable paDeinterleavingConverters = PA_FRAME_CONVERTER_TABLE_( Deinterleave );
+
+/* -------------------------------------------------------------------------- */
+
+#endif /* PA_NO_STANDARD_CONVERTERS */
+
+/* -------------------------------------------------------------------------- */
+
+void PaUtil_InitializeConverterTier( void )
+{
+#ifndef PA_NO_STANDARD_CONVERTERS
+    InstallConverterTier( ChooseConverterTier() );
+    PA_DEBUG(( "PaUtil_InitializeConverterTier: using converter tier %d\n", installedConverterTier_ ));
+#endif
+}
+
+
+PaError PaUtil_SetConverterTier( PaConverterTier tier )
+{
+#ifdef PA_NO_STANDARD_CONVERTERS
+    /* there are no standard converters to choose between */
+    return ( tier == paConverterTierDefault || tier == paConverterTierScalar )
+            ? paNoError : paConverterTierNotSupported;
+#else
+    if( tier != paConverterTierDefault && !PaUtil_IsConverterTierSupported( tier ) )
+        return paConverterTierNotSupported;
+
+    requestedConverterTier_ = tier;
+    InstallConverterTier( ChooseConverterTier() );
+
+    return paNoError;
+#endif
+}
+
+
+PaConverterTier PaUtil_GetConverterTier( void )
+{
+#ifdef PA_NO_STANDARD_CONVERTERS
+    return paConverterTierScalar;
+#else
+    EnsureConverterTierInstalled();
+    return installedConverterTier_;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
+PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
+{
+    switch( destinationFormat & ~paNonInterleaved ){
+    case paFloat64:
+        return paZeroers.Zero64;
+    case paFloat32:
+        return paZeroers.Zero32;
+    case paInt32:
+        return paZeroers.Zero32;
+    case paInt24:
+        return paZeroers.Zero24;
+    case paInt16:
+        return paZeroers.Zero16;
+    case paInt8:
+        return paZeroers.Zero8;
+    case paUInt8:
+        return paZeroers.ZeroU8;
+    default: return 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef PA_NO_STANDARD_ZEROERS
+
+/* -------------------------------------------------------------------------- */
+
+PaUtilZeroerTable paZeroers = {
+    0,  /* PaUtilZeroer *ZeroU8; */
+    0,  /* PaUtilZeroer *Zero8; */
+    0,  /* PaUtilZeroer *Zero16; */
+    0,  /* PaUtilZeroer *Zero24; */
+    0,  /* PaUtilZeroer *Zero32; */
+    0,  /* PaUtilZeroer *Zero64; */
+};
+
+/* -------------------------------------------------------------------------- */
+
+#else /* PA_NO_STANDARD_ZEROERS is not defined */
+
+/* -------------------------------------------------------------------------- */
+
+static void ZeroU8( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
+{
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+
+    while( count-- )
+    {
+        *dest = 128;
+
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Zero8( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
+{
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+
+    while( count-- )
+    {
+        *dest = 0;
+
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Zero16( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
+{
+    PaUint16 *dest = (PaUint16 *)destinationBuffer;
+
+    while( count-- )
+    {
+        *dest = 0;
+
+        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Zero24( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
 {
     unsigned char *dest = (unsigned char*)destinationBuffer;
 
@@ -1982,12 +3826,29 @@ static void Zero32( void *destinationBuffer, signed int destinationStride,
 
 /* -------------------------------------------------------------------------- */
 
+static void Zero64( void *destinationBuffer, signed int destinationStride,
+        unsigned int count )
+{
+    PaUint32 *dest = (PaUint32 *)destinationBuffer;
+
+    while( count-- )
+    {
+        dest[0] = 0;
+        dest[1] = 0;
+
+        dest += destinationStride * 2;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 PaUtilZeroerTable paZeroers = {
     ZeroU8,  /* PaUtilZeroer *ZeroU8; */
     Zero8,  /* PaUtilZeroer *Zero8; */
     Zero16,  /* PaUtilZeroer *Zero16; */
     Zero24,  /* PaUtilZeroer *Zero24; */
     Zero32,  /* PaUtilZeroer *Zero32; */
+    Zero64,  /* PaUtilZeroer *Zero64; */
 };
 
 /* -------------------------------------------------------------------------- */
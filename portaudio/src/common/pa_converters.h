@@ -103,11 +103,41 @@ typedef void PaUtilConverter(
     version is returned.
     If the source and destination formats are the same, a function which
     copies data of the appropriate size will be returned.
+    If no converter tier has been installed yet, the first call installs
+    one as PaUtil_InitializeConverterTier() does.
+    @see PaUtil_InitializeConverterTier
 */
 PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags );
 
 
+/** Replace the standard Float32 to and from Int32, Int24 and Int16 entries
+    of paConverters with the implementations for the instruction set tier
+    requested with PaUtil_SetConverterTier() or the PA_CONVERTER_TIER
+    environment variable, or otherwise with the fastest implementations
+    supported by the processor. Entries which have been replaced by the host
+    API are kept. Called by Pa_Initialize().
+    @see PaUtil_InitializeSimdConverters
+*/
+void PaUtil_InitializeConverterTier( void );
+
+
+/** Implements Pa_SetConverterTier(). The new tier is installed immediately
+    and is used by converters selected afterwards. paConverters is written
+    without synchronization, so this must not be called while a stream is
+    open or while another thread selects converters.
+    @return paNoError, or paConverterTierNotSupported if the tier is not
+    supported by the processor.
+*/
+PaError PaUtil_SetConverterTier( PaConverterTier tier );
+
+
+/** Implements Pa_GetConverterTier().
+    @return The tier whose converters are installed in paConverters.
+*/
+PaConverterTier PaUtil_GetConverterTier( void );
+
+
 /** The generic buffer zeroer prototype. Buffer zeroers copy count zeros to
     destinationBuffer. The actual type of the data pointed to varys for
     different zeroer functions.
@@ -127,6 +157,46 @@ typedef void PaUtilZeroer(
 */
 PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat );
 
+
+/** The generic frame converter prototype. Frame converters convert and
+    interleave (or deinterleave) every channel of a buffer in a single pass:
+    all channels of one frame are converted before moving on to the next
+    frame, so each cache line of the interleaved buffer is only visited once.
+    Interleaving converters read from channelBuffers and write to
+    interleavedBuffer, deinterleaving converters read from interleavedBuffer
+    and write to channelBuffers.
+    @param interleavedBuffer A pointer to the first sample of the first
+    channel of the interleaved buffer. The interleaved buffer contains
+    exactly channelCount channels.
+    @param channelBuffers An array of channelCount pointers to the first
+    sample of each non-interleaved channel. Samples within each channel are
+    contiguous.
+    @param channelCount The number of channels to convert.
+    @param frameCount The number of frames to convert.
+    @param ditherGenerator State information used to calculate dither.
+    Converters that do not perform dithering will ignore this parameter.
+*/
+typedef void PaUtilFrameConverter(
+    void *interleavedBuffer, void **channelBuffers,
+    unsigned int channelCount, unsigned int frameCount,
+    struct PaUtilTriangularDitherGenerator *ditherGenerator );
+
+
+/** Find a frame converter function for the given source and destination
+    formats and flags (clip and dither.) Exactly one of sourceFormat and
+    destinationFormat must include the paNonInterleaved flag: if it is the
+    source, an interleaving converter is returned, otherwise a
+    deinterleaving converter is returned.
+    @return
+    A pointer to a PaUtilFrameConverter which will perform the requested
+    conversion, or NULL if no frame converter is available for the given
+    formats, or if the installed converter tier converts them faster one
+    channel at a time. In that case the converter returned by PaUtil_SelectConverter
+    should be called once per channel instead.
+*/
+PaUtilFrameConverter* PaUtil_SelectFrameConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags );
+
 /*----------------------------------------------------------------------------*/
 /* low level functions and data structures which may be used for
     substituting conversion functions */
@@ -150,6 +220,7 @@ typedef struct{
     PaUtilConverter *Float32_To_Int16_Dither;
     PaUtilConverter *Float32_To_Int16_Clip;
     PaUtilConverter *Float32_To_Int16_DitherClip;
+    PaUtilConverter *Float32_To_Int16_NoiseShaped;
 
     PaUtilConverter *Float32_To_Int8;
     PaUtilConverter *Float32_To_Int8_Dither;
@@ -166,6 +237,7 @@ typedef struct{
     PaUtilConverter *Int32_To_Int24_Dither;
     PaUtilConverter *Int32_To_Int16;
     PaUtilConverter *Int32_To_Int16_Dither;
+    PaUtilConverter *Int32_To_Int16_NoiseShaped;
     PaUtilConverter *Int32_To_Int8;
     PaUtilConverter *Int32_To_Int8_Dither;
     PaUtilConverter *Int32_To_UInt8;
@@ -175,6 +247,7 @@ typedef struct{
     PaUtilConverter *Int24_To_Int32;
     PaUtilConverter *Int24_To_Int16;
     PaUtilConverter *Int24_To_Int16_Dither;
+    PaUtilConverter *Int24_To_Int16_NoiseShaped;
     PaUtilConverter *Int24_To_Int8;
     PaUtilConverter *Int24_To_Int8_Dither;
     PaUtilConverter *Int24_To_UInt8;
@@ -200,10 +273,46 @@ typedef struct{
     PaUtilConverter *UInt8_To_Int16;
     PaUtilConverter *UInt8_To_Int8;
 
+    PaUtilConverter *Float32_To_Float64;
+    PaUtilConverter *Float64_To_Float32;
+
+    PaUtilConverter *Float64_To_Int32;
+    PaUtilConverter *Float64_To_Int32_Dither;
+    PaUtilConverter *Float64_To_Int32_Clip;
+    PaUtilConverter *Float64_To_Int32_DitherClip;
+
+    PaUtilConverter *Float64_To_Int24;
+    PaUtilConverter *Float64_To_Int24_Dither;
+    PaUtilConverter *Float64_To_Int24_Clip;
+    PaUtilConverter *Float64_To_Int24_DitherClip;
+
+    PaUtilConverter *Float64_To_Int16;
+    PaUtilConverter *Float64_To_Int16_Dither;
+    PaUtilConverter *Float64_To_Int16_Clip;
+    PaUtilConverter *Float64_To_Int16_DitherClip;
+    PaUtilConverter *Float64_To_Int16_NoiseShaped;
+
+    PaUtilConverter *Float64_To_Int8;
+    PaUtilConverter *Float64_To_Int8_Dither;
+    PaUtilConverter *Float64_To_Int8_Clip;
+    PaUtilConverter *Float64_To_Int8_DitherClip;
+
+    PaUtilConverter *Float64_To_UInt8;
+    PaUtilConverter *Float64_To_UInt8_Dither;
+    PaUtilConverter *Float64_To_UInt8_Clip;
+    PaUtilConverter *Float64_To_UInt8_DitherClip;
+
+    PaUtilConverter *Int32_To_Float64;
+    PaUtilConverter *Int24_To_Float64;
+    PaUtilConverter *Int16_To_Float64;
+    PaUtilConverter *Int8_To_Float64;
+    PaUtilConverter *UInt8_To_Float64;
+
     PaUtilConverter *Copy_8_To_8;       /* copy without any conversion */
     PaUtilConverter *Copy_16_To_16;     /* copy without any conversion */
     PaUtilConverter *Copy_24_To_24;     /* copy without any conversion */
     PaUtilConverter *Copy_32_To_32;     /* copy without any conversion */
+    PaUtilConverter *Copy_64_To_64;     /* copy without any conversion */
 } PaUtilConverterTable;
 
 
@@ -236,6 +345,7 @@ typedef struct{
     PaUtilZeroer *Zero16;
     PaUtilZeroer *Zero24;
     PaUtilZeroer *Zero32;
+    PaUtilZeroer *Zero64;
 } PaUtilZeroerTable;
 
 
@@ -257,6 +367,54 @@ typedef struct{
 */
 extern PaUtilZeroerTable paZeroers;
 
+
+/** The type used to store frame converter functions. Only the most commonly
+    used conversions have frame converters.
+    @see paInterleavingConverters, paDeinterleavingConverters
+*/
+typedef struct{
+    PaUtilFrameConverter *Float32_To_Int32;
+    PaUtilFrameConverter *Float32_To_Int32_Dither;
+    PaUtilFrameConverter *Float32_To_Int32_Clip;
+    PaUtilFrameConverter *Float32_To_Int32_DitherClip;
+
+    PaUtilFrameConverter *Float32_To_Int24;
+    PaUtilFrameConverter *Float32_To_Int24_Dither;
+    PaUtilFrameConverter *Float32_To_Int24_Clip;
+    PaUtilFrameConverter *Float32_To_Int24_DitherClip;
+
+    PaUtilFrameConverter *Float32_To_Int16;
+    PaUtilFrameConverter *Float32_To_Int16_Dither;
+    PaUtilFrameConverter *Float32_To_Int16_Clip;
+    PaUtilFrameConverter *Float32_To_Int16_DitherClip;
+
+    PaUtilFrameConverter *Int32_To_Float32;
+    PaUtilFrameConverter *Int24_To_Float32;
+    PaUtilFrameConverter *Int16_To_Float32;
+
+    PaUtilFrameConverter *Copy_16_To_16;     /* copy without any conversion */
+    PaUtilFrameConverter *Copy_24_To_24;     /* copy without any conversion */
+    PaUtilFrameConverter *Copy_32_To_32;     /* copy without any conversion */
+} PaUtilFrameConverterTable;
+
+
+/** Tables of pointers to the frame converter functions which read
+    non-interleaved channels and write an interleaved buffer
+    (paInterleavingConverters) and which read an interleaved buffer and
+    write non-interleaved channels (paDeinterleavingConverters).
+    PaUtil_SelectFrameConverter() uses these tables to lookup the
+    appropriate functions. Fields may be NULL, indicating that the
+    conversion should be performed one channel at a time.
+
+    @note
+    If the PA_NO_STANDARD_CONVERTERS preprocessor variable is defined, all
+    fields of these structures will be initialized to NULL.
+
+    @see PaUtilFrameConverterTable, PaUtilFrameConverter, PaUtil_SelectFrameConverter
+*/
+extern PaUtilFrameConverterTable paInterleavingConverters;
+extern PaUtilFrameConverterTable paDeinterleavingConverters;
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
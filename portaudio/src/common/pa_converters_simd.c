@@ -0,0 +1,1876 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library SIMD sample conversion mechanism
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SSE2, AVX2, AVX-512 and NEON implementations of the Float32 to
+ Int32, Int24 and Int16 sample converters, and of the Int32, Int24 and Int16
+ to Float32 sample converters.
+
+ Each converter processes blocks of 4 (SSE2, NEON), 8 (AVX2) or 16 (AVX-512)
+ samples and finishes the remaining samples with scalar code. Interleaved
+ buffers are gathered into, and scattered out of, vector registers so any
+ stride can be handled. The input converters have a separate loop for the common case where
+ both buffers are contiguous.
+
+ The arithmetic mirrors the scalar converters exactly: Int32 and Int24
+ conversions are scaled and clipped in double precision, Int16 conversions
+ in single precision, and float to integer conversions truncate. The
+ non-clipping converters wrap out of range values in the same way as the
+ scalar casts on the same processor. The input converters scale by a power
+ of two after converting to float, which gives the same result as the
+ scalar double precision scaling.
+
+ The SIMD converters are only compiled for little endian targets. The SSE2
+ converters are available on processors where SSE2 is part of the baseline
+ instruction set (x86-64, or x86 builds which target SSE2), the AVX2 and
+ AVX-512 converters on x86-64 processors which report support for them at
+ runtime, and the NEON converters on AArch64. pa_converters.c chooses
+ between them when PortAudio is initialized.
+*/
+
+#include <string.h> /* memcpy() */
+
+#include "pa_converters_simd.h"
+#include "pa_dither.h"
+#include "pa_endianness.h"
+#include "pa_types.h"
+
+
+#if defined(PA_LITTLE_ENDIAN)
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PA_SIMD_SSE2_
+#endif
+
+#if defined(PA_SIMD_SSE2_) && (defined(__x86_64__) || defined(_M_X64)) \
+        && (defined(_MSC_VER) || defined(__clang__) \
+            || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define PA_SIMD_AVX2_
+#endif
+
+#if defined(PA_SIMD_AVX2_) && (defined(__clang__) \
+            || (defined(_MSC_VER) && _MSC_VER >= 1911) \
+            || (!defined(_MSC_VER) && defined(__GNUC__) && __GNUC__ >= 5))
+#define PA_SIMD_AVX512_
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define PA_SIMD_NEON_
+#endif
+
+#endif /* PA_LITTLE_ENDIAN */
+
+
+#if defined(PA_SIMD_SSE2_) || defined(PA_SIMD_NEON_)
+
+#if defined(_MSC_VER)
+#define PA_SIMD_INLINE_ static __forceinline
+#elif defined(__GNUC__)
+#define PA_SIMD_INLINE_ static __inline__ __attribute__((always_inline))
+#else
+#define PA_SIMD_INLINE_ static
+#endif
+
+/* functions which use AVX2 instructions must be marked as such for gcc and
+ clang, MSVC allows any intrinsic to be used in any function. */
+#if defined(__GNUC__) || defined(__clang__)
+#define PA_SIMD_TARGET_AVX2_ __attribute__((target("avx2")))
+#define PA_SIMD_TARGET_AVX512_ __attribute__((target("avx512f")))
+#else
+#define PA_SIMD_TARGET_AVX2_
+#define PA_SIMD_TARGET_AVX512_
+#endif
+
+#define PA_SIMD_TARGET_DEFAULT_
+
+
+#if defined(PA_SIMD_SSE2_)
+#include <emmintrin.h>
+#endif
+
+#if defined(PA_SIMD_AVX2_)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(PA_SIMD_NEON_)
+#include <arm_neon.h>
+#endif
+
+
+#define PA_CLIP_( val, min, max )\
+    { val = ((val) < (min)) ? (min) : (((val) > (max)) ? (max) : (val)); }
+
+
+/* Declare a converter with the standard PaUtilConverter signature which calls
+ an inlined worker with constant dither and clip arguments, so that the
+ compiler generates a specialised loop for each variant. */
+#define PA_DEFINE_SIMD_CONVERTER_( target, name, worker, dither, clip )        \
+    target static void name(                                                    \
+        void *destinationBuffer, signed int destinationStride,                  \
+        void *sourceBuffer, signed int sourceStride,                            \
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator ) \
+    {                                                                           \
+        worker( destinationBuffer, destinationStride, sourceBuffer, sourceStride, \
+                count, ditherGenerator, dither, clip );                         \
+    }
+
+
+/* -------------------------------------------------------------------------- */
+
+/* Scalar helpers shared by all instruction sets. These perform exactly the
+ same operations as the corresponding converters in pa_converters.c and are
+ used for the samples left over after the last complete vector. */
+
+PA_SIMD_INLINE_ PaInt32 Float32ToInt32Sample_( float sample,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator, int dither, int clip )
+{
+    double scaled;
+
+    if( dither )
+    {
+        double ditherValue = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        scaled = ((double)sample * (2147483646.0)) + ditherValue;
+    }
+    else
+    {
+        scaled = (double)sample * 2147483647.0;
+    }
+
+    if( clip )
+        PA_CLIP_( scaled, -2147483648., 2147483647. );
+
+    return (PaInt32) scaled;
+}
+
+
+PA_SIMD_INLINE_ PaInt16 Float32ToInt16Sample_( float sample,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator, int dither, int clip )
+{
+    float scaled;
+    PaInt32 samp;
+
+    if( dither )
+    {
+        float ditherValue = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
+        /* use smaller scaler to prevent overflow when we add the dither */
+        scaled = (sample * (32766.0f)) + ditherValue;
+    }
+    else
+    {
+        scaled = sample * (32767.0f);
+    }
+
+    samp = (PaInt32) scaled;
+    if( clip )
+        PA_CLIP_( samp, -0x8000, 0x7FFF );
+
+    return (PaInt16) samp;
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int32_Tail_( PaInt32 *dest, signed int destinationStride,
+        const float *src, signed int sourceStride, unsigned int count,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator, int dither, int clip )
+{
+    while( count-- )
+    {
+        *dest = Float32ToInt32Sample_( *src, ditherGenerator, dither, clip );
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ void StoreInt24_( unsigned char *dest, PaInt32 temp )
+{
+    dest[0] = (unsigned char)(temp >> 8);
+    dest[1] = (unsigned char)(temp >> 16);
+    dest[2] = (unsigned char)(temp >> 24);
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int24_Tail_( unsigned char *dest, signed int destinationStride,
+        const float *src, signed int sourceStride, unsigned int count,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator, int dither, int clip )
+{
+    while( count-- )
+    {
+        StoreInt24_( dest, Float32ToInt32Sample_( *src, ditherGenerator, dither, clip ) );
+
+        src += sourceStride;
+        dest += destinationStride * 3;
+    }
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int16_Tail_( PaInt16 *dest, signed int destinationStride,
+        const float *src, signed int sourceStride, unsigned int count,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator, int dither, int clip )
+{
+    while( count-- )
+    {
+        *dest = Float32ToInt16Sample_( *src, ditherGenerator, dither, clip );
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ PaInt32 LoadInt24_( const unsigned char *src )
+{
+    return (((PaInt32)src[0]) << 8) | (((PaInt32)src[1]) << 16) | (((PaInt32)src[2]) << 24);
+}
+
+
+PA_SIMD_INLINE_ void Int32_To_Float32_Tail_( float *dest, signed int destinationStride,
+        const PaInt32 *src, signed int sourceStride, unsigned int count )
+{
+    while( count-- )
+    {
+        *dest = (float) ((double)*src * (1.0 / 2147483648.0));
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ void Int24_To_Float32_Tail_( float *dest, signed int destinationStride,
+        const unsigned char *src, signed int sourceStride, unsigned int count )
+{
+    while( count-- )
+    {
+        *dest = (float) ((double)LoadInt24_( src ) * (1.0 / 2147483648.0));
+
+        src += sourceStride * 3;
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ void Int16_To_Float32_Tail_( float *dest, signed int destinationStride,
+        const PaInt16 *src, signed int sourceStride, unsigned int count )
+{
+    while( count-- )
+    {
+        *dest = *src * (1.0f / 32768.f);
+
+        src += sourceStride;
+        dest += destinationStride;
+    }
+}
+
+
+/* Dither for the vector loops is generated PA_DITHER_BLOCK_SIZE values at a
+ time by the block dither generator. A block never holds more values than
+ the remaining complete vectors consume, so the scalar tail continues the
+ same dither sequence and the vector converters consume dither in the same
+ order as the scalar ones. */
+typedef struct PaSimdDitherBlock_
+{
+    float values[PA_DITHER_BLOCK_SIZE];
+    unsigned int index;
+    unsigned int count;
+} PaSimdDitherBlock_;
+
+
+PA_SIMD_INLINE_ void InitializeDitherBlock_( PaSimdDitherBlock_ *block )
+{
+    block->index = 0;
+    block->count = 0;
+}
+
+
+/* Return the dither values for the next vectorWidth samples. remaining is the
+ number of samples which are still to be converted. */
+PA_SIMD_INLINE_ const float *NextDitherValues_( PaSimdDitherBlock_ *block,
+        unsigned int vectorWidth, unsigned int remaining,
+        struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    if( block->index == block->count )
+    {
+        remaining -= remaining % vectorWidth;
+        block->count = (remaining < PA_DITHER_BLOCK_SIZE) ? remaining : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, block->values, block->count );
+        block->index = 0;
+    }
+
+    block->index += vectorWidth;
+    return block->values + block->index - vectorWidth;
+}
+
+
+PA_SIMD_INLINE_ void ScatterInt32_( PaInt32 *dest, signed int destinationStride,
+        const PaInt32 *block, int count )
+{
+    int i;
+    for( i = 0; i < count; ++i )
+    {
+        *dest = block[i];
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ void ScatterInt24_( unsigned char *dest, signed int destinationStride,
+        const PaInt32 *block, int count )
+{
+    int i;
+    for( i = 0; i < count; ++i )
+    {
+        StoreInt24_( dest, block[i] );
+        dest += destinationStride * 3;
+    }
+}
+
+
+/* Pack the upper 24 bits of 4 samples into 12 contiguous bytes. */
+PA_SIMD_INLINE_ void PackInt24x4_( unsigned char *dest, const PaInt32 *block )
+{
+    PaUint32 words[3];
+    PaUint32 s0 = (PaUint32)block[0], s1 = (PaUint32)block[1];
+    PaUint32 s2 = (PaUint32)block[2], s3 = (PaUint32)block[3];
+
+    words[0] = (s0 >> 8) | ((s1 & 0x0000FF00) << 16);
+    words[1] = (s1 >> 16) | ((s2 & 0x00FFFF00) << 8);
+    words[2] = (s2 >> 24) | (s3 & 0xFFFFFF00);
+
+    memcpy( dest, words, 12 );
+}
+
+
+/* Unpack 12 contiguous bytes into 4 samples with the 24 bits in the upper
+ bytes, as returned by LoadInt24_(). */
+PA_SIMD_INLINE_ void UnpackInt24x4_( PaInt32 *block, const unsigned char *src )
+{
+    PaUint32 words[3];
+
+    memcpy( words, src, 12 );
+
+    block[0] = (PaInt32)(words[0] << 8);
+    block[1] = (PaInt32)(((words[0] >> 16) & 0x0000FF00) | (words[1] << 16));
+    block[2] = (PaInt32)(((words[1] >> 8) & 0x00FFFF00) | (words[2] << 24));
+    block[3] = (PaInt32)(words[2] & 0xFFFFFF00);
+}
+
+
+PA_SIMD_INLINE_ void GatherInt24_( PaInt32 *block, const unsigned char *src,
+        signed int sourceStride, int count )
+{
+    int i;
+    for( i = 0; i < count; ++i )
+    {
+        block[i] = LoadInt24_( src );
+        src += sourceStride * 3;
+    }
+}
+
+
+PA_SIMD_INLINE_ void ScatterFloat32_( float *dest, signed int destinationStride,
+        const float *block, int count )
+{
+    int i;
+    for( i = 0; i < count; ++i )
+    {
+        *dest = block[i];
+        dest += destinationStride;
+    }
+}
+
+
+PA_SIMD_INLINE_ void ScatterInt16_( PaInt16 *dest, signed int destinationStride,
+        const PaInt16 *block, int count )
+{
+    int i;
+    for( i = 0; i < count; ++i )
+    {
+        *dest = block[i];
+        dest += destinationStride;
+    }
+}
+
+#endif /* PA_SIMD_SSE2_ || PA_SIMD_NEON_ */
+
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_SIMD_SSE2_)
+
+PA_SIMD_INLINE_ __m128 LoadFloat32x4_SSE2_( const float *src, signed int sourceStride )
+{
+    if( sourceStride == 1 )
+        return _mm_loadu_ps( src );
+    else
+        return _mm_setr_ps( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride] );
+}
+
+
+/* Convert 4 floats to 32 bit integers using double precision arithmetic. */
+PA_SIMD_INLINE_ __m128i Float32ToInt32x4_SSE2_( __m128 samples,
+        const float *ditherValues, int dither, int clip )
+{
+    const __m128d scaler = _mm_set1_pd( dither ? 2147483646.0 : 2147483647.0 );
+    __m128d lo = _mm_mul_pd( _mm_cvtps_pd( samples ), scaler );
+    __m128d hi = _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( samples, samples ) ), scaler );
+
+    if( dither )
+    {
+        __m128 ditherVector = _mm_loadu_ps( ditherValues );
+        lo = _mm_add_pd( lo, _mm_cvtps_pd( ditherVector ) );
+        hi = _mm_add_pd( hi, _mm_cvtps_pd( _mm_movehl_ps( ditherVector, ditherVector ) ) );
+    }
+
+    if( clip )
+    {
+        /* maxpd returns its second operand for NaN, matching the
+            truncation of an unclipped NaN in the scalar converter */
+        const __m128d minimum = _mm_set1_pd( -2147483648. );
+        const __m128d maximum = _mm_set1_pd( 2147483647. );
+        lo = _mm_min_pd( _mm_max_pd( lo, minimum ), maximum );
+        hi = _mm_min_pd( _mm_max_pd( hi, minimum ), maximum );
+    }
+
+    return _mm_unpacklo_epi64( _mm_cvttpd_epi32( lo ), _mm_cvttpd_epi32( hi ) );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int32_SSE2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[4];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        __m128i samples;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+
+        samples = Float32ToInt32x4_SSE2_( LoadFloat32x4_SSE2_( src, sourceStride ),
+                ditherValues, dither, clip );
+
+        if( destinationStride == 1 )
+        {
+            _mm_storeu_si128( (__m128i*)dest, samples );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)block, samples );
+            ScatterInt32_( dest, destinationStride, block, 4 );
+        }
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride;
+        count -= 4;
+    }
+
+    Float32_To_Int32_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int24_SSE2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[4];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+
+        _mm_storeu_si128( (__m128i*)block, Float32ToInt32x4_SSE2_(
+                LoadFloat32x4_SSE2_( src, sourceStride ), ditherValues, dither, clip ) );
+
+        if( destinationStride == 1 )
+            PackInt24x4_( dest, block );
+        else
+            ScatterInt24_( dest, destinationStride, block, 4 );
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride * 3;
+        count -= 4;
+    }
+
+    Float32_To_Int24_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int16_SSE2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m128 scaler = _mm_set1_ps( dither ? 32766.0f : 32767.0f );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt16 block[8];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        __m128 scaled = _mm_mul_ps( LoadFloat32x4_SSE2_( src, sourceStride ), scaler );
+        __m128i samples;
+
+        if( dither )
+        {
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+            scaled = _mm_add_ps( scaled, _mm_loadu_ps( ditherValues ) );
+        }
+
+        samples = _mm_cvttps_epi32( scaled );
+        if( !clip ) /* wrap to 16 bits, so that packssdw doesn't saturate */
+            samples = _mm_srai_epi32( _mm_slli_epi32( samples, 16 ), 16 );
+        samples = _mm_packs_epi32( samples, samples );
+
+        if( destinationStride == 1 )
+        {
+            _mm_storel_epi64( (__m128i*)dest, samples );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)block, samples );
+            ScatterInt16_( dest, destinationStride, block, 4 );
+        }
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride;
+        count -= 4;
+    }
+
+    Float32_To_Int16_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_SSE2, Float32_To_Int32_SSE2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_Dither_SSE2, Float32_To_Int32_SSE2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_Clip_SSE2, Float32_To_Int32_SSE2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_DitherClip_SSE2, Float32_To_Int32_SSE2_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_SSE2, Float32_To_Int24_SSE2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_Dither_SSE2, Float32_To_Int24_SSE2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_Clip_SSE2, Float32_To_Int24_SSE2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_DitherClip_SSE2, Float32_To_Int24_SSE2_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_SSE2, Float32_To_Int16_SSE2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_Dither_SSE2, Float32_To_Int16_SSE2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_Clip_SSE2, Float32_To_Int16_SSE2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_DitherClip_SSE2, Float32_To_Int16_SSE2_, 1, 1 )
+
+
+
+PA_SIMD_INLINE_ void StoreFloat32x4_SSE2_( float *dest, signed int destinationStride, __m128 samples )
+{
+    if( destinationStride == 1 )
+    {
+        _mm_storeu_ps( dest, samples );
+    }
+    else
+    {
+        float block[4];
+        _mm_storeu_ps( block, samples );
+        ScatterFloat32_( dest, destinationStride, block, 4 );
+    }
+}
+
+
+static void Int32_To_Float32_SSE2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m128 scaler = _mm_set1_ps( 1.0f / 2147483648.0f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 4; count -= 4, src += 4, dest += 4 )
+            _mm_storeu_ps( dest, _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*)src ) ), scaler ) );
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride, dest += 4 * destinationStride )
+        {
+            __m128i samples = _mm_setr_epi32( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride] );
+            StoreFloat32x4_SSE2_( dest, destinationStride, _mm_mul_ps( _mm_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int32_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+static void Int24_To_Float32_SSE2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m128 scaler = _mm_set1_ps( 1.0f / 2147483648.0f );
+    PaInt32 block[4];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 4; count -= 4, src += 12, dest += 4 )
+        {
+            UnpackInt24x4_( block, src );
+            _mm_storeu_ps( dest, _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*)block ) ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride * 3, dest += 4 * destinationStride )
+        {
+            GatherInt24_( block, src, sourceStride, 4 );
+            StoreFloat32x4_SSE2_( dest, destinationStride,
+                    _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*)block ) ), scaler ) );
+        }
+    }
+
+    Int24_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+static void Int16_To_Float32_SSE2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m128 scaler = _mm_set1_ps( 1.0f / 32768.f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 8; count -= 8, src += 8, dest += 8 )
+        {
+            __m128i samples = _mm_loadu_si128( (const __m128i*)src );
+            /* sign extend by placing each sample in the upper half of a 32 bit lane */
+            __m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( samples, samples ), 16 );
+            __m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( samples, samples ), 16 );
+            _mm_storeu_ps( dest, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scaler ) );
+            _mm_storeu_ps( dest + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride, dest += 4 * destinationStride )
+        {
+            __m128i samples = _mm_setr_epi32( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride] );
+            StoreFloat32x4_SSE2_( dest, destinationStride, _mm_mul_ps( _mm_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int16_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+#endif /* PA_SIMD_SSE2_ */
+
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_SIMD_AVX2_)
+
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ __m256 LoadFloat32x8_AVX2_( const float *src, signed int sourceStride )
+{
+    if( sourceStride == 1 )
+        return _mm256_loadu_ps( src );
+    else
+        return _mm256_setr_ps( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride],
+                src[4*sourceStride], src[5*sourceStride], src[6*sourceStride], src[7*sourceStride] );
+}
+
+
+/* Convert 4 floats to 32 bit integers using double precision arithmetic. */
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ __m128i Float32ToInt32x4_AVX2_( __m128 samples,
+        const float *ditherValues, int dither, int clip )
+{
+    __m256d scaled = _mm256_mul_pd( _mm256_cvtps_pd( samples ),
+            _mm256_set1_pd( dither ? 2147483646.0 : 2147483647.0 ) );
+
+    if( dither )
+        scaled = _mm256_add_pd( scaled, _mm256_cvtps_pd( _mm_loadu_ps( ditherValues ) ) );
+
+    if( clip )
+    {
+        scaled = _mm256_min_pd( _mm256_max_pd( scaled, _mm256_set1_pd( -2147483648. ) ),
+                _mm256_set1_pd( 2147483647. ) );
+    }
+
+    return _mm256_cvttpd_epi32( scaled );
+}
+
+
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ void Float32_To_Int32_AVX2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[8];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 8 )
+    {
+        __m256 samples = LoadFloat32x8_AVX2_( src, sourceStride );
+        __m128i lo, hi;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 8, count, ditherGenerator );
+
+        lo = Float32ToInt32x4_AVX2_( _mm256_castps256_ps128( samples ), ditherValues, dither, clip );
+        hi = Float32ToInt32x4_AVX2_( _mm256_extractf128_ps( samples, 1 ), ditherValues + 4, dither, clip );
+
+        if( destinationStride == 1 )
+        {
+            _mm_storeu_si128( (__m128i*)dest, lo );
+            _mm_storeu_si128( (__m128i*)(dest + 4), hi );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)block, lo );
+            _mm_storeu_si128( (__m128i*)(block + 4), hi );
+            ScatterInt32_( dest, destinationStride, block, 8 );
+        }
+
+        src += 8 * sourceStride;
+        dest += 8 * destinationStride;
+        count -= 8;
+    }
+
+    Float32_To_Int32_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ void Float32_To_Int24_AVX2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    /* selects bytes 1-3 of each 32 bit sample */
+    const __m128i packInt24 = _mm_setr_epi8( 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1 );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[8];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 8 )
+    {
+        __m256 samples = LoadFloat32x8_AVX2_( src, sourceStride );
+        __m128i lo, hi;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 8, count, ditherGenerator );
+
+        lo = Float32ToInt32x4_AVX2_( _mm256_castps256_ps128( samples ), ditherValues, dither, clip );
+        hi = Float32ToInt32x4_AVX2_( _mm256_extractf128_ps( samples, 1 ), ditherValues + 4, dither, clip );
+
+        if( destinationStride == 1 )
+        {
+            unsigned char packed[32];
+            _mm_storeu_si128( (__m128i*)packed, _mm_shuffle_epi8( lo, packInt24 ) );
+            _mm_storeu_si128( (__m128i*)(packed + 12), _mm_shuffle_epi8( hi, packInt24 ) );
+            memcpy( dest, packed, 24 );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)block, lo );
+            _mm_storeu_si128( (__m128i*)(block + 4), hi );
+            ScatterInt24_( dest, destinationStride, block, 8 );
+        }
+
+        src += 8 * sourceStride;
+        dest += 8 * destinationStride * 3;
+        count -= 8;
+    }
+
+    Float32_To_Int24_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ void Float32_To_Int16_AVX2_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m256 scaler = _mm256_set1_ps( dither ? 32766.0f : 32767.0f );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt16 block[8];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 8 )
+    {
+        __m256 scaled = _mm256_mul_ps( LoadFloat32x8_AVX2_( src, sourceStride ), scaler );
+        __m256i samples;
+        __m128i packed;
+
+        if( dither )
+        {
+            ditherValues = NextDitherValues_( &ditherBlock, 8, count, ditherGenerator );
+            scaled = _mm256_add_ps( scaled, _mm256_loadu_ps( ditherValues ) );
+        }
+
+        samples = _mm256_cvttps_epi32( scaled );
+        if( !clip ) /* wrap to 16 bits, so that packssdw doesn't saturate */
+            samples = _mm256_srai_epi32( _mm256_slli_epi32( samples, 16 ), 16 );
+        packed = _mm_packs_epi32( _mm256_castsi256_si128( samples ),
+                _mm256_extracti128_si256( samples, 1 ) );
+
+        if( destinationStride == 1 )
+        {
+            _mm_storeu_si128( (__m128i*)dest, packed );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)block, packed );
+            ScatterInt16_( dest, destinationStride, block, 8 );
+        }
+
+        src += 8 * sourceStride;
+        dest += 8 * destinationStride;
+        count -= 8;
+    }
+
+    Float32_To_Int16_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int32_AVX2, Float32_To_Int32_AVX2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int32_Dither_AVX2, Float32_To_Int32_AVX2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int32_Clip_AVX2, Float32_To_Int32_AVX2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int32_DitherClip_AVX2, Float32_To_Int32_AVX2_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int24_AVX2, Float32_To_Int24_AVX2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int24_Dither_AVX2, Float32_To_Int24_AVX2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int24_Clip_AVX2, Float32_To_Int24_AVX2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int24_DitherClip_AVX2, Float32_To_Int24_AVX2_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int16_AVX2, Float32_To_Int16_AVX2_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int16_Dither_AVX2, Float32_To_Int16_AVX2_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int16_Clip_AVX2, Float32_To_Int16_AVX2_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX2_, Float32_To_Int16_DitherClip_AVX2, Float32_To_Int16_AVX2_, 1, 1 )
+
+
+PA_SIMD_TARGET_AVX2_ PA_SIMD_INLINE_ void StoreFloat32x8_AVX2_( float *dest, signed int destinationStride, __m256 samples )
+{
+    if( destinationStride == 1 )
+    {
+        _mm256_storeu_ps( dest, samples );
+    }
+    else
+    {
+        float block[8];
+        _mm256_storeu_ps( block, samples );
+        ScatterFloat32_( dest, destinationStride, block, 8 );
+    }
+}
+
+
+PA_SIMD_TARGET_AVX2_ static void Int32_To_Float32_AVX2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scaler = _mm256_set1_ps( 1.0f / 2147483648.0f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 8; count -= 8, src += 8, dest += 8 )
+            _mm256_storeu_ps( dest, _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( (const __m256i*)src ) ), scaler ) );
+    }
+    else
+    {
+        for( ; count >= 8; count -= 8, src += 8 * sourceStride, dest += 8 * destinationStride )
+        {
+            __m256i samples = _mm256_setr_epi32( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride],
+                    src[4*sourceStride], src[5*sourceStride], src[6*sourceStride], src[7*sourceStride] );
+            StoreFloat32x8_AVX2_( dest, destinationStride, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int32_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+PA_SIMD_TARGET_AVX2_ static void Int24_To_Float32_AVX2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scaler = _mm256_set1_ps( 1.0f / 2147483648.0f );
+    PaInt32 block[8];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        /* 8 samples occupy 24 bytes. They are read as bytes 0-15 and 8-23 so
+            that nothing beyond the last sample is touched. */
+        const __m128i unpackLo = _mm_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+        const __m128i unpackHi = _mm_setr_epi8( -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15 );
+
+        for( ; count >= 8; count -= 8, src += 24, dest += 8 )
+        {
+            __m128i lo = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)src ), unpackLo );
+            __m128i hi = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(src + 8) ), unpackHi );
+            __m256i samples = _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+            _mm256_storeu_ps( dest, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 8; count -= 8, src += 8 * sourceStride * 3, dest += 8 * destinationStride )
+        {
+            GatherInt24_( block, src, sourceStride, 8 );
+            StoreFloat32x8_AVX2_( dest, destinationStride,
+                    _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( (const __m256i*)block ) ), scaler ) );
+        }
+    }
+
+    Int24_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+PA_SIMD_TARGET_AVX2_ static void Int16_To_Float32_AVX2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scaler = _mm256_set1_ps( 1.0f / 32768.f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 8; count -= 8, src += 8, dest += 8 )
+        {
+            __m256i samples = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)src ) );
+            _mm256_storeu_ps( dest, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 8; count -= 8, src += 8 * sourceStride, dest += 8 * destinationStride )
+        {
+            __m256i samples = _mm256_setr_epi32( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride],
+                    src[4*sourceStride], src[5*sourceStride], src[6*sourceStride], src[7*sourceStride] );
+            StoreFloat32x8_AVX2_( dest, destinationStride, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int16_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+/* Returns non-zero if the processor and the operating system support AVX2
+ and, if avx512 is non-zero, AVX-512F. */
+static int CpuSupportsAvx( int avx512 )
+{
+    /* XMM and YMM state, plus opmask and ZMM state for AVX-512 */
+    unsigned int osStateMask = avx512 ? 0xE6 : 0x6;
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid( info, 0 );
+    if( info[0] < 7 )
+        return 0;
+
+    __cpuid( info, 1 );
+    if( (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ) /* OSXSAVE, AVX */
+        return 0;
+
+    if( ((unsigned int)_xgetbv( 0 ) & osStateMask) != osStateMask ) /* state enabled by the OS */
+        return 0;
+
+    __cpuidex( info, 7, 0 );
+    if( (info[1] & (1 << 5)) == 0 ) /* AVX2 */
+        return 0;
+
+    return !avx512 || (info[1] & (1 << 16)) != 0; /* AVX512F */
+#else
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0Low, xcr0High;
+
+    if( __get_cpuid_max( 0, 0 ) < 7 )
+        return 0;
+
+    __cpuid( 1, eax, ebx, ecx, edx );
+    if( (ecx & (1 << 27)) == 0 || (ecx & (1 << 28)) == 0 ) /* OSXSAVE, AVX */
+        return 0;
+
+    __asm__ __volatile__ ( "xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0) );
+    (void)xcr0High;
+    if( (xcr0Low & osStateMask) != osStateMask ) /* state enabled by the OS */
+        return 0;
+
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    if( (ebx & (1 << 5)) == 0 ) /* AVX2 */
+        return 0;
+
+    return !avx512 || (ebx & (1u << 16)) != 0; /* AVX512F */
+#endif
+}
+
+#endif /* PA_SIMD_AVX2_ */
+
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_SIMD_AVX512_)
+
+/* Element offsets of 16 samples which are sampleStride elements apart. */
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ __m512i StrideOffsets_AVX512_( signed int sampleStride )
+{
+    return _mm512_mullo_epi32( _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+            _mm512_set1_epi32( sampleStride ) );
+}
+
+
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ __m512 LoadFloat32x16_AVX512_( const float *src,
+        signed int sourceStride, __m512i sourceOffsets )
+{
+    if( sourceStride == 1 )
+        return _mm512_loadu_ps( src );
+    else
+        return _mm512_i32gather_ps( sourceOffsets, src, 4 );
+}
+
+
+/* Convert 8 floats to 32 bit integers using double precision arithmetic. */
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ __m256i Float32ToInt32x8_AVX512_( __m256 samples,
+        const float *ditherValues, int dither, int clip )
+{
+    __m512d scaled = _mm512_mul_pd( _mm512_cvtps_pd( samples ),
+            _mm512_set1_pd( dither ? 2147483646.0 : 2147483647.0 ) );
+
+    if( dither )
+        scaled = _mm512_add_pd( scaled, _mm512_cvtps_pd( _mm256_loadu_ps( ditherValues ) ) );
+
+    if( clip )
+    {
+        scaled = _mm512_min_pd( _mm512_max_pd( scaled, _mm512_set1_pd( -2147483648. ) ),
+                _mm512_set1_pd( 2147483647. ) );
+    }
+
+    return _mm512_cvttpd_epi32( scaled );
+}
+
+
+/* Convert 16 floats to 32 bit integers using double precision arithmetic. */
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ __m512i Float32ToInt32x16_AVX512_( __m512 samples,
+        const float *ditherValues, int dither, int clip )
+{
+    __m256i lo = Float32ToInt32x8_AVX512_(
+            _mm256_castpd_ps( _mm512_castpd512_pd256( _mm512_castps_pd( samples ) ) ),
+            ditherValues, dither, clip );
+    __m256i hi = Float32ToInt32x8_AVX512_(
+            _mm256_castpd_ps( _mm512_extractf64x4_pd( _mm512_castps_pd( samples ), 1 ) ),
+            ditherValues + 8, dither, clip );
+
+    return _mm512_inserti64x4( _mm512_castsi256_si512( lo ), hi, 1 );
+}
+
+
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ void Float32_To_Int32_AVX512_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    const __m512i sourceOffsets = StrideOffsets_AVX512_( sourceStride );
+    const __m512i destinationOffsets = StrideOffsets_AVX512_( destinationStride );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 16 )
+    {
+        __m512i samples;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 16, count, ditherGenerator );
+
+        samples = Float32ToInt32x16_AVX512_( LoadFloat32x16_AVX512_( src, sourceStride, sourceOffsets ),
+                ditherValues, dither, clip );
+
+        if( destinationStride == 1 )
+            _mm512_storeu_si512( dest, samples );
+        else
+            _mm512_i32scatter_epi32( dest, destinationOffsets, samples, 4 );
+
+        src += 16 * sourceStride;
+        dest += 16 * destinationStride;
+        count -= 16;
+    }
+
+    Float32_To_Int32_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ void Float32_To_Int24_AVX512_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    const __m512i sourceOffsets = StrideOffsets_AVX512_( sourceStride );
+    /* selects bytes 1-3 of each 32 bit sample */
+    const __m128i packInt24 = _mm_setr_epi8( 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1 );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[16];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 16 )
+    {
+        __m512i samples;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 16, count, ditherGenerator );
+
+        samples = Float32ToInt32x16_AVX512_( LoadFloat32x16_AVX512_( src, sourceStride, sourceOffsets ),
+                ditherValues, dither, clip );
+
+        if( destinationStride == 1 )
+        {
+            unsigned char packed[64];
+            _mm_storeu_si128( (__m128i*)packed,
+                    _mm_shuffle_epi8( _mm512_extracti32x4_epi32( samples, 0 ), packInt24 ) );
+            _mm_storeu_si128( (__m128i*)(packed + 12),
+                    _mm_shuffle_epi8( _mm512_extracti32x4_epi32( samples, 1 ), packInt24 ) );
+            _mm_storeu_si128( (__m128i*)(packed + 24),
+                    _mm_shuffle_epi8( _mm512_extracti32x4_epi32( samples, 2 ), packInt24 ) );
+            _mm_storeu_si128( (__m128i*)(packed + 36),
+                    _mm_shuffle_epi8( _mm512_extracti32x4_epi32( samples, 3 ), packInt24 ) );
+            memcpy( dest, packed, 48 );
+        }
+        else
+        {
+            _mm512_storeu_si512( block, samples );
+            ScatterInt24_( dest, destinationStride, block, 16 );
+        }
+
+        src += 16 * sourceStride;
+        dest += 16 * destinationStride * 3;
+        count -= 16;
+    }
+
+    Float32_To_Int24_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ void Float32_To_Int16_AVX512_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m512i sourceOffsets = StrideOffsets_AVX512_( sourceStride );
+    const __m512 scaler = _mm512_set1_ps( dither ? 32766.0f : 32767.0f );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt16 block[16];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 16 )
+    {
+        __m512 scaled = _mm512_mul_ps( LoadFloat32x16_AVX512_( src, sourceStride, sourceOffsets ), scaler );
+        __m512i samples;
+        __m256i packed;
+
+        if( dither )
+        {
+            ditherValues = NextDitherValues_( &ditherBlock, 16, count, ditherGenerator );
+            scaled = _mm512_add_ps( scaled, _mm512_loadu_ps( ditherValues ) );
+        }
+
+        samples = _mm512_cvttps_epi32( scaled );
+        if( clip )
+            packed = _mm512_cvtsepi32_epi16( samples ); /* saturate */
+        else
+            packed = _mm512_cvtepi32_epi16( samples ); /* wrap */
+
+        if( destinationStride == 1 )
+        {
+            _mm256_storeu_si256( (__m256i*)dest, packed );
+        }
+        else
+        {
+            _mm256_storeu_si256( (__m256i*)block, packed );
+            ScatterInt16_( dest, destinationStride, block, 16 );
+        }
+
+        src += 16 * sourceStride;
+        dest += 16 * destinationStride;
+        count -= 16;
+    }
+
+    Float32_To_Int16_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int32_AVX512, Float32_To_Int32_AVX512_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int32_Dither_AVX512, Float32_To_Int32_AVX512_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int32_Clip_AVX512, Float32_To_Int32_AVX512_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int32_DitherClip_AVX512, Float32_To_Int32_AVX512_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int24_AVX512, Float32_To_Int24_AVX512_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int24_Dither_AVX512, Float32_To_Int24_AVX512_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int24_Clip_AVX512, Float32_To_Int24_AVX512_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int24_DitherClip_AVX512, Float32_To_Int24_AVX512_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int16_AVX512, Float32_To_Int16_AVX512_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int16_Dither_AVX512, Float32_To_Int16_AVX512_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int16_Clip_AVX512, Float32_To_Int16_AVX512_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_AVX512_, Float32_To_Int16_DitherClip_AVX512, Float32_To_Int16_AVX512_, 1, 1 )
+
+
+PA_SIMD_TARGET_AVX512_ PA_SIMD_INLINE_ void StoreFloat32x16_AVX512_( float *dest,
+        signed int destinationStride, __m512i destinationOffsets, __m512 samples )
+{
+    if( destinationStride == 1 )
+        _mm512_storeu_ps( dest, samples );
+    else
+        _mm512_i32scatter_ps( dest, destinationOffsets, samples, 4 );
+}
+
+
+PA_SIMD_TARGET_AVX512_ static void Int32_To_Float32_AVX512(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m512 scaler = _mm512_set1_ps( 1.0f / 2147483648.0f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 16; count -= 16, src += 16, dest += 16 )
+            _mm512_storeu_ps( dest, _mm512_mul_ps( _mm512_cvtepi32_ps( _mm512_loadu_si512( src ) ), scaler ) );
+    }
+    else
+    {
+        const __m512i sourceOffsets = StrideOffsets_AVX512_( sourceStride );
+        const __m512i destinationOffsets = StrideOffsets_AVX512_( destinationStride );
+
+        for( ; count >= 16; count -= 16, src += 16 * sourceStride, dest += 16 * destinationStride )
+        {
+            __m512i samples = _mm512_i32gather_epi32( sourceOffsets, src, 4 );
+            StoreFloat32x16_AVX512_( dest, destinationStride, destinationOffsets,
+                    _mm512_mul_ps( _mm512_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int32_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+PA_SIMD_TARGET_AVX512_ static void Int24_To_Float32_AVX512(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m512 scaler = _mm512_set1_ps( 1.0f / 2147483648.0f );
+    PaInt32 block[16];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        /* 16 samples occupy 48 bytes. They are read as bytes 0-15, 8-23,
+            24-39 and 32-47 so that nothing beyond the last sample is touched. */
+        const __m128i unpackLo = _mm_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+        const __m128i unpackHi = _mm_setr_epi8( -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15 );
+
+        for( ; count >= 16; count -= 16, src += 48, dest += 16 )
+        {
+            __m512i samples = _mm512_castsi128_si512(
+                    _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)src ), unpackLo ) );
+            samples = _mm512_inserti32x4( samples,
+                    _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(src + 8) ), unpackHi ), 1 );
+            samples = _mm512_inserti32x4( samples,
+                    _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(src + 24) ), unpackLo ), 2 );
+            samples = _mm512_inserti32x4( samples,
+                    _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(src + 32) ), unpackHi ), 3 );
+            _mm512_storeu_ps( dest, _mm512_mul_ps( _mm512_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+    else
+    {
+        const __m512i destinationOffsets = StrideOffsets_AVX512_( destinationStride );
+
+        for( ; count >= 16; count -= 16, src += 16 * sourceStride * 3, dest += 16 * destinationStride )
+        {
+            GatherInt24_( block, src, sourceStride, 16 );
+            StoreFloat32x16_AVX512_( dest, destinationStride, destinationOffsets,
+                    _mm512_mul_ps( _mm512_cvtepi32_ps( _mm512_loadu_si512( block ) ), scaler ) );
+        }
+    }
+
+    Int24_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+PA_SIMD_TARGET_AVX512_ static void Int16_To_Float32_AVX512(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m512 scaler = _mm512_set1_ps( 1.0f / 32768.f );
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 16; count -= 16, src += 16, dest += 16 )
+        {
+            __m512i samples = _mm512_cvtepi16_epi32( _mm256_loadu_si256( (const __m256i*)src ) );
+            _mm512_storeu_ps( dest, _mm512_mul_ps( _mm512_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+    else
+    {
+        const __m512i destinationOffsets = StrideOffsets_AVX512_( destinationStride );
+
+        for( ; count >= 16; count -= 16, src += 16 * sourceStride, dest += 16 * destinationStride )
+        {
+            /* there is no 16 bit gather, and a 32 bit gather could read
+                beyond the last sample */
+            __m512i samples = _mm512_setr_epi32( src[0], src[sourceStride], src[2*sourceStride], src[3*sourceStride],
+                    src[4*sourceStride], src[5*sourceStride], src[6*sourceStride], src[7*sourceStride],
+                    src[8*sourceStride], src[9*sourceStride], src[10*sourceStride], src[11*sourceStride],
+                    src[12*sourceStride], src[13*sourceStride], src[14*sourceStride], src[15*sourceStride] );
+            StoreFloat32x16_AVX512_( dest, destinationStride, destinationOffsets,
+                    _mm512_mul_ps( _mm512_cvtepi32_ps( samples ), scaler ) );
+        }
+    }
+
+    Int16_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+#endif /* PA_SIMD_AVX512_ */
+
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_SIMD_NEON_)
+
+PA_SIMD_INLINE_ float32x4_t LoadFloat32x4_NEON_( const float *src, signed int sourceStride )
+{
+    if( sourceStride == 1 )
+    {
+        return vld1q_f32( src );
+    }
+    else
+    {
+        float gathered[4];
+        gathered[0] = src[0];
+        gathered[1] = src[sourceStride];
+        gathered[2] = src[2*sourceStride];
+        gathered[3] = src[3*sourceStride];
+        return vld1q_f32( gathered );
+    }
+}
+
+
+/* Convert 4 floats to 32 bit integers using double precision arithmetic.
+ fcvtzs saturates and the narrowing is saturating too, which matches the
+ scalar float to int conversion on AArch64, including NaN becoming 0. */
+PA_SIMD_INLINE_ int32x4_t Float32ToInt32x4_NEON_( float32x4_t samples,
+        const float *ditherValues, int dither, int clip )
+{
+    const float64x2_t scaler = vdupq_n_f64( dither ? 2147483646.0 : 2147483647.0 );
+    float64x2_t lo = vmulq_f64( vcvt_f64_f32( vget_low_f32( samples ) ), scaler );
+    float64x2_t hi = vmulq_f64( vcvt_high_f64_f32( samples ), scaler );
+
+    if( dither )
+    {
+        float32x4_t ditherVector = vld1q_f32( ditherValues );
+        lo = vaddq_f64( lo, vcvt_f64_f32( vget_low_f32( ditherVector ) ) );
+        hi = vaddq_f64( hi, vcvt_high_f64_f32( ditherVector ) );
+    }
+
+    if( clip )
+    {
+        const float64x2_t minimum = vdupq_n_f64( -2147483648. );
+        const float64x2_t maximum = vdupq_n_f64( 2147483647. );
+        lo = vminq_f64( vmaxq_f64( lo, minimum ), maximum );
+        hi = vminq_f64( vmaxq_f64( hi, minimum ), maximum );
+    }
+
+    return vcombine_s32( vqmovn_s64( vcvtq_s64_f64( lo ) ), vqmovn_s64( vcvtq_s64_f64( hi ) ) );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int32_NEON_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[4];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        int32x4_t samples;
+
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+
+        samples = Float32ToInt32x4_NEON_( LoadFloat32x4_NEON_( src, sourceStride ),
+                ditherValues, dither, clip );
+
+        if( destinationStride == 1 )
+        {
+            vst1q_s32( (int32_t*)dest, samples );
+        }
+        else
+        {
+            vst1q_s32( (int32_t*)block, samples );
+            ScatterInt32_( dest, destinationStride, block, 4 );
+        }
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride;
+        count -= 4;
+    }
+
+    Float32_To_Int32_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int24_NEON_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt32 block[4];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        if( dither )
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+
+        vst1q_s32( (int32_t*)block, Float32ToInt32x4_NEON_(
+                LoadFloat32x4_NEON_( src, sourceStride ), ditherValues, dither, clip ) );
+
+        if( destinationStride == 1 )
+            PackInt24x4_( dest, block );
+        else
+            ScatterInt24_( dest, destinationStride, block, 4 );
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride * 3;
+        count -= 4;
+    }
+
+    Float32_To_Int24_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_SIMD_INLINE_ void Float32_To_Int16_NEON_(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator,
+    int dither, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const float32x4_t scaler = vdupq_n_f32( dither ? 32766.0f : 32767.0f );
+    PaSimdDitherBlock_ ditherBlock;
+    const float *ditherValues = ditherBlock.values;
+    PaInt16 block[4];
+
+    InitializeDitherBlock_( &ditherBlock );
+
+    while( count >= 4 )
+    {
+        float32x4_t scaled = vmulq_f32( LoadFloat32x4_NEON_( src, sourceStride ), scaler );
+        int32x4_t samples;
+        int16x4_t narrowed;
+
+        if( dither )
+        {
+            ditherValues = NextDitherValues_( &ditherBlock, 4, count, ditherGenerator );
+            scaled = vaddq_f32( scaled, vld1q_f32( ditherValues ) );
+        }
+
+        samples = vcvtq_s32_f32( scaled );
+        /* the saturating narrow clips, the plain narrow wraps like a cast */
+        narrowed = clip ? vqmovn_s32( samples ) : vmovn_s32( samples );
+
+        if( destinationStride == 1 )
+        {
+            vst1_s16( (int16_t*)dest, narrowed );
+        }
+        else
+        {
+            vst1_s16( (int16_t*)block, narrowed );
+            ScatterInt16_( dest, destinationStride, block, 4 );
+        }
+
+        src += 4 * sourceStride;
+        dest += 4 * destinationStride;
+        count -= 4;
+    }
+
+    Float32_To_Int16_Tail_( dest, destinationStride, src, sourceStride, count,
+            ditherGenerator, dither, clip );
+}
+
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_NEON, Float32_To_Int32_NEON_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_Dither_NEON, Float32_To_Int32_NEON_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_Clip_NEON, Float32_To_Int32_NEON_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int32_DitherClip_NEON, Float32_To_Int32_NEON_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_NEON, Float32_To_Int24_NEON_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_Dither_NEON, Float32_To_Int24_NEON_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_Clip_NEON, Float32_To_Int24_NEON_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int24_DitherClip_NEON, Float32_To_Int24_NEON_, 1, 1 )
+
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_NEON, Float32_To_Int16_NEON_, 0, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_Dither_NEON, Float32_To_Int16_NEON_, 1, 0 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_Clip_NEON, Float32_To_Int16_NEON_, 0, 1 )
+PA_DEFINE_SIMD_CONVERTER_( PA_SIMD_TARGET_DEFAULT_, Float32_To_Int16_DitherClip_NEON, Float32_To_Int16_NEON_, 1, 1 )
+
+
+
+PA_SIMD_INLINE_ void StoreFloat32x4_NEON_( float *dest, signed int destinationStride, float32x4_t samples )
+{
+    if( destinationStride == 1 )
+    {
+        vst1q_f32( dest, samples );
+    }
+    else
+    {
+        float block[4];
+        vst1q_f32( block, samples );
+        ScatterFloat32_( dest, destinationStride, block, 4 );
+    }
+}
+
+
+static void Int32_To_Float32_NEON(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const float scaler = 1.0f / 2147483648.0f;
+    PaInt32 block[4];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 4; count -= 4, src += 4, dest += 4 )
+            vst1q_f32( dest, vmulq_n_f32( vcvtq_f32_s32( vld1q_s32( (const int32_t*)src ) ), scaler ) );
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride, dest += 4 * destinationStride )
+        {
+            block[0] = src[0];
+            block[1] = src[sourceStride];
+            block[2] = src[2*sourceStride];
+            block[3] = src[3*sourceStride];
+            StoreFloat32x4_NEON_( dest, destinationStride,
+                    vmulq_n_f32( vcvtq_f32_s32( vld1q_s32( (const int32_t*)block ) ), scaler ) );
+        }
+    }
+
+    Int32_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+static void Int24_To_Float32_NEON(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const float scaler = 1.0f / 2147483648.0f;
+    PaInt32 block[4];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        /* 8 samples occupy 24 bytes. They are read as bytes 0-15 and 8-23 so
+            that nothing beyond the last sample is touched. Out of range table
+            indices produce zero bytes. */
+        static const unsigned char unpackLoIndices[16] =
+            { 255, 0, 1, 2, 255, 3, 4, 5, 255, 6, 7, 8, 255, 9, 10, 11 };
+        static const unsigned char unpackHiIndices[16] =
+            { 255, 4, 5, 6, 255, 7, 8, 9, 255, 10, 11, 12, 255, 13, 14, 15 };
+        const uint8x16_t unpackLo = vld1q_u8( unpackLoIndices );
+        const uint8x16_t unpackHi = vld1q_u8( unpackHiIndices );
+
+        for( ; count >= 8; count -= 8, src += 24, dest += 8 )
+        {
+            int32x4_t lo = vreinterpretq_s32_u8( vqtbl1q_u8( vld1q_u8( src ), unpackLo ) );
+            int32x4_t hi = vreinterpretq_s32_u8( vqtbl1q_u8( vld1q_u8( src + 8 ), unpackHi ) );
+            vst1q_f32( dest, vmulq_n_f32( vcvtq_f32_s32( lo ), scaler ) );
+            vst1q_f32( dest + 4, vmulq_n_f32( vcvtq_f32_s32( hi ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride * 3, dest += 4 * destinationStride )
+        {
+            GatherInt24_( block, src, sourceStride, 4 );
+            StoreFloat32x4_NEON_( dest, destinationStride,
+                    vmulq_n_f32( vcvtq_f32_s32( vld1q_s32( (const int32_t*)block ) ), scaler ) );
+        }
+    }
+
+    Int24_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+
+static void Int16_To_Float32_NEON(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const float scaler = 1.0f / 32768.f;
+    PaInt32 block[4];
+    (void)ditherGenerator; /* unused parameter */
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; count >= 8; count -= 8, src += 8, dest += 8 )
+        {
+            int16x8_t samples = vld1q_s16( (const int16_t*)src );
+            vst1q_f32( dest, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( samples ) ) ), scaler ) );
+            vst1q_f32( dest + 4, vmulq_n_f32( vcvtq_f32_s32( vmovl_high_s16( samples ) ), scaler ) );
+        }
+    }
+    else
+    {
+        for( ; count >= 4; count -= 4, src += 4 * sourceStride, dest += 4 * destinationStride )
+        {
+            block[0] = src[0];
+            block[1] = src[sourceStride];
+            block[2] = src[2*sourceStride];
+            block[3] = src[3*sourceStride];
+            StoreFloat32x4_NEON_( dest, destinationStride,
+                    vmulq_n_f32( vcvtq_f32_s32( vld1q_s32( (const int32_t*)block ) ), scaler ) );
+        }
+    }
+
+    Int16_To_Float32_Tail_( dest, destinationStride, src, sourceStride, count );
+}
+
+#endif /* PA_SIMD_NEON_ */
+
+
+/* -------------------------------------------------------------------------- */
+
+#define PA_INSTALL_SIMD_CONVERTERS_( table, isa )                              \
+    {                                                                           \
+        table->Float32_To_Int32 = Float32_To_Int32_ ## isa;                     \
+        table->Float32_To_Int32_Dither = Float32_To_Int32_Dither_ ## isa;       \
+        table->Float32_To_Int32_Clip = Float32_To_Int32_Clip_ ## isa;           \
+        table->Float32_To_Int32_DitherClip = Float32_To_Int32_DitherClip_ ## isa; \
+        table->Float32_To_Int24 = Float32_To_Int24_ ## isa;                     \
+        table->Float32_To_Int24_Dither = Float32_To_Int24_Dither_ ## isa;       \
+        table->Float32_To_Int24_Clip = Float32_To_Int24_Clip_ ## isa;           \
+        table->Float32_To_Int24_DitherClip = Float32_To_Int24_DitherClip_ ## isa; \
+        table->Float32_To_Int16 = Float32_To_Int16_ ## isa;                     \
+        table->Float32_To_Int16_Dither = Float32_To_Int16_Dither_ ## isa;       \
+        table->Float32_To_Int16_Clip = Float32_To_Int16_Clip_ ## isa;           \
+        table->Float32_To_Int16_DitherClip = Float32_To_Int16_DitherClip_ ## isa; \
+        table->Int32_To_Float32 = Int32_To_Float32_ ## isa;                     \
+        table->Int24_To_Float32 = Int24_To_Float32_ ## isa;                     \
+        table->Int16_To_Float32 = Int16_To_Float32_ ## isa;                     \
+    }
+
+
+int PaUtil_IsConverterTierSupported( PaConverterTier tier )
+{
+    switch( tier )
+    {
+    case paConverterTierScalar:
+        return 1;
+#if defined(PA_SIMD_SSE2_)
+    case paConverterTierSSE2:
+        return 1;
+#endif
+#if defined(PA_SIMD_AVX2_)
+    case paConverterTierAVX2:
+        return CpuSupportsAvx( 0 );
+#endif
+#if defined(PA_SIMD_AVX512_)
+    case paConverterTierAVX512:
+        return CpuSupportsAvx( 1 );
+#endif
+#if defined(PA_SIMD_NEON_)
+    case paConverterTierNEON:
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+
+void PaUtil_InitializeSimdConverters( PaUtilConverterTable *table, PaConverterTier tier )
+{
+    switch( tier )
+    {
+#if defined(PA_SIMD_SSE2_)
+    case paConverterTierSSE2:
+        PA_INSTALL_SIMD_CONVERTERS_( table, SSE2 );
+        break;
+#endif
+#if defined(PA_SIMD_AVX2_)
+    case paConverterTierAVX2:
+        PA_INSTALL_SIMD_CONVERTERS_( table, AVX2 );
+        break;
+#endif
+#if defined(PA_SIMD_AVX512_)
+    case paConverterTierAVX512:
+        PA_INSTALL_SIMD_CONVERTERS_( table, AVX512 );
+        break;
+#endif
+#if defined(PA_SIMD_NEON_)
+    case paConverterTierNEON:
+        PA_INSTALL_SIMD_CONVERTERS_( table, NEON );
+        break;
+#endif
+    default:
+        (void)table; /* the scalar converters are left in place */
+        break;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PA_CONVERTERS_SIMD_H
+#define PA_CONVERTERS_SIMD_H
+/*
+ * $Id$
+ * Portable Audio I/O Library SIMD sample conversion mechanism
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SSE2, AVX2, AVX-512 and NEON implementations of the Float32 to
+ Int32, Int24 and Int16 sample converters, and of the Int32, Int24 and Int16
+ to Float32 sample converters.
+
+ The non-dithering converters produce output which is bit-identical to the
+ scalar converters in pa_converters.c. The dithering converters consume
+ values from the triangular dither generator in the same order as the
+ scalar converters do.
+*/
+
+
+#include "pa_converters.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Determine whether the converters of an instruction set tier were compiled
+ in and can be used on the host processor. paConverterTierScalar is always
+ supported, paConverterTierDefault never is.
+
+ @return Non-zero if the tier is supported.
+*/
+int PaUtil_IsConverterTierSupported( PaConverterTier tier );
+
+
+/** Overwrite the Float32_To_Int32, Float32_To_Int24 and Float32_To_Int16
+ entries (including their _Dither, _Clip and _DitherClip variants) and the
+ Int32_To_Float32, Int24_To_Float32 and Int16_To_Float32 entries of the
+ supplied converter table with the implementations for the given instruction
+ set tier. Entries are left untouched for paConverterTierScalar, and for
+ tiers which were not compiled in. The caller is responsible for checking
+ that the tier is supported with PaUtil_IsConverterTierSupported().
+
+ @param table The converter table to update.
+
+ @param tier The instruction set tier to install.
+
+ @see PaUtil_SelectConverter
+*/
+void PaUtil_InitializeSimdConverters( PaUtilConverterTable *table, PaConverterTier tier );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_CONVERTERS_SIMD_H */
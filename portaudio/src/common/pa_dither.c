@@ -59,6 +59,19 @@ void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *st
     state->previous = 0;
     state->randSeed1 = 22222;
     state->randSeed2 = 5555555;
+    state->noiseShapingError1 = 0.0f;
+    state->noiseShapingError2 = 0.0f;
+}
+
+
+void PaUtil_InitializeChannelTriangularDitherState( PaUtilTriangularDitherGenerator *state,
+        unsigned int channelIndex )
+{
+    PaUtil_InitializeTriangularDitherState( state );
+
+    /* start each channel at a widely separated point of the sequence */
+    state->randSeed1 += channelIndex * 0x9E3779B9U;
+    state->randSeed2 += channelIndex * 0x7F4A7C15U;
 }
 
 
@@ -112,6 +125,121 @@ float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *sta
 }
 
 
+/*
+    The block generators below run PA_DITHER_LANES_ independent copies of the
+    linear congruential generators, lane j producing every PA_DITHER_LANES_th
+    value starting at value j. Each lane is started by jumping the shared
+    seeds ahead j+1 steps and then steps PA_DITHER_LANES_ values at a time, so
+    the lanes have no serial dependency on each other and the inner loops can
+    be vectorized, while the generated sequence is identical to the one
+    produced by calling the single value generators repeatedly.
+
+    ditherLaneMultipliers_[k] and ditherLaneIncrements_[k] jump a seed ahead
+    by k+1 steps: seed(n+k+1) = seed(n) * multiplier[k] + increment[k]
+*/
+
+#define PA_DITHER_LANES_  (8)
+
+static const PaUint32 ditherLaneMultipliers_[PA_DITHER_LANES_] = {
+    196314165U, 3026498297U, 473723277U, 2007447089U,
+    4241652773U, 1148569513U, 3313531389U, 1298576737U
+};
+
+static const PaUint32 ditherLaneIncrements_[PA_DITHER_LANES_] = {
+    907633515U, 2641306770U, 4111285669U, 4143921812U,
+    1151390735U, 1144653446U, 2469123369U, 381724904U
+};
+
+
+/* Generates count high pass filtered triangular dither values. count must be
+ at most PA_DITHER_BLOCK_SIZE. */
+static void GenerateTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        PaInt32 *highPass, unsigned long count )
+{
+    PaUint32 seed1[PA_DITHER_LANES_], seed2[PA_DITHER_LANES_];
+    PaInt32 current[PA_DITHER_BLOCK_SIZE];
+    const PaUint32 laneMultiplier = ditherLaneMultipliers_[PA_DITHER_LANES_-1];
+    const PaUint32 laneIncrement = ditherLaneIncrements_[PA_DITHER_LANES_-1];
+    unsigned long i, j;
+
+    if( count == 0 )
+        return;
+
+    for( j=0; j<PA_DITHER_LANES_; ++j )
+    {
+        seed1[j] = (state->randSeed1 * ditherLaneMultipliers_[j]) + ditherLaneIncrements_[j];
+        seed2[j] = (state->randSeed2 * ditherLaneMultipliers_[j]) + ditherLaneIncrements_[j];
+    }
+
+    /* Generate triangular distribution about 0, PA_DITHER_LANES_ values at a time.
+     * The final partial group computes a few extra values which are discarded.
+     */
+    for( i=0; i<count; i+=PA_DITHER_LANES_ )
+    {
+        for( j=0; j<PA_DITHER_LANES_; ++j )
+        {
+            current[i+j] = (((PaInt32)seed1[j])>>DITHER_SHIFT_) +
+                           (((PaInt32)seed2[j])>>DITHER_SHIFT_);
+        }
+
+        if( i + PA_DITHER_LANES_ >= count )
+        {
+            /* keep the seeds of the last value actually used */
+            state->randSeed1 = seed1[ (count - 1) - i ];
+            state->randSeed2 = seed2[ (count - 1) - i ];
+        }
+
+        for( j=0; j<PA_DITHER_LANES_; ++j )
+        {
+            seed1[j] = (seed1[j] * laneMultiplier) + laneIncrement;
+            seed2[j] = (seed2[j] * laneMultiplier) + laneIncrement;
+        }
+    }
+
+    /* High pass filter to reduce audibility. */
+    highPass[0] = current[0] - (PaInt32)state->previous;
+    for( i=1; i<count; ++i )
+        highPass[i] = current[i] - current[i-1];
+    state->previous = current[count-1];
+}
+
+
+void PaUtil_Generate16BitTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        PaInt32 *dither, unsigned long count )
+{
+    while( count > 0 )
+    {
+        unsigned long blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        GenerateTriangularDitherBlock( state, dither, blockCount );
+
+        dither += blockCount;
+        count -= blockCount;
+    }
+}
+
+
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        float *dither, unsigned long count )
+{
+    PaInt32 highPass[PA_DITHER_BLOCK_SIZE];
+    unsigned long i;
+
+    while( count > 0 )
+    {
+        unsigned long blockCount = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        GenerateTriangularDitherBlock( state, highPass, blockCount );
+
+        for( i=0; i<blockCount; ++i )
+            dither[i] = ((float)highPass[i]) * const_float_dither_scale_;
+
+        dither += blockCount;
+        count -= blockCount;
+    }
+}
+
+
 /*
 The following alternate dither algorithms (from musicdsp.org) could be
 considered
@@ -57,11 +57,22 @@ extern "C"
  * unsigned long so it will work on 64 bit systems.
  */
 
+/** The number of dither values which the block generators compute per pass.
+ Callers converting long buffers are encouraged to request dither in blocks
+ of this size. Must be a multiple of 8.
+*/
+#define PA_DITHER_BLOCK_SIZE    (64)
+
+
 /** @brief State needed to generate a dither signal */
 typedef struct PaUtilTriangularDitherGenerator{
     PaUint32 previous;
     PaUint32 randSeed1;
     PaUint32 randSeed2;
+    /* requantization error of the previous two samples, used by the noise
+        shaping converters */
+    float noiseShapingError1;
+    float noiseShapingError2;
 } PaUtilTriangularDitherGenerator;
 
 
@@ -69,6 +80,15 @@ typedef struct PaUtilTriangularDitherGenerator{
 void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/**
+ @brief Initialize the dither state for one of several channels which are
+ dithered independently, as is required by the noise shaping converters.
+ Each channel index yields a different, but reproducible, dither sequence.
+*/
+void PaUtil_InitializeChannelTriangularDitherState( PaUtilTriangularDitherGenerator *ditherState,
+        unsigned int channelIndex );
+
+
 /**
  @brief Calculate 2 LSB dither signal with a triangular distribution.
  Ranged for adding to a 1 bit right-shifted 32 bit integer
@@ -99,6 +119,37 @@ PaInt32 PaUtil_Generate16BitTriangularDither( PaUtilTriangularDitherGenerator *d
 float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/**
+ @brief Fill a buffer with successive values of the 16-bit dither signal.
+
+ The values are computed several at a time using independent generator
+ lanes, but are identical to those returned by count successive calls to
+ PaUtil_Generate16BitTriangularDither(), and calls to the block and single
+ value generators may be freely mixed on the same state. In particular a
+ generator initialized with PaUtil_InitializeTriangularDitherState() always
+ produces the same reproducible sequence.
+
+ @param dither The buffer to fill with count values ranged as returned by
+ PaUtil_Generate16BitTriangularDither().
+*/
+void PaUtil_Generate16BitTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        PaInt32 *dither, unsigned long count );
+
+
+/**
+ @brief Fill a buffer with successive values of the float dither signal.
+
+ As for PaUtil_Generate16BitTriangularDitherBlock(), the values are identical
+ to those returned by count successive calls to
+ PaUtil_GenerateFloatTriangularDither().
+
+ @param dither The buffer to fill with count values ranged as returned by
+ PaUtil_GenerateFloatTriangularDither().
+*/
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        float *dither, unsigned long count );
+
+
 
 #ifdef __cplusplus
 }
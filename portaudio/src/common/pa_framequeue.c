@@ -0,0 +1,333 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * Multiple-writer frame queue utility.
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/**
+ @file
+ @ingroup common_src
+*/
+
+#include <string.h>
+#include "pa_framequeue.h"
+
+/*
+    Writers claim elements by advancing reserveIndex with a compare-exchange,
+    so each reservation is owned by exactly one writer. A writer commits its
+    reservation by storing its length, with release semantics, in the commit
+    record of its first element. The reader acquires the commit records from
+    committedIndex onwards, clearing each one and stepping over the
+    reservation it describes, until it reaches a reservation which hasn't
+    been committed. The reader's release of readIndex ensures that it has
+    finished reading elements, and cleared their commit records, before a
+    writer can reserve them again.
+
+    GCC and Clang provide the atomic operations as the __atomic builtins.
+    Other compilers use the interlocked or __sync compare-exchange, which
+    are full barriers, and full memory barriers for loads and stores.
+*/
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+
+static ring_buffer_size_t LoadAcquire( const volatile ring_buffer_size_t *index )
+{
+    return __atomic_load_n( index, __ATOMIC_ACQUIRE );
+}
+
+static void StoreRelease( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+    __atomic_store_n( index, value, __ATOMIC_RELEASE );
+}
+
+/* Set *index to desired if it is *expected, otherwise update *expected.
+   Returns non-zero on success. */
+static int CompareExchange( volatile ring_buffer_size_t *index, ring_buffer_size_t *expected, ring_buffer_size_t desired )
+{
+    return __atomic_compare_exchange_n( index, expected, desired, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+}
+
+#else /* no __atomic builtins */
+
+#include "pa_memorybarrier.h"
+
+static ring_buffer_size_t LoadAcquire( const volatile ring_buffer_size_t *index )
+{
+    ring_buffer_size_t result = *index;
+    PaUtil_FullMemoryBarrier();
+    return result;
+}
+
+static void StoreRelease( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+    PaUtil_FullMemoryBarrier();
+    *index = value;
+}
+
+static int CompareExchange( volatile ring_buffer_size_t *index, ring_buffer_size_t *expected, ring_buffer_size_t desired )
+{
+    ring_buffer_size_t previous;
+#if defined(_MSC_VER)
+    previous = _InterlockedCompareExchange( (volatile long *)index, desired, *expected );
+#elif defined(__GNUC__)
+    previous = __sync_val_compare_and_swap( index, *expected, desired );
+#else
+#error A compare-exchange operation is not defined for this compiler.
+#endif
+    if( previous == *expected ) return 1;
+    *expected = previous;
+    return 0;
+}
+
+#endif /* __ATOMIC_ACQUIRE */
+
+/*
+    Indices run from 0 to indexLimit-1, where indexLimit is the largest
+    multiple of bufferSize below 2^30. An element's position is its index
+    modulo bufferSize. Because the range is so large, a writer which is
+    preempted between loading reserveIndex and exchanging it can't be fooled
+    by the index wrapping back to the same value.
+*/
+#define PA_FRAMEQUEUE_MAX_INDEX_ (0x3FFFFFFFL)
+
+/* Return the number of elements from fromIndex up to toIndex. */
+static ring_buffer_size_t IndexDistance( const PaUtilFrameQueue *queue, ring_buffer_size_t toIndex, ring_buffer_size_t fromIndex )
+{
+    ring_buffer_size_t distance = toIndex - fromIndex;
+    if( distance < 0 ) distance += queue->indexLimit;
+    return distance;
+}
+
+/* Return index advanced by elementCount elements. */
+static ring_buffer_size_t AdvanceIndex( const PaUtilFrameQueue *queue, ring_buffer_size_t index, ring_buffer_size_t elementCount )
+{
+    index += elementCount;
+    if( index >= queue->indexLimit ) index -= queue->indexLimit;
+    return index;
+}
+
+/* Store the region(s) of elementCount elements starting at index. */
+static void GetRegions( const PaUtilFrameQueue *queue, ring_buffer_size_t index, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    ring_buffer_size_t position = index % queue->bufferSize;
+    if( position + elementCount > queue->bufferSize )
+    {
+        ring_buffer_size_t firstHalf = queue->bufferSize - position;
+        *dataPtr1 = &queue->buffer[position*queue->elementSizeBytes];
+        *sizePtr1 = firstHalf;
+        *dataPtr2 = &queue->buffer[0];
+        *sizePtr2 = elementCount - firstHalf;
+    }
+    else
+    {
+        *dataPtr1 = &queue->buffer[position*queue->elementSizeBytes];
+        *sizePtr1 = elementCount;
+        *dataPtr2 = NULL;
+        *sizePtr2 = 0;
+    }
+}
+
+/* Advance committedIndex over committed reservations until at least
+   elementCount elements are readable. Returns the number readable. */
+static ring_buffer_size_t ScanCommits( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t readIndex = queue->readIndex; /* only changed by this thread */
+    ring_buffer_size_t available = IndexDistance( queue, queue->committedIndex, readIndex );
+
+    while( available < elementCount )
+    {
+        ring_buffer_size_t position = queue->committedIndex % queue->bufferSize;
+        ring_buffer_size_t length = LoadAcquire( &queue->commitLengths[position] );
+        if( length == 0 )
+            break; /* the next reservation is still being written */
+        queue->commitLengths[position] = 0;
+        queue->committedIndex = AdvanceIndex( queue, queue->committedIndex, length );
+        available += length;
+    }
+    return available;
+}
+
+/***************************************************************************
+ * Initialize queue.
+ * elementCount must be greater than 0 and small enough for indexLimit to
+ * be at least twice elementCount, returns -1 if not.
+ */
+ring_buffer_size_t PaUtil_InitializeFrameQueue( PaUtilFrameQueue *queue, ring_buffer_size_t elementSizeBytes,
+        ring_buffer_size_t elementCount, void *dataPtr, ring_buffer_size_t *commitPtr )
+{
+    if( elementCount <= 0 || elementCount > PA_FRAMEQUEUE_MAX_INDEX_ / 2 ) return -1;
+    queue->bufferSize = elementCount;
+    queue->elementSizeBytes = elementSizeBytes;
+    queue->indexLimit = ( PA_FRAMEQUEUE_MAX_INDEX_ / elementCount ) * elementCount;
+    queue->buffer = (char *)dataPtr;
+    queue->commitLengths = commitPtr;
+    PaUtil_FlushFrameQueue( queue );
+    return 0;
+}
+
+/***************************************************************************
+** Clear queue. Should only be called when queue is NOT being read or written. */
+void PaUtil_FlushFrameQueue( PaUtilFrameQueue *queue )
+{
+    ring_buffer_size_t i;
+    for( i = 0; i < queue->bufferSize; ++i )
+        queue->commitLengths[i] = 0;
+    queue->reserveIndex = queue->readIndex = 0;
+    queue->committedIndex = 0;
+}
+
+/***************************************************************************
+** Reserve elements and get address of region(s) to which we can write data.
+** If the region is contiguous, size2 will be zero.
+** If non-contiguous, size2 will be the size of second region.
+** Returns elements reserved, the room available or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_ReserveFrameQueueWrite( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount,
+        PaUtilFrameQueueReservation *reservation,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    ring_buffer_size_t index = queue->reserveIndex;
+    ring_buffer_size_t count;
+
+    for(;;)
+    {
+        ring_buffer_size_t used = IndexDistance( queue, index, LoadAcquire( &queue->readIndex ) );
+        if( used > queue->bufferSize )
+        {
+            /* index is stale, the reader has already read past it */
+            index = queue->reserveIndex;
+            continue;
+        }
+        count = queue->bufferSize - used;
+        if( elementCount < count ) count = elementCount;
+        if( count <= 0 )
+        {
+            count = 0;
+            break;
+        }
+        if( CompareExchange( &queue->reserveIndex, &index, AdvanceIndex( queue, index, count ) ) )
+            break;
+        /* another writer reserved first, index now holds the new reserveIndex */
+    }
+
+    reservation->index = index;
+    reservation->elementCount = count;
+    GetRegions( queue, index, count, dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    return count;
+}
+
+/***************************************************************************
+*/
+void PaUtil_CommitFrameQueueWrite( PaUtilFrameQueue *queue, const PaUtilFrameQueueReservation *reservation )
+{
+    /* the release store ensures that the data written to the reservation is
+       seen before its commit record (write after write) */
+    if( reservation->elementCount > 0 )
+        StoreRelease( &queue->commitLengths[reservation->index % queue->bufferSize], reservation->elementCount );
+}
+
+/***************************************************************************
+** Return elements written. */
+ring_buffer_size_t PaUtil_WriteFrameQueue( PaUtilFrameQueue *queue, const void *data, ring_buffer_size_t elementCount )
+{
+    PaUtilFrameQueueReservation reservation;
+    ring_buffer_size_t size1, size2, numWritten;
+    void *data1, *data2;
+    numWritten = PaUtil_ReserveFrameQueueWrite( queue, elementCount, &reservation, &data1, &size1, &data2, &size2 );
+    memcpy( data1, data, size1*queue->elementSizeBytes );
+    if( size2 > 0 )
+    {
+        data = ((const char *)data) + size1*queue->elementSizeBytes;
+        memcpy( data2, data, size2*queue->elementSizeBytes );
+    }
+    PaUtil_CommitFrameQueueWrite( queue, &reservation );
+    return numWritten;
+}
+
+/***************************************************************************
+** Return number of committed elements available for reading. */
+ring_buffer_size_t PaUtil_GetFrameQueueReadAvailable( PaUtilFrameQueue *queue )
+{
+    return ScanCommits( queue, queue->bufferSize );
+}
+
+/***************************************************************************
+** Get address of region(s) from which we can read data.
+** If the region is contiguous, size2 will be zero.
+** If non-contiguous, size2 will be the size of second region.
+** Returns committed elements available to be read or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetFrameQueueReadRegions( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    ring_buffer_size_t available = ScanCommits( queue, elementCount );
+    if( elementCount > available ) elementCount = available;
+    GetRegions( queue, queue->readIndex, elementCount, dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    return elementCount;
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_AdvanceFrameQueueReadIndex( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount )
+{
+    /* the release store ensures that previous reads (copies out of the
+       queue) are completed before the writers can see the new read index
+       (write-after-read) */
+    ring_buffer_size_t readIndex = AdvanceIndex( queue, queue->readIndex, elementCount );
+    StoreRelease( &queue->readIndex, readIndex );
+    return readIndex;
+}
+
+/***************************************************************************
+** Return elements read. */
+ring_buffer_size_t PaUtil_ReadFrameQueue( PaUtilFrameQueue *queue, void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t size1, size2, numRead;
+    void *data1, *data2;
+    numRead = PaUtil_GetFrameQueueReadRegions( queue, elementCount, &data1, &size1, &data2, &size2 );
+    memcpy( data, data1, size1*queue->elementSizeBytes );
+    if( size2 > 0 )
+    {
+        data = ((char *)data) + size1*queue->elementSizeBytes;
+        memcpy( data, data2, size2*queue->elementSizeBytes );
+    }
+    PaUtil_AdvanceFrameQueueReadIndex( queue, numRead );
+    return numRead;
+}
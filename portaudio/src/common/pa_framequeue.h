@@ -0,0 +1,252 @@
+#ifndef PA_FRAMEQUEUE_H
+#define PA_FRAMEQUEUE_H
+/*
+ * $Id$
+ * Portable Audio I/O Library
+ * Multiple-writer frame queue utility.
+ *
+ * This program is distributed with the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+ @brief Multiple-writer single-reader lock-free frame queue
+
+ PaUtilFrameQueue is a ring buffer which any number of threads may write to
+ concurrently, while a single thread (usually the stream callback) reads
+ from it. It is intended for feeding frames from many sources, such as
+ decoder threads, into one stream without serializing the writers behind a
+ lock.
+
+ A writer reserves elements with PaUtil_ReserveFrameQueueWrite(), which
+ returns the region(s) of the buffer it owns, writes directly into them, and
+ then calls PaUtil_CommitFrameQueueWrite(). Reservations are made in order,
+ but may be committed in any order. The reader uses the same region-based
+ interface as PaUtilRingBuffer, and only sees elements up to the first
+ reservation which hasn't been committed yet, so every reservation must be
+ committed promptly, even if nothing was written to it.
+
+ The queue contains N elements, where N may be any positive number. An
+ element may be any size (specified in bytes). Elements from one writer are
+ read in the order that writer reserved them; elements from different
+ writers are interleaved in reservation order.
+
+ The memory areas used to store the elements and the commit records must be
+ allocated by the client prior to calling PaUtil_InitializeFrameQueue() and
+ must outlive the use of the queue.
+
+ @note The frame queue functions are not normally exposed in the PortAudio libraries.
+ If you want to call them then you will need to add pa_framequeue.c and
+ pa_ringbuffer.h to your application source code.
+*/
+
+#include "pa_ringbuffer.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* The writers' shared reserve index and the reader's indices are separated
+ from each other and from the read-only fields by a cache line of padding,
+ so that writers contending for reservations don't invalidate the line the
+ reader is working on.
+*/
+typedef struct PaUtilFrameQueue
+{
+    ring_buffer_size_t  bufferSize; /**< Number of elements in the queue. Set by PaUtil_InitializeFrameQueue. */
+    ring_buffer_size_t  elementSizeBytes; /**< Number of bytes per element. */
+    ring_buffer_size_t  indexLimit; /**< Indices run from 0 to indexLimit-1, a large multiple of bufferSize. */
+    char  *buffer;    /**< Pointer to the buffer containing the actual data. */
+    volatile ring_buffer_size_t  *commitLengths; /**< Length of the committed reservation starting at each element, or 0. */
+
+    char  writerPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  reserveIndex; /**< Index of next element to be reserved. Advanced by PaUtil_ReserveFrameQueueWrite. */
+
+    char  readerPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  readIndex; /**< Index of next readable element. Set by PaUtil_AdvanceFrameQueueReadIndex. */
+    ring_buffer_size_t  committedIndex; /**< The reader's index of the first element not yet known to be committed. */
+
+    char  endPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+}PaUtilFrameQueue;
+
+/** Elements reserved by a writer, returned by PaUtil_ReserveFrameQueueWrite()
+ and passed back to PaUtil_CommitFrameQueueWrite().
+*/
+typedef struct PaUtilFrameQueueReservation
+{
+    ring_buffer_size_t  index;        /**< Index of the first reserved element. */
+    ring_buffer_size_t  elementCount; /**< Number of reserved elements, possibly 0. */
+}PaUtilFrameQueueReservation;
+
+/** Initialize a frame queue to empty state ready to have elements written to it.
+
+ @param queue The frame queue.
+
+ @param elementSizeBytes The size of a single data element in bytes.
+
+ @param elementCount The number of elements in the queue (must be greater
+ than 0, and less than 2^29).
+
+ @param dataPtr A pointer to a previously allocated area where the data
+ will be maintained.  It must be elementCount*elementSizeBytes long.
+
+ @param commitPtr A pointer to a previously allocated array of elementCount
+ ring_buffer_size_t values, where the commit records will be maintained.
+
+ @return -1 if elementCount is out of range, otherwise 0.
+*/
+ring_buffer_size_t PaUtil_InitializeFrameQueue( PaUtilFrameQueue *queue, ring_buffer_size_t elementSizeBytes,
+        ring_buffer_size_t elementCount, void *dataPtr, ring_buffer_size_t *commitPtr );
+
+/** Reset the queue to empty. Should only be called when the queue is NOT being read or written.
+
+ @param queue The frame queue.
+*/
+void PaUtil_FlushFrameQueue( PaUtilFrameQueue *queue );
+
+/** Reserve elements for writing and get address of region(s) to which the
+ data should be written. May be called by any number of threads at once.
+
+ @param queue The frame queue.
+
+ @param elementCount The number of elements desired.
+
+ @param reservation The address where the reservation will be stored. It must
+ be passed to PaUtil_CommitFrameQueueWrite() once the data has been written,
+ even if no elements were reserved.
+
+ @param dataPtr1 The address where the first (or only) region pointer will be
+ stored.
+
+ @param sizePtr1 The address where the first (or only) region length will be
+ stored.
+
+ @param dataPtr2 The address where the second region pointer will be stored if
+ the first region is too small to satisfy elementCount.
+
+ @param sizePtr2 The address where the second region length will be stored if
+ the first region is too small to satisfy elementCount.
+
+ @return The number of elements reserved, which is the room available to be
+ written or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_ReserveFrameQueueWrite( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount,
+        PaUtilFrameQueueReservation *reservation,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+
+/** Make the elements of a reservation available to the reader.
+
+ @param queue The frame queue.
+
+ @param reservation The reservation returned by PaUtil_ReserveFrameQueueWrite().
+*/
+void PaUtil_CommitFrameQueueWrite( PaUtilFrameQueue *queue, const PaUtilFrameQueueReservation *reservation );
+
+/** Write data to the frame queue. May be called by any number of threads at once.
+
+ @param queue The frame queue.
+
+ @param data The address of new data to write to the queue.
+
+ @param elementCount The number of elements to be written.
+
+ @return The number of elements written.
+*/
+ring_buffer_size_t PaUtil_WriteFrameQueue( PaUtilFrameQueue *queue, const void *data, ring_buffer_size_t elementCount );
+
+/** Retrieve the number of committed elements available for reading. May only
+ be called by the reader.
+
+ @param queue The frame queue.
+
+ @return The number of elements available for reading.
+*/
+ring_buffer_size_t PaUtil_GetFrameQueueReadAvailable( PaUtilFrameQueue *queue );
+
+/** Get address of region(s) from which we can read data. May only be called
+ by the reader.
+
+ @param queue The frame queue.
+
+ @param elementCount The number of elements desired.
+
+ @param dataPtr1 The address where the first (or only) region pointer will be
+ stored.
+
+ @param sizePtr1 The address where the first (or only) region length will be
+ stored.
+
+ @param dataPtr2 The address where the second region pointer will be stored if
+ the first region is too small to satisfy elementCount.
+
+ @param sizePtr2 The address where the second region length will be stored if
+ the first region is too small to satisfy elementCount.
+
+ @return The number of elements available for reading or elementCount,
+ whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetFrameQueueReadRegions( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+
+/** Advance the read index past elements which have been read, making room
+ for writers. May only be called by the reader.
+
+ @param queue The frame queue.
+
+ @param elementCount The number of elements to advance.
+
+ @return The new position.
+*/
+ring_buffer_size_t PaUtil_AdvanceFrameQueueReadIndex( PaUtilFrameQueue *queue, ring_buffer_size_t elementCount );
+
+/** Read data from the frame queue. May only be called by the reader.
+
+ @param queue The frame queue.
+
+ @param data The address where the data should be stored.
+
+ @param elementCount The number of elements to be read.
+
+ @return The number of elements read.
+*/
+ring_buffer_size_t PaUtil_ReadFrameQueue( PaUtilFrameQueue *queue, void *data, ring_buffer_size_t elementCount );
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_FRAMEQUEUE_H */
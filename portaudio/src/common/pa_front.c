@@ -74,6 +74,9 @@
 #include "pa_types.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+#include "pa_offline.h"
 #include "pa_trace.h" /* still useful?*/
 #include "pa_debugprint.h"
 
@@ -381,6 +384,7 @@ PaError Pa_Initialize( void )
 
         PaUtil_InitializeClock();
         PaUtil_ResetTraceMessages();
+        PaUtil_InitializeConverterTier();
 
         result = InitializeHostApis();
         if( result == paNoError )
@@ -470,6 +474,11 @@ const char *Pa_GetErrorText( PaError errorCode )
     case paIncompatibleStreamHostApi: result = "Incompatible stream host API"; break;
     case paBadBufferPtr:             result = "Bad buffer pointer"; break;
     case paCanNotInitializeRecursively: result = "PortAudio can not be initialized recursively"; break;
+    case paConverterTierNotSupported: result = "Converter tier not supported by this processor"; break;
+    case paStreamEventQueueFull:     result = "Stream event queue full"; break;
+    case paBufferNotAcquired:        result = "Buffer not acquired"; break;
+    case paBufferAlreadyAcquired:    result = "Buffer already acquired"; break;
+    case paConverterTierInUse:       result = "Converter tier can't be changed while a stream is open"; break;
     default:
         if( errorCode > 0 )
             result = "Invalid error code (value greater than zero)";
@@ -808,6 +817,7 @@ static int SampleFormatIsValid( PaSampleFormat format )
     switch( format & ~paNonInterleaved )
     {
     case paFloat32: return 1;
+    case paFloat64: return 1;
     case paInt16: return 1;
     case paInt32: return 1;
     case paInt24: return 1;
@@ -1023,7 +1033,26 @@ static PaError ValidateOpenStreamParameters(
     if( (sampleRate < 1000.0) || (sampleRate > 768000.0) )
         return paInvalidSampleRate;
 
-    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback ) ) != 0 )
+    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback | paNoiseShapedDither
+            | paConvertSampleRate | paSampleRateConversionLowLatency | paSampleRateConversionHighQuality
+            | paBatchUserBuffers ) ) != 0 )
+        return paInvalidFlag;
+
+    if( streamFlags & paBatchUserBuffers )
+    {
+        /* batches are made of fixed size user buffers passed to a callback */
+        if( !streamCallback || framesPerBuffer == paFramesPerBufferUnspecified )
+            return paInvalidFlag;
+    }
+
+    if( streamFlags & paConvertSampleRate )
+    {
+        /* conversion is performed in the stream callback */
+        if( !streamCallback )
+            return paInvalidFlag;
+    }
+
+    if( (streamFlags & paSampleRateConversionLowLatency) && (streamFlags & paSampleRateConversionHighQuality) )
         return paInvalidFlag;
 
     if( streamFlags & paNeverDropInput )
@@ -1149,6 +1178,67 @@ PaError Pa_IsFormatSupported( const PaStreamParameters *inputParameters,
 }
 
 
+/* Open a stream at the default sample rate of the device and convert it to
+ sampleRate in the buffer processor. Called when the host API rejected
+ sampleRate and paConvertSampleRate was specified. */
+static PaError OpenResamplingStream( PaUtilHostApiRepresentation *hostApi, PaStream** stream,
+        const PaStreamParameters *inputParameters, const PaStreamParameters *outputParameters,
+        double sampleRate, unsigned long framesPerBuffer, PaStreamFlags streamFlags,
+        PaStreamCallback *streamCallback, void *userData )
+{
+    PaError result;
+    double hostSampleRate;
+    unsigned long framesPerHostBuffer = paFramesPerBufferUnspecified;
+    PaUtilResamplerQuality quality = paUtilResamplerQualityMedium;
+    PaUtilStreamRepresentation *streamRep;
+
+    if( outputParameters )
+        hostSampleRate = hostApi->deviceInfos[ outputParameters->device ]->defaultSampleRate;
+    else
+        hostSampleRate = hostApi->deviceInfos[ inputParameters->device ]->defaultSampleRate;
+
+    if( hostSampleRate == sampleRate || hostSampleRate <= 0. )
+        return paInvalidSampleRate;
+
+    if( streamFlags & paSampleRateConversionLowLatency )
+        quality = paUtilResamplerQualityLow;
+    else if( streamFlags & paSampleRateConversionHighQuality )
+        quality = paUtilResamplerQualityHigh;
+
+    if( framesPerBuffer != paFramesPerBufferUnspecified )
+        framesPerHostBuffer = (unsigned long)( framesPerBuffer * hostSampleRate / sampleRate + .5 );
+
+    result = hostApi->OpenStream( hostApi, stream, inputParameters, outputParameters,
+            hostSampleRate, framesPerHostBuffer,
+            streamFlags & ~(paConvertSampleRate | paSampleRateConversionLowLatency | paSampleRateConversionHighQuality),
+            streamCallback, userData );
+    if( result != paNoError )
+        return result;
+
+    streamRep = PA_STREAM_REP( *stream );
+    if( !streamRep->bufferProcessor )
+        result = paInvalidSampleRate; /* the host API doesn't use the buffer processor */
+    else
+        result = PaUtil_EnableBufferProcessorResampling( streamRep->bufferProcessor,
+                sampleRate, framesPerBuffer, quality );
+
+    if( result != paNoError )
+    {
+        PA_STREAM_INTERFACE( *stream )->Close( *stream );
+        *stream = 0;
+        return result;
+    }
+
+    streamRep->streamInfo.sampleRate = sampleRate;
+    streamRep->streamInfo.inputLatency +=
+            PaUtil_GetBufferProcessorResamplingInputLatency( streamRep->bufferProcessor );
+    streamRep->streamInfo.outputLatency +=
+            PaUtil_GetBufferProcessorResamplingOutputLatency( streamRep->bufferProcessor );
+
+    return paNoError;
+}
+
+
 PaError Pa_OpenStream( PaStream** stream,
                        const PaStreamParameters *inputParameters,
                        const PaStreamParameters *outputParameters,
@@ -1163,6 +1253,7 @@ PaError Pa_OpenStream( PaStream** stream,
     PaDeviceIndex hostApiInputDevice = paNoDevice, hostApiOutputDevice = paNoDevice;
     PaStreamParameters hostApiInputParameters, hostApiOutputParameters;
     PaStreamParameters *hostApiInputParametersPtr, *hostApiOutputParametersPtr;
+    PaStreamFlags hostApiStreamFlags;
 
 
 #ifdef PA_LOG_API_CALLS
@@ -1267,9 +1358,20 @@ PaError Pa_OpenStream( PaStream** stream,
         hostApiOutputParametersPtr = NULL;
     }
 
+    /* the sample rate conversion flags are handled here, not by the host API */
+    hostApiStreamFlags = streamFlags & ~(paConvertSampleRate
+            | paSampleRateConversionLowLatency | paSampleRateConversionHighQuality);
+
     result = hostApi->OpenStream( hostApi, stream,
                                   hostApiInputParametersPtr, hostApiOutputParametersPtr,
-                                  sampleRate, framesPerBuffer, streamFlags, streamCallback, userData );
+                                  sampleRate, framesPerBuffer, hostApiStreamFlags, streamCallback, userData );
+
+    if( result == paInvalidSampleRate && (streamFlags & paConvertSampleRate) )
+    {
+        result = OpenResamplingStream( hostApi, stream,
+                                       hostApiInputParametersPtr, hostApiOutputParametersPtr,
+                                       sampleRate, framesPerBuffer, streamFlags, streamCallback, userData );
+    }
 
     if( result == paNoError )
         AddOpenStream( *stream );
@@ -1379,6 +1481,76 @@ PaError PaUtil_ValidateStreamPointer( PaStream* stream )
 }
 
 
+PaError Pa_OpenOfflineStream( PaStream** stream,
+                              const PaStreamParameters *inputParameters,
+                              const PaStreamParameters *outputParameters,
+                              double sampleRate,
+                              unsigned long framesPerBuffer,
+                              PaStreamFlags streamFlags,
+                              const PaOfflineStreamInfo *offlineStreamInfo,
+                              PaStreamCallback *streamCallback,
+                              void *userData )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_OpenOfflineStream" );
+    PA_LOGAPI(("\tPaStream** stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamParameters *inputParameters: 0x%p\n", inputParameters ));
+    PA_LOGAPI(("\tPaStreamParameters *outputParameters: 0x%p\n", outputParameters ));
+    PA_LOGAPI(("\tdouble sampleRate: %g\n", sampleRate ));
+    PA_LOGAPI(("\tunsigned long framesPerBuffer: %d\n", framesPerBuffer ));
+    PA_LOGAPI(("\tPaStreamFlags streamFlags: 0x%x\n", streamFlags ));
+    PA_LOGAPI(("\tconst PaOfflineStreamInfo *offlineStreamInfo: 0x%p\n", offlineStreamInfo ));
+    PA_LOGAPI(("\tPaStreamCallback *streamCallback: 0x%p\n", streamCallback ));
+    PA_LOGAPI(("\tvoid *userData: 0x%p\n", userData ));
+
+    if( !PA_IS_INITIALISED_ )
+    {
+        result = paNotInitialized;
+    }
+    else if( stream == NULL )
+    {
+        result = paBadStreamPtr;
+    }
+    else
+    {
+        result = PaUtil_OpenOfflineStream( stream, inputParameters, outputParameters,
+                sampleRate, framesPerBuffer, streamFlags, offlineStreamInfo,
+                streamCallback, userData );
+
+        /* the stream is closed by Pa_Terminate() like any other */
+        if( result == paNoError )
+            AddOpenStream( *stream );
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_OpenOfflineStream", result );
+
+    return result;
+}
+
+
+PaError Pa_RenderOfflineStream( PaStream* stream,
+                                const void *input,
+                                void *output,
+                                unsigned long frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_RenderOfflineStream" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tconst void *input: 0x%p\n", input ));
+    PA_LOGAPI(("\tvoid *output: 0x%p\n", output ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+
+    if( result == paNoError )
+        result = PaUtil_RenderOfflineStream( stream, input, output, frames );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_RenderOfflineStream", result );
+
+    return result;
+}
+
+
 PaError Pa_CloseStream( PaStream* stream )
 {
     PaUtilStreamInterface *interface;
@@ -1458,6 +1630,9 @@ PaError Pa_StartStream( PaStream *stream )
         }
         else if( result == 1 )
         {
+            PA_STREAM_REP(stream)->framesLentForReading = 0;
+            PA_STREAM_REP(stream)->framesLentForWriting = 0;
+
             result = PA_STREAM_INTERFACE(stream)->Start( stream );
         }
     }
@@ -1481,6 +1656,10 @@ PaError Pa_StopStream( PaStream *stream )
         if( result == 0 )
         {
             result = PA_STREAM_INTERFACE(stream)->Stop( stream );
+
+            /* any frames which are still lent are discarded */
+            PA_STREAM_REP(stream)->framesLentForReading = 0;
+            PA_STREAM_REP(stream)->framesLentForWriting = 0;
         }
         else if( result == 1 )
         {
@@ -1507,6 +1686,10 @@ PaError Pa_AbortStream( PaStream *stream )
         if( result == 0 )
         {
             result = PA_STREAM_INTERFACE(stream)->Abort( stream );
+
+            /* any frames which are still lent are discarded */
+            PA_STREAM_REP(stream)->framesLentForReading = 0;
+            PA_STREAM_REP(stream)->framesLentForWriting = 0;
         }
         else if( result == 1 )
         {
@@ -1648,6 +1831,255 @@ double Pa_GetStreamCpuLoad( PaStream* stream )
 }
 
 
+PaError Pa_SetStreamChannelGain( PaStream* stream, int channel, float gain )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamChannelGain" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tint channel: %d\n", channel ));
+    PA_LOGAPI(("\tfloat gain: %g\n", gain ));
+
+    if( result == paNoError )
+    {
+        if( channel < 0 )
+        {
+            result = paInvalidChannelCount;
+        }
+        else if( !PA_STREAM_REP( stream )->bufferProcessor )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PaUtil_SetBufferProcessorOutputGain(
+                    PA_STREAM_REP( stream )->bufferProcessor, (unsigned int)channel, gain );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamChannelGain", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamRouting( PaStream* stream, const PaStreamRoutingInfo *routingInfo )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamRouting" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tconst PaStreamRoutingInfo *routingInfo: 0x%p\n", routingInfo ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( routingInfo == NULL || routingInfo->size != sizeof(PaStreamRoutingInfo)
+                || routingInfo->version != 1 )
+        {
+            result = paIncompatibleHostApiSpecificStreamInfo;
+        }
+        else if( routingInfo->inputChannelCount < 0 || routingInfo->outputChannelCount < 0 )
+        {
+            result = paInvalidChannelCount;
+        }
+        else if( !bufferProcessor )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                result = PaUtil_EnableBufferProcessorRouting( bufferProcessor,
+                        routingInfo->inputChannelCount, routingInfo->inputRoutes,
+                        routingInfo->inputRouteCount,
+                        routingInfo->outputChannelCount, routingInfo->outputRoutes,
+                        routingInfo->outputRouteCount );
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamRouting", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamBatchCallback( PaStream* stream, PaStreamBatchCallback *batchCallback )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamBatchCallback" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamBatchCallback *batchCallback: 0x%p\n", batchCallback ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( !bufferProcessor )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                result = PaUtil_SetBufferProcessorBatchCallback( bufferProcessor, batchCallback );
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamBatchCallback", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamEventCallback( PaStream* stream, PaStreamEventCallback *eventCallback,
+        unsigned long maxPendingEvents )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaUtilBufferProcessor *bufferProcessor;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamEventCallback" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamEventCallback *eventCallback: 0x%p\n", eventCallback ));
+    PA_LOGAPI(("\tunsigned long maxPendingEvents: %lu\n", maxPendingEvents ));
+
+    if( result == paNoError )
+    {
+        bufferProcessor = PA_STREAM_REP( stream )->bufferProcessor;
+
+        if( !bufferProcessor )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = paStreamIsNotStopped;
+            }
+            else if( result == 1 )
+            {
+                result = PaUtil_SetBufferProcessorEventCallback( bufferProcessor,
+                        eventCallback, maxPendingEvents );
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamEventCallback", result );
+
+    return result;
+}
+
+
+PaError Pa_PostStreamEvent( PaStream* stream, const PaStreamEvent *event )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_PostStreamEvent" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tconst PaStreamEvent *event: 0x%p\n", event ));
+
+    if( result == paNoError )
+    {
+        if( event == NULL )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( !PA_STREAM_REP( stream )->bufferProcessor )
+        {
+            result = paNullCallback;
+        }
+        else
+        {
+            result = PaUtil_PostBufferProcessorEvent(
+                    PA_STREAM_REP( stream )->bufferProcessor, event );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_PostStreamEvent", result );
+
+    return result;
+}
+
+
+PaError Pa_GetStreamProcessingTimes( PaStream* stream, PaStreamProcessingTimes *times )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamProcessingTimes" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamProcessingTimes *times: 0x%p\n", times ));
+
+    if( result == paNoError )
+    {
+        if( times == NULL )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( !PA_STREAM_REP( stream )->bufferProcessor )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else
+        {
+            result = PaUtil_GetBufferProcessorStageTimes(
+                    PA_STREAM_REP( stream )->bufferProcessor, times );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetStreamProcessingTimes", result );
+
+    return result;
+}
+
+
+signed long Pa_GetStreamBufferAlignment( PaStream* stream )
+{
+    PaError error = PaUtil_ValidateStreamPointer( stream );
+    signed long result;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamBufferAlignment" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+
+    if( error == paNoError && !PA_STREAM_REP( stream )->bufferProcessor )
+        error = paIncompatibleStreamHostApi;
+
+    if( error != paNoError )
+    {
+        result = error;
+    }
+    else
+    {
+        result = (signed long)PaUtil_GetBufferProcessorBufferAlignment(
+                PA_STREAM_REP( stream )->bufferProcessor );
+    }
+
+    PA_LOGAPI(("Pa_GetStreamBufferAlignment returned:\n" ));
+    PA_LOGAPI(("\tsigned long: %ld\n", result ));
+
+    return result;
+}
+
+
 PaError Pa_ReadStream( PaStream* stream,
                        void *buffer,
                        unsigned long frames )
@@ -1785,6 +2217,162 @@ signed long Pa_GetStreamWriteAvailable( PaStream* stream )
 }
 
 
+PaError Pa_AcquireReadBuffer( PaStream* stream, const void **buffer, unsigned long *frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_AcquireReadBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+
+    if( result == paNoError )
+    {
+        if( buffer == 0 || frames == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_REP(stream)->streamCallback )
+        {
+            result = paCanNotReadFromACallbackStream;
+        }
+        else if( !PA_STREAM_INTERFACE(stream)->AcquireReadBuffer )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( PA_STREAM_REP(stream)->framesLentForReading > 0 )
+        {
+            result = paBufferAlreadyAcquired;
+        }
+        else if( *frames == 0 )
+        {
+            *buffer = 0;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = PA_STREAM_INTERFACE(stream)->AcquireReadBuffer( stream, buffer, frames );
+                if( result == paNoError || result == paInputOverflowed )
+                    PA_STREAM_REP(stream)->framesLentForReading = *frames;
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_AcquireReadBuffer", result );
+
+    return result;
+}
+
+
+PaError Pa_ReleaseReadBuffer( PaStream* stream, unsigned long frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_ReleaseReadBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+
+    if( result == paNoError )
+    {
+        if( frames > PA_STREAM_REP(stream)->framesLentForReading )
+        {
+            result = paBufferNotAcquired;
+        }
+        else if( PA_STREAM_REP(stream)->framesLentForReading > 0 )
+        {
+            PA_STREAM_REP(stream)->framesLentForReading = 0;
+            result = PA_STREAM_INTERFACE(stream)->ReleaseReadBuffer( stream, frames );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_ReleaseReadBuffer", result );
+
+    return result;
+}
+
+
+PaError Pa_AcquireWriteBuffer( PaStream* stream, void **buffer, unsigned long *frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_AcquireWriteBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+
+    if( result == paNoError )
+    {
+        if( buffer == 0 || frames == 0 )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_REP(stream)->streamCallback )
+        {
+            result = paCanNotWriteToACallbackStream;
+        }
+        else if( !PA_STREAM_INTERFACE(stream)->AcquireWriteBuffer )
+        {
+            result = paIncompatibleStreamHostApi;
+        }
+        else if( PA_STREAM_REP(stream)->framesLentForWriting > 0 )
+        {
+            result = paBufferAlreadyAcquired;
+        }
+        else if( *frames == 0 )
+        {
+            *buffer = 0;
+        }
+        else
+        {
+            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            if( result == 0 )
+            {
+                result = PA_STREAM_INTERFACE(stream)->AcquireWriteBuffer( stream, buffer, frames );
+                if( result == paNoError || result == paOutputUnderflowed )
+                    PA_STREAM_REP(stream)->framesLentForWriting = *frames;
+            }
+            else if( result == 1 )
+            {
+                result = paStreamIsStopped;
+            }
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_AcquireWriteBuffer", result );
+
+    return result;
+}
+
+
+PaError Pa_CommitWriteBuffer( PaStream* stream, unsigned long frames )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_CommitWriteBuffer" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tunsigned long frames: %lu\n", frames ));
+
+    if( result == paNoError )
+    {
+        if( frames > PA_STREAM_REP(stream)->framesLentForWriting )
+        {
+            result = paBufferNotAcquired;
+        }
+        else if( PA_STREAM_REP(stream)->framesLentForWriting > 0 )
+        {
+            PA_STREAM_REP(stream)->framesLentForWriting = 0;
+            result = PA_STREAM_INTERFACE(stream)->CommitWriteBuffer( stream, frames );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_CommitWriteBuffer", result );
+
+    return result;
+}
+
+
 PaError Pa_GetSampleSize( PaSampleFormat format )
 {
     int result;
@@ -1813,6 +2401,10 @@ PaError Pa_GetSampleSize( PaSampleFormat format )
         result = 4;
         break;
 
+    case paFloat64:
+        result = 8;
+        break;
+
     default:
         result = paSampleFormatNotSupported;
         break;
@@ -1822,3 +2414,37 @@ PaError Pa_GetSampleSize( PaSampleFormat format )
 
     return (PaError) result;
 }
+
+
+PaError Pa_SetConverterTier( PaConverterTier tier )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetConverterTier" );
+    PA_LOGAPI(("\tPaConverterTier tier: %d\n", tier ));
+
+    /* the converters are selected when streams are opened and when the
+        buffer processor is reconfigured, without synchronization */
+    if( firstOpenStream_ != NULL )
+        result = paConverterTierInUse;
+    else
+        result = PaUtil_SetConverterTier( tier );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetConverterTier", result );
+
+    return result;
+}
+
+
+PaConverterTier Pa_GetConverterTier( void )
+{
+    PaConverterTier result;
+
+    PA_LOGAPI_ENTER( "Pa_GetConverterTier" );
+
+    result = PaUtil_GetConverterTier();
+
+    PA_LOGAPI_EXIT_T( "Pa_GetConverterTier", "PaConverterTier: %d", result );
+
+    return result;
+}
@@ -0,0 +1,516 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library offline streams
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Offline streams, which render a callback stream through the buffer
+ processor on the caller's thread.
+
+ The stream behaves like a callback stream of a host API with a fixed host
+ buffer size, except that host buffers are supplied by
+ PaUtil_RenderOfflineStream() instead of a device, and the stream time is the
+ number of frames rendered divided by the sample rate.
+*/
+
+#include <string.h> /* memset(), memcpy() */
+
+#include "pa_offline.h"
+#include "pa_util.h"
+#include "pa_allocation.h"
+#include "pa_stream.h"
+#include "pa_cpuload.h"
+#include "pa_process.h"
+#include "pa_converters.h"
+
+
+/* the host buffer size used when neither the offline stream info nor
+    framesPerBuffer specify one */
+#define PA_OFFLINE_DEFAULT_FRAMES_PER_HOST_BUFFER_  (512)
+
+
+typedef struct PaUtilOfflineStream
+{
+    PaUtilStreamRepresentation streamRepresentation;
+    PaUtilCpuLoadMeasurer cpuLoadMeasurer;
+    PaUtilBufferProcessor bufferProcessor;
+
+    double sampleRate;
+    unsigned long framesPerHostBuffer;
+    double framePosition;           /**< frames rendered since the stream was opened */
+    PaTime deviceInputLatency;      /**< latency of the simulated device, used for the time info */
+    PaTime deviceOutputLatency;
+
+    int inputChannelCount;
+    unsigned int bytesPerHostInputFrame;
+    PaUtilZeroer *inputZeroer;
+    void *partialInputBuffer;       /**< one host buffer, used to pad a partial host buffer */
+
+    int outputChannelCount;
+    unsigned int bytesPerHostOutputFrame;
+    void *partialOutputBuffer;      /**< one host buffer, used to truncate a partial host buffer */
+
+    int isStopped;
+    int isActive;
+    int callbackResult;
+} PaUtilOfflineStream;
+
+
+static PaError CloseStream( PaStream* s );
+static PaError StartStream( PaStream *s );
+static PaError StopStream( PaStream *s );
+static PaError AbortStream( PaStream *s );
+static PaError IsStreamStopped( PaStream *s );
+static PaError IsStreamActive( PaStream *s );
+static PaTime GetStreamTime( PaStream *s );
+static double GetStreamCpuLoad( PaStream* s );
+
+
+static PaUtilStreamInterface offlineStreamInterface_ =
+{
+    CloseStream,
+    StartStream,
+    StopStream,
+    AbortStream,
+    IsStreamStopped,
+    IsStreamActive,
+    GetStreamTime,
+    GetStreamCpuLoad,
+    PaUtil_DummyRead,
+    PaUtil_DummyWrite,
+    PaUtil_DummyGetReadAvailable,
+    PaUtil_DummyGetWriteAvailable,
+    0, 0, 0, 0 /* no buffer lending */
+};
+
+
+/* returns the host format of a direction of the stream, which is interleaved */
+static PaSampleFormat GetHostSampleFormat( PaSampleFormat hostSampleFormat,
+        PaSampleFormat userSampleFormat )
+{
+    if( hostSampleFormat == 0 )
+        return userSampleFormat & ~paNonInterleaved;
+
+    return hostSampleFormat;
+}
+
+
+PaError PaUtil_OpenOfflineStream( PaStream** s,
+        const PaStreamParameters *inputParameters,
+        const PaStreamParameters *outputParameters,
+        double sampleRate, unsigned long framesPerBuffer, PaStreamFlags streamFlags,
+        const PaOfflineStreamInfo *offlineStreamInfo,
+        PaStreamCallback *streamCallback, void *userData )
+{
+    PaError result = paNoError;
+    PaUtilOfflineStream *stream = 0;
+    PaOfflineStreamInfo defaultStreamInfo;
+    int inputChannelCount = 0, outputChannelCount = 0;
+    PaSampleFormat inputSampleFormat, outputSampleFormat;
+    PaSampleFormat hostInputSampleFormat, hostOutputSampleFormat;
+    int bytesPerHostInputSample = 0, bytesPerHostOutputSample = 0;
+    unsigned long framesPerHostBuffer;
+
+    if( !streamCallback )
+        return paNullCallback;
+
+    if( !inputParameters && !outputParameters )
+        return paInvalidChannelCount;
+
+    if( sampleRate <= 0. )
+        return paInvalidSampleRate;
+
+    /* the sample rate of an offline stream can be anything, so sample rate
+        conversion isn't supported */
+    if( (streamFlags & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback
+            | paNoiseShapedDither | paBatchUserBuffers)) != 0 )
+        return paInvalidFlag;
+
+    if( (streamFlags & paBatchUserBuffers) && framesPerBuffer == paFramesPerBufferUnspecified )
+        return paInvalidFlag;
+
+    if( offlineStreamInfo )
+    {
+        if( offlineStreamInfo->size != sizeof(PaOfflineStreamInfo)
+                || offlineStreamInfo->version != 1 )
+            return paIncompatibleHostApiSpecificStreamInfo;
+    }
+    else
+    {
+        memset( &defaultStreamInfo, 0, sizeof(defaultStreamInfo) );
+        defaultStreamInfo.size = sizeof(PaOfflineStreamInfo);
+        defaultStreamInfo.version = 1;
+        offlineStreamInfo = &defaultStreamInfo;
+    }
+
+    if( inputParameters )
+    {
+        inputChannelCount = inputParameters->channelCount;
+        inputSampleFormat = inputParameters->sampleFormat;
+        hostInputSampleFormat = GetHostSampleFormat(
+                offlineStreamInfo->hostInputSampleFormat, inputSampleFormat );
+
+        if( inputChannelCount <= 0 )
+            return paInvalidChannelCount;
+
+        if( hostInputSampleFormat & paNonInterleaved )
+            return paSampleFormatNotSupported;
+
+        bytesPerHostInputSample = Pa_GetSampleSize( hostInputSampleFormat );
+        if( bytesPerHostInputSample < 0 )
+            return bytesPerHostInputSample;
+    }
+    else
+    {
+        inputSampleFormat = hostInputSampleFormat = paFloat32; /* Suppress 'uninitialised var' warnings. */
+    }
+
+    if( outputParameters )
+    {
+        outputChannelCount = outputParameters->channelCount;
+        outputSampleFormat = outputParameters->sampleFormat;
+        hostOutputSampleFormat = GetHostSampleFormat(
+                offlineStreamInfo->hostOutputSampleFormat, outputSampleFormat );
+
+        if( outputChannelCount <= 0 )
+            return paInvalidChannelCount;
+
+        if( hostOutputSampleFormat & paNonInterleaved )
+            return paSampleFormatNotSupported;
+
+        bytesPerHostOutputSample = Pa_GetSampleSize( hostOutputSampleFormat );
+        if( bytesPerHostOutputSample < 0 )
+            return bytesPerHostOutputSample;
+    }
+    else
+    {
+        outputSampleFormat = hostOutputSampleFormat = paFloat32; /* Suppress 'uninitialised var' warnings. */
+    }
+
+    if( offlineStreamInfo->framesPerHostBuffer > 0 )
+        framesPerHostBuffer = offlineStreamInfo->framesPerHostBuffer;
+    else if( framesPerBuffer != paFramesPerBufferUnspecified )
+        framesPerHostBuffer = framesPerBuffer;
+    else
+        framesPerHostBuffer = PA_OFFLINE_DEFAULT_FRAMES_PER_HOST_BUFFER_;
+
+    stream = (PaUtilOfflineStream*)PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilOfflineStream) );
+    if( !stream )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    PaUtil_InitializeStreamRepresentation( &stream->streamRepresentation,
+            &offlineStreamInterface_, streamCallback, userData );
+
+    PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+
+    result = PaUtil_InitializeBufferProcessor( &stream->bufferProcessor,
+            inputChannelCount, inputSampleFormat, hostInputSampleFormat,
+            outputChannelCount, outputSampleFormat, hostOutputSampleFormat,
+            sampleRate, streamFlags, framesPerBuffer,
+            framesPerHostBuffer, paUtilFixedHostBufferSize,
+            streamCallback, userData );
+    if( result != paNoError )
+        goto error;
+
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+
+    stream->sampleRate = sampleRate;
+    stream->framesPerHostBuffer = framesPerHostBuffer;
+    stream->inputChannelCount = inputChannelCount;
+    stream->outputChannelCount = outputChannelCount;
+    stream->bytesPerHostInputFrame = bytesPerHostInputSample * inputChannelCount;
+    stream->bytesPerHostOutputFrame = bytesPerHostOutputSample * outputChannelCount;
+
+    if( inputChannelCount > 0 )
+    {
+        stream->deviceInputLatency = ( inputParameters->suggestedLatency > 0. )
+                ? inputParameters->suggestedLatency : 0.;
+        stream->inputZeroer = PaUtil_SelectZeroer( hostInputSampleFormat );
+
+        stream->partialInputBuffer = PaUtil_AllocateZeroInitializedMemory(
+                stream->bytesPerHostInputFrame * framesPerHostBuffer );
+        if( !stream->partialInputBuffer )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        stream->deviceOutputLatency = ( outputParameters->suggestedLatency > 0. )
+                ? outputParameters->suggestedLatency : 0.;
+
+        stream->partialOutputBuffer = PaUtil_AllocateZeroInitializedMemory(
+                stream->bytesPerHostOutputFrame * framesPerHostBuffer );
+        if( !stream->partialOutputBuffer )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+    }
+
+    stream->streamRepresentation.streamInfo.inputLatency = stream->deviceInputLatency +
+            (PaTime)PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor ) / sampleRate;
+    stream->streamRepresentation.streamInfo.outputLatency = stream->deviceOutputLatency +
+            (PaTime)PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor ) / sampleRate;
+    stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
+
+    stream->isStopped = 1;
+    stream->isActive = 0;
+    stream->callbackResult = paContinue;
+
+    *s = (PaStream*)stream;
+
+    return result;
+
+error:
+    if( stream )
+    {
+        if( stream->streamRepresentation.bufferProcessor )
+            PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
+
+        if( stream->partialInputBuffer )
+            PaUtil_FreeMemory( stream->partialInputBuffer );
+
+        PaUtil_FreeMemory( stream );
+    }
+
+    return result;
+}
+
+
+/* passes one host buffer through the buffer processor */
+static void RenderHostBuffer( PaUtilOfflineStream *stream, void *hostInput, void *hostOutput )
+{
+    PaUtilBufferProcessor *bp = &stream->bufferProcessor;
+    PaStreamCallbackTimeInfo timeInfo;
+    unsigned long framesProcessed;
+
+    timeInfo.currentTime = stream->framePosition / stream->sampleRate;
+    timeInfo.inputBufferAdcTime = timeInfo.currentTime - stream->deviceInputLatency;
+    timeInfo.outputBufferDacTime = timeInfo.currentTime + stream->deviceOutputLatency;
+
+    PaUtil_BeginCpuLoadMeasurement( &stream->cpuLoadMeasurer );
+
+    PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+
+    if( stream->inputChannelCount > 0 )
+    {
+        PaUtil_SetInputFrameCount( bp, stream->framesPerHostBuffer );
+        PaUtil_SetInterleavedInputChannels( bp, 0, hostInput, 0 );
+    }
+
+    if( stream->outputChannelCount > 0 )
+    {
+        PaUtil_SetOutputFrameCount( bp, stream->framesPerHostBuffer );
+        PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, 0 );
+    }
+
+    framesProcessed = PaUtil_EndBufferProcessing( bp, &stream->callbackResult );
+
+    PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer, framesProcessed );
+
+    stream->framePosition += stream->framesPerHostBuffer;
+
+    if( stream->isActive && stream->callbackResult != paContinue )
+    {
+        stream->isActive = 0;
+
+        if( stream->streamRepresentation.streamFinishedCallback != 0 )
+            stream->streamRepresentation.streamFinishedCallback( stream->streamRepresentation.userData );
+    }
+}
+
+
+PaError PaUtil_RenderOfflineStream( PaStream* s,
+        const void *input, void *output, unsigned long frames )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+    const unsigned char *userInput = (const unsigned char*)input;
+    unsigned char *userOutput = (unsigned char*)output;
+    void *hostInput, *hostOutput;
+    unsigned long frameCount;
+
+    if( stream->streamRepresentation.streamInterface != &offlineStreamInterface_ )
+        return paIncompatibleStreamHostApi;
+
+    if( stream->isStopped )
+        return paStreamIsStopped;
+
+    if( (stream->inputChannelCount > 0 && !input)
+            || (stream->outputChannelCount > 0 && !output) )
+        return paBadBufferPtr;
+
+    while( frames > 0 )
+    {
+        frameCount = ( frames < stream->framesPerHostBuffer ) ? frames : stream->framesPerHostBuffer;
+
+        hostInput = 0;
+        if( stream->inputChannelCount > 0 )
+        {
+            if( frameCount < stream->framesPerHostBuffer )
+            {
+                /* pad the last host buffer with silence */
+                memcpy( stream->partialInputBuffer, userInput, frameCount * stream->bytesPerHostInputFrame );
+                stream->inputZeroer( (unsigned char*)stream->partialInputBuffer
+                        + frameCount * stream->bytesPerHostInputFrame, 1,
+                        (stream->framesPerHostBuffer - frameCount) * stream->inputChannelCount );
+
+                hostInput = stream->partialInputBuffer;
+            }
+            else
+            {
+                hostInput = (void*)userInput;
+            }
+
+            userInput += frameCount * stream->bytesPerHostInputFrame;
+        }
+
+        hostOutput = 0;
+        if( stream->outputChannelCount > 0 )
+        {
+            hostOutput = ( frameCount < stream->framesPerHostBuffer )
+                    ? stream->partialOutputBuffer : (void*)userOutput;
+        }
+
+        RenderHostBuffer( stream, hostInput, hostOutput );
+
+        if( stream->outputChannelCount > 0 )
+        {
+            if( hostOutput == stream->partialOutputBuffer )
+                memcpy( userOutput, stream->partialOutputBuffer, frameCount * stream->bytesPerHostOutputFrame );
+
+            userOutput += frameCount * stream->bytesPerHostOutputFrame;
+        }
+
+        frames -= frameCount;
+    }
+
+    return paNoError;
+}
+
+
+static PaError CloseStream( PaStream* s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
+    PaUtil_TerminateStreamRepresentation( &stream->streamRepresentation );
+
+    if( stream->partialInputBuffer )
+        PaUtil_FreeMemory( stream->partialInputBuffer );
+
+    if( stream->partialOutputBuffer )
+        PaUtil_FreeMemory( stream->partialOutputBuffer );
+
+    PaUtil_FreeMemory( stream );
+
+    return paNoError;
+}
+
+
+static PaError StartStream( PaStream *s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    PaUtil_ResetBufferProcessor( &stream->bufferProcessor );
+    PaUtil_ResetCpuLoadMeasurer( &stream->cpuLoadMeasurer );
+
+    stream->callbackResult = paContinue;
+    stream->isStopped = 0;
+    stream->isActive = 1;
+
+    return paNoError;
+}
+
+
+static PaError StopStream( PaStream *s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    if( stream->isActive && stream->streamRepresentation.streamFinishedCallback != 0 )
+        stream->streamRepresentation.streamFinishedCallback( stream->streamRepresentation.userData );
+
+    stream->isStopped = 1;
+    stream->isActive = 0;
+
+    return paNoError;
+}
+
+
+static PaError AbortStream( PaStream *s )
+{
+    /* nothing is queued for a device, so stopping and aborting are the same */
+    return StopStream( s );
+}
+
+
+static PaError IsStreamStopped( PaStream *s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    return stream->isStopped;
+}
+
+
+static PaError IsStreamActive( PaStream *s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    return stream->isActive;
+}
+
+
+static PaTime GetStreamTime( PaStream *s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    return stream->framePosition / stream->sampleRate;
+}
+
+
+static double GetStreamCpuLoad( PaStream* s )
+{
+    PaUtilOfflineStream *stream = (PaUtilOfflineStream*)s;
+
+    return PaUtil_GetCpuLoad( &stream->cpuLoadMeasurer );
+}
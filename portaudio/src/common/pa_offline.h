@@ -0,0 +1,88 @@
+#ifndef PA_OFFLINE_H
+#define PA_OFFLINE_H
+/*
+ * $Id$
+ * Portable Audio I/O Library offline streams
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Offline streams, which run the buffer processor of a callback stream
+ on the caller's thread instead of a device.
+
+ An offline stream simulates a device with a fixed buffer size. Each call to
+ PaUtil_RenderOfflineStream() passes the caller's frames through the buffer
+ processor in buffers of that size, with time info derived from the number of
+ frames rendered, so the output only depends on the input and the sequence of
+ calls.
+*/
+
+#include "portaudio.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Implements Pa_OpenOfflineStream(). The parameters have the same meaning.
+ The stream is not added to the list of open streams, this is left to the
+ caller.
+*/
+PaError PaUtil_OpenOfflineStream( PaStream** stream,
+        const PaStreamParameters *inputParameters,
+        const PaStreamParameters *outputParameters,
+        double sampleRate, unsigned long framesPerBuffer, PaStreamFlags streamFlags,
+        const PaOfflineStreamInfo *offlineStreamInfo,
+        PaStreamCallback *streamCallback, void *userData );
+
+
+/** Implements Pa_RenderOfflineStream(). The stream pointer must have been
+ validated with PaUtil_ValidateStreamPointer().
+
+ @return paIncompatibleStreamHostApi if the stream was not opened with
+ PaUtil_OpenOfflineStream(), otherwise as Pa_RenderOfflineStream().
+*/
+PaError PaUtil_RenderOfflineStream( PaStream* stream,
+        const void *input, void *output, unsigned long frames );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_OFFLINE_H */
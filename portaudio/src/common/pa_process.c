@@ -46,16 +46,109 @@
 
 #include <assert.h>
 #include <string.h> /* memset() */
+#include <limits.h> /* LONG_MAX */
+#include <math.h> /* ceil(), floor() */
 
 #include "pa_process.h"
 #include "pa_util.h"
+#include "pa_memorybarrier.h"
+
+#if PA_PROCESS_STAGE_TIMING
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h> /* __rdtsc() */
+#define PA_STAGE_TIMER_USES_TSC_
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h> /* __rdtsc() */
+#define PA_STAGE_TIMER_USES_TSC_
+#elif defined(__unix__) || defined(__APPLE__)
+#include <time.h> /* clock_gettime() */
+#endif
+#endif /* PA_PROCESS_STAGE_TIMING */
 
 
 #define PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_    1024
 
+/* duration of the ramp used when an output channel gain changes */
+#define PA_OUTPUT_GAIN_RAMP_SECONDS_    (0.005)
+
+/* number of samples scaled by the output gain in each pass */
+#define PA_OUTPUT_GAIN_BLOCK_SIZE_      (64)
+
+/* alignment of the temporary buffers and of each non-interleaved channel
+ within them. This is a cache line, and suits the widest SIMD loads. */
+#define PA_TEMP_BUFFER_ALIGNMENT_       (64)
+
+/* blocks at least this large are aligned to a page */
+#define PA_TEMP_BUFFER_PAGE_SIZE_       (4096)
+#define PA_TEMP_BUFFER_PAGE_ALIGNMENT_THRESHOLD_ (4 * PA_TEMP_BUFFER_PAGE_SIZE_)
+
 #define PA_MIN_( a, b ) ( ((a)<(b)) ? (a) : (b) )
 
 
+/*
+    Output gains may be set by PaUtil_SetBufferProcessorOutputGain() while the
+    callback thread is processing. The target gain and then the
+    outputGainIsEnabled flag are published with release stores and observed
+    with acquire loads, so a callback thread which sees the flag also sees the
+    gain, and a gain change is seen as a whole float. As in pa_ringbuffer.c
+    GCC and Clang provide these as the __atomic builtins, and other compilers
+    fall back to full memory barriers.
+*/
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+
+static float LoadGainAcquire( const volatile float *gain )
+{
+    float result;
+    __atomic_load( gain, &result, __ATOMIC_ACQUIRE );
+    return result;
+}
+
+static void StoreGainRelease( volatile float *gain, float value )
+{
+    __atomic_store( gain, &value, __ATOMIC_RELEASE );
+}
+
+static int LoadFlagAcquire( const volatile int *flag )
+{
+    return __atomic_load_n( flag, __ATOMIC_ACQUIRE );
+}
+
+static void StoreFlagRelease( volatile int *flag, int value )
+{
+    __atomic_store_n( flag, value, __ATOMIC_RELEASE );
+}
+
+#else /* no __atomic builtins */
+
+static float LoadGainAcquire( const volatile float *gain )
+{
+    float result = *gain;
+    PaUtil_FullMemoryBarrier();
+    return result;
+}
+
+static void StoreGainRelease( volatile float *gain, float value )
+{
+    PaUtil_FullMemoryBarrier();
+    *gain = value;
+}
+
+static int LoadFlagAcquire( const volatile int *flag )
+{
+    int result = *flag;
+    PaUtil_FullMemoryBarrier();
+    return result;
+}
+
+static void StoreFlagRelease( volatile int *flag, int value )
+{
+    PaUtil_FullMemoryBarrier();
+    *flag = value;
+}
+
+#endif /* __ATOMIC_ACQUIRE */
+
+
 /* greatest common divisor - PGCD in French */
 static unsigned long GCD( unsigned long a, unsigned long b )
 {
@@ -87,362 +180,1952 @@ static unsigned long CalculateFrameShift( unsigned long M, unsigned long N )
 }
 
 
-PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
-        int inputChannelCount, PaSampleFormat userInputSampleFormat,
-        PaSampleFormat hostInputSampleFormat,
-        int outputChannelCount, PaSampleFormat userOutputSampleFormat,
-        PaSampleFormat hostOutputSampleFormat,
-        double sampleRate,
-        PaStreamFlags streamFlags,
-        unsigned long framesPerUserBuffer,
-        unsigned long framesPerHostBuffer,
-        PaUtilHostBufferSizeMode hostBufferSizeMode,
-        PaStreamCallback *streamCallback, void *userData )
+#if PA_PROCESS_STAGE_TIMING
+
+/* returns the stage timer in ticks: processor cycles where a cycle counter is
+ available, otherwise nanoseconds */
+static double ReadStageTimer( void )
 {
-    PaError result = paNoError;
-    PaError bytesPerSample;
-    unsigned long tempInputBufferSize, tempOutputBufferSize;
-    PaStreamFlags tempInputStreamFlags;
+#if defined(PA_STAGE_TIMER_USES_TSC_)
+    return (double)__rdtsc();
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+#else
+    return PaUtil_GetTime() * 1e9;
+#endif
+}
 
-    if( streamFlags & paNeverDropInput )
+static void AddStageTicks( PaUtilBufferProcessor *bp, PaUtilProcessStage stage, double startTicks )
+{
+    double ticks = ReadStageTimer() - startTicks;
+
+    if( bp->pendingStageTicks[stage] < 0. )
+        bp->pendingStageTicks[stage] = ticks;
+    else
+        bp->pendingStageTicks[stage] += ticks;
+}
+
+/* add the stage times of the current host buffer to bp->stageTicks, which
+ may be read by PaUtil_GetBufferProcessorStageTimes() from another thread */
+static void PublishStageTicks( PaUtilBufferProcessor *bp )
+{
+    int i;
+
+    ++bp->stageTicksSequence;
+    PaUtil_WriteMemoryBarrier();
+
+    for( i=0; i<paUtilProcessStageCount; ++i )
     {
-        /* paNeverDropInput is only valid for full-duplex callback streams, with an unspecified number of frames per buffer. */
-        if( !streamCallback || !(inputChannelCount > 0 && outputChannelCount > 0) ||
-                framesPerUserBuffer != paFramesPerBufferUnspecified )
-            return paInvalidFlag;
+        PaUtilStageTicks *stageTicks = &bp->stageTicks[i];
+        double ticks = bp->pendingStageTicks[i];
+
+        if( ticks >= 0. )
+        {
+            ++stageTicks->count;
+            stageTicks->total += ticks;
+            stageTicks->last = ticks;
+            if( ticks > stageTicks->maximum )
+                stageTicks->maximum = ticks;
+
+            bp->pendingStageTicks[i] = -1.;
+        }
     }
 
-    /* initialize buffer ptrs to zero so they can be freed if necessary in error */
-    bp->tempInputBuffer = 0;
-    bp->tempInputBufferPtrs = 0;
-    bp->tempOutputBuffer = 0;
-    bp->tempOutputBufferPtrs = 0;
+    PaUtil_WriteMemoryBarrier();
+    ++bp->stageTicksSequence;
+}
 
-    bp->framesPerUserBuffer = framesPerUserBuffer;
-    bp->framesPerHostBuffer = framesPerHostBuffer;
+#define PA_DECLARE_STAGE_TIMER_( start )            double start;
+#define PA_START_STAGE_TIMER_( start )              (start) = ReadStageTimer()
+#define PA_STOP_STAGE_TIMER_( bp, stage, start )    AddStageTicks( (bp), (stage), (start) )
+#define PA_PUBLISH_STAGE_TIMES_( bp )               PublishStageTicks( bp )
 
-    bp->inputChannelCount = inputChannelCount;
-    bp->outputChannelCount = outputChannelCount;
+#else /* not PA_PROCESS_STAGE_TIMING */
 
-    bp->hostBufferSizeMode = hostBufferSizeMode;
+#define PA_DECLARE_STAGE_TIMER_( start )
+#define PA_START_STAGE_TIMER_( start )              ((void)0)
+#define PA_STOP_STAGE_TIMER_( bp, stage, start )    ((void)0)
+#define PA_PUBLISH_STAGE_TIMES_( bp )               ((void)0)
 
-    bp->hostInputChannels[0] = bp->hostInputChannels[1] = 0;
-    bp->hostOutputChannels[0] = bp->hostOutputChannels[1] = 0;
+#endif /* PA_PROCESS_STAGE_TIMING */
 
-    if( framesPerUserBuffer == 0 ) /* streamCallback will accept any buffer size */
+
+/* the initial output frames end where the first user buffer is written to
+ the output FIFO, which is a whole number of user buffers into the temp buffer */
+static unsigned long GetInitialTempOutputBufferReadFrame( PaUtilBufferProcessor *bp )
+{
+    unsigned long initialFrames = bp->initialFramesInTempOutputBuffer;
+
+    if( bp->useNonAdaptingProcess || initialFrames == 0 )
+        return 0;
+
+    return (initialFrames + bp->framesPerUserBuffer - 1) / bp->framesPerUserBuffer
+            * bp->framesPerUserBuffer - initialFrames;
+}
+
+static unsigned long GetTempBufferAlignment( unsigned long size )
+{
+    return ( size >= PA_TEMP_BUFFER_PAGE_ALIGNMENT_THRESHOLD_ )
+            ? PA_TEMP_BUFFER_PAGE_SIZE_ : PA_TEMP_BUFFER_ALIGNMENT_;
+}
+
+static unsigned long RoundUpToAlignment( unsigned long size, unsigned long alignment )
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/* Returns the distance in bytes between the user buffers in a FIFO of the
+ adapting processors, which is the size of a user buffer rounded up to the
+ alignment. bytesPerFrame is the size of a frame of an interleaved buffer, or
+ of a sample of a non-interleaved channel. The non-adapting processor uses the
+ temp buffer as a single block. */
+static unsigned long GetTempBufferBlockStrideBytes( PaUtilBufferProcessor *bp,
+        unsigned long bytesPerFrame )
+{
+    if( bp->useNonAdaptingProcess )
+        return bp->framesPerTempBuffer * bytesPerFrame;
+
+    return RoundUpToAlignment( bp->framesPerUserBuffer * bytesPerFrame, bp->bufferAlignment );
+}
+
+/* Returns the size in bytes of an interleaved temp buffer, or of a channel of
+ a non-interleaved temp buffer before it is padded. */
+static unsigned long GetTempBufferChannelBytes( PaUtilBufferProcessor *bp,
+        unsigned long blockStrideBytes )
+{
+    if( bp->useNonAdaptingProcess )
+        return blockStrideBytes;
+
+    /* the adapting processors' temp buffers hold a whole number of user buffers */
+    return blockStrideBytes * (bp->framesPerTempBuffer / bp->framesPerUserBuffer);
+}
+
+/* Allocate a zero-initialized block aligned to a power of two. The pointer
+ returned by the underlying allocator is stored just before the aligned
+ block, for FreeAlignedMemory(). */
+static void *AllocateAlignedZeroInitializedMemory( unsigned long size, unsigned long alignment )
+{
+    unsigned char *block = (unsigned char*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(size + alignment + sizeof(void*)) );
+    unsigned char *aligned;
+
+    if( !block )
+        return 0;
+
+    aligned = block + sizeof(void*);
+    aligned += (alignment - ((size_t)aligned & (alignment - 1))) & (alignment - 1);
+    ((void**)aligned)[-1] = block;
+
+    return aligned;
+}
+
+static void FreeAlignedMemory( void *block )
+{
+    PaUtil_FreeMemory( ((void**)block)[-1] );
+}
+
+/* returns the largest power of two which divides size, which is the
+ alignment of every multiple of size from an aligned address */
+static unsigned long GetNaturalAlignment( unsigned long size )
+{
+    return size ? (size & (~size + 1)) : 1;
+}
+
+/* returns non-zero if every non-interleaved host channel can be passed to the
+ callback directly, which requires the samples to be contiguous */
+static int ChannelsAreContiguous( const PaUtilChannelDescriptor *channels,
+        unsigned int channelCount )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
     {
-        bp->useNonAdaptingProcess = 1;
-        bp->initialFramesInTempInputBuffer = 0;
-        bp->initialFramesInTempOutputBuffer = 0;
+        if( channels[i].stride != 1 )
+            return 0;
+    }
 
-        if( hostBufferSizeMode == paUtilFixedHostBufferSize
-                || hostBufferSizeMode == paUtilBoundedHostBufferSize )
-        {
-            bp->framesPerTempBuffer = framesPerHostBuffer;
-        }
-        else /* unknown host buffer size */
-        {
-            bp->framesPerTempBuffer = PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_;
-        }
+    return 1;
+}
+
+
+/* Converts between the host and user sample rates when resampling has been
+ enabled by PaUtil_EnableBufferProcessorResampling(). The buffer processor
+ then calls ResamplingStageCallback() with non-interleaved Float32 buffers at
+ the host sample rate, and the stage calls the user's callback with
+ framesPerUserBuffer frames at the user sample rate. */
+typedef struct PaUtilResamplingStage
+{
+    PaStreamCallback *streamCallback;
+    void *userData;
+    double userSampleRate;
+    unsigned long framesPerUserBuffer;
+    unsigned long primingFrames; /**< silent frames written to the output resampler on reset */
+
+    unsigned int inputChannelCount;
+    PaUtilResampler inputResampler; /**< host rate to user rate */
+    float *inputBlock;              /**< inputChannelCount blocks of framesPerUserBuffer samples */
+    float **inputBlockPtrs;
+    void *userInputBuffer;          /**< NULL if the user format is non-interleaved Float32 */
+    void **userInputBufferPtrs;
+    void *userInput;                /**< passed to the user's callback */
+    unsigned int bytesPerUserInputSample;
+    int userInputIsInterleaved;
+    PaUtilConverter *inputConverter;
+
+    unsigned int outputChannelCount;
+    PaUtilResampler outputResampler; /**< user rate to host rate */
+    float *outputBlock;
+    float **outputBlockPtrs;
+    void *userOutputBuffer;
+    void **userOutputBufferPtrs;
+    void *userOutput;
+    unsigned int bytesPerUserOutputSample;
+    int userOutputIsInterleaved;
+    PaUtilConverter *outputConverter;
+    float **hostOutputPtrs;         /**< the host output channels offset by the frames already written */
+
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    PaStreamCallbackFlags statusFlags; /**< flags to pass with the next call of the user's callback */
+    PaTime inputLatency;
+    PaTime outputLatency;
+} PaUtilResamplingStage;
+
+
+static void FreeResamplingStage( PaUtilResamplingStage *stage )
+{
+    if( stage->inputBlock )
+        PaUtil_FreeMemory( stage->inputBlock );
+    if( stage->inputBlockPtrs )
+        PaUtil_FreeMemory( stage->inputBlockPtrs );
+    if( stage->userInputBuffer )
+        PaUtil_FreeMemory( stage->userInputBuffer );
+    if( stage->userInputBufferPtrs )
+        PaUtil_FreeMemory( stage->userInputBufferPtrs );
+    if( stage->outputBlock )
+        PaUtil_FreeMemory( stage->outputBlock );
+    if( stage->outputBlockPtrs )
+        PaUtil_FreeMemory( stage->outputBlockPtrs );
+    if( stage->userOutputBuffer )
+        PaUtil_FreeMemory( stage->userOutputBuffer );
+    if( stage->userOutputBufferPtrs )
+        PaUtil_FreeMemory( stage->userOutputBufferPtrs );
+    if( stage->hostOutputPtrs )
+        PaUtil_FreeMemory( stage->hostOutputPtrs );
+
+    /* PaUtil_TerminateResampler() accepts a zeroed resampler */
+    PaUtil_TerminateResampler( &stage->inputResampler );
+    PaUtil_TerminateResampler( &stage->outputResampler );
+
+    PaUtil_FreeMemory( stage );
+}
+
+
+static void ResetResamplingStage( PaUtilResamplingStage *stage )
+{
+    if( stage->inputChannelCount > 0 )
+        PaUtil_ResetResampler( &stage->inputResampler );
+
+    if( stage->outputChannelCount > 0 )
+    {
+        PaUtil_ResetResampler( &stage->outputResampler );
+        PaUtil_WriteResamplerInput( &stage->outputResampler, NULL, stage->primingFrames );
     }
-    else
+
+    stage->statusFlags = 0;
+}
+
+
+/* Allocate the float block and user buffer for one direction. If the user
+ format is non-interleaved Float32 the user's callback is passed the float
+ block directly. */
+static PaError AllocateResamplingStageBuffers( unsigned int channelCount,
+        unsigned long frameCount, PaSampleFormat userFormat,
+        float **block, float ***blockPtrs, void **userBuffer, void ***userBufferPtrs,
+        void **userData, unsigned int *bytesPerUserSample, int *userIsInterleaved )
+{
+    unsigned int i;
+    int bytesPerSample = Pa_GetSampleSize( userFormat );
+
+    if( bytesPerSample < 0 )
+        return bytesPerSample;
+
+    *bytesPerUserSample = bytesPerSample;
+    *userIsInterleaved = (userFormat & paNonInterleaved) ? 0 : 1;
+
+    *block = (float*)PaUtil_AllocateZeroInitializedMemory( sizeof(float) * channelCount * frameCount );
+    *blockPtrs = (float**)PaUtil_AllocateZeroInitializedMemory( sizeof(float*) * channelCount );
+    if( !*block || !*blockPtrs )
+        return paInsufficientMemory;
+
+    for( i=0; i<channelCount; ++i )
+        (*blockPtrs)[i] = *block + i * frameCount;
+
+    if( userFormat == (paFloat32 | paNonInterleaved) )
     {
-        bp->framesPerTempBuffer = framesPerUserBuffer;
+        *userData = *blockPtrs;
+        return paNoError;
+    }
 
-        if( hostBufferSizeMode == paUtilFixedHostBufferSize
-                && framesPerHostBuffer % framesPerUserBuffer == 0 )
+    *userBuffer = PaUtil_AllocateZeroInitializedMemory( bytesPerSample * channelCount * frameCount );
+    if( !*userBuffer )
+        return paInsufficientMemory;
+
+    if( *userIsInterleaved )
+    {
+        *userData = *userBuffer;
+        return paNoError;
+    }
+
+    *userBufferPtrs = (void**)PaUtil_AllocateZeroInitializedMemory( sizeof(void*) * channelCount );
+    if( !*userBufferPtrs )
+        return paInsufficientMemory;
+
+    for( i=0; i<channelCount; ++i )
+        (*userBufferPtrs)[i] = (unsigned char*)*userBuffer + i * frameCount * bytesPerSample;
+
+    *userData = *userBufferPtrs;
+    return paNoError;
+}
+
+
+/* Call the user's callback once with framesPerUserBuffer frames, reading
+ the input from the input resampler and writing the output to the output
+ resampler. */
+static int CallResamplingStageUserCallback( PaUtilResamplingStage *stage,
+        const PaStreamCallbackTimeInfo *hostTimeInfo )
+{
+    PaStreamCallbackTimeInfo timeInfo = *hostTimeInfo;
+    unsigned long frameCount = stage->framesPerUserBuffer;
+    unsigned long framesRead;
+    unsigned int i;
+    int result;
+
+    if( stage->inputChannelCount > 0 )
+    {
+        framesRead = PaUtil_ReadResamplerOutput( &stage->inputResampler, stage->inputBlockPtrs, frameCount );
+        if( framesRead < frameCount )
         {
-            bp->useNonAdaptingProcess = 1;
-            bp->initialFramesInTempInputBuffer = 0;
-            bp->initialFramesInTempOutputBuffer = 0;
+            for( i=0; i<stage->inputChannelCount; ++i )
+                memset( stage->inputBlockPtrs[i] + framesRead, 0, sizeof(float) * (frameCount - framesRead) );
+
+            stage->statusFlags |= paInputUnderflow;
         }
-        else
-        {
-            bp->useNonAdaptingProcess = 0;
 
-            if( inputChannelCount > 0 && outputChannelCount > 0 )
+        if( stage->inputConverter )
+        {
+            for( i=0; i<stage->inputChannelCount; ++i )
             {
-                /* full duplex */
-                if( hostBufferSizeMode == paUtilFixedHostBufferSize )
+                if( stage->userInputIsInterleaved )
                 {
-                    unsigned long frameShift =
-                        CalculateFrameShift( framesPerHostBuffer, framesPerUserBuffer );
-
-                    if( framesPerUserBuffer > framesPerHostBuffer )
-                    {
-                        bp->initialFramesInTempInputBuffer = frameShift;
-                        bp->initialFramesInTempOutputBuffer = 0;
-                    }
-                    else
-                    {
-                        bp->initialFramesInTempInputBuffer = 0;
-                        bp->initialFramesInTempOutputBuffer = frameShift;
-                    }
+                    stage->inputConverter( (unsigned char*)stage->userInputBuffer + i * stage->bytesPerUserInputSample,
+                            stage->inputChannelCount, stage->inputBlockPtrs[i], 1, frameCount,
+                            &stage->ditherGenerator );
                 }
-                else /* variable host buffer size, add framesPerUserBuffer latency */
+                else
                 {
-                    bp->initialFramesInTempInputBuffer = 0;
-                    bp->initialFramesInTempOutputBuffer = framesPerUserBuffer;
+                    stage->inputConverter( stage->userInputBufferPtrs[i], 1,
+                            stage->inputBlockPtrs[i], 1, frameCount, &stage->ditherGenerator );
                 }
             }
-            else
+        }
+    }
+
+    timeInfo.inputBufferAdcTime -= stage->inputLatency;
+    timeInfo.outputBufferDacTime += stage->outputLatency;
+
+    result = stage->streamCallback( stage->userInput, stage->userOutput, frameCount,
+            &timeInfo, stage->statusFlags, stage->userData );
+    stage->statusFlags = 0;
+
+    if( stage->outputChannelCount > 0 )
+    {
+        if( stage->outputConverter )
+        {
+            for( i=0; i<stage->outputChannelCount; ++i )
             {
-                /* half duplex */
-                bp->initialFramesInTempInputBuffer = 0;
-                bp->initialFramesInTempOutputBuffer = 0;
+                if( stage->userOutputIsInterleaved )
+                {
+                    stage->outputConverter( stage->outputBlockPtrs[i], 1,
+                            (unsigned char*)stage->userOutputBuffer + i * stage->bytesPerUserOutputSample,
+                            stage->outputChannelCount, frameCount, &stage->ditherGenerator );
+                }
+                else
+                {
+                    stage->outputConverter( stage->outputBlockPtrs[i], 1,
+                            stage->userOutputBufferPtrs[i], 1, frameCount, &stage->ditherGenerator );
+                }
             }
         }
+
+        PaUtil_WriteResamplerInput( &stage->outputResampler,
+                (const float *const *)stage->outputBlockPtrs, frameCount );
     }
 
+    return result;
+}
 
-    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
-    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
 
+/* The stream callback of a buffer processor with resampling enabled. input
+ and output are non-interleaved Float32 buffers at the host sample rate. */
+static int ResamplingStageCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    PaUtilResamplingStage *stage = (PaUtilResamplingStage*)userData;
+    unsigned long framesDone;
+    unsigned int i;
+    int result = paContinue;
 
-    if( inputChannelCount > 0 )
+    stage->statusFlags |= statusFlags;
+
+    if( stage->inputChannelCount > 0 )
     {
-        bytesPerSample = Pa_GetSampleSize( hostInputSampleFormat );
-        if( bytesPerSample > 0 )
+        if( input )
         {
-            bp->bytesPerHostInputSample = bytesPerSample;
+            if( PaUtil_WriteResamplerInput( &stage->inputResampler,
+                    (const float *const *)input, frameCount ) < frameCount )
+                stage->statusFlags |= paInputOverflow;
         }
         else
         {
-            result = bytesPerSample;
-            goto error;
+            PaUtil_WriteResamplerInput( &stage->inputResampler, NULL, frameCount );
         }
+    }
 
-        bytesPerSample = Pa_GetSampleSize( userInputSampleFormat );
-        if( bytesPerSample > 0 )
-        {
-            bp->bytesPerUserInputSample = bytesPerSample;
-        }
-        else
+    if( stage->outputChannelCount == 0 )
+    {
+        while( result == paContinue &&
+                PaUtil_GetResamplerOutputFramesAvailable( &stage->inputResampler ) >= stage->framesPerUserBuffer )
         {
-            result = bytesPerSample;
-            goto error;
+            result = CallResamplingStageUserCallback( stage, timeInfo );
         }
 
-        /* Under the assumption that no ADC in existence delivers better than 24bits resolution,
-            we disable dithering when host input format is paInt32 and user format is paInt24,
-            since the host samples will just be padded with zeros anyway. */
+        return result;
+    }
 
-        tempInputStreamFlags = streamFlags;
-        if( !(tempInputStreamFlags & paDitherOff) /* dither is on */
-                && (hostInputSampleFormat & paInt32) /* host input format is int32 */
-                && (userInputSampleFormat & paInt24) /* user requested format is int24 */ ){
+    framesDone = 0;
+    for(;;)
+    {
+        for( i=0; i<stage->outputChannelCount; ++i )
+            stage->hostOutputPtrs[i] = ((float**)output)[i] + framesDone;
 
-            tempInputStreamFlags = tempInputStreamFlags | paDitherOff;
-        }
+        framesDone += PaUtil_ReadResamplerOutput( &stage->outputResampler,
+                stage->hostOutputPtrs, frameCount - framesDone );
 
-        bp->inputConverter =
-            PaUtil_SelectConverter( hostInputSampleFormat, userInputSampleFormat, tempInputStreamFlags );
+        if( framesDone == frameCount || result != paContinue )
+            break;
 
-        bp->inputZeroer = PaUtil_SelectZeroer( userInputSampleFormat );
+        result = CallResamplingStageUserCallback( stage, timeInfo );
+    }
 
-        bp->userInputIsInterleaved = (userInputSampleFormat & paNonInterleaved)?0:1;
+    if( framesDone < frameCount )
+    {
+        /* the user's callback returned paComplete or paAbort */
+        for( i=0; i<stage->outputChannelCount; ++i )
+            memset( ((float**)output)[i] + framesDone, 0, sizeof(float) * (frameCount - framesDone) );
+    }
 
-        bp->hostInputIsInterleaved = (hostInputSampleFormat & paNonInterleaved)?0:1;
+    return result;
+}
 
-        bp->userInputSampleFormatIsEqualToHost = ((userInputSampleFormat & ~paNonInterleaved) == (hostInputSampleFormat & ~paNonInterleaved));
 
-        tempInputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserInputSample * inputChannelCount;
+/* One direction of a PaUtilRoutingStage. */
+typedef struct PaUtilRoutingDirection
+{
+    unsigned int userChannelCount;  /**< 0 if the direction isn't routed */
+    unsigned int hostChannelCount;
+    PaSampleFormat userSampleFormat;
+    PaSampleFormat hostSideSampleFormat; /**< the user format of the reinitialized buffer processor */
+    unsigned int bytesPerUserSample;
+    int userIsInterleaved;
+    unsigned long framesPerBuffer;
+
+    /* when the routes form a permutation, hostChannels holds the host channel
+        of each user channel, or -1 if the user channel isn't routed, and
+        hostChannelIsRouted is non-zero for each routed host channel. */
+    int isPermutation;
+    int *hostChannels;
+    unsigned char *hostChannelIsRouted;
+
+    PaChannelRoute *routes;
+    unsigned long routeCount;
+
+    void *userBuffer;               /**< userChannelCount channels in the user format */
+    void **userBufferPtrs;          /**< non-interleaved channel pointers passed to the callback */
+    float *mixBuffer;               /**< userChannelCount channels of Float32 when mixing */
+    float **mixBufferPtrs;
+
+    PaUtilConverter *converter;     /**< copies a permutation, or converts to or from Float32 when mixing */
+    PaUtilZeroer *zeroer;           /**< zeroes the user format */
+} PaUtilRoutingDirection;
+
+
+/* Routes channels between the user's callback and the buffer processor when
+ routing has been enabled by PaUtil_EnableBufferProcessorRouting(). */
+typedef struct PaUtilRoutingStage
+{
+    PaStreamCallback *streamCallback;
+    void *userData;
+    PaUtilRoutingDirection input;
+    PaUtilRoutingDirection output;
+    PaUtilTriangularDitherGenerator ditherGenerator;
+} PaUtilRoutingStage;
 
-        bp->tempInputBuffer = PaUtil_AllocateZeroInitializedMemory( tempInputBufferSize );
-        if( bp->tempInputBuffer == 0 )
+
+static void TerminateRoutingDirection( PaUtilRoutingDirection *direction )
+{
+    if( direction->hostChannels )
+        PaUtil_FreeMemory( direction->hostChannels );
+    if( direction->hostChannelIsRouted )
+        PaUtil_FreeMemory( direction->hostChannelIsRouted );
+    if( direction->routes )
+        PaUtil_FreeMemory( direction->routes );
+    if( direction->userBuffer )
+        PaUtil_FreeMemory( direction->userBuffer );
+    if( direction->userBufferPtrs )
+        PaUtil_FreeMemory( direction->userBufferPtrs );
+    if( direction->mixBuffer )
+        PaUtil_FreeMemory( direction->mixBuffer );
+    if( direction->mixBufferPtrs )
+        PaUtil_FreeMemory( direction->mixBufferPtrs );
+}
+
+
+static void FreeRoutingStage( PaUtilRoutingStage *stage )
+{
+    TerminateRoutingDirection( &stage->input );
+    TerminateRoutingDirection( &stage->output );
+    PaUtil_FreeMemory( stage );
+}
+
+
+static void FreeBatchStorage( PaUtilBufferProcessor *bp )
+{
+    if( bp->batchBlocks )
+        PaUtil_FreeMemory( bp->batchBlocks );
+    bp->batchBlocks = 0;
+
+    if( bp->batchInputChannelPtrs )
+        PaUtil_FreeMemory( bp->batchInputChannelPtrs );
+    bp->batchInputChannelPtrs = 0;
+
+    if( bp->batchOutputChannelPtrs )
+        PaUtil_FreeMemory( bp->batchOutputChannelPtrs );
+    bp->batchOutputChannelPtrs = 0;
+
+    bp->maxBatchBlockCount = 0;
+}
+
+
+/* returns non-zero if each route has unity gain and no user or host channel
+ appears in more than one route */
+static int RoutesArePermutation( const PaChannelRoute *routes, unsigned long routeCount )
+{
+    unsigned long i, j;
+
+    for( i=0; i<routeCount; ++i )
+    {
+        if( routes[i].gain != 1.0f )
+            return 0;
+
+        for( j=0; j<i; ++j )
         {
-            result = paInsufficientMemory;
-            goto error;
+            if( routes[j].userChannel == routes[i].userChannel
+                    || routes[j].deviceChannel == routes[i].deviceChannel )
+                return 0;
         }
+    }
 
-        if( bp->framesInTempInputBuffer > 0 )
+    return 1;
+}
+
+
+/* Initialize one direction of a routing stage. isInput selects the dither and
+ clipping of the conversion from Float32 to the user format. The user sample
+ format of the reinitialized buffer processor is returned in
+ direction->hostSideSampleFormat. */
+static PaError InitializeRoutingDirection( PaUtilRoutingDirection *direction,
+        unsigned int userChannelCount, unsigned int hostChannelCount,
+        PaSampleFormat userSampleFormat, const PaChannelRoute *routes, unsigned long routeCount,
+        unsigned long framesPerBuffer, int isInput, PaStreamFlags streamFlags )
+{
+    unsigned long i;
+    unsigned int c;
+    int bytesPerSample;
+    PaSampleFormat format = userSampleFormat & ~paNonInterleaved;
+
+    direction->userSampleFormat = userSampleFormat;
+    direction->hostSideSampleFormat = userSampleFormat;
+    direction->hostChannelCount = hostChannelCount;
+    direction->userChannelCount = userChannelCount;
+    if( userChannelCount == 0 )
+        return paNoError;
+
+    for( i=0; i<routeCount; ++i )
+    {
+        if( routes[i].userChannel < 0 || routes[i].userChannel >= (int)userChannelCount
+                || routes[i].deviceChannel < 0 || routes[i].deviceChannel >= (int)hostChannelCount )
+            return paInvalidChannelCount;
+    }
+
+    bytesPerSample = Pa_GetSampleSize( userSampleFormat );
+    if( bytesPerSample < 0 )
+        return bytesPerSample;
+
+    direction->bytesPerUserSample = bytesPerSample;
+    direction->userIsInterleaved = (userSampleFormat & paNonInterleaved) ? 0 : 1;
+    direction->framesPerBuffer = framesPerBuffer;
+    direction->isPermutation = RoutesArePermutation( routes, routeCount );
+    direction->zeroer = PaUtil_SelectZeroer( format );
+
+    if( routeCount > 0 )
+    {
+        direction->routes = (PaChannelRoute*)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(PaChannelRoute) * routeCount );
+        if( !direction->routes )
+            return paInsufficientMemory;
+
+        memcpy( direction->routes, routes, sizeof(PaChannelRoute) * routeCount );
+    }
+    direction->routeCount = routeCount;
+
+    direction->userBuffer = PaUtil_AllocateZeroInitializedMemory(
+            bytesPerSample * userChannelCount * framesPerBuffer );
+    direction->userBufferPtrs = (void**)PaUtil_AllocateZeroInitializedMemory(
+            sizeof(void*) * userChannelCount );
+    if( !direction->userBuffer || !direction->userBufferPtrs )
+        return paInsufficientMemory;
+
+    for( c=0; c<userChannelCount; ++c )
+    {
+        direction->userBufferPtrs[c] = (unsigned char*)direction->userBuffer
+                + c * framesPerBuffer * bytesPerSample;
+    }
+
+    if( direction->isPermutation )
+    {
+        /* the buffer processor converts between the user format and the
+            host format, the stage only moves samples between channels */
+        direction->hostSideSampleFormat = format | paNonInterleaved;
+
+        direction->hostChannels = (int*)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(int) * userChannelCount );
+        direction->hostChannelIsRouted = (unsigned char*)PaUtil_AllocateZeroInitializedMemory(
+                hostChannelCount );
+        if( !direction->hostChannels || !direction->hostChannelIsRouted )
+            return paInsufficientMemory;
+
+        for( c=0; c<userChannelCount; ++c )
+            direction->hostChannels[c] = -1;
+
+        for( i=0; i<routeCount; ++i )
         {
-            /* NOTE: we depend on bp->tempInputBuffer being zero-initialized by the allocator. */
-            /* memset( bp->tempInputBuffer, 0, tempInputBufferSize ); */
+            direction->hostChannels[ routes[i].userChannel ] = routes[i].deviceChannel;
+            direction->hostChannelIsRouted[ routes[i].deviceChannel ] = 1;
         }
 
-        if( userInputSampleFormat & paNonInterleaved )
+        if( direction->userIsInterleaved )
         {
-            bp->tempInputBufferPtrs =
-                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*inputChannelCount );
-            if( bp->tempInputBufferPtrs == 0 )
-            {
-                result = paInsufficientMemory;
-                goto error;
-            }
+            direction->converter = PaUtil_SelectConverter( format, format, paClipOff | paDitherOff );
+            if( !direction->converter )
+                return paSampleFormatNotSupported;
         }
+    }
+    else
+    {
+        direction->hostSideSampleFormat = paFloat32 | paNonInterleaved;
 
-        bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
-        if( bp->hostInputChannels[0] == 0 )
+        direction->mixBuffer = (float*)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(float) * userChannelCount * framesPerBuffer );
+        direction->mixBufferPtrs = (float**)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(float*) * userChannelCount );
+        if( !direction->mixBuffer || !direction->mixBufferPtrs )
+            return paInsufficientMemory;
+
+        for( c=0; c<userChannelCount; ++c )
+            direction->mixBufferPtrs[c] = direction->mixBuffer + c * framesPerBuffer;
+
+        if( userSampleFormat != (paFloat32 | paNonInterleaved) )
         {
-            result = paInsufficientMemory;
-            goto error;
+            if( isInput )
+                direction->converter = PaUtil_SelectConverter( paFloat32, format, streamFlags );
+            else
+                direction->converter = PaUtil_SelectConverter( format, paFloat32, paClipOff | paDitherOff );
+            if( !direction->converter )
+                return paSampleFormatNotSupported;
         }
+    }
 
-        bp->hostInputChannels[1] = &bp->hostInputChannels[0][inputChannelCount];
+    return paNoError;
+}
+
+
+/* Return the user channel c of a routing direction, and its stride in samples. */
+static void *GetRoutingUserChannel( PaUtilRoutingDirection *direction, unsigned int c,
+        unsigned int *stride )
+{
+    if( direction->userIsInterleaved )
+    {
+        *stride = direction->userChannelCount;
+        return (unsigned char*)direction->userBuffer + c * direction->bytesPerUserSample;
     }
 
-    if( outputChannelCount > 0 )
+    *stride = 1;
+    return direction->userBufferPtrs[c];
+}
+
+
+/* Build the user input buffer from the non-interleaved host side channels. */
+static void *RouteInput( PaUtilRoutingStage *stage, void **hostChannels,
+        unsigned long frameCount )
+{
+    PaUtilRoutingDirection *direction = &stage->input;
+    unsigned long i, j;
+    unsigned int c, stride;
+    void *channel;
+
+    if( !hostChannels )
+        return 0;
+
+    if( direction->isPermutation )
     {
-        bytesPerSample = Pa_GetSampleSize( hostOutputSampleFormat );
-        if( bytesPerSample > 0 )
+        for( c=0; c<direction->userChannelCount; ++c )
         {
-            bp->bytesPerHostOutputSample = bytesPerSample;
+            int hostChannel = direction->hostChannels[c];
+
+            if( !direction->userIsInterleaved )
+            {
+                /* point directly at the host side channel */
+                direction->userBufferPtrs[c] = ( hostChannel >= 0 )
+                        ? hostChannels[hostChannel]
+                        : (unsigned char*)direction->userBuffer
+                                + c * direction->framesPerBuffer * direction->bytesPerUserSample;
+
+                if( hostChannel < 0 )
+                    direction->zeroer( direction->userBufferPtrs[c], 1, frameCount );
+            }
+            else
+            {
+                channel = GetRoutingUserChannel( direction, c, &stride );
+                if( hostChannel >= 0 )
+                {
+                    direction->converter( channel, stride, hostChannels[hostChannel], 1,
+                            frameCount, &stage->ditherGenerator );
+                }
+                else
+                {
+                    direction->zeroer( channel, stride, frameCount );
+                }
+            }
         }
-        else
+
+        return direction->userIsInterleaved ? direction->userBuffer : (void*)direction->userBufferPtrs;
+    }
+
+    for( c=0; c<direction->userChannelCount; ++c )
+        memset( direction->mixBufferPtrs[c], 0, sizeof(float) * frameCount );
+
+    for( i=0; i<direction->routeCount; ++i )
+    {
+        const PaChannelRoute *route = &direction->routes[i];
+        const float *source = (const float*)hostChannels[ route->deviceChannel ];
+        float *destination = direction->mixBufferPtrs[ route->userChannel ];
+        float gain = route->gain;
+
+        for( j=0; j<frameCount; ++j )
+            destination[j] += gain * source[j];
+    }
+
+    if( !direction->converter )
+        return direction->mixBufferPtrs;
+
+    for( c=0; c<direction->userChannelCount; ++c )
+    {
+        channel = GetRoutingUserChannel( direction, c, &stride );
+        direction->converter( channel, stride, direction->mixBufferPtrs[c], 1,
+                frameCount, &stage->ditherGenerator );
+    }
+
+    return direction->userIsInterleaved ? direction->userBuffer : (void*)direction->userBufferPtrs;
+}
+
+
+/* Return the buffer which the user's callback writes its output to. */
+static void *PrepareRoutedOutput( PaUtilRoutingStage *stage, void **hostChannels )
+{
+    PaUtilRoutingDirection *direction = &stage->output;
+    unsigned int c;
+
+    if( direction->isPermutation && !direction->userIsInterleaved )
+    {
+        /* the callback writes directly to the host side channels */
+        for( c=0; c<direction->userChannelCount; ++c )
         {
-            result = bytesPerSample;
-            goto error;
+            int hostChannel = direction->hostChannels[c];
+
+            direction->userBufferPtrs[c] = ( hostChannel >= 0 )
+                    ? hostChannels[hostChannel]
+                    : (unsigned char*)direction->userBuffer
+                            + c * direction->framesPerBuffer * direction->bytesPerUserSample;
         }
 
-        bytesPerSample = Pa_GetSampleSize( userOutputSampleFormat );
-        if( bytesPerSample > 0 )
+        return direction->userBufferPtrs;
+    }
+
+    if( !direction->isPermutation && !direction->converter )
+        return direction->mixBufferPtrs;
+
+    return direction->userIsInterleaved ? direction->userBuffer : (void*)direction->userBufferPtrs;
+}
+
+
+/* Write the user output to the non-interleaved host side channels. */
+static void RouteOutput( PaUtilRoutingStage *stage, void **hostChannels,
+        unsigned long frameCount )
+{
+    PaUtilRoutingDirection *direction = &stage->output;
+    unsigned long i, j;
+    unsigned int c, stride;
+    void *channel;
+
+    if( direction->isPermutation )
+    {
+        if( direction->userIsInterleaved )
         {
-            bp->bytesPerUserOutputSample = bytesPerSample;
+            for( c=0; c<direction->userChannelCount; ++c )
+            {
+                if( direction->hostChannels[c] >= 0 )
+                {
+                    channel = GetRoutingUserChannel( direction, c, &stride );
+                    direction->converter( hostChannels[ direction->hostChannels[c] ], 1,
+                            channel, stride, frameCount, &stage->ditherGenerator );
+                }
+            }
         }
-        else
+
+        for( c=0; c<direction->hostChannelCount; ++c )
         {
-            result = bytesPerSample;
-            goto error;
+            if( !direction->hostChannelIsRouted[c] )
+                direction->zeroer( hostChannels[c], 1, frameCount );
         }
 
-        bp->outputConverter =
-            PaUtil_SelectConverter( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
+        return;
+    }
 
-        bp->outputZeroer = PaUtil_SelectZeroer( hostOutputSampleFormat );
+    if( direction->converter )
+    {
+        for( c=0; c<direction->userChannelCount; ++c )
+        {
+            channel = GetRoutingUserChannel( direction, c, &stride );
+            direction->converter( direction->mixBufferPtrs[c], 1, channel, stride,
+                    frameCount, &stage->ditherGenerator );
+        }
+    }
 
-        bp->userOutputIsInterleaved = (userOutputSampleFormat & paNonInterleaved)?0:1;
+    for( c=0; c<direction->hostChannelCount; ++c )
+        memset( hostChannels[c], 0, sizeof(float) * frameCount );
 
-        bp->hostOutputIsInterleaved = (hostOutputSampleFormat & paNonInterleaved)?0:1;
+    for( i=0; i<direction->routeCount; ++i )
+    {
+        const PaChannelRoute *route = &direction->routes[i];
+        const float *source = direction->mixBufferPtrs[ route->userChannel ];
+        float *destination = (float*)hostChannels[ route->deviceChannel ];
+        float gain = route->gain;
 
-        bp->userOutputSampleFormatIsEqualToHost = ((userOutputSampleFormat & ~paNonInterleaved) == (hostOutputSampleFormat & ~paNonInterleaved));
+        for( j=0; j<frameCount; ++j )
+            destination[j] += gain * source[j];
+    }
+}
 
-        tempOutputBufferSize =
-                bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * outputChannelCount;
 
-        bp->tempOutputBuffer = PaUtil_AllocateZeroInitializedMemory( tempOutputBufferSize );
-        if( bp->tempOutputBuffer == 0 )
+/* The stream callback of a buffer processor with routing enabled. The routed
+ directions are non-interleaved. */
+static int RoutingStageCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    PaUtilRoutingStage *stage = (PaUtilRoutingStage*)userData;
+    const void *userInput = input;
+    void *userOutput = output;
+    int result;
+
+    if( stage->input.userChannelCount > 0 )
+        userInput = RouteInput( stage, (void**)input, frameCount );
+
+    if( stage->output.userChannelCount > 0 )
+        userOutput = PrepareRoutedOutput( stage, (void**)output );
+
+    result = stage->streamCallback( userInput, userOutput, frameCount,
+            timeInfo, statusFlags, stage->userData );
+
+    if( stage->output.userChannelCount > 0 )
+        RouteOutput( stage, (void**)output, frameCount );
+
+    return result;
+}
+
+
+PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
+        int inputChannelCount, PaSampleFormat userInputSampleFormat,
+        PaSampleFormat hostInputSampleFormat,
+        int outputChannelCount, PaSampleFormat userOutputSampleFormat,
+        PaSampleFormat hostOutputSampleFormat,
+        double sampleRate,
+        PaStreamFlags streamFlags,
+        unsigned long framesPerUserBuffer,
+        unsigned long framesPerHostBuffer,
+        PaUtilHostBufferSizeMode hostBufferSizeMode,
+        PaStreamCallback *streamCallback, void *userData )
+{
+    PaError result = paNoError;
+    PaError bytesPerSample;
+    unsigned long tempInputBufferSize, tempOutputBufferSize;
+    PaStreamFlags tempInputStreamFlags;
+    PaSampleFormat gainBlockFormat;
+    int i;
+
+    if( streamFlags & paNeverDropInput )
+    {
+        /* paNeverDropInput is only valid for full-duplex callback streams, with an unspecified number of frames per buffer. */
+        if( !streamCallback || !(inputChannelCount > 0 && outputChannelCount > 0) ||
+                framesPerUserBuffer != paFramesPerBufferUnspecified )
+            return paInvalidFlag;
+    }
+
+    /* initialize buffer ptrs to zero so they can be freed if necessary in error */
+    bp->tempInputBuffer = 0;
+    bp->tempInputBufferPtrs = 0;
+    bp->tempOutputBuffer = 0;
+    bp->tempOutputBufferPtrs = 0;
+    bp->tempInputBufferSize = 0;
+    bp->tempInputChannelStrideBytes = 0;
+    bp->tempInputBlockStrideBytes = 0;
+    bp->tempOutputBufferSize = 0;
+    bp->tempOutputChannelStrideBytes = 0;
+    bp->tempOutputBlockStrideBytes = 0;
+    bp->bufferAlignment = PA_TEMP_BUFFER_ALIGNMENT_;
+    bp->frameConverterChannelPtrs = 0;
+    bp->outputChannelDitherGenerators = 0;
+    bp->outputChannelGains = 0;
+    bp->outputGainIsEnabled = 0;
+    bp->outputGainSourceConverter = 0;
+    bp->outputGainConverter = 0;
+    bp->inputFrameConverter = 0;
+    bp->outputFrameConverter = 0;
+    bp->resamplingStage = 0;
+    bp->routingStage = 0;
+    bp->batchCallback = 0;
+    bp->maxBatchBlockCount = 0;
+    bp->batchBlocks = 0;
+    bp->batchInputChannelPtrs = 0;
+    bp->batchOutputChannelPtrs = 0;
+    bp->eventCallback = 0;
+    bp->eventQueueData = 0;
+
+    for( i=0; i<paUtilProcessStageCount; ++i )
+        bp->pendingStageTicks[i] = -1.;
+    bp->stageTicksSequence = 0;
+    memset( bp->stageTicks, 0, sizeof(bp->stageTicks) );
+#if PA_PROCESS_STAGE_TIMING
+    bp->stageTimerStartTicks = ReadStageTimer();
+    bp->stageTimerStartTime = PaUtil_GetTime();
+#else
+    bp->stageTimerStartTicks = 0.;
+    bp->stageTimerStartTime = 0.;
+#endif
+
+    bp->userInputSampleFormat = userInputSampleFormat;
+    bp->hostInputSampleFormat = hostInputSampleFormat;
+    bp->userOutputSampleFormat = userOutputSampleFormat;
+    bp->hostOutputSampleFormat = hostOutputSampleFormat;
+    bp->streamFlags = streamFlags;
+    bp->sampleRate = sampleRate;
+
+    bp->framesPerUserBuffer = framesPerUserBuffer;
+    bp->framesPerHostBuffer = framesPerHostBuffer;
+
+    bp->inputChannelCount = inputChannelCount;
+    bp->outputChannelCount = outputChannelCount;
+
+    bp->hostBufferSizeMode = hostBufferSizeMode;
+
+    bp->hostInputChannels[0] = bp->hostInputChannels[1] = 0;
+    bp->hostOutputChannels[0] = bp->hostOutputChannels[1] = 0;
+
+    if( framesPerUserBuffer == 0 ) /* streamCallback will accept any buffer size */
+    {
+        bp->useNonAdaptingProcess = 1;
+        bp->initialFramesInTempInputBuffer = 0;
+        bp->initialFramesInTempOutputBuffer = 0;
+
+        if( hostBufferSizeMode == paUtilFixedHostBufferSize
+                || hostBufferSizeMode == paUtilBoundedHostBufferSize )
         {
-            result = paInsufficientMemory;
-            goto error;
+            bp->framesPerTempBuffer = framesPerHostBuffer;
         }
-
-        if( bp->framesInTempOutputBuffer > 0 )
+        else /* unknown host buffer size */
         {
-            /* NOTE: we depend on bp->tempOutputBuffer being zero-initialized by the allocator. */
-            /* memset( bp->tempOutputBuffer, 0, tempOutputBufferSize ); */
+            bp->framesPerTempBuffer = PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_;
         }
+    }
+    else
+    {
+        bp->framesPerTempBuffer = framesPerUserBuffer;
 
-        if( userOutputSampleFormat & paNonInterleaved )
+        /* a batched callback is passed user buffers from the FIFOs of the
+            adapting processor, even when the host buffer size is a multiple
+            of the user buffer size */
+        if( hostBufferSizeMode == paUtilFixedHostBufferSize
+                && framesPerHostBuffer % framesPerUserBuffer == 0
+                && !(streamFlags & paBatchUserBuffers) )
         {
-            bp->tempOutputBufferPtrs =
-                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*outputChannelCount );
-            if( bp->tempOutputBufferPtrs == 0 )
+            bp->useNonAdaptingProcess = 1;
+            bp->initialFramesInTempInputBuffer = 0;
+            bp->initialFramesInTempOutputBuffer = 0;
+        }
+        else
+        {
+            unsigned long framesPerHostBufferEstimate = framesPerHostBuffer;
+
+            bp->useNonAdaptingProcess = 0;
+
+            /* the temp buffers are FIFOs which hold the frames of a host buffer,
+                rounded up to whole user buffers, and a partial user buffer at
+                each end */
+            if( framesPerHostBufferEstimate == 0
+                    || hostBufferSizeMode == paUtilUnknownHostBufferSize
+                    || hostBufferSizeMode == paUtilVariableHostBufferSizePartialUsageAllowed )
+                framesPerHostBufferEstimate = PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_;
+
+            bp->framesPerTempBuffer = framesPerUserBuffer *
+                    ((framesPerHostBufferEstimate + framesPerUserBuffer - 1) / framesPerUserBuffer + 2);
+
+            if( inputChannelCount > 0 && outputChannelCount > 0 )
+            {
+                /* full duplex */
+                if( hostBufferSizeMode == paUtilFixedHostBufferSize )
+                {
+                    unsigned long frameShift =
+                        CalculateFrameShift( framesPerHostBuffer, framesPerUserBuffer );
+
+                    if( framesPerUserBuffer > framesPerHostBuffer )
+                    {
+                        bp->initialFramesInTempInputBuffer = frameShift;
+                        bp->initialFramesInTempOutputBuffer = 0;
+                    }
+                    else
+                    {
+                        bp->initialFramesInTempInputBuffer = 0;
+                        bp->initialFramesInTempOutputBuffer = frameShift;
+                    }
+                }
+                else /* variable host buffer size, add framesPerUserBuffer latency */
+                {
+                    bp->initialFramesInTempInputBuffer = 0;
+                    bp->initialFramesInTempOutputBuffer = framesPerUserBuffer;
+                }
+            }
+            else
+            {
+                /* half duplex */
+                bp->initialFramesInTempInputBuffer = 0;
+                bp->initialFramesInTempOutputBuffer = 0;
+            }
+        }
+    }
+
+
+    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
+    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
+    bp->tempInputBufferReadFrame = 0;
+    bp->tempOutputBufferReadFrame = GetInitialTempOutputBufferReadFrame( bp );
+    bp->tempInputBufferCapacity = bp->framesPerTempBuffer;
+    bp->tempOutputBufferCapacity = bp->framesPerTempBuffer;
+
+
+    if( inputChannelCount > 0 )
+    {
+        bytesPerSample = Pa_GetSampleSize( hostInputSampleFormat );
+        if( bytesPerSample > 0 )
+        {
+            bp->bytesPerHostInputSample = bytesPerSample;
+        }
+        else
+        {
+            result = bytesPerSample;
+            goto error;
+        }
+
+        bytesPerSample = Pa_GetSampleSize( userInputSampleFormat );
+        if( bytesPerSample > 0 )
+        {
+            bp->bytesPerUserInputSample = bytesPerSample;
+        }
+        else
+        {
+            result = bytesPerSample;
+            goto error;
+        }
+
+        /* Under the assumption that no ADC in existence delivers better than 24bits resolution,
+            we disable dithering when host input format is paInt32 and user format is paInt24,
+            since the host samples will just be padded with zeros anyway. */
+
+        tempInputStreamFlags = streamFlags;
+        if( !(tempInputStreamFlags & paDitherOff) /* dither is on */
+                && (hostInputSampleFormat & paInt32) /* host input format is int32 */
+                && (userInputSampleFormat & paInt24) /* user requested format is int24 */ ){
+
+            tempInputStreamFlags = tempInputStreamFlags | paDitherOff;
+        }
+
+        bp->inputConverter =
+            PaUtil_SelectConverter( hostInputSampleFormat, userInputSampleFormat, tempInputStreamFlags );
+
+        /* a frame converter only pays off when it can replace more than one
+            per-channel conversion */
+        if( inputChannelCount > 1 )
+            bp->inputFrameConverter =
+                PaUtil_SelectFrameConverter( hostInputSampleFormat, userInputSampleFormat, tempInputStreamFlags );
+
+        bp->inputZeroer = PaUtil_SelectZeroer( userInputSampleFormat );
+
+        bp->userInputIsInterleaved = (userInputSampleFormat & paNonInterleaved)?0:1;
+
+        bp->hostInputIsInterleaved = (hostInputSampleFormat & paNonInterleaved)?0:1;
+
+        bp->userInputSampleFormatIsEqualToHost = ((userInputSampleFormat & ~paNonInterleaved) == (hostInputSampleFormat & ~paNonInterleaved));
+
+        /* pad each user buffer in the FIFO, and each non-interleaved channel,
+            so that every pointer passed to the callback is aligned */
+        bp->tempInputBlockStrideBytes = GetTempBufferBlockStrideBytes( bp,
+                bp->bytesPerUserInputSample * (bp->userInputIsInterleaved ? inputChannelCount : 1) );
+        tempInputBufferSize = GetTempBufferChannelBytes( bp, bp->tempInputBlockStrideBytes );
+        if( userInputSampleFormat & paNonInterleaved )
+        {
+            bp->tempInputChannelStrideBytes = RoundUpToAlignment( tempInputBufferSize,
+                    GetTempBufferAlignment( tempInputBufferSize ) );
+            tempInputBufferSize = bp->tempInputChannelStrideBytes * inputChannelCount;
+        }
+
+        bp->tempInputBufferSize = tempInputBufferSize;
+
+        bp->tempInputBuffer = AllocateAlignedZeroInitializedMemory( tempInputBufferSize,
+                GetTempBufferAlignment( tempInputBufferSize ) );
+        if( bp->tempInputBuffer == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        if( bp->framesInTempInputBuffer > 0 )
+        {
+            /* NOTE: we depend on bp->tempInputBuffer being zero-initialized by the allocator. */
+            /* memset( bp->tempInputBuffer, 0, tempInputBufferSize ); */
+        }
+
+        if( userInputSampleFormat & paNonInterleaved )
+        {
+            bp->tempInputBufferPtrs =
+                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*inputChannelCount );
+            if( bp->tempInputBufferPtrs == 0 )
             {
                 result = paInsufficientMemory;
                 goto error;
             }
         }
 
-        bp->hostOutputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
-        if( bp->hostOutputChannels[0] == 0 )
+        bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
+                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
+        if( bp->hostInputChannels[0] == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        bp->hostInputChannels[1] = &bp->hostInputChannels[0][inputChannelCount];
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        bytesPerSample = Pa_GetSampleSize( hostOutputSampleFormat );
+        if( bytesPerSample > 0 )
+        {
+            bp->bytesPerHostOutputSample = bytesPerSample;
+        }
+        else
+        {
+            result = bytesPerSample;
+            goto error;
+        }
+
+        bytesPerSample = Pa_GetSampleSize( userOutputSampleFormat );
+        if( bytesPerSample > 0 )
+        {
+            bp->bytesPerUserOutputSample = bytesPerSample;
+        }
+        else
+        {
+            result = bytesPerSample;
+            goto error;
+        }
+
+        bp->outputConverter =
+            PaUtil_SelectConverter( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
+
+        if( outputChannelCount > 1 )
+            bp->outputFrameConverter =
+                PaUtil_SelectFrameConverter( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
+
+        bp->outputZeroer = PaUtil_SelectZeroer( hostOutputSampleFormat );
+
+        /* the output gain is applied to blocks of floats, or doubles for
+            formats which have more precision than a float */
+        if( (userOutputSampleFormat & ~paNonInterleaved) == paFloat64
+                || (userOutputSampleFormat & ~paNonInterleaved) == paInt32 )
+            gainBlockFormat = paFloat64;
+        else
+            gainBlockFormat = paFloat32;
+
+        bp->outputGainBlockIsFloat64 = (gainBlockFormat == paFloat64);
+        bp->outputGainSourceConverter =
+            PaUtil_SelectConverter( userOutputSampleFormat, gainBlockFormat, paClipOff | paDitherOff );
+        bp->outputGainConverter =
+            PaUtil_SelectConverter( gainBlockFormat, hostOutputSampleFormat, streamFlags );
+
+        bp->outputGainRampFrames = (unsigned long)(sampleRate * PA_OUTPUT_GAIN_RAMP_SECONDS_);
+        if( bp->outputGainRampFrames == 0 )
+            bp->outputGainRampFrames = 1;
+
+        bp->outputChannelGains = (PaUtilChannelGain *)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(PaUtilChannelGain) * outputChannelCount );
+        if( bp->outputChannelGains == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        for( i=0; i<outputChannelCount; ++i )
+        {
+            bp->outputChannelGains[i].targetGain = 1.0f;
+            bp->outputChannelGains[i].gain = 1.0f;
+            bp->outputChannelGains[i].rampTarget = 1.0f;
+        }
+
+        bp->userOutputIsInterleaved = (userOutputSampleFormat & paNonInterleaved)?0:1;
+
+        bp->hostOutputIsInterleaved = (hostOutputSampleFormat & paNonInterleaved)?0:1;
+
+        bp->userOutputSampleFormatIsEqualToHost = ((userOutputSampleFormat & ~paNonInterleaved) == (hostOutputSampleFormat & ~paNonInterleaved));
+
+        bp->tempOutputBlockStrideBytes = GetTempBufferBlockStrideBytes( bp,
+                bp->bytesPerUserOutputSample * (bp->userOutputIsInterleaved ? outputChannelCount : 1) );
+        tempOutputBufferSize = GetTempBufferChannelBytes( bp, bp->tempOutputBlockStrideBytes );
+        if( userOutputSampleFormat & paNonInterleaved )
+        {
+            bp->tempOutputChannelStrideBytes = RoundUpToAlignment( tempOutputBufferSize,
+                    GetTempBufferAlignment( tempOutputBufferSize ) );
+            tempOutputBufferSize = bp->tempOutputChannelStrideBytes * outputChannelCount;
+        }
+
+        bp->tempOutputBufferSize = tempOutputBufferSize;
+
+        bp->tempOutputBuffer = AllocateAlignedZeroInitializedMemory( tempOutputBufferSize,
+                GetTempBufferAlignment( tempOutputBufferSize ) );
+        if( bp->tempOutputBuffer == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        if( bp->framesInTempOutputBuffer > 0 )
+        {
+            /* NOTE: we depend on bp->tempOutputBuffer being zero-initialized by the allocator. */
+            /* memset( bp->tempOutputBuffer, 0, tempOutputBufferSize ); */
+        }
+
+        if( userOutputSampleFormat & paNonInterleaved )
+        {
+            bp->tempOutputBufferPtrs =
+                (void **)PaUtil_AllocateZeroInitializedMemory( sizeof(void*)*outputChannelCount );
+            if( bp->tempOutputBufferPtrs == 0 )
+            {
+                result = paInsufficientMemory;
+                goto error;
+            }
+        }
+
+        bp->hostOutputChannels[0] = (PaUtilChannelDescriptor*)
+                PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
+        if( bp->hostOutputChannels[0] == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        bp->hostOutputChannels[1] = &bp->hostOutputChannels[0][outputChannelCount];
+    }
+
+    if( bp->inputFrameConverter || bp->outputFrameConverter )
+    {
+        bp->frameConverterChannelPtrs = (void **)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(void*) * ((inputChannelCount > outputChannelCount) ? inputChannelCount : outputChannelCount) );
+        if( bp->frameConverterChannelPtrs == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+    }
+
+    PaUtil_InitializeTriangularDitherState( &bp->ditherGenerator );
+
+    if( outputChannelCount > 0
+            && (streamFlags & paNoiseShapedDither) && !(streamFlags & paDitherOff) )
+    {
+        /* noise shaping feeds back each channel's requantization error, so
+            every channel needs its own state */
+        bp->outputChannelDitherGenerators = (PaUtilTriangularDitherGenerator *)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(PaUtilTriangularDitherGenerator) * outputChannelCount );
+        if( bp->outputChannelDitherGenerators == 0 )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        for( i=0; i<outputChannelCount; ++i )
+            PaUtil_InitializeChannelTriangularDitherState( &bp->outputChannelDitherGenerators[i], i );
+    }
+
+    bp->samplePeriod = 1. / sampleRate;
+
+    bp->streamCallback = streamCallback;
+    bp->userData = userData;
+
+    return result;
+
+error:
+    if( bp->tempInputBuffer )
+        FreeAlignedMemory( bp->tempInputBuffer );
+
+    if( bp->tempInputBufferPtrs )
+        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
+
+    if( bp->hostInputChannels[0] )
+        PaUtil_FreeMemory( bp->hostInputChannels[0] );
+
+    if( bp->tempOutputBuffer )
+        FreeAlignedMemory( bp->tempOutputBuffer );
+
+    if( bp->tempOutputBufferPtrs )
+        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
+
+    if( bp->hostOutputChannels[0] )
+        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+
+    if( bp->frameConverterChannelPtrs )
+        PaUtil_FreeMemory( bp->frameConverterChannelPtrs );
+
+    if( bp->outputChannelDitherGenerators )
+        PaUtil_FreeMemory( bp->outputChannelDitherGenerators );
+
+    if( bp->outputChannelGains )
+        PaUtil_FreeMemory( bp->outputChannelGains );
+
+    return result;
+}
+
+
+void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
+{
+    if( bp->tempInputBuffer )
+        FreeAlignedMemory( bp->tempInputBuffer );
+
+    if( bp->tempInputBufferPtrs )
+        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
+
+    if( bp->hostInputChannels[0] )
+        PaUtil_FreeMemory( bp->hostInputChannels[0] );
+
+    if( bp->tempOutputBuffer )
+        FreeAlignedMemory( bp->tempOutputBuffer );
+
+    if( bp->tempOutputBufferPtrs )
+        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
+
+    if( bp->hostOutputChannels[0] )
+        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+
+    if( bp->frameConverterChannelPtrs )
+        PaUtil_FreeMemory( bp->frameConverterChannelPtrs );
+
+    if( bp->outputChannelDitherGenerators )
+        PaUtil_FreeMemory( bp->outputChannelDitherGenerators );
+
+    if( bp->outputChannelGains )
+        PaUtil_FreeMemory( bp->outputChannelGains );
+
+    if( bp->resamplingStage )
+        FreeResamplingStage( bp->resamplingStage );
+
+    if( bp->routingStage )
+        FreeRoutingStage( bp->routingStage );
+
+    FreeBatchStorage( bp );
+
+    if( bp->eventQueueData )
+        PaUtil_FreeMemory( bp->eventQueueData );
+}
+
+
+void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
+{
+    unsigned int i;
+
+    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
+    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
+    bp->tempInputBufferReadFrame = 0;
+    bp->tempOutputBufferReadFrame = GetInitialTempOutputBufferReadFrame( bp );
+
+    if( bp->framesInTempInputBuffer > 0 )
+    {
+        memset( bp->tempInputBuffer, 0, bp->tempInputBufferSize );
+    }
+
+    if( bp->framesInTempOutputBuffer > 0 )
+    {
+        memset( bp->tempOutputBuffer, 0, bp->tempOutputBufferSize );
+    }
+
+    /* there is no need to ramp to gains which were set while stopped */
+    for( i=0; i<bp->outputChannelCount; ++i )
+    {
+        PaUtilChannelGain *channelGain = &bp->outputChannelGains[i];
+        channelGain->gain = channelGain->rampTarget = LoadGainAcquire( &channelGain->targetGain );
+        channelGain->rampFramesRemaining = 0;
+    }
+
+    if( bp->resamplingStage )
+        ResetResamplingStage( bp->resamplingStage );
+}
+
+
+unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor* bp )
+{
+    return bp->initialFramesInTempInputBuffer;
+}
+
+
+unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bp )
+{
+    return bp->initialFramesInTempOutputBuffer;
+}
+
+
+/* returns the alignment of the host buffers when NonAdaptingProcess() passes
+ them to the callback directly: the alignment of their samples, reduced by
+ the offsets of the blocks it passes from within each host buffer */
+static unsigned long GetDirectHostBufferAlignment( PaUtilBufferProcessor* bp,
+        unsigned int bytesPerHostSample, int hostIsInterleaved, unsigned int channelCount )
+{
+    unsigned long alignment = GetNaturalAlignment( bytesPerHostSample );
+    unsigned long bytesPerFrame = bytesPerHostSample * (hostIsInterleaved ? channelCount : 1);
+
+    /* with a variable user buffer size, or when events split the blocks, a
+        block may start on any frame */
+    if( bp->framesPerUserBuffer != 0 && !bp->eventCallback )
+        bytesPerFrame *= bp->framesPerUserBuffer;
+
+    return PA_MIN_( alignment, GetNaturalAlignment( bytesPerFrame ) );
+}
+
+
+unsigned long PaUtil_GetBufferProcessorBufferAlignment( PaUtilBufferProcessor* bp )
+{
+    unsigned long alignment = bp->bufferAlignment;
+
+    if( bp->routingStage )
+    {
+        if( bp->inputChannelCount > 0 )
+            alignment = PA_MIN_( alignment, GetNaturalAlignment( bp->routingStage->input.bytesPerUserSample ) );
+        if( bp->outputChannelCount > 0 )
+            alignment = PA_MIN_( alignment, GetNaturalAlignment( bp->routingStage->output.bytesPerUserSample ) );
+        return alignment;
+    }
+
+    if( bp->resamplingStage )
+    {
+        if( bp->inputChannelCount > 0 )
+            alignment = PA_MIN_( alignment, GetNaturalAlignment( bp->resamplingStage->bytesPerUserInputSample ) );
+        if( bp->outputChannelCount > 0 )
+            alignment = PA_MIN_( alignment, GetNaturalAlignment( bp->resamplingStage->bytesPerUserOutputSample ) );
+        return alignment;
+    }
+
+    if( !bp->useNonAdaptingProcess )
+        return alignment;
+
+    if( bp->inputChannelCount > 0 && bp->userInputSampleFormatIsEqualToHost
+            && bp->userInputIsInterleaved == bp->hostInputIsInterleaved )
+    {
+        alignment = PA_MIN_( alignment, GetDirectHostBufferAlignment( bp,
+                bp->bytesPerHostInputSample, bp->hostInputIsInterleaved, bp->inputChannelCount ) );
+    }
+
+    if( bp->outputChannelCount > 0 && bp->userOutputSampleFormatIsEqualToHost
+            && bp->userOutputIsInterleaved == bp->hostOutputIsInterleaved )
+    {
+        alignment = PA_MIN_( alignment, GetDirectHostBufferAlignment( bp,
+                bp->bytesPerHostOutputSample, bp->hostOutputIsInterleaved, bp->outputChannelCount ) );
+    }
+
+    return alignment;
+}
+
+
+PaError PaUtil_SetBufferProcessorBatchCallback( PaUtilBufferProcessor* bp,
+        PaStreamBatchCallback *batchCallback )
+{
+    unsigned long maxBlockCount;
+
+    if( !bp->streamCallback )
+        return paIncompatibleStreamHostApi;
+
+    if( !(bp->streamFlags & paBatchUserBuffers) || bp->useNonAdaptingProcess
+            || bp->resamplingStage || bp->routingStage || bp->eventCallback )
+        return paInvalidFlag;
+
+    FreeBatchStorage( bp );
+    bp->batchCallback = 0;
+
+    if( !batchCallback )
+        return paNoError;
+
+    /* the blocks of a batch must be contiguous in each FIFO */
+    if( bp->inputChannelCount > 0 && bp->outputChannelCount > 0 )
+        maxBlockCount = PA_MIN_( bp->tempInputBufferCapacity, bp->tempOutputBufferCapacity );
+    else if( bp->inputChannelCount > 0 )
+        maxBlockCount = bp->tempInputBufferCapacity;
+    else
+        maxBlockCount = bp->tempOutputBufferCapacity;
+    maxBlockCount /= bp->framesPerUserBuffer;
+
+    bp->batchBlocks = (PaStreamCallbackBlock*)PaUtil_AllocateZeroInitializedMemory(
+            sizeof(PaStreamCallbackBlock) * maxBlockCount );
+    if( !bp->batchBlocks )
+        goto error;
+
+    if( bp->inputChannelCount > 0 && !bp->userInputIsInterleaved )
+    {
+        bp->batchInputChannelPtrs = (void**)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(void*) * maxBlockCount * bp->inputChannelCount );
+        if( !bp->batchInputChannelPtrs )
+            goto error;
+    }
+
+    if( bp->outputChannelCount > 0 && !bp->userOutputIsInterleaved )
+    {
+        bp->batchOutputChannelPtrs = (void**)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(void*) * maxBlockCount * bp->outputChannelCount );
+        if( !bp->batchOutputChannelPtrs )
+            goto error;
+    }
+
+    bp->maxBatchBlockCount = maxBlockCount;
+    bp->batchCallback = batchCallback;
+
+    return paNoError;
+
+error:
+    FreeBatchStorage( bp );
+
+    return paInsufficientMemory;
+}
+
+
+PaError PaUtil_SetBufferProcessorEventCallback( PaUtilBufferProcessor* bp,
+        PaStreamEventCallback *eventCallback, unsigned long maxPendingEvents )
+{
+    if( !bp->streamCallback )
+        return paIncompatibleStreamHostApi;
+
+    if( bp->resamplingStage || bp->routingStage || bp->batchCallback )
+        return paInvalidFlag;
+
+    bp->eventCallback = 0;
+    if( bp->eventQueueData )
+        PaUtil_FreeMemory( bp->eventQueueData );
+    bp->eventQueueData = 0;
+
+    if( !eventCallback )
+        return paNoError;
+
+    if( maxPendingEvents == 0 )
+        return paBufferTooSmall;
+
+    /* the queue's indices and the size of its memory must not overflow */
+    if( maxPendingEvents > PA_RINGBUFFER_MAX_ELEMENT_COUNT
+            || maxPendingEvents > (unsigned long)LONG_MAX / sizeof(PaStreamEvent) )
+        return paInsufficientMemory;
+
+    bp->eventQueueData = PaUtil_AllocateZeroInitializedMemory( (long)(sizeof(PaStreamEvent) * maxPendingEvents) );
+    if( !bp->eventQueueData )
+        return paInsufficientMemory;
+
+    if( PaUtil_InitializeRingBuffer( &bp->eventQueue, sizeof(PaStreamEvent),
+            (ring_buffer_size_t)maxPendingEvents, bp->eventQueueData ) != 0 )
+    {
+        PaUtil_FreeMemory( bp->eventQueueData );
+        bp->eventQueueData = 0;
+        return paInternalError;
+    }
+    bp->eventCallback = eventCallback;
+
+    return paNoError;
+}
+
+
+PaError PaUtil_PostBufferProcessorEvent( PaUtilBufferProcessor* bp,
+        const PaStreamEvent *event )
+{
+    if( !bp->eventCallback )
+        return paNullCallback;
+
+    if( PaUtil_WriteRingBuffer( &bp->eventQueue, event, 1 ) == 0 )
+        return paStreamEventQueueFull;
+
+    return paNoError;
+}
+
+
+PaError PaUtil_GetBufferProcessorStageTimes( PaUtilBufferProcessor* bp,
+        PaStreamProcessingTimes *times )
+{
+#if PA_PROCESS_STAGE_TIMING
+    PaUtilStageTicks stageTicks[paUtilProcessStageCount];
+    PaStreamStageTime *stageTimes[paUtilProcessStageCount];
+    unsigned long sequence;
+    double ticksPerSecond;
+    int i;
+
+    /* retry if the processing thread published new times while copying */
+    do{
+        sequence = bp->stageTicksSequence;
+        PaUtil_ReadMemoryBarrier();
+        memcpy( stageTicks, bp->stageTicks, sizeof(stageTicks) );
+        PaUtil_ReadMemoryBarrier();
+    }while( (sequence & 1) != 0 || sequence != bp->stageTicksSequence );
+
+#if defined(PA_STAGE_TIMER_USES_TSC_)
+    /* calibrate the cycle counter against the clock since initialization */
+    ticksPerSecond = PaUtil_GetTime() - bp->stageTimerStartTime;
+    ticksPerSecond = ( ticksPerSecond > 0. )
+            ? (ReadStageTimer() - bp->stageTimerStartTicks) / ticksPerSecond
+            : 1e9;
+#else
+    ticksPerSecond = 1e9;
+#endif
+
+    stageTimes[paUtilInputConversionStage] = &times->inputConversion;
+    stageTimes[paUtilCallbackStage] = &times->callback;
+    stageTimes[paUtilOutputConversionStage] = &times->outputConversion;
+
+    for( i=0; i<paUtilProcessStageCount; ++i )
+    {
+        stageTimes[i]->count = stageTicks[i].count;
+        stageTimes[i]->total = stageTicks[i].total / ticksPerSecond;
+        stageTimes[i]->maximum = stageTicks[i].maximum / ticksPerSecond;
+        stageTimes[i]->last = stageTicks[i].last / ticksPerSecond;
+    }
+
+    return paNoError;
+#else
+    (void)bp;
+    memset( times, 0, sizeof(PaStreamProcessingTimes) );
+    return paIncompatibleStreamHostApi;
+#endif
+}
+
+
+PaError PaUtil_SetBufferProcessorOutputGain( PaUtilBufferProcessor* bp,
+        unsigned int channel, float gain )
+{
+    if( channel >= bp->outputChannelCount )
+        return paInvalidChannelCount;
+
+    if( !bp->outputGainSourceConverter || !bp->outputGainConverter )
+        return paSampleFormatNotSupported;
+
+    StoreGainRelease( &bp->outputChannelGains[channel].targetGain, gain );
+    StoreFlagRelease( &bp->outputGainIsEnabled, 1 );
+
+    return paNoError;
+}
+
+
+PaError PaUtil_EnableBufferProcessorResampling( PaUtilBufferProcessor* bp,
+        double userSampleRate, unsigned long framesPerUserBuffer, PaUtilResamplerQuality quality )
+{
+    PaError result;
+    PaUtilBufferProcessor hostBp;
+    PaUtilResamplingStage *stage;
+    double hostSampleRate = bp->sampleRate;
+    double inputFilterFrames = 0., outputFilterFrames = 0.;
+    unsigned long maxInputFramesPerWrite;
+
+    if( !bp->streamCallback || bp->resamplingStage || bp->batchCallback || bp->eventCallback )
+        return paInvalidSampleRate;
+
+    if( userSampleRate <= 0. )
+        return paInvalidSampleRate;
+
+    stage = (PaUtilResamplingStage*)PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilResamplingStage) );
+    if( !stage )
+        return paInsufficientMemory;
+
+    /* the host side of the stage converts the host buffers to and from
+        non-interleaved Float32, with any buffer size */
+    result = PaUtil_InitializeBufferProcessor( &hostBp,
+            bp->inputChannelCount, paFloat32 | paNonInterleaved, bp->hostInputSampleFormat,
+            bp->outputChannelCount, paFloat32 | paNonInterleaved, bp->hostOutputSampleFormat,
+            hostSampleRate, bp->streamFlags, paFramesPerBufferUnspecified,
+            bp->framesPerHostBuffer, bp->hostBufferSizeMode,
+            ResamplingStageCallback, stage );
+    if( result != paNoError )
+    {
+        PaUtil_FreeMemory( stage );
+        return result;
+    }
+
+    if( framesPerUserBuffer == paFramesPerBufferUnspecified )
+        framesPerUserBuffer = (unsigned long)ceil( hostBp.framesPerTempBuffer * userSampleRate / hostSampleRate );
+
+    stage->streamCallback = bp->streamCallback;
+    stage->userData = bp->userData;
+    stage->userSampleRate = userSampleRate;
+    stage->framesPerUserBuffer = framesPerUserBuffer;
+    stage->inputChannelCount = bp->inputChannelCount;
+    stage->outputChannelCount = bp->outputChannelCount;
+    PaUtil_InitializeTriangularDitherState( &stage->ditherGenerator );
+
+    if( bp->inputChannelCount > 0 )
+    {
+        /* the user's callback is only called once a full user buffer can be
+            read, so up to one user buffer of host frames may still be in the
+            history when the next host buffer is written. The resampler adds
+            room for the filter length. */
+        maxInputFramesPerWrite = hostBp.framesPerTempBuffer
+                + (unsigned long)ceil( framesPerUserBuffer * hostSampleRate / userSampleRate ) + 1;
+
+        /* in full duplex, initialize the input resampler once to find the
+            filter length, which determines the output priming, which in turn
+            determines the input buffer capacity */
+        result = PaUtil_InitializeResampler( &stage->inputResampler, bp->inputChannelCount,
+                hostSampleRate, userSampleRate, quality, maxInputFramesPerWrite );
+        if( result != paNoError )
+            goto error;
+
+        inputFilterFrames = PaUtil_GetResamplerLatencyFrames( &stage->inputResampler );
+    }
+
+    if( bp->inputChannelCount > 0 && bp->outputChannelCount > 0 )
+    {
+        /* in full duplex the output resampler is primed with enough silence
+            that a full buffer of input is always available when the output
+            resampler needs more frames from the user's callback. The output
+            filter delay is added below. */
+        stage->primingFrames = framesPerUserBuffer
+                + (unsigned long)ceil( inputFilterFrames * userSampleRate / hostSampleRate ) + 2;
+    }
+
+    if( bp->outputChannelCount > 0 )
+    {
+        result = PaUtil_InitializeResampler( &stage->outputResampler, bp->outputChannelCount,
+                userSampleRate, hostSampleRate, quality,
+                PA_MAX_( framesPerUserBuffer, stage->primingFrames ) );
+        if( result != paNoError )
+            goto error;
+
+        outputFilterFrames = PaUtil_GetResamplerLatencyFrames( &stage->outputResampler );
+    }
+
+    if( bp->inputChannelCount > 0 && bp->outputChannelCount > 0 )
+    {
+        /* the history buffer has room for the extra frames, which are all
+            written by ResetResamplingStage() */
+        stage->primingFrames += (unsigned long)ceil( outputFilterFrames );
+
+        maxInputFramesPerWrite = hostBp.framesPerTempBuffer + (unsigned long)ceil(
+                (2 * framesPerUserBuffer + stage->primingFrames) * hostSampleRate / userSampleRate );
+
+        PaUtil_TerminateResampler( &stage->inputResampler );
+        result = PaUtil_InitializeResampler( &stage->inputResampler, bp->inputChannelCount,
+                hostSampleRate, userSampleRate, quality, maxInputFramesPerWrite );
+        if( result != paNoError )
+            goto error;
+    }
+
+    if( bp->inputChannelCount > 0 )
+    {
+        result = AllocateResamplingStageBuffers( bp->inputChannelCount, framesPerUserBuffer,
+                bp->userInputSampleFormat, &stage->inputBlock, &stage->inputBlockPtrs,
+                &stage->userInputBuffer, &stage->userInputBufferPtrs, &stage->userInput,
+                &stage->bytesPerUserInputSample, &stage->userInputIsInterleaved );
+        if( result != paNoError )
+            goto error;
+
+        if( stage->userInputBuffer )
+        {
+            stage->inputConverter = PaUtil_SelectConverter( paFloat32,
+                    bp->userInputSampleFormat, bp->streamFlags );
+            if( !stage->inputConverter )
+            {
+                result = paSampleFormatNotSupported;
+                goto error;
+            }
+        }
+
+        /* in full duplex the input is delayed by the frames which are
+            buffered while the output primed with silence is played */
+        stage->inputLatency = inputFilterFrames / hostSampleRate + ( stage->primingFrames > 0
+                ? (stage->primingFrames - outputFilterFrames) : framesPerUserBuffer ) / userSampleRate;
+    }
+
+    if( bp->outputChannelCount > 0 )
+    {
+        result = AllocateResamplingStageBuffers( bp->outputChannelCount, framesPerUserBuffer,
+                bp->userOutputSampleFormat, &stage->outputBlock, &stage->outputBlockPtrs,
+                &stage->userOutputBuffer, &stage->userOutputBufferPtrs, &stage->userOutput,
+                &stage->bytesPerUserOutputSample, &stage->userOutputIsInterleaved );
+        if( result != paNoError )
+            goto error;
+
+        if( stage->userOutputBuffer )
+        {
+            stage->outputConverter = PaUtil_SelectConverter( bp->userOutputSampleFormat,
+                    paFloat32, paClipOff | paDitherOff );
+            if( !stage->outputConverter )
+            {
+                result = paSampleFormatNotSupported;
+                goto error;
+            }
+        }
+
+        stage->hostOutputPtrs = (float**)PaUtil_AllocateZeroInitializedMemory(
+                sizeof(float*) * bp->outputChannelCount );
+        if( !stage->hostOutputPtrs )
         {
             result = paInsufficientMemory;
             goto error;
         }
 
-        bp->hostOutputChannels[1] = &bp->hostOutputChannels[0][outputChannelCount];
+        stage->outputLatency = (framesPerUserBuffer + outputFilterFrames) / userSampleRate;
     }
 
-    PaUtil_InitializeTriangularDitherState( &bp->ditherGenerator );
-
-    bp->samplePeriod = 1. / sampleRate;
-
-    bp->streamCallback = streamCallback;
-    bp->userData = userData;
+    /* replace the buffer processor with the host side of the stage */
+    PaUtil_TerminateBufferProcessor( bp );
+    *bp = hostBp;
+    bp->resamplingStage = stage;
+    ResetResamplingStage( stage );
 
-    return result;
+    return paNoError;
 
 error:
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
-
+    PaUtil_TerminateBufferProcessor( &hostBp );
+    FreeResamplingStage( stage );
     return result;
 }
 
 
-void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
+PaTime PaUtil_GetBufferProcessorResamplingInputLatency( PaUtilBufferProcessor* bp )
 {
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    return bp->resamplingStage ? bp->resamplingStage->inputLatency : 0.;
 }
 
 
-void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
+PaTime PaUtil_GetBufferProcessorResamplingOutputLatency( PaUtilBufferProcessor* bp )
 {
-    unsigned long tempInputBufferSize, tempOutputBufferSize;
-
-    bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
-    bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
-
-    if( bp->framesInTempInputBuffer > 0 )
-    {
-        tempInputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserInputSample * bp->inputChannelCount;
-        memset( bp->tempInputBuffer, 0, tempInputBufferSize );
-    }
-
-    if( bp->framesInTempOutputBuffer > 0 )
-    {
-        tempOutputBufferSize =
-            bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * bp->outputChannelCount;
-        memset( bp->tempOutputBuffer, 0, tempOutputBufferSize );
-    }
+    return bp->resamplingStage ? bp->resamplingStage->outputLatency : 0.;
 }
 
 
-unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor* bp )
+PaError PaUtil_EnableBufferProcessorRouting( PaUtilBufferProcessor* bp,
+        int userInputChannelCount, const PaChannelRoute *inputRoutes, unsigned long inputRouteCount,
+        int userOutputChannelCount, const PaChannelRoute *outputRoutes, unsigned long outputRouteCount )
 {
-    return bp->initialFramesInTempInputBuffer;
-}
+    PaError result;
+    PaUtilBufferProcessor routedBp;
+    PaUtilRoutingStage *stage;
+    PaStreamCallback *streamCallback = bp->streamCallback;
+    void *userData = bp->userData;
+    PaSampleFormat userInputSampleFormat = bp->userInputSampleFormat;
+    PaSampleFormat userOutputSampleFormat = bp->userOutputSampleFormat;
+
+    if( !bp->streamCallback )
+        return paIncompatibleStreamHostApi;
+
+    if( bp->resamplingStage || bp->batchCallback || bp->eventCallback )
+        return paInvalidFlag;
+
+    if( userInputChannelCount < 0 || userOutputChannelCount < 0
+            || (userInputChannelCount > 0 && bp->inputChannelCount == 0)
+            || (userOutputChannelCount > 0 && bp->outputChannelCount == 0)
+            || (inputRouteCount > 0 && !inputRoutes)
+            || (outputRouteCount > 0 && !outputRoutes) )
+        return paInvalidChannelCount;
+
+    if( bp->routingStage )
+    {
+        /* replace the existing routing */
+        streamCallback = bp->routingStage->streamCallback;
+        userData = bp->routingStage->userData;
+        userInputSampleFormat = bp->routingStage->input.userSampleFormat;
+        userOutputSampleFormat = bp->routingStage->output.userSampleFormat;
+    }
 
+    stage = (PaUtilRoutingStage*)PaUtil_AllocateZeroInitializedMemory( sizeof(PaUtilRoutingStage) );
+    if( !stage )
+        return paInsufficientMemory;
+
+    stage->streamCallback = streamCallback;
+    stage->userData = userData;
+    PaUtil_InitializeTriangularDitherState( &stage->ditherGenerator );
+
+    result = InitializeRoutingDirection( &stage->input, userInputChannelCount,
+            bp->inputChannelCount, userInputSampleFormat, inputRoutes, inputRouteCount,
+            bp->framesPerTempBuffer, 1, bp->streamFlags );
+    if( result != paNoError )
+        goto error;
+
+    result = InitializeRoutingDirection( &stage->output, userOutputChannelCount,
+            bp->outputChannelCount, userOutputSampleFormat, outputRoutes, outputRouteCount,
+            bp->framesPerTempBuffer, 0, bp->streamFlags );
+    if( result != paNoError )
+        goto error;
+
+    result = PaUtil_InitializeBufferProcessor( &routedBp,
+            bp->inputChannelCount, stage->input.hostSideSampleFormat, bp->hostInputSampleFormat,
+            bp->outputChannelCount, stage->output.hostSideSampleFormat, bp->hostOutputSampleFormat,
+            bp->sampleRate, bp->streamFlags, bp->framesPerUserBuffer,
+            bp->framesPerHostBuffer, bp->hostBufferSizeMode,
+            RoutingStageCallback, stage );
+    if( result != paNoError )
+        goto error;
+
+    /* the temp buffers hold the same number of frames, so the stage's
+        buffers are large enough for every callback */
+    assert( routedBp.framesPerTempBuffer == bp->framesPerTempBuffer );
+
+    PaUtil_TerminateBufferProcessor( bp );
+    *bp = routedBp;
+    bp->routingStage = stage;
+
+    return paNoError;
 
-unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bp )
-{
-    return bp->initialFramesInTempOutputBuffer;
+error:
+    FreeRoutingStage( stage );
+    return result;
 }
 
 
@@ -647,54 +2330,416 @@ void PaUtil_Set2ndInterleavedOutputChannels( PaUtilBufferProcessor* bp,
     unsigned int channel = firstChannel;
     unsigned char *p = (unsigned char*)data;
 
-    if( channelCount == 0 )
-        channelCount = bp->outputChannelCount;
+    if( channelCount == 0 )
+        channelCount = bp->outputChannelCount;
+
+    assert( firstChannel < bp->outputChannelCount );
+    assert( firstChannel + channelCount <= bp->outputChannelCount );
+    assert( bp->hostOutputIsInterleaved );
+
+    for( i=0; i< channelCount; ++i )
+    {
+        PaUtil_Set2ndOutputChannel( bp, channel + i, p, channelCount );
+        p += bp->bytesPerHostOutputSample;
+    }
+}
+
+
+void PaUtil_Set2ndNonInterleavedOutputChannel( PaUtilBufferProcessor* bp,
+        unsigned int channel, void *data )
+{
+    assert( channel < bp->outputChannelCount );
+    assert( !bp->hostOutputIsInterleaved );
+
+    PaUtil_Set2ndOutputChannel( bp, channel, data, 1 );
+}
+
+
+void PaUtil_BeginBufferProcessing( PaUtilBufferProcessor* bp,
+        PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags callbackStatusFlags )
+{
+    bp->timeInfo = timeInfo;
+
+    /* the first streamCallback will be called to process samples which are
+        currently in the input buffer before the ones starting at the timeInfo time */
+
+    bp->timeInfo->inputBufferAdcTime -= bp->framesInTempInputBuffer * bp->samplePeriod;
+
+    /* We just pass through timeInfo->currentTime provided by the caller. This is
+        not strictly conformant to the word of the spec, since the buffer processor
+        might call the callback multiple times, and we never refresh currentTime. */
+
+    /* the first streamCallback will be called to generate samples which will be
+        outputted after the frames currently in the output buffer have been
+        outputted. */
+    bp->timeInfo->outputBufferDacTime += bp->framesInTempOutputBuffer * bp->samplePeriod;
+
+    bp->callbackStatusFlags = callbackStatusFlags;
+
+    bp->hostInputFrameCount[1] = 0;
+    bp->hostOutputFrameCount[1] = 0;
+}
+
+
+/*
+    HostChannelsSuitFrameConverter() returns non-zero if the host channel
+    descriptors can be handed to a frame converter: interleaved host channels
+    must describe a single buffer with all channels in order, non-interleaved
+    host channels must have a stride of one sample.
+*/
+static int HostChannelsSuitFrameConverter( PaUtilChannelDescriptor *hostChannels,
+        unsigned int channelCount, unsigned int bytesPerHostSample, int hostIsInterleaved )
+{
+    unsigned int i;
+
+    if( hostIsInterleaved )
+    {
+        for( i=0; i<channelCount; ++i )
+        {
+            if( hostChannels[i].stride != channelCount
+                    || hostChannels[i].data != ((unsigned char*)hostChannels[0].data) + i * bytesPerHostSample )
+                return 0;
+        }
+    }
+    else
+    {
+        for( i=0; i<channelCount; ++i )
+        {
+            if( hostChannels[i].stride != 1 )
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/*
+    ConvertInputChannels() converts frameCount frames from the host input
+    channels into the user input buffer, and advances the host channel
+    pointers. The user buffer is either described by destBytePtr,
+    destSampleStrideSamples and destChannelStrideBytes, or if destChannelPtrs
+    is not NULL, by an array of non-interleaved channel pointers.
+    When the user and host differ in interleaving, all channels are converted
+    in a single pass by the frame converter, otherwise each channel is
+    converted separately.
+*/
+static void ConvertInputChannels( PaUtilBufferProcessor *bp,
+        PaUtilChannelDescriptor *hostInputChannels,
+        unsigned char *destBytePtr, unsigned int destSampleStrideSamples,
+        unsigned int destChannelStrideBytes, void **destChannelPtrs,
+        unsigned long frameCount )
+{
+    unsigned int i;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
+
+    PA_START_STAGE_TIMER_( stageStartTicks );
+
+    if( bp->inputFrameConverter
+            && HostChannelsSuitFrameConverter( hostInputChannels, bp->inputChannelCount,
+                    bp->bytesPerHostInputSample, bp->hostInputIsInterleaved ) )
+    {
+        if( bp->hostInputIsInterleaved )
+        {
+            /* deinterleave into the non-interleaved user buffer */
+            if( !destChannelPtrs )
+            {
+                destChannelPtrs = bp->frameConverterChannelPtrs;
+                for( i=0; i<bp->inputChannelCount; ++i )
+                    destChannelPtrs[i] = destBytePtr + i * destChannelStrideBytes;
+            }
+
+            bp->inputFrameConverter( hostInputChannels[0].data, destChannelPtrs,
+                    bp->inputChannelCount, frameCount, &bp->ditherGenerator );
+        }
+        else
+        {
+            /* interleave the non-interleaved host channels into the user buffer */
+            for( i=0; i<bp->inputChannelCount; ++i )
+                bp->frameConverterChannelPtrs[i] = hostInputChannels[i].data;
+
+            bp->inputFrameConverter( destBytePtr, bp->frameConverterChannelPtrs,
+                    bp->inputChannelCount, frameCount, &bp->ditherGenerator );
+        }
+
+        for( i=0; i<bp->inputChannelCount; ++i )
+        {
+            /* advance src ptr for next iteration */
+            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+        }
+    }
+    else
+    {
+        for( i=0; i<bp->inputChannelCount; ++i )
+        {
+            bp->inputConverter( destChannelPtrs ? destChannelPtrs[i] : destBytePtr,
+                                    destSampleStrideSamples,
+                                    hostInputChannels[i].data,
+                                    hostInputChannels[i].stride,
+                                    frameCount, &bp->ditherGenerator );
+
+            destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
+
+            /* advance src ptr for next iteration */
+            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+        }
+    }
+
+    PA_STOP_STAGE_TIMER_( bp, paUtilInputConversionStage, stageStartTicks );
+}
+
+
+/*
+    ApplyOutputGain() and ApplyOutputGainFloat64() scale count samples by the
+    channel gain, advancing any ramp in progress.
+*/
+static void ApplyOutputGain( PaUtilChannelGain *channelGain,
+        float *samples, unsigned long count )
+{
+    float gain = channelGain->gain;
+    unsigned long i = 0;
+
+    while( channelGain->rampFramesRemaining > 0 && i < count )
+    {
+        gain += channelGain->rampIncrement;
+        samples[i++] *= gain;
+
+        if( --channelGain->rampFramesRemaining == 0 )
+            gain = channelGain->rampTarget; /* don't accumulate rounding errors */
+    }
+
+    for( ; i < count; ++i )
+        samples[i] *= gain;
+
+    channelGain->gain = gain;
+}
+
+
+static void ApplyOutputGainFloat64( PaUtilChannelGain *channelGain,
+        double *samples, unsigned long count )
+{
+    float gain = channelGain->gain;
+    unsigned long i = 0;
+
+    while( channelGain->rampFramesRemaining > 0 && i < count )
+    {
+        gain += channelGain->rampIncrement;
+        samples[i++] *= gain;
+
+        if( --channelGain->rampFramesRemaining == 0 )
+            gain = channelGain->rampTarget;
+    }
+
+    for( ; i < count; ++i )
+        samples[i] *= gain;
+
+    channelGain->gain = gain;
+}
+
+
+/*
+    ConvertOutputChannelWithGain() converts frameCount samples of one output
+    channel in the same way as bp->outputConverter, scaling them by the
+    channel's gain. Rather than making an extra pass over the user buffer, the
+    samples are processed in blocks which stay in the cache: each block is
+    converted to float (or double), scaled in place, and converted to the host
+    format. Channels with a gain of one or zero are converted or zeroed
+    directly.
+*/
+static void ConvertOutputChannelWithGain( PaUtilBufferProcessor *bp,
+        PaUtilChannelGain *channelGain,
+        void *destination, unsigned int destinationStride,
+        void *source, unsigned int sourceStride,
+        unsigned long frameCount, PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double block[PA_OUTPUT_GAIN_BLOCK_SIZE_]; /* holds floats or doubles */
+    unsigned char *destBytePtr = (unsigned char*)destination;
+    unsigned char *srcBytePtr = (unsigned char*)source;
+    float targetGain = LoadGainAcquire( &channelGain->targetGain );
+    unsigned long blockCount;
+
+    if( targetGain != channelGain->rampTarget )
+    {
+        /* start ramping from the current gain to the new gain */
+        channelGain->rampTarget = targetGain;
+        channelGain->rampIncrement = (targetGain - channelGain->gain) / bp->outputGainRampFrames;
+        channelGain->rampFramesRemaining = bp->outputGainRampFrames;
+    }
+
+    if( channelGain->rampFramesRemaining == 0 )
+    {
+        if( channelGain->gain == 1.0f )
+        {
+            bp->outputConverter( destination, destinationStride, source, sourceStride,
+                    frameCount, ditherGenerator );
+            return;
+        }
+        else if( channelGain->gain == 0.0f )
+        {
+            bp->outputZeroer( destination, destinationStride, frameCount );
+            return;
+        }
+    }
+
+    while( frameCount > 0 )
+    {
+        blockCount = PA_MIN_( frameCount, PA_OUTPUT_GAIN_BLOCK_SIZE_ );
+
+        bp->outputGainSourceConverter( block, 1, srcBytePtr, sourceStride,
+                blockCount, ditherGenerator );
+
+        if( bp->outputGainBlockIsFloat64 )
+            ApplyOutputGainFloat64( channelGain, block, blockCount );
+        else
+            ApplyOutputGain( channelGain, (float*)block, blockCount );
+
+        bp->outputGainConverter( destBytePtr, destinationStride, block, 1,
+                blockCount, ditherGenerator );
+
+        srcBytePtr += blockCount * sourceStride * bp->bytesPerUserOutputSample;
+        destBytePtr += blockCount * destinationStride * bp->bytesPerHostOutputSample;
+        frameCount -= blockCount;
+    }
+}
+
+
+/*
+    ConvertOutputChannels() converts frameCount frames from the user output
+    buffer into the host output channels, and advances the host channel
+    pointers. The user buffer is either described by srcBytePtr,
+    srcSampleStrideSamples and srcChannelStrideBytes, or if srcChannelPtrs
+    is not NULL, by an array of non-interleaved channel pointers.
+    When the user and host differ in interleaving, all channels are converted
+    in a single pass by the frame converter, otherwise each channel is
+    converted separately. Once an output gain has been set, each channel is
+    converted separately by ConvertOutputChannelWithGain().
+*/
+static void ConvertOutputChannels( PaUtilBufferProcessor *bp,
+        PaUtilChannelDescriptor *hostOutputChannels,
+        unsigned char *srcBytePtr, unsigned int srcSampleStrideSamples,
+        unsigned int srcChannelStrideBytes, void **srcChannelPtrs,
+        unsigned long frameCount )
+{
+    unsigned int i;
+    int applyGain = LoadFlagAcquire( &bp->outputGainIsEnabled );
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
+
+    PA_START_STAGE_TIMER_( stageStartTicks );
+
+    if( !applyGain && bp->outputFrameConverter
+            && HostChannelsSuitFrameConverter( hostOutputChannels, bp->outputChannelCount,
+                    bp->bytesPerHostOutputSample, bp->hostOutputIsInterleaved ) )
+    {
+        if( bp->hostOutputIsInterleaved )
+        {
+            /* interleave the non-interleaved user buffer into the host buffer */
+            if( !srcChannelPtrs )
+            {
+                srcChannelPtrs = bp->frameConverterChannelPtrs;
+                for( i=0; i<bp->outputChannelCount; ++i )
+                    srcChannelPtrs[i] = srcBytePtr + i * srcChannelStrideBytes;
+            }
+
+            bp->outputFrameConverter( hostOutputChannels[0].data, srcChannelPtrs,
+                    bp->outputChannelCount, frameCount, &bp->ditherGenerator );
+        }
+        else
+        {
+            /* deinterleave the user buffer into the non-interleaved host channels */
+            for( i=0; i<bp->outputChannelCount; ++i )
+                bp->frameConverterChannelPtrs[i] = hostOutputChannels[i].data;
+
+            bp->outputFrameConverter( srcBytePtr, bp->frameConverterChannelPtrs,
+                    bp->outputChannelCount, frameCount, &bp->ditherGenerator );
+        }
+
+        for( i=0; i<bp->outputChannelCount; ++i )
+        {
+            /* advance dest ptr for next iteration */
+            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                    frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+        }
+    }
+    else
+    {
+        for( i=0; i<bp->outputChannelCount; ++i )
+        {
+            PaUtilTriangularDitherGenerator *ditherGenerator = bp->outputChannelDitherGenerators
+                    ? &bp->outputChannelDitherGenerators[i]
+                    : &bp->ditherGenerator;
+
+            if( applyGain )
+            {
+                ConvertOutputChannelWithGain( bp, &bp->outputChannelGains[i],
+                                    hostOutputChannels[i].data,
+                                    hostOutputChannels[i].stride,
+                                    srcChannelPtrs ? srcChannelPtrs[i] : srcBytePtr,
+                                    srcSampleStrideSamples,
+                                    frameCount, ditherGenerator );
+            }
+            else
+            {
+                bp->outputConverter(    hostOutputChannels[i].data,
+                                        hostOutputChannels[i].stride,
+                                        srcChannelPtrs ? srcChannelPtrs[i] : srcBytePtr,
+                                        srcSampleStrideSamples,
+                                        frameCount, ditherGenerator );
+            }
 
-    assert( firstChannel < bp->outputChannelCount );
-    assert( firstChannel + channelCount <= bp->outputChannelCount );
-    assert( bp->hostOutputIsInterleaved );
+            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
-    for( i=0; i< channelCount; ++i )
-    {
-        PaUtil_Set2ndOutputChannel( bp, channel + i, p, channelCount );
-        p += bp->bytesPerHostOutputSample;
+            /* advance dest ptr for next iteration */
+            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                    frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+        }
     }
-}
-
-
-void PaUtil_Set2ndNonInterleavedOutputChannel( PaUtilBufferProcessor* bp,
-        unsigned int channel, void *data )
-{
-    assert( channel < bp->outputChannelCount );
-    assert( !bp->hostOutputIsInterleaved );
 
-    PaUtil_Set2ndOutputChannel( bp, channel, data, 1 );
+    PA_STOP_STAGE_TIMER_( bp, paUtilOutputConversionStage, stageStartTicks );
 }
 
 
-void PaUtil_BeginBufferProcessing( PaUtilBufferProcessor* bp,
-        PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags callbackStatusFlags )
+/*
+    DispatchStreamEvents() passes the queued events which fall within the next
+    frameCount frames to the eventCallback, and returns the number of frames
+    the streamCallback should be called with. When canSplit is non-zero the
+    buffer is ended at the first event which doesn't fall on its first frame,
+    otherwise all of the events are delivered with their offset into the buffer.
+    Events are assumed to be posted in time order, and late events are delivered
+    at offset 0.
+*/
+static unsigned long DispatchStreamEvents( PaUtilBufferProcessor *bp,
+        unsigned long frameCount, int canSplit )
 {
-    bp->timeInfo = timeInfo;
-
-    /* the first streamCallback will be called to process samples which are
-        currently in the input buffer before the ones starting at the timeInfo time */
+    PaTime bufferTime = ( bp->outputChannelCount > 0 )
+            ? bp->timeInfo->outputBufferDacTime : bp->timeInfo->inputBufferAdcTime;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+    const PaStreamEvent *event;
+    unsigned long frameOffset;
+
+    while( PaUtil_GetRingBufferReadRegions( &bp->eventQueue, 1,
+            &data1, &size1, &data2, &size2 ) == 1 )
+    {
+        event = (const PaStreamEvent*)data1;
 
-    bp->timeInfo->inputBufferAdcTime -= bp->framesInTempInputBuffer * bp->samplePeriod;
+        if( event->time <= bufferTime )
+            frameOffset = 0;
+        else
+            frameOffset = (unsigned long)floor( (event->time - bufferTime) * bp->sampleRate + .5 );
 
-    /* We just pass through timeInfo->currentTime provided by the caller. This is
-        not strictly conformant to the word of the spec, since the buffer processor
-        might call the callback multiple times, and we never refresh currentTime. */
+        if( frameOffset >= frameCount )
+            break;
 
-    /* the first streamCallback will be called to generate samples which will be
-        outputted after the frames currently in the output buffer have been
-        outputted. */
-    bp->timeInfo->outputBufferDacTime += bp->framesInTempOutputBuffer * bp->samplePeriod;
+        if( frameOffset > 0 && canSplit )
+            return frameOffset;
 
-    bp->callbackStatusFlags = callbackStatusFlags;
+        bp->eventCallback( event, frameOffset, bp->userData );
+        PaUtil_AdvanceRingBufferReadIndex( &bp->eventQueue, 1 );
+    }
 
-    bp->hostInputFrameCount[1] = 0;
-    bp->hostOutputFrameCount[1] = 0;
+    return frameCount;
 }
 
 
@@ -723,8 +2768,9 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
     unsigned long frameCount;
     unsigned long framesToGo = framesToProcess;
     unsigned long framesProcessed = 0;
-    int skipOutputConvert = 0;
-    int skipInputConvert = 0;
+    int skipOutputConvert;
+    int skipInputConvert;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
 
 
     if( *streamCallbackResult == paContinue )
@@ -733,6 +2779,12 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
         {
             frameCount = PA_MIN_( bp->framesPerTempBuffer, framesToGo );
 
+            if( bp->eventCallback )
+                frameCount = DispatchStreamEvents( bp, frameCount, bp->framesPerUserBuffer == 0 );
+
+            skipOutputConvert = 0;
+            skipInputConvert = 0;
+
             /* configure user input buffer and convert input data (host -> user) */
             if( bp->inputChannelCount == 0 )
             {
@@ -766,10 +2818,11 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 else /* user input is not interleaved */
                 {
                     destSampleStrideSamples = 1;
-                    destChannelStrideBytes = frameCount * bp->bytesPerUserInputSample;
+                    destChannelStrideBytes = bp->tempInputChannelStrideBytes;
 
                     /* setup non-interleaved ptrs */
-                    if( bp->userInputSampleFormatIsEqualToHost && !bp->hostInputIsInterleaved && bp->hostInputChannels[0][0].data )
+                    if( bp->userInputSampleFormatIsEqualToHost && !bp->hostInputIsInterleaved && bp->hostInputChannels[0][0].data
+                        && ChannelsAreContiguous( hostInputChannels, bp->inputChannelCount ) )
                     {
                         for( i=0; i<bp->inputChannelCount; ++i )
                         {
@@ -782,7 +2835,7 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                         for( i=0; i<bp->inputChannelCount; ++i )
                         {
                             bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                                i * bp->bytesPerUserInputSample * frameCount;
+                                i * bp->tempInputChannelStrideBytes;
                         }
                     }
 
@@ -813,19 +2866,8 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                     }
                     else
                     {
-                        for( i=0; i<bp->inputChannelCount; ++i )
-                        {
-                            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                                    hostInputChannels[i].data,
-                                                    hostInputChannels[i].stride,
-                                                    frameCount, &bp->ditherGenerator );
-
-                            destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
-
-                            /* advance src ptr for next iteration */
-                            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-                        }
+                        ConvertInputChannels( bp, hostInputChannels, destBytePtr,
+                                destSampleStrideSamples, destChannelStrideBytes, 0, frameCount );
                     }
                 }
             }
@@ -843,7 +2885,9 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                     /* process host buffer directly, or use temp buffer if formats differ or host buffer non-interleaved,
                      * or if num channels differs between the host (set in stride) and the user (eg with some Alsa hw:) */
                     if( bp->userOutputSampleFormatIsEqualToHost && bp->hostOutputIsInterleaved
-                            && bp->outputChannelCount == hostOutputChannels[0].stride )
+                            && bp->hostOutputChannels[0][0].data
+                            && bp->outputChannelCount == hostOutputChannels[0].stride
+                            && !LoadFlagAcquire( &bp->outputGainIsEnabled ) )
                     {
                         userOutput = hostOutputChannels[0].data;
                         skipOutputConvert = 1;
@@ -855,7 +2899,12 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
                 else /* user output is not interleaved */
                 {
-                    if( bp->userOutputSampleFormatIsEqualToHost && !bp->hostOutputIsInterleaved )
+                    /* let the callback write directly to the host channel buffers if
+                        formats match, or use temp buffer and convert afterwards */
+                    if( bp->userOutputSampleFormatIsEqualToHost && !bp->hostOutputIsInterleaved
+                            && bp->hostOutputChannels[0][0].data
+                            && !LoadFlagAcquire( &bp->outputGainIsEnabled )
+                            && ChannelsAreContiguous( hostOutputChannels, bp->outputChannelCount ) )
                     {
                         for( i=0; i<bp->outputChannelCount; ++i )
                         {
@@ -868,7 +2917,7 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                         for( i=0; i<bp->outputChannelCount; ++i )
                         {
                             bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                                i * bp->bytesPerUserOutputSample * frameCount;
+                                i * bp->tempOutputChannelStrideBytes;
                         }
                     }
 
@@ -876,8 +2925,10 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
             }
 
+            PA_START_STAGE_TIMER_( stageStartTicks );
             *streamCallbackResult = bp->streamCallback( userInput, userOutput,
                     frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+            PA_STOP_STAGE_TIMER_( bp, paUtilCallbackStage, stageStartTicks );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -915,22 +2966,11 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                         else /* user output is not interleaved */
                         {
                             srcSampleStrideSamples = 1;
-                            srcChannelStrideBytes = frameCount * bp->bytesPerUserOutputSample;
+                            srcChannelStrideBytes = bp->tempOutputChannelStrideBytes;
                         }
 
-                        for( i=0; i<bp->outputChannelCount; ++i )
-                        {
-                            bp->outputConverter(    hostOutputChannels[i].data,
-                                                    hostOutputChannels[i].stride,
-                                                    srcBytePtr, srcSampleStrideSamples,
-                                                    frameCount, &bp->ditherGenerator );
-
-                            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-                            /* advance dest ptr for next iteration */
-                            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                                        frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-                        }
+                        ConvertOutputChannels( bp, hostOutputChannels, srcBytePtr,
+                                srcSampleStrideSamples, srcChannelStrideBytes, 0, frameCount );
                     }
                 }
 
@@ -971,80 +3011,421 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
 
 
 /*
-    AdaptingInputOnlyProcess() is a half duplex input buffer processor. It
-    converts data from the input buffers into the temporary input buffer,
-    when the temporary input buffer is full, it calls the streamCallback.
+    The adapting processors use tempInputBuffer and tempOutputBuffer as FIFOs
+    of user frames, starting at tempInputBufferReadFrame
+    (tempOutputBufferReadFrame). The FIFOs are divided into blocks of one user
+    buffer, each padded to the alignment, and the callback is passed pointers
+    into the FIFOs. User buffers always start a whole number of user buffers
+    into a FIFO, so they are always at the start of a block, and aligned. The
+    frames exchanged with a host buffer are converted by one call to
+    ConvertInputChannels() or ConvertOutputChannels() per block they span.
 */
-static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
-        int *streamCallbackResult,
-        PaUtilChannelDescriptor *hostInputChannels,
-        unsigned long framesToProcess )
+
+static unsigned long GetTempBufferFrameOffset( PaUtilBufferProcessor *bp, unsigned long frame,
+        unsigned long bytesPerFrame, unsigned long blockStrideBytes )
 {
-    void *userInput, *userOutput;
-    unsigned char *destBytePtr;
+    if( bp->useNonAdaptingProcess )
+        return frame * bytesPerFrame;
+
+    return (frame / bp->framesPerUserBuffer) * blockStrideBytes
+            + (frame % bp->framesPerUserBuffer) * bytesPerFrame;
+}
+
+
+/* returns the offset of frame within tempInputBuffer, or within each channel
+ of a non-interleaved tempInputBuffer */
+static unsigned long GetTempInputBufferFrameOffset( PaUtilBufferProcessor *bp, unsigned long frame )
+{
+    return GetTempBufferFrameOffset( bp, frame, bp->bytesPerUserInputSample *
+            ( bp->userInputIsInterleaved ? bp->inputChannelCount : 1 ), bp->tempInputBlockStrideBytes );
+}
+
+
+static unsigned long GetTempOutputBufferFrameOffset( PaUtilBufferProcessor *bp, unsigned long frame )
+{
+    return GetTempBufferFrameOffset( bp, frame, bp->bytesPerUserOutputSample *
+            ( bp->userOutputIsInterleaved ? bp->outputChannelCount : 1 ), bp->tempOutputBlockStrideBytes );
+}
+
+
+static unsigned char *GetTempInputBufferFrame( PaUtilBufferProcessor *bp, unsigned long frame )
+{
+    return ((unsigned char*)bp->tempInputBuffer) + GetTempInputBufferFrameOffset( bp, frame );
+}
+
+
+static unsigned char *GetTempOutputBufferFrame( PaUtilBufferProcessor *bp, unsigned long frame )
+{
+    return ((unsigned char*)bp->tempOutputBuffer) + GetTempOutputBufferFrameOffset( bp, frame );
+}
+
+
+/*
+    returns the number of frames from frame to the end of its block
+*/
+static unsigned long GetFramesToEndOfTempBufferBlock( PaUtilBufferProcessor *bp, unsigned long frame )
+{
+    return bp->framesPerUserBuffer - frame % bp->framesPerUserBuffer;
+}
+
+
+/*
+    MoveTempBufferFrames() moves frameCount frames of a temp buffer from
+    sourceOffset to destinationOffset, the offsets of the frames within the
+    buffer or within each channel (see GetTempInputBufferFrameOffset()).
+    Frames are only moved by whole blocks, so the padding between the blocks
+    is moved with them.
+*/
+static void MoveTempBufferFrames( void *buffer, int isInterleaved,
+        unsigned int channelCount, unsigned long channelStrideBytes,
+        unsigned long destinationOffset, unsigned long sourceOffset,
+        unsigned long byteCount )
+{
+    unsigned char *channel = (unsigned char*)buffer;
+    unsigned int i;
+
+    if( byteCount == 0 || destinationOffset == sourceOffset )
+        return;
+
+    if( isInterleaved )
+        channelCount = 1;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        memmove( channel + destinationOffset, channel + sourceOffset, byteCount );
+
+        channel += channelStrideBytes;
+    }
+}
+
+
+/*
+    returns the user input buffer starting at frame of the input FIFO. for
+    non-interleaved user buffers the channel pointers are stored in channelPtrs
+*/
+static void *GetUserInputBuffer( PaUtilBufferProcessor *bp, unsigned long frame,
+        void **channelPtrs )
+{
+    unsigned int i;
+
+    if( bp->userInputIsInterleaved )
+        return GetTempInputBufferFrame( bp, frame );
+
+    for( i=0; i<bp->inputChannelCount; ++i )
+    {
+        channelPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
+                i * bp->tempInputChannelStrideBytes + GetTempInputBufferFrameOffset( bp, frame );
+    }
+
+    return channelPtrs;
+}
+
+
+/*
+    returns the user output buffer starting at frame of the output FIFO. for
+    non-interleaved user buffers the channel pointers are stored in channelPtrs
+*/
+static void *GetUserOutputBuffer( PaUtilBufferProcessor *bp, unsigned long frame,
+        void **channelPtrs )
+{
+    unsigned int i;
+
+    if( bp->userOutputIsInterleaved )
+        return GetTempOutputBufferFrame( bp, frame );
+
+    for( i=0; i<bp->outputChannelCount; ++i )
+    {
+        channelPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
+                i * bp->tempOutputChannelStrideBytes + GetTempOutputBufferFrameOffset( bp, frame );
+    }
+
+    return channelPtrs;
+}
+
+
+/*
+    FillTempInputBuffer() converts up to maxFrameCount frames from the 1st and
+    2nd host input buffers to the end of the input FIFO, with one conversion
+    per host buffer, and returns the number of frames converted.
+*/
+static unsigned long FillTempInputBuffer( PaUtilBufferProcessor *bp, unsigned long maxFrameCount )
+{
+    unsigned long framesConverted = 0;
+    unsigned long frameCount, blockFrameCount, writeFrame;
     unsigned int destSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
     unsigned int destChannelStrideBytes; /* stride from one channel to the next, in bytes */
-    unsigned int i;
-    unsigned long frameCount;
-    unsigned long framesToGo = framesToProcess;
-    unsigned long framesProcessed = 0;
+    int i;
 
-    userOutput = 0;
+    maxFrameCount = PA_MIN_( maxFrameCount,
+            bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1] );
 
-    do
+    /* user buffers are taken from the start of the FIFO, so the frames which
+        remain can be moved to the beginning of the buffer to make room */
+    if( bp->tempInputBufferReadFrame > 0 && bp->tempInputBufferReadFrame +
+            bp->framesInTempInputBuffer + maxFrameCount > bp->tempInputBufferCapacity )
+    {
+        MoveTempBufferFrames( bp->tempInputBuffer, bp->userInputIsInterleaved,
+                bp->inputChannelCount, bp->tempInputChannelStrideBytes, 0,
+                GetTempInputBufferFrameOffset( bp, bp->tempInputBufferReadFrame ),
+                GetTempInputBufferFrameOffset( bp, bp->tempInputBufferReadFrame + bp->framesInTempInputBuffer )
+                        - GetTempInputBufferFrameOffset( bp, bp->tempInputBufferReadFrame ) );
+
+        bp->tempInputBufferReadFrame = 0;
+    }
+
+    if( bp->userInputIsInterleaved )
+    {
+        destSampleStrideSamples = bp->inputChannelCount;
+        destChannelStrideBytes = bp->bytesPerUserInputSample;
+    }
+    else /* user input is not interleaved */
+    {
+        destSampleStrideSamples = 1;
+        destChannelStrideBytes = bp->tempInputChannelStrideBytes;
+    }
+
+    for( i=0; i<2 && framesConverted < maxFrameCount; ++i )
     {
-        frameCount = ( bp->framesInTempInputBuffer + framesToGo > bp->framesPerUserBuffer )
-                ? ( bp->framesPerUserBuffer - bp->framesInTempInputBuffer )
-                : framesToGo;
+        writeFrame = bp->tempInputBufferReadFrame + bp->framesInTempInputBuffer;
 
-        /* convert frameCount samples into temp buffer */
+        frameCount = PA_MIN_( bp->hostInputFrameCount[i], maxFrameCount - framesConverted );
+        frameCount = PA_MIN_( frameCount, bp->tempInputBufferCapacity - writeFrame );
 
-        if( bp->userInputIsInterleaved )
+        while( frameCount > 0 )
         {
-            destBytePtr = ((unsigned char*)bp->tempInputBuffer) +
-                    bp->bytesPerUserInputSample * bp->inputChannelCount *
-                    bp->framesInTempInputBuffer;
+            blockFrameCount = PA_MIN_( frameCount, GetFramesToEndOfTempBufferBlock( bp, writeFrame ) );
+
+            ConvertInputChannels( bp, bp->hostInputChannels[i], GetTempInputBufferFrame( bp, writeFrame ),
+                    destSampleStrideSamples, destChannelStrideBytes, 0, blockFrameCount );
+
+            bp->hostInputFrameCount[i] -= blockFrameCount;
+            bp->framesInTempInputBuffer += blockFrameCount;
+            framesConverted += blockFrameCount;
+            writeFrame += blockFrameCount;
+            frameCount -= blockFrameCount;
+        }
+
+        if( bp->hostInputFrameCount[i] > 0 )
+            break; /* the 1st buffer must be consumed before the 2nd */
+    }
+
+    return framesConverted;
+}
+
+
+/*
+    DrainTempOutputBuffer() converts as many frames from the start of the
+    output FIFO as fit into the 1st and 2nd host output buffers, with one
+    conversion per host buffer, and returns the number of frames converted.
+*/
+static unsigned long DrainTempOutputBuffer( PaUtilBufferProcessor *bp )
+{
+    unsigned long framesConverted = 0;
+    unsigned long frameCount, blockFrameCount;
+    unsigned int srcSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
+    unsigned int srcChannelStrideBytes; /* stride from one channel to the next, in bytes */
+    unsigned int j;
+    int i;
+
+    if( bp->userOutputIsInterleaved )
+    {
+        srcSampleStrideSamples = bp->outputChannelCount;
+        srcChannelStrideBytes = bp->bytesPerUserOutputSample;
+    }
+    else /* user output is not interleaved */
+    {
+        srcSampleStrideSamples = 1;
+        srcChannelStrideBytes = bp->tempOutputChannelStrideBytes;
+    }
+
+    for( i=0; i<2 && bp->framesInTempOutputBuffer > 0; ++i )
+    {
+        frameCount = PA_MIN_( bp->hostOutputFrameCount[i], bp->framesInTempOutputBuffer );
+        if( frameCount == 0 )
+            continue;
 
-            destSampleStrideSamples = bp->inputChannelCount;
-            destChannelStrideBytes = bp->bytesPerUserInputSample;
+        for( j=0; j<bp->outputChannelCount; ++j )
+            assert( bp->hostOutputChannels[i][j].data != NULL );
 
-            userInput = bp->tempInputBuffer;
+        while( frameCount > 0 )
+        {
+            blockFrameCount = PA_MIN_( frameCount,
+                    GetFramesToEndOfTempBufferBlock( bp, bp->tempOutputBufferReadFrame ) );
+
+            ConvertOutputChannels( bp, bp->hostOutputChannels[i],
+                    GetTempOutputBufferFrame( bp, bp->tempOutputBufferReadFrame ),
+                    srcSampleStrideSamples, srcChannelStrideBytes, 0, blockFrameCount );
+
+            bp->hostOutputFrameCount[i] -= blockFrameCount;
+            bp->tempOutputBufferReadFrame += blockFrameCount;
+            bp->framesInTempOutputBuffer -= blockFrameCount;
+            framesConverted += blockFrameCount;
+            frameCount -= blockFrameCount;
         }
-        else /* user input is not interleaved */
+    }
+
+    return framesConverted;
+}
+
+
+/*
+    MakeRoomForUserOutputBuffers() moves the output FIFO if fewer than
+    userBufferCount user buffers can be appended to it, and returns non-zero
+    if at least one can. The end of the FIFO is always a whole number of user
+    buffers into the temp buffer, the frames are moved towards the beginning
+    of the buffer by whole user buffers to keep it that way.
+*/
+static int MakeRoomForUserOutputBuffers( PaUtilBufferProcessor *bp,
+        unsigned long userBufferCount )
+{
+    unsigned long shift;
+
+    if( bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer
+            + userBufferCount * bp->framesPerUserBuffer > bp->tempOutputBufferCapacity )
+    {
+        shift = bp->tempOutputBufferReadFrame - bp->tempOutputBufferReadFrame % bp->framesPerUserBuffer;
+
+        if( shift > 0 )
         {
-            destBytePtr = ((unsigned char*)bp->tempInputBuffer) +
-                    bp->bytesPerUserInputSample * bp->framesInTempInputBuffer;
+            MoveTempBufferFrames( bp->tempOutputBuffer, bp->userOutputIsInterleaved,
+                    bp->outputChannelCount, bp->tempOutputChannelStrideBytes,
+                    GetTempOutputBufferFrameOffset( bp, bp->tempOutputBufferReadFrame - shift ),
+                    GetTempOutputBufferFrameOffset( bp, bp->tempOutputBufferReadFrame ),
+                    GetTempOutputBufferFrameOffset( bp, bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer )
+                            - GetTempOutputBufferFrameOffset( bp, bp->tempOutputBufferReadFrame ) );
+
+            bp->tempOutputBufferReadFrame -= shift;
+        }
+    }
 
-            destSampleStrideSamples = 1;
-            destChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
+    return bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer
+            + bp->framesPerUserBuffer <= bp->tempOutputBufferCapacity;
+}
 
-            /* setup non-interleaved ptrs */
-            for( i=0; i<bp->inputChannelCount; ++i )
-            {
-                bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                    i * bp->bytesPerUserInputSample * bp->framesPerUserBuffer;
-            }
 
-            userInput = bp->tempInputBufferPtrs;
+/*
+    GetUserOutputRoom() returns the number of user buffers which can be
+    appended to the output FIFO without moving it.
+*/
+static unsigned long GetUserOutputRoom( PaUtilBufferProcessor *bp )
+{
+    return (bp->tempOutputBufferCapacity -
+            (bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer))
+            / bp->framesPerUserBuffer;
+}
+
+
+/*
+    CallBatchCallback() passes up to maxBlockCount consecutive user buffers,
+    starting at inputFrame of the input FIFO and outputFrame of the output
+    FIFO, to the batchCallback in a single call and returns the number of user
+    buffers passed. The buffers point into the FIFOs, nothing is copied. The
+    time info of each buffer follows on from bp->timeInfo.
+*/
+static unsigned long CallBatchCallback( PaUtilBufferProcessor *bp,
+        int *streamCallbackResult, unsigned long inputFrame,
+        unsigned long outputFrame, unsigned long maxBlockCount )
+{
+    PaStreamCallbackBlock *block;
+    PaTime blockDuration = bp->framesPerUserBuffer * bp->samplePeriod;
+    unsigned long blockCount = PA_MIN_( maxBlockCount, bp->maxBatchBlockCount );
+    unsigned long i;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
+
+    assert( blockCount > 0 );
+
+    for( i=0; i<blockCount; ++i )
+    {
+        block = &bp->batchBlocks[i];
+
+        block->input = 0;
+        block->output = 0;
+        block->timeInfo = *bp->timeInfo;
+
+        if( bp->inputChannelCount > 0 )
+        {
+            block->input = GetUserInputBuffer( bp, inputFrame + i * bp->framesPerUserBuffer,
+                    bp->batchInputChannelPtrs + i * bp->inputChannelCount );
+            block->timeInfo.inputBufferAdcTime += i * blockDuration;
         }
 
-        for( i=0; i<bp->inputChannelCount; ++i )
+        if( bp->outputChannelCount > 0 )
         {
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                    hostInputChannels[i].data,
-                                    hostInputChannels[i].stride,
-                                    frameCount, &bp->ditherGenerator );
+            block->output = GetUserOutputBuffer( bp, outputFrame + i * bp->framesPerUserBuffer,
+                    bp->batchOutputChannelPtrs + i * bp->outputChannelCount );
+            block->timeInfo.outputBufferDacTime += i * blockDuration;
+        }
+    }
+
+    PA_START_STAGE_TIMER_( stageStartTicks );
+    *streamCallbackResult = bp->batchCallback( bp->batchBlocks, blockCount,
+            bp->framesPerUserBuffer, bp->callbackStatusFlags, bp->userData );
+    PA_STOP_STAGE_TIMER_( bp, paUtilCallbackStage, stageStartTicks );
+
+    return blockCount;
+}
+
+
+/*
+    ZeroHostOutput() zeros what remains of the 1st and 2nd host output buffers
+    and returns the number of frames zeroed.
+*/
+static unsigned long ZeroHostOutput( PaUtilBufferProcessor *bp )
+{
+    PaUtilChannelDescriptor *hostOutputChannels;
+    unsigned long framesZeroed = 0;
+    unsigned long frameCount;
+    unsigned int i, j;
+
+    for( i=0; i<2; ++i )
+    {
+        frameCount = bp->hostOutputFrameCount[i];
+        if( frameCount > 0 )
+        {
+            hostOutputChannels = bp->hostOutputChannels[i];
+
+            for( j=0; j<bp->outputChannelCount; ++j )
+            {
+                bp->outputZeroer(   hostOutputChannels[j].data,
+                                    hostOutputChannels[j].stride,
+                                    frameCount );
+
+                /* advance dest ptr for next iteration  */
+                hostOutputChannels[j].data = ((unsigned char*)hostOutputChannels[j].data) +
+                        frameCount * hostOutputChannels[j].stride * bp->bytesPerHostOutputSample;
+            }
+            bp->hostOutputFrameCount[i] = 0;
+            framesZeroed += frameCount;
+        }
+    }
 
-            destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
+    return framesZeroed;
+}
 
-            /* advance src ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-        }
 
-        bp->framesInTempInputBuffer += frameCount;
+/*
+    AdaptingInputOnlyProcess() is a half duplex input buffer processor. It
+    converts data from the 1st and 2nd host input buffers into the input FIFO,
+    and calls the streamCallback for each full user buffer in the FIFO, or the
+    batchCallback once for all of them.
+*/
+static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
+        int *streamCallbackResult )
+{
+    void *userInput, *userOutput;
+    unsigned long frameCount;
+    unsigned long blockCount;
+    unsigned long framesProcessed = 0;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
+
+    userOutput = 0;
+
+    do
+    {
+        frameCount = FillTempInputBuffer( bp,
+                bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1] );
 
-        if( bp->framesInTempInputBuffer == bp->framesPerUserBuffer )
+        while( bp->framesInTempInputBuffer >= bp->framesPerUserBuffer )
         {
             /**
             @todo (non-critical optimisation)
@@ -1054,239 +3435,143 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
             terminated earlier, thus some unneeded conversion cycles would be
             saved.
             */
+            blockCount = 1;
+
             if( *streamCallbackResult == paContinue )
             {
                 bp->timeInfo->outputBufferDacTime = 0;
 
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
+                if( bp->batchCallback )
+                {
+                    blockCount = CallBatchCallback( bp, streamCallbackResult,
+                            bp->tempInputBufferReadFrame, 0,
+                            bp->framesInTempInputBuffer / bp->framesPerUserBuffer );
+                }
+                else
+                {
+                    userInput = GetUserInputBuffer( bp, bp->tempInputBufferReadFrame,
+                            bp->tempInputBufferPtrs );
+
+                    if( bp->eventCallback )
+                        DispatchStreamEvents( bp, bp->framesPerUserBuffer, 0 );
 
-                bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
+                    PA_START_STAGE_TIMER_( stageStartTicks );
+                    *streamCallbackResult = bp->streamCallback( userInput, userOutput,
+                            bp->framesPerUserBuffer, bp->timeInfo,
+                            bp->callbackStatusFlags, bp->userData );
+                    PA_STOP_STAGE_TIMER_( bp, paUtilCallbackStage, stageStartTicks );
+                }
+
+                bp->timeInfo->inputBufferAdcTime += blockCount * bp->framesPerUserBuffer * bp->samplePeriod;
             }
 
-            bp->framesInTempInputBuffer = 0;
+            bp->tempInputBufferReadFrame += blockCount * bp->framesPerUserBuffer;
+            bp->framesInTempInputBuffer -= blockCount * bp->framesPerUserBuffer;
         }
 
         framesProcessed += frameCount;
 
-        framesToGo -= frameCount;
-    }while( framesToGo > 0 );
+    }while( frameCount > 0 );
 
     return framesProcessed;
 }
 
 
 /*
-    AdaptingOutputOnlyProcess() is a half duplex output buffer processor.
-    It converts data from the temporary output buffer, to the output buffers,
-    when the temporary output buffer is empty, it calls the streamCallback.
+    AdaptingOutputOnlyProcess() is a half duplex output buffer processor. It
+    calls the streamCallback (or the batchCallback, for as many user buffers
+    as fit) until the output FIFO holds enough frames to fill the 1st and 2nd
+    host output buffers, then converts them. When the
+    callback has returned paComplete or paAbort and the FIFO is empty, the
+    remainder of the host buffers is filled with zeros.
 */
 static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
-        int *streamCallbackResult,
-        PaUtilChannelDescriptor *hostOutputChannels,
-        unsigned long framesToProcess )
+        int *streamCallbackResult )
 {
     void *userInput, *userOutput;
-    unsigned char *srcBytePtr;
-    unsigned int srcSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
-    unsigned int srcChannelStrideBytes;  /* stride from one channel to the next, in bytes */
-    unsigned int i;
     unsigned long frameCount;
-    unsigned long framesToGo = framesToProcess;
+    unsigned long blockCount;
+    unsigned long framesToGo = bp->hostOutputFrameCount[0] + bp->hostOutputFrameCount[1];
     unsigned long framesProcessed = 0;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
+
+    userInput = 0;
 
     do
     {
-        if( bp->framesInTempOutputBuffer == 0 && *streamCallbackResult == paContinue )
+        while( bp->framesInTempOutputBuffer < framesToGo
+                && *streamCallbackResult == paContinue )
         {
-            userInput = 0;
-
-            /* setup userOutput */
-            if( bp->userOutputIsInterleaved )
-            {
-                userOutput = bp->tempOutputBuffer;
-            }
-            else /* user output is not interleaved */
-            {
-                for( i = 0; i < bp->outputChannelCount; ++i )
-                {
-                    bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                            i * bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
-                }
+            /* the number of user buffers needed to fill the host buffers */
+            blockCount = bp->batchCallback ? (framesToGo - bp->framesInTempOutputBuffer
+                    + bp->framesPerUserBuffer - 1) / bp->framesPerUserBuffer : 1;
 
-                userOutput = bp->tempOutputBufferPtrs;
-            }
+            if( !MakeRoomForUserOutputBuffers( bp, blockCount ) )
+                break; /* the output FIFO must be drained first */
 
             bp->timeInfo->inputBufferAdcTime = 0;
 
-            *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                    bp->framesPerUserBuffer, bp->timeInfo,
-                    bp->callbackStatusFlags, bp->userData );
-
-            if( *streamCallbackResult == paAbort )
+            if( bp->batchCallback )
             {
-                /* if the callback returned paAbort, we disregard its output */
+                blockCount = CallBatchCallback( bp, streamCallbackResult, 0,
+                        bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer,
+                        PA_MIN_( GetUserOutputRoom( bp ), blockCount ) );
             }
             else
             {
-                bp->timeInfo->outputBufferDacTime += bp->framesPerUserBuffer * bp->samplePeriod;
-
-                bp->framesInTempOutputBuffer = bp->framesPerUserBuffer;
-            }
-        }
-
-        if( bp->framesInTempOutputBuffer > 0 )
-        {
-            /* convert frameCount frames from user buffer to host buffer */
-
-            frameCount = PA_MIN_( bp->framesInTempOutputBuffer, framesToGo );
-
-            if( bp->userOutputIsInterleaved )
-            {
-                srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                        bp->bytesPerUserOutputSample * bp->outputChannelCount *
-                        (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
+                userOutput = GetUserOutputBuffer( bp,
+                        bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer,
+                        bp->tempOutputBufferPtrs );
 
-                srcSampleStrideSamples = bp->outputChannelCount;
-                srcChannelStrideBytes = bp->bytesPerUserOutputSample;
-            }
-            else /* user output is not interleaved */
-            {
-                srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                        bp->bytesPerUserOutputSample *
-                        (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
+                if( bp->eventCallback )
+                    DispatchStreamEvents( bp, bp->framesPerUserBuffer, 0 );
 
-                srcSampleStrideSamples = 1;
-                srcChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
+                PA_START_STAGE_TIMER_( stageStartTicks );
+                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
+                        bp->framesPerUserBuffer, bp->timeInfo,
+                        bp->callbackStatusFlags, bp->userData );
+                PA_STOP_STAGE_TIMER_( bp, paUtilCallbackStage, stageStartTicks );
             }
 
-            for( i=0; i<bp->outputChannelCount; ++i )
+            if( *streamCallbackResult == paAbort )
             {
-                bp->outputConverter(    hostOutputChannels[i].data,
-                                        hostOutputChannels[i].stride,
-                                        srcBytePtr, srcSampleStrideSamples,
-                                        frameCount, &bp->ditherGenerator );
-
-                srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-                /* advance dest ptr for next iteration */
-                hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                        frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+                /* if the callback returned paAbort, we disregard its output */
             }
-
-            bp->framesInTempOutputBuffer -= frameCount;
-        }
-        else
-        {
-            /* no more user data is available because the callback has returned
-                paComplete or paAbort. Fill the remainder of the host buffer
-                with zeros.
-            */
-
-            frameCount = framesToGo;
-
-            for( i=0; i<bp->outputChannelCount; ++i )
+            else
             {
-                bp->outputZeroer(   hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    frameCount );
+                bp->timeInfo->outputBufferDacTime += blockCount * bp->framesPerUserBuffer * bp->samplePeriod;
 
-                /* advance dest ptr for next iteration */
-                hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                        frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+                bp->framesInTempOutputBuffer += blockCount * bp->framesPerUserBuffer;
             }
         }
 
+        frameCount = DrainTempOutputBuffer( bp );
+
         framesProcessed += frameCount;
 
         framesToGo -= frameCount;
 
-    }while( framesToGo > 0 );
-
-    return framesProcessed;
-}
-
-/* CopyTempOutputBuffersToHostOutputBuffers is called from AdaptingProcess to copy frames from
-    tempOutputBuffer to hostOutputChannels. This includes data conversion
-    and interleaving.
-*/
-static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
-{
-    unsigned long maxFramesToCopy;
-    PaUtilChannelDescriptor *hostOutputChannels;
-    unsigned int frameCount;
-    unsigned char *srcBytePtr;
-    unsigned int srcSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
-    unsigned int srcChannelStrideBytes; /* stride from one channel to the next, in bytes */
-    unsigned int i;
+    }while( frameCount > 0 && framesToGo > 0 );
 
-    /* copy frames from user to host output buffers */
-    while( bp->framesInTempOutputBuffer > 0 &&
-            ((bp->hostOutputFrameCount[0] + bp->hostOutputFrameCount[1]) > 0) )
+    if( framesToGo > 0 )
     {
-        maxFramesToCopy = bp->framesInTempOutputBuffer;
-
-        /* select the output buffer set (1st or 2nd) */
-        if( bp->hostOutputFrameCount[0] > 0 )
-        {
-            hostOutputChannels = bp->hostOutputChannels[0];
-            frameCount = PA_MIN_( bp->hostOutputFrameCount[0], maxFramesToCopy );
-        }
-        else
-        {
-            hostOutputChannels = bp->hostOutputChannels[1];
-            frameCount = PA_MIN_( bp->hostOutputFrameCount[1], maxFramesToCopy );
-        }
-
-        if( bp->userOutputIsInterleaved )
-        {
-            srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                    bp->bytesPerUserOutputSample * bp->outputChannelCount *
-                    (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
-
-            srcSampleStrideSamples = bp->outputChannelCount;
-            srcChannelStrideBytes = bp->bytesPerUserOutputSample;
-        }
-        else /* user output is not interleaved */
-        {
-            srcBytePtr = ((unsigned char*)bp->tempOutputBuffer) +
-                    bp->bytesPerUserOutputSample *
-                    (bp->framesPerUserBuffer - bp->framesInTempOutputBuffer);
-
-            srcSampleStrideSamples = 1;
-            srcChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
-        }
-
-        for( i=0; i<bp->outputChannelCount; ++i )
-        {
-            assert( hostOutputChannels[i].data != NULL );
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    frameCount, &bp->ditherGenerator );
-
-            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-        }
-
-        if( bp->hostOutputFrameCount[0] > 0 )
-            bp->hostOutputFrameCount[0] -= frameCount;
-        else
-            bp->hostOutputFrameCount[1] -= frameCount;
-
-        bp->framesInTempOutputBuffer -= frameCount;
+        /* no more user data is available because the callback has returned
+            paComplete or paAbort. Fill the remainder of the host buffer
+            with zeros.
+        */
+        framesProcessed += ZeroHostOutput( bp );
     }
+
+    return framesProcessed;
 }
 
+
 /*
     AdaptingProcess is a full duplex adapting buffer processor. It converts
-    data from the temporary output buffer into the host output buffers, then
-    from the host input buffers into the temporary input buffers. Calling the
-    streamCallback when necessary.
+    data from the host input buffers into the input FIFO, calls the
+    streamCallback for each full user buffer in it (or the batchCallback once
+    for as many as fit into the output FIFO), and converts data from the
+    output FIFO into the host output buffers.
     When processPartialUserBuffers is 0, all available input data will be
     consumed and all available output space will be filled. When
     processPartialUserBuffers is non-zero, as many full user buffers
@@ -1298,190 +3583,97 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
     void *userInput, *userOutput;
     unsigned long framesProcessed = 0;
     unsigned long framesAvailable;
-    unsigned long endProcessingMinFrameCount;
-    unsigned long maxFramesToCopy;
-    PaUtilChannelDescriptor *hostInputChannels, *hostOutputChannels;
-    unsigned int frameCount;
-    unsigned char *destBytePtr;
-    unsigned int destSampleStrideSamples; /* stride from one sample to the next within a channel, in samples */
-    unsigned int destChannelStrideBytes; /* stride from one channel to the next, in bytes */
-    unsigned int i, j;
+    unsigned long framesToProcess;
+    unsigned long progress;
+    unsigned long blockCount;
+    PA_DECLARE_STAGE_TIMER_( stageStartTicks )
 
 
     framesAvailable = bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1];/* this is assumed to be the same as the output buffer's frame count */
 
     if( processPartialUserBuffers )
-        endProcessingMinFrameCount = 0;
+        framesToProcess = framesAvailable;
+    else if( framesAvailable >= bp->framesPerUserBuffer )
+        /* only consume the frames which complete user buffers */
+        framesToProcess = framesAvailable -
+                (bp->framesInTempInputBuffer + framesAvailable) % bp->framesPerUserBuffer;
     else
-        endProcessingMinFrameCount = (bp->framesPerUserBuffer - 1);
-
-    /* Fill host output with remaining frames in user output (tempOutputBuffer) */
-    CopyTempOutputBuffersToHostOutputBuffers( bp );
+        framesToProcess = 0;
 
-    while( framesAvailable > endProcessingMinFrameCount )
+    do
     {
+        progress = FillTempInputBuffer( bp, framesToProcess - framesProcessed );
 
-        if( bp->framesInTempOutputBuffer == 0 && *streamCallbackResult != paContinue )
-        {
-            /* the callback will not be called any more, so zero what remains
-                of the host output buffers */
-
-            for( i=0; i<2; ++i )
-            {
-                frameCount = bp->hostOutputFrameCount[i];
-                if( frameCount > 0 )
-                {
-                    hostOutputChannels = bp->hostOutputChannels[i];
-
-                    for( j=0; j<bp->outputChannelCount; ++j )
-                    {
-                        bp->outputZeroer(   hostOutputChannels[j].data,
-                                            hostOutputChannels[j].stride,
-                                            frameCount );
-
-                        /* advance dest ptr for next iteration  */
-                        hostOutputChannels[j].data = ((unsigned char*)hostOutputChannels[j].data) +
-                                frameCount * hostOutputChannels[j].stride * bp->bytesPerHostOutputSample;
-                    }
-                    bp->hostOutputFrameCount[i] = 0;
-                }
-            }
-        }
-
+        framesProcessed += progress;
 
-        /* copy frames from host to user input buffers */
-        while( bp->framesInTempInputBuffer < bp->framesPerUserBuffer &&
-                ((bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1]) > 0) )
+        while( bp->framesInTempInputBuffer >= bp->framesPerUserBuffer )
         {
-            maxFramesToCopy = bp->framesPerUserBuffer - bp->framesInTempInputBuffer;
-
-            /* select the input buffer set (1st or 2nd) */
-            if( bp->hostInputFrameCount[0] > 0 )
-            {
-                hostInputChannels = bp->hostInputChannels[0];
-                frameCount = PA_MIN_( bp->hostInputFrameCount[0], maxFramesToCopy );
-            }
-            else
-            {
-                hostInputChannels = bp->hostInputChannels[1];
-                frameCount = PA_MIN_( bp->hostInputFrameCount[1], maxFramesToCopy );
-            }
-
-            /* configure conversion destination pointers */
-            if( bp->userInputIsInterleaved )
-            {
-                destBytePtr = ((unsigned char*)bp->tempInputBuffer) +
-                        bp->bytesPerUserInputSample * bp->inputChannelCount *
-                        bp->framesInTempInputBuffer;
-
-                destSampleStrideSamples = bp->inputChannelCount;
-                destChannelStrideBytes = bp->bytesPerUserInputSample;
-            }
-            else /* user input is not interleaved */
-            {
-                destBytePtr = ((unsigned char*)bp->tempInputBuffer) +
-                        bp->bytesPerUserInputSample * bp->framesInTempInputBuffer;
-
-                destSampleStrideSamples = 1;
-                destChannelStrideBytes = bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
-            }
-
-            for( i=0; i<bp->inputChannelCount; ++i )
-            {
-                bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                        hostInputChannels[i].data,
-                                        hostInputChannels[i].stride,
-                                        frameCount, &bp->ditherGenerator );
-
-                destBytePtr += destChannelStrideBytes;  /* skip to next destination channel */
-
-                /* advance src ptr for next iteration */
-                hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                        frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-            }
-
-            if( bp->hostInputFrameCount[0] > 0 )
-                bp->hostInputFrameCount[0] -= frameCount;
-            else
-                bp->hostInputFrameCount[1] -= frameCount;
-
-            bp->framesInTempInputBuffer += frameCount;
-
-            /* update framesAvailable and framesProcessed based on input consumed
-                unless something is very wrong this will also correspond to the
-                amount of output generated */
-            framesAvailable -= frameCount;
-            framesProcessed += frameCount;
-        }
+            blockCount = 1;
 
-        /* call streamCallback */
-        if( bp->framesInTempInputBuffer == bp->framesPerUserBuffer &&
-            bp->framesInTempOutputBuffer == 0 )
-        {
             if( *streamCallbackResult == paContinue )
             {
-                /* setup userInput */
-                if( bp->userInputIsInterleaved )
-                {
-                    userInput = bp->tempInputBuffer;
-                }
-                else /* user input is not interleaved */
-                {
-                    for( i = 0; i < bp->inputChannelCount; ++i )
-                    {
-                        bp->tempInputBufferPtrs[i] = ((unsigned char*)bp->tempInputBuffer) +
-                                i * bp->framesPerUserBuffer * bp->bytesPerUserInputSample;
-                    }
+                if( bp->batchCallback )
+                    blockCount = bp->framesInTempInputBuffer / bp->framesPerUserBuffer;
 
-                    userInput = bp->tempInputBufferPtrs;
-                }
+                if( !MakeRoomForUserOutputBuffers( bp, blockCount ) )
+                    break; /* the output FIFO must be drained first */
 
-                /* setup userOutput */
-                if( bp->userOutputIsInterleaved )
+                if( bp->batchCallback )
                 {
-                    userOutput = bp->tempOutputBuffer;
+                    blockCount = CallBatchCallback( bp, streamCallbackResult,
+                            bp->tempInputBufferReadFrame,
+                            bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer,
+                            PA_MIN_( GetUserOutputRoom( bp ), blockCount ) );
                 }
-                else /* user output is not interleaved */
+                else
                 {
-                    for( i = 0; i < bp->outputChannelCount; ++i )
-                    {
-                        bp->tempOutputBufferPtrs[i] = ((unsigned char*)bp->tempOutputBuffer) +
-                                i * bp->framesPerUserBuffer * bp->bytesPerUserOutputSample;
-                    }
-
-                    userOutput = bp->tempOutputBufferPtrs;
+                    userInput = GetUserInputBuffer( bp, bp->tempInputBufferReadFrame,
+                            bp->tempInputBufferPtrs );
+                    userOutput = GetUserOutputBuffer( bp,
+                            bp->tempOutputBufferReadFrame + bp->framesInTempOutputBuffer,
+                            bp->tempOutputBufferPtrs );
+
+                    /* call streamCallback */
+
+                    if( bp->eventCallback )
+                        DispatchStreamEvents( bp, bp->framesPerUserBuffer, 0 );
+
+                    PA_START_STAGE_TIMER_( stageStartTicks );
+                    *streamCallbackResult = bp->streamCallback( userInput, userOutput,
+                            bp->framesPerUserBuffer, bp->timeInfo,
+                            bp->callbackStatusFlags, bp->userData );
+                    PA_STOP_STAGE_TIMER_( bp, paUtilCallbackStage, stageStartTicks );
                 }
 
-                /* call streamCallback */
-
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
-
-                bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
-                bp->timeInfo->outputBufferDacTime += bp->framesPerUserBuffer * bp->samplePeriod;
-
-                bp->framesInTempInputBuffer = 0;
+                bp->timeInfo->inputBufferAdcTime += blockCount * bp->framesPerUserBuffer * bp->samplePeriod;
+                bp->timeInfo->outputBufferDacTime += blockCount * bp->framesPerUserBuffer * bp->samplePeriod;
 
-                if( *streamCallbackResult == paAbort )
-                    bp->framesInTempOutputBuffer = 0;
-                else
-                    bp->framesInTempOutputBuffer = bp->framesPerUserBuffer;
+                /* if the callback returned paAbort, we disregard its output */
+                if( *streamCallbackResult != paAbort )
+                    bp->framesInTempOutputBuffer += blockCount * bp->framesPerUserBuffer;
             }
             else
             {
                 /* paComplete or paAbort has already been called. */
-
-                bp->framesInTempInputBuffer = 0;
             }
+
+            bp->tempInputBufferReadFrame += blockCount * bp->framesPerUserBuffer;
+            bp->framesInTempInputBuffer -= blockCount * bp->framesPerUserBuffer;
+
+            ++progress;
         }
 
-        /* copy frames from user (tempOutputBuffer) to host output buffers (hostOutputChannels)
-           Means to process the user output provided by the callback. Has to be called after
-            each callback. */
-        CopyTempOutputBuffersToHostOutputBuffers( bp );
+        progress += DrainTempOutputBuffer( bp );
 
-    }
+        if( bp->framesInTempOutputBuffer == 0 && *streamCallbackResult != paContinue
+                && framesToProcess > 0 )
+        {
+            /* the callback will not be called any more, so zero what remains
+                of the host output buffers */
+            ZeroHostOutput( bp );
+        }
+
+    }while( progress > 0 );
 
     return framesProcessed;
 }
@@ -1551,7 +3743,7 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
                     hostOutputFrameCount = &noOutputOutputFrameCount;
                     hostOutputChannels = 0;
                 }
-                if( bp->hostOutputFrameCount[0] != 0 )
+                else if( bp->hostOutputFrameCount[0] != 0 )
                 {
                     hostOutputFrameCount = &bp->hostOutputFrameCount[0];
                     hostOutputChannels = bp->hostOutputChannels[0];
@@ -1626,35 +3818,17 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
         else if( bp->inputChannelCount != 0 )
         {
             /* input only */
-            framesToProcess = bp->hostInputFrameCount[0];
-
-            framesProcessed = AdaptingInputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostInputChannels[0], framesToProcess );
-
-            framesToProcess = bp->hostInputFrameCount[1];
-            if( framesToProcess > 0 )
-            {
-                framesProcessed += AdaptingInputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostInputChannels[1], framesToProcess );
-            }
+            framesProcessed = AdaptingInputOnlyProcess( bp, streamCallbackResult );
         }
         else
         {
             /* output only */
-            framesToProcess = bp->hostOutputFrameCount[0];
-
-            framesProcessed = AdaptingOutputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostOutputChannels[0], framesToProcess );
-
-            framesToProcess = bp->hostOutputFrameCount[1];
-            if( framesToProcess > 0 )
-            {
-                framesProcessed += AdaptingOutputOnlyProcess( bp, streamCallbackResult,
-                        bp->hostOutputChannels[1], framesToProcess );
-            }
+            framesProcessed = AdaptingOutputOnlyProcess( bp, streamCallbackResult );
         }
     }
 
+    PA_PUBLISH_STAGE_TIMES_( bp );
+
     return framesProcessed;
 }
 
@@ -1686,19 +3860,8 @@ unsigned long PaUtil_CopyInput( PaUtilBufferProcessor* bp,
         destSampleStrideSamples = bp->inputChannelCount;
         destChannelStrideBytes = bp->bytesPerUserInputSample;
 
-        for( i=0; i<bp->inputChannelCount; ++i )
-        {
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                hostInputChannels[i].data,
-                                hostInputChannels[i].stride,
-                                framesToCopy, &bp->ditherGenerator );
-
-            destBytePtr += destChannelStrideBytes;  /* skip to next dest channel */
-
-            /* advance source ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
-        }
+        ConvertInputChannels( bp, hostInputChannels, destBytePtr,
+                destSampleStrideSamples, destChannelStrideBytes, 0, framesToCopy );
 
         /* advance callers dest pointer (buffer) */
         *buffer = ((unsigned char *)*buffer) +
@@ -1712,27 +3875,22 @@ unsigned long PaUtil_CopyInput( PaUtilBufferProcessor* bp,
 
         destSampleStrideSamples = 1;
 
+        ConvertInputChannels( bp, hostInputChannels, 0,
+                destSampleStrideSamples, 0, nonInterleavedDestPtrs, framesToCopy );
+
         for( i=0; i<bp->inputChannelCount; ++i )
         {
-            destBytePtr = (unsigned char*)nonInterleavedDestPtrs[i];
-
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                hostInputChannels[i].data,
-                                hostInputChannels[i].stride,
-                                framesToCopy, &bp->ditherGenerator );
-
             /* advance callers dest pointer (nonInterleavedDestPtrs[i]) */
+            destBytePtr = (unsigned char*)nonInterleavedDestPtrs[i];
             destBytePtr += bp->bytesPerUserInputSample * framesToCopy;
             nonInterleavedDestPtrs[i] = destBytePtr;
-
-            /* advance source ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
         }
     }
 
     bp->hostInputFrameCount[0] -= framesToCopy;
 
+    PA_PUBLISH_STAGE_TIMES_( bp );
+
     return framesToCopy;
 }
 
@@ -1757,19 +3915,8 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
         srcSampleStrideSamples = bp->outputChannelCount;
         srcChannelStrideBytes = bp->bytesPerUserOutputSample;
 
-        for( i=0; i<bp->outputChannelCount; ++i )
-        {
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
-
-            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
-        }
+        ConvertOutputChannels( bp, hostOutputChannels, srcBytePtr,
+                srcSampleStrideSamples, srcChannelStrideBytes, 0, framesToCopy );
 
         /* advance callers source pointer (buffer) */
         *buffer = ((unsigned char *)*buffer) +
@@ -1784,28 +3931,22 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
 
         srcSampleStrideSamples = 1;
 
+        ConvertOutputChannels( bp, hostOutputChannels, 0,
+                srcSampleStrideSamples, 0, nonInterleavedSrcPtrs, framesToCopy );
+
         for( i=0; i<bp->outputChannelCount; ++i )
         {
-            srcBytePtr = (unsigned char*)nonInterleavedSrcPtrs[i];
-
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
-
-
             /* advance callers source pointer (nonInterleavedSrcPtrs[i]) */
+            srcBytePtr = (unsigned char*)nonInterleavedSrcPtrs[i];
             srcBytePtr += bp->bytesPerUserOutputSample * framesToCopy;
             nonInterleavedSrcPtrs[i] = srcBytePtr;
-
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
         }
     }
 
     bp->hostOutputFrameCount[0] += framesToCopy;
 
+    PA_PUBLISH_STAGE_TIMES_( bp );
+
     return framesToCopy;
 }
 
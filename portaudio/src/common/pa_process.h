@@ -203,6 +203,12 @@
 #include "portaudio.h"
 #include "pa_converters.h"
 #include "pa_dither.h"
+#include "pa_resampler.h"
+#include "pa_ringbuffer.h"
+
+#ifndef PA_PROCESS_STAGE_TIMING
+#define PA_PROCESS_STAGE_TIMING     (0)   /**< Set to 1 to time each stage of buffer processing, see PaUtil_GetBufferProcessorStageTimes() */
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -245,12 +251,43 @@ typedef struct PaUtilChannelDescriptor{
 }PaUtilChannelDescriptor;
 
 
+/** @brief An auxiliary data structure used internally by the buffer processor
+ to represent the gain applied to an output channel. */
+typedef struct PaUtilChannelGain{
+    volatile float targetGain; /**< the requested gain. Written by PaUtil_SetBufferProcessorOutputGain(), possibly from another thread, with a release store */
+    float gain;                /**< the gain applied to the next sample */
+    float rampTarget;          /**< the gain at the end of the current ramp */
+    float rampIncrement;       /**< the change of gain per frame during a ramp */
+    unsigned long rampFramesRemaining;
+}PaUtilChannelGain;
+
+
+/** @brief The stages of buffer processing timed when PA_PROCESS_STAGE_TIMING
+ is 1. */
+typedef enum {
+    paUtilInputConversionStage,
+    paUtilCallbackStage,
+    paUtilOutputConversionStage,
+    paUtilProcessStageCount
+}PaUtilProcessStage;
+
+
+/** @brief An auxiliary data structure used internally by the buffer processor
+ to accumulate the time spent in one stage, in timer ticks. */
+typedef struct PaUtilStageTicks{
+    unsigned long count;
+    double total;
+    double maximum;
+    double last;
+}PaUtilStageTicks;
+
+
 /** @brief The main buffer processor data structure.
 
  Allocate one of these, initialize it with PaUtil_InitializeBufferProcessor
  and terminate it with PaUtil_TerminateBufferProcessor.
 */
-typedef struct {
+typedef struct PaUtilBufferProcessor {
     unsigned long framesPerUserBuffer;
     unsigned long framesPerHostBuffer;
 
@@ -265,6 +302,7 @@ typedef struct {
     unsigned int bytesPerUserInputSample;
     int userInputIsInterleaved;
     PaUtilConverter *inputConverter;
+    PaUtilFrameConverter *inputFrameConverter; /**< NULL unless exactly one of the user and host input is interleaved and a frame converter is available for the formats */
     PaUtilZeroer *inputZeroer;
 
     unsigned int outputChannelCount;
@@ -272,6 +310,7 @@ typedef struct {
     unsigned int bytesPerUserOutputSample;
     int userOutputIsInterleaved;
     PaUtilConverter *outputConverter;
+    PaUtilFrameConverter *outputFrameConverter; /**< NULL unless exactly one of the user and host output is interleaved and a frame converter is available for the formats */
     PaUtilZeroer *outputZeroer;
 
     unsigned long initialFramesInTempInputBuffer;
@@ -280,10 +319,24 @@ typedef struct {
     void *tempInputBuffer;          /**< used for slips, block adaption, and conversion. */
     void **tempInputBufferPtrs;     /**< storage for non-interleaved buffer pointers, NULL for interleaved user input */
     unsigned long framesInTempInputBuffer; /**< frames remaining in input buffer from previous adaption iteration */
+    unsigned long tempInputBufferReadFrame; /**< index of the first of those frames, the adapting processors use tempInputBuffer as a FIFO */
+    unsigned long tempInputBufferCapacity; /**< number of frames the adapting processors store in tempInputBuffer */
 
     void *tempOutputBuffer;         /**< used for slips, block adaption, and conversion. */
     void **tempOutputBufferPtrs;    /**< storage for non-interleaved buffer pointers, NULL for interleaved user output */
     unsigned long framesInTempOutputBuffer; /**< frames remaining in input buffer from previous adaption iteration */
+    unsigned long tempOutputBufferReadFrame; /**< index of the first of those frames, the adapting processors use tempOutputBuffer as a FIFO */
+    unsigned long tempOutputBufferCapacity; /**< number of frames the adapting processors store in tempOutputBuffer */
+
+    unsigned long tempInputBufferSize;  /**< size of tempInputBuffer in bytes, including channel padding */
+    unsigned long tempInputChannelStrideBytes; /**< distance between the channels of non-interleaved user input in tempInputBuffer */
+    unsigned long tempInputBlockStrideBytes; /**< distance between the user buffers in tempInputBuffer, or in each of its channels, including padding */
+    unsigned long tempOutputBufferSize; /**< size of tempOutputBuffer in bytes, including channel padding */
+    unsigned long tempOutputChannelStrideBytes; /**< distance between the channels of non-interleaved user output in tempOutputBuffer */
+    unsigned long tempOutputBlockStrideBytes; /**< distance between the user buffers in tempOutputBuffer, or in each of its channels, including padding */
+    unsigned long bufferAlignment;  /**< alignment in bytes of the temp buffers */
+
+    void **frameConverterChannelPtrs; /**< storage for the channel pointers passed to the frame converters, NULL if no frame converter is used */
 
     PaStreamCallbackTimeInfo *timeInfo;
 
@@ -305,11 +358,64 @@ typedef struct {
                                                          */
 
     PaUtilTriangularDitherGenerator ditherGenerator;
+    PaUtilTriangularDitherGenerator *outputChannelDitherGenerators; /**< separate dither and noise shaping
+                                                        state for each output channel, used instead of
+                                                        ditherGenerator when the paNoiseShapedDither flag is
+                                                        set. NULL otherwise. */
+
+    PaUtilChannelGain *outputChannelGains; /**< gain state for each output channel, NULL for input-only streams */
+    volatile int outputGainIsEnabled; /**< non-zero once a gain has been set with PaUtil_SetBufferProcessorOutputGain().
+                                           From then on the output is scaled while it is converted, without using
+                                           the frame converters or letting the user write directly to the host buffer. */
+    PaUtilConverter *outputGainSourceConverter; /**< converts user output samples to the float (or double) gain blocks */
+    PaUtilConverter *outputGainConverter;       /**< converts the gain blocks to host output samples */
+    int outputGainBlockIsFloat64;
+    unsigned long outputGainRampFrames;
 
     double samplePeriod;
 
     PaStreamCallback *streamCallback;
     void *userData;
+
+    /* the parameters passed to PaUtil_InitializeBufferProcessor(), kept so that
+        the buffer processor can be reinitialized by
+        PaUtil_EnableBufferProcessorResampling() */
+    PaSampleFormat userInputSampleFormat;
+    PaSampleFormat hostInputSampleFormat;
+    PaSampleFormat userOutputSampleFormat;
+    PaSampleFormat hostOutputSampleFormat;
+    PaStreamFlags streamFlags;
+    double sampleRate;
+
+    struct PaUtilResamplingStage *resamplingStage; /**< converts between the host and user sample rates.
+                                                        NULL unless PaUtil_EnableBufferProcessorResampling()
+                                                        has been called. */
+    struct PaUtilRoutingStage *routingStage; /**< routes the user channels to the host channels.
+                                                  NULL unless PaUtil_EnableBufferProcessorRouting()
+                                                  has been called. */
+
+    PaStreamBatchCallback *batchCallback; /**< called instead of streamCallback with every complete user buffer.
+                                               NULL unless PaUtil_SetBufferProcessorBatchCallback()
+                                               has been called. */
+    unsigned long maxBatchBlockCount;   /**< the number of user buffers which fit in a temp buffer */
+    PaStreamCallbackBlock *batchBlocks; /**< storage for the blocks passed to batchCallback */
+    void **batchInputChannelPtrs;       /**< storage for the non-interleaved input buffer pointers of each block, NULL for interleaved user input */
+    void **batchOutputChannelPtrs;      /**< storage for the non-interleaved output buffer pointers of each block, NULL for interleaved user output */
+
+    PaStreamEventCallback *eventCallback; /**< called with each event before the user buffer it falls in.
+                                               NULL unless PaUtil_SetBufferProcessorEventCallback()
+                                               has been called. */
+    PaUtilRingBuffer eventQueue;        /**< PaStreamEvent elements posted by PaUtil_PostBufferProcessorEvent() */
+    void *eventQueueData;               /**< storage for eventQueue */
+
+    /* stage timing. These fields are always present so that the size of the
+        structure doesn't depend on PA_PROCESS_STAGE_TIMING, but are only
+        updated if it is 1 */
+    double pendingStageTicks[paUtilProcessStageCount]; /**< ticks spent in each stage since the last publication */
+    volatile unsigned long stageTicksSequence; /**< odd while stageTicks is being written */
+    PaUtilStageTicks stageTicks[paUtilProcessStageCount];
+    double stageTimerStartTicks;    /**< timer ticks when the buffer processor was initialized */
+    double stageTimerStartTime;     /**< PaUtil_GetTime() when the buffer processor was initialized */
 } PaUtilBufferProcessor;
 
 
@@ -426,6 +532,218 @@ unsigned long PaUtil_GetBufferProcessorInputLatencyFrames( PaUtilBufferProcessor
 */
 unsigned long PaUtil_GetBufferProcessorOutputLatencyFrames( PaUtilBufferProcessor* bufferProcessor );
 
+/** Retrieve the alignment which a buffer processor guarantees for the user
+ buffers it passes to the stream callback. For non-interleaved user buffers
+ the alignment applies to each channel pointer.
+
+ The temporary buffers are allocated with a cache line alignment (large ones
+ are page aligned). When the user and host formats match, the host buffers
+ are passed to the callback directly instead of being copied, whatever their
+ alignment. The host APIs don't tell the buffer processor how their buffers
+ are aligned, so the guarantee is then only the alignment of the host
+ samples, reduced by the offsets of the blocks within each host buffer. When resampling or routing is enabled the
+ callback's buffers belong to the stage, and are only aligned to their
+ sample size.
+
+ @param bufferProcessor The buffer processor to examine.
+
+ @return The alignment in bytes, a power of two.
+*/
+unsigned long PaUtil_GetBufferProcessorBufferAlignment( PaUtilBufferProcessor* bufferProcessor );
+
+
+/** Run the stream callback at a different sample rate from the host.
+
+ The buffer processor is reinitialized so that it converts the host buffers
+ to and from non-interleaved Float32 buffers at the host sample rate, which
+ are resampled to the user sample rate by polyphase filters. The stream
+ callback passed to PaUtil_InitializeBufferProcessor() is then called with
+ buffers of framesPerUserBuffer frames, in the user sample formats, at
+ userSampleRate.
+
+ This must be called after PaUtil_InitializeBufferProcessor() and before the
+ stream is started. Only callback streams are supported.
+
+ @param bufferProcessor The buffer processor.
+
+ @param userSampleRate The sample rate of the stream callback.
+
+ @param framesPerUserBuffer The number of frames passed to each call of the
+ stream callback, or paFramesPerBufferUnspecified to use a size close to the
+ host buffer size.
+
+ @param quality The quality of the resampling filters.
+
+ @return paNoError on success, paInvalidSampleRate for blocking streams,
+ or paInsufficientMemory. On failure the buffer processor is unchanged.
+
+ @see PaUtil_GetBufferProcessorResamplingInputLatency,
+ PaUtil_GetBufferProcessorResamplingOutputLatency
+*/
+PaError PaUtil_EnableBufferProcessorResampling( PaUtilBufferProcessor* bufferProcessor,
+        double userSampleRate, unsigned long framesPerUserBuffer, PaUtilResamplerQuality quality );
+
+
+/** Retrieve the input latency added by resampling, in seconds. 0 if resampling
+ is not enabled. */
+PaTime PaUtil_GetBufferProcessorResamplingInputLatency( PaUtilBufferProcessor* bufferProcessor );
+
+
+/** Retrieve the output latency added by resampling, in seconds. 0 if
+ resampling is not enabled. */
+PaTime PaUtil_GetBufferProcessorResamplingOutputLatency( PaUtilBufferProcessor* bufferProcessor );
+
+
+/** Route the channels of the user buffers to different host channels.
+
+ The buffer processor is reinitialized so that the stream callback passed to
+ PaUtil_InitializeBufferProcessor() is called with userInputChannelCount and
+ userOutputChannelCount channels, in the same sample formats, while the host
+ channel counts are unchanged.
+
+ When every route of a direction has unity gain and connects a distinct pair
+ of channels, samples are copied without conversion, and non-interleaved user
+ buffers point directly into the buffers of the host channels. Otherwise the
+ routes are mixed in Float32.
+
+ This must be called while the stream is stopped. It may be called again to
+ change the routing. Output gains set with PaUtil_SetBufferProcessorOutputGain()
+ are reset.
+
+ @param bufferProcessor The buffer processor.
+
+ @param userInputChannelCount The number of user input channels, or 0 to
+ leave the input channels unchanged.
+
+ @param inputRoutes inputRouteCount routes, whose deviceChannel is a host
+ input channel and userChannel a user input channel.
+
+ @param userOutputChannelCount The number of user output channels, or 0 to
+ leave the output channels unchanged.
+
+ @param outputRoutes outputRouteCount routes, whose userChannel is a user
+ output channel and deviceChannel a host output channel.
+
+ @return paNoError on success, paInvalidChannelCount if a route refers to a
+ channel which doesn't exist, paIncompatibleStreamHostApi for blocking
+ streams, paInvalidFlag if resampling is enabled, or paInsufficientMemory.
+ On failure the buffer processor is unchanged.
+*/
+PaError PaUtil_EnableBufferProcessorRouting( PaUtilBufferProcessor* bufferProcessor,
+        int userInputChannelCount, const PaChannelRoute *inputRoutes, unsigned long inputRouteCount,
+        int userOutputChannelCount, const PaChannelRoute *outputRoutes, unsigned long outputRouteCount );
+
+
+/** Set a callback which is called with all of the complete user buffers in
+ the temp buffers at once, instead of calling the stream callback for each of
+ them. The user buffers are passed as pointers into the temp buffers.
+
+ The buffer processor must have been initialized with the paBatchUserBuffers
+ flag, which selects the adapting processors even when the host buffer size
+ is a multiple of the user buffer size. Only the first user buffer is passed
+ if the user buffers can't be aligned (see PaUtil_InitializeBufferProcessor()).
+
+ This must be called while the stream is stopped.
+
+ @param bufferProcessor The buffer processor.
+
+ @param batchCallback The callback, or NULL to call the stream callback again.
+
+ @return paNoError on success, paInvalidFlag if the buffer processor wasn't
+ initialized with paBatchUserBuffers and a non-zero framesPerUserBuffer, or
+ resampling or routing is enabled, paIncompatibleStreamHostApi for blocking
+ streams, or paInsufficientMemory.
+*/
+PaError PaUtil_SetBufferProcessorBatchCallback( PaUtilBufferProcessor* bufferProcessor,
+        PaStreamBatchCallback *batchCallback );
+
+
+/** Set a callback which is called with the events posted by
+ PaUtil_PostBufferProcessorEvent(), and allocate a queue for them.
+
+ Before each call to the stream callback, the events whose time falls before
+ the end of the user buffer are removed from the queue and passed to the event
+ callback, with their offset in frames from the start of the buffer. When
+ framesPerUserBuffer is 0 the user buffer is split at each event, so that every
+ event is delivered at offset 0 of the buffer it applies to.
+
+ This must be called while the stream is stopped.
+
+ @param bufferProcessor The buffer processor.
+
+ @param eventCallback The callback, or NULL to free the queue.
+
+ @param maxPendingEvents The number of events which may be queued, from 1 to
+ PA_RINGBUFFER_MAX_ELEMENT_COUNT.
+
+ @return paNoError on success, paInvalidFlag if resampling, routing or a batch
+ callback is enabled, paIncompatibleStreamHostApi for blocking streams,
+ paBufferTooSmall if maxPendingEvents is 0, paInsufficientMemory if the queue
+ is too large or can't be allocated, or paInternalError if the queue can't be
+ initialized.
+*/
+PaError PaUtil_SetBufferProcessorEventCallback( PaUtilBufferProcessor* bufferProcessor,
+        PaStreamEventCallback *eventCallback, unsigned long maxPendingEvents );
+
+
+/** Queue an event for the event callback.
+
+ This function doesn't block or allocate memory. It may be called from one
+ thread at a time while the buffer processor is in use by the callback thread.
+
+ @param bufferProcessor The buffer processor.
+
+ @param event The event, which is copied into the queue.
+
+ @return paNoError, paStreamEventQueueFull if the queue is full, or
+ paNullCallback if no event callback has been set.
+*/
+PaError PaUtil_PostBufferProcessorEvent( PaUtilBufferProcessor* bufferProcessor,
+        const PaStreamEvent *event );
+
+
+/** Retrieve the time spent in each stage of buffer processing.
+
+ The stages are timed with the processor's cycle counter where available,
+ otherwise with a monotonic clock, and accumulated for each call to
+ PaUtil_EndBufferProcessing(), PaUtil_CopyInput() or PaUtil_CopyOutput(). The
+ times are published with a sequence counter so that this function may be
+ called from any thread without blocking the processing thread.
+
+ @param bufferProcessor The buffer processor.
+
+ @param times Receives the times in seconds.
+
+ @return paNoError, or paIncompatibleStreamHostApi if PA_PROCESS_STAGE_TIMING
+ is 0.
+*/
+PaError PaUtil_GetBufferProcessorStageTimes( PaUtilBufferProcessor* bufferProcessor,
+        PaStreamProcessingTimes *times );
+
+
+/** Set the gain applied to an output channel. The gain is applied while the
+ user output is converted to the host format, and changes are ramped over a
+ few milliseconds to avoid clicks. Gain changes made before the stream is
+ started take effect immediately.
+
+ This function doesn't block or allocate memory, and may be called from any
+ thread while the buffer processor is in use by the callback thread.
+
+ @param bufferProcessor The buffer processor.
+
+ @param channel The output channel, from 0 to outputChannelCount-1.
+
+ @param gain The linear gain. 1.0 leaves the channel unchanged.
+
+ @return paInvalidChannelCount if the channel is out of range,
+ paSampleFormatNotSupported if no converters are available for applying the
+ gain, otherwise paNoError.
+
+ @see Pa_SetStreamChannelGain
+*/
+PaError PaUtil_SetBufferProcessorOutputGain( PaUtilBufferProcessor* bufferProcessor,
+        unsigned int channel, float gain );
+
 /*@}*/
 
 
@@ -0,0 +1,394 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library sample rate converter
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Polyphase sample rate converter used by the buffer processor.
+
+ The prototype filter is a sinc windowed by a 4 term Blackman-Harris window,
+ with its cutoff just below the Nyquist frequency of the lower of the two
+ sample rates. When downsampling the filter is stretched, so the number of
+ taps grows with the ratio.
+
+ Output frame i is centred at input position i * step, relative to the first
+ input frame. The history buffer starts with tapCount/2 - 1 frames of silence,
+ so the first output frame can be computed once tapCount/2 + 1 input frames
+ have been written.
+*/
+
+#include <string.h> /* memset(), memmove() */
+#include <math.h>
+
+#include "pa_resampler.h"
+#include "pa_util.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PA_RESAMPLER_SSE2_
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PA_RESAMPLER_NEON_
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+#define PA_RESAMPLER_MAX_TAPS_  (1024)
+
+
+typedef struct PaUtilResamplerQualitySettings{
+    unsigned int tapCount;  /* at a ratio of 1 */
+    unsigned int phaseCount;
+    double rolloff;         /* cutoff as a fraction of the Nyquist frequency */
+} PaUtilResamplerQualitySettings;
+
+static const PaUtilResamplerQualitySettings qualitySettings_[] =
+{
+    { 16, 64, 0.80 },   /* paUtilResamplerQualityLow */
+    { 32, 128, 0.90 },  /* paUtilResamplerQualityMedium */
+    { 64, 256, 0.94 }   /* paUtilResamplerQualityHigh */
+};
+
+
+static double BlackmanHarris( double x )
+{
+    return 0.35875 - 0.48829 * cos( 2.0 * M_PI * x ) + 0.14128 * cos( 4.0 * M_PI * x )
+            - 0.01168 * cos( 6.0 * M_PI * x );
+}
+
+
+/* Tabulate the filter at phaseCount + 1 fractional positions from 0 to 1, so
+ that coefficients can be interpolated between phase j and j + 1 for any j
+ below phaseCount. Each phase is normalized to unity gain at DC. */
+static void ComputeCoefficients( PaUtilResampler *resampler, double cutoff )
+{
+    unsigned int tapCount = resampler->tapCount;
+    double halfLength = tapCount / 2;
+    unsigned int j, k;
+
+    for( j = 0; j <= resampler->phaseCount; ++j )
+    {
+        float *row = resampler->coefficients + j * tapCount;
+        double fraction = (double)j / resampler->phaseCount;
+        double sum = 0.0;
+
+        for( k = 0; k < tapCount; ++k )
+        {
+            double x = (double)k - (halfLength - 1.0) - fraction;
+            double arg = 2.0 * M_PI * cutoff * x;
+            double sinc = ( x == 0.0 ) ? 1.0 : sin( arg ) / arg;
+            double value = 2.0 * cutoff * sinc * BlackmanHarris( (x + halfLength) / (2.0 * halfLength) );
+
+            row[k] = (float)value;
+            sum += value;
+        }
+
+        for( k = 0; k < tapCount; ++k )
+            row[k] = (float)(row[k] / sum);
+    }
+}
+
+
+PaError PaUtil_InitializeResampler( PaUtilResampler *resampler, unsigned int channelCount,
+        double inputSampleRate, double outputSampleRate, PaUtilResamplerQuality quality,
+        unsigned long maxFramesPerWrite )
+{
+    const PaUtilResamplerQualitySettings *settings = &qualitySettings_[quality];
+    double ratio, tapCount;
+
+    resampler->coefficients = 0;
+    resampler->interpolatedCoefficients = 0;
+    resampler->history = 0;
+
+    if( inputSampleRate <= 0.0 || outputSampleRate <= 0.0 )
+        return paInvalidSampleRate;
+
+    ratio = outputSampleRate / inputSampleRate;
+
+    resampler->channelCount = channelCount;
+    resampler->step = 1.0 / ratio;
+    resampler->phaseCount = settings->phaseCount;
+
+    /* widen the filter by the downsampling ratio, rounded up to a multiple of 4 */
+    tapCount = ( ratio < 1.0 ) ? settings->tapCount / ratio : settings->tapCount;
+    if( tapCount > PA_RESAMPLER_MAX_TAPS_ )
+        tapCount = PA_RESAMPLER_MAX_TAPS_;
+    resampler->tapCount = ((unsigned int)ceil( tapCount ) + 3) & ~3U;
+
+    resampler->historyCapacity = 2 * resampler->tapCount + maxFramesPerWrite + (unsigned long)ceil( resampler->step );
+
+    resampler->coefficients = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * (resampler->phaseCount + 1) * resampler->tapCount) );
+    resampler->interpolatedCoefficients = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * resampler->tapCount) );
+    resampler->history = (float*)PaUtil_AllocateZeroInitializedMemory(
+            (long)(sizeof(float) * channelCount * resampler->historyCapacity) );
+    if( !resampler->coefficients || !resampler->interpolatedCoefficients || !resampler->history )
+    {
+        PaUtil_TerminateResampler( resampler );
+        return paInsufficientMemory;
+    }
+
+    ComputeCoefficients( resampler, 0.5 * settings->rolloff * (( ratio < 1.0 ) ? ratio : 1.0) );
+
+    PaUtil_ResetResampler( resampler );
+
+    return paNoError;
+}
+
+
+void PaUtil_TerminateResampler( PaUtilResampler *resampler )
+{
+    if( resampler->coefficients )
+        PaUtil_FreeMemory( resampler->coefficients );
+    resampler->coefficients = 0;
+
+    if( resampler->interpolatedCoefficients )
+        PaUtil_FreeMemory( resampler->interpolatedCoefficients );
+    resampler->interpolatedCoefficients = 0;
+
+    if( resampler->history )
+        PaUtil_FreeMemory( resampler->history );
+    resampler->history = 0;
+}
+
+
+void PaUtil_ResetResampler( PaUtilResampler *resampler )
+{
+    resampler->historyFrames = resampler->tapCount / 2 - 1;
+    resampler->readIndex = 0;
+    resampler->fraction = 0.0;
+
+    memset( resampler->history, 0,
+            sizeof(float) * resampler->channelCount * resampler->historyCapacity );
+}
+
+
+/* discard the history frames which are no longer needed */
+static void CompactHistory( PaUtilResampler *resampler )
+{
+    unsigned long discard = resampler->readIndex;
+    unsigned int c;
+
+    if( discard > resampler->historyFrames )
+        discard = resampler->historyFrames;
+
+    if( discard == 0 )
+        return;
+
+    for( c = 0; c < resampler->channelCount; ++c )
+    {
+        float *history = resampler->history + c * resampler->historyCapacity;
+        memmove( history, history + discard, sizeof(float) * (resampler->historyFrames - discard) );
+    }
+
+    resampler->historyFrames -= discard;
+    resampler->readIndex -= discard;
+}
+
+
+unsigned long PaUtil_WriteResamplerInput( PaUtilResampler *resampler,
+        const float *const *channels, unsigned long frameCount )
+{
+    unsigned long framesToWrite;
+    unsigned int c;
+
+    if( resampler->historyFrames + frameCount > resampler->historyCapacity )
+        CompactHistory( resampler );
+
+    framesToWrite = resampler->historyCapacity - resampler->historyFrames;
+    if( framesToWrite > frameCount )
+        framesToWrite = frameCount;
+
+    for( c = 0; c < resampler->channelCount; ++c )
+    {
+        float *history = resampler->history + c * resampler->historyCapacity + resampler->historyFrames;
+
+        if( channels )
+            memcpy( history, channels[c], sizeof(float) * framesToWrite );
+        else
+            memset( history, 0, sizeof(float) * framesToWrite );
+    }
+
+    resampler->historyFrames += framesToWrite;
+
+    return framesToWrite;
+}
+
+
+/* Interpolate the coefficients for a fractional position between two phases. */
+static void InterpolateCoefficients( float *dest, const float *row0, const float *row1,
+        float weight, unsigned int tapCount )
+{
+    unsigned int k;
+
+#if defined(PA_RESAMPLER_SSE2_)
+    __m128 w = _mm_set1_ps( weight );
+    for( k = 0; k < tapCount; k += 4 )
+    {
+        __m128 c0 = _mm_loadu_ps( row0 + k );
+        __m128 c1 = _mm_loadu_ps( row1 + k );
+        _mm_storeu_ps( dest + k, _mm_add_ps( c0, _mm_mul_ps( w, _mm_sub_ps( c1, c0 ) ) ) );
+    }
+#else
+    for( k = 0; k < tapCount; ++k )
+        dest[k] = row0[k] + weight * (row1[k] - row0[k]);
+#endif
+}
+
+
+/* Dot product of tapCount coefficients and samples, tapCount is a multiple of 4. */
+static float DotProduct( const float *coefficients, const float *samples, unsigned int tapCount )
+{
+    unsigned int k;
+
+#if defined(PA_RESAMPLER_SSE2_)
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    float result[4];
+
+    for( k = 0; k + 8 <= tapCount; k += 8 )
+    {
+        sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( coefficients + k ), _mm_loadu_ps( samples + k ) ) );
+        sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( coefficients + k + 4 ), _mm_loadu_ps( samples + k + 4 ) ) );
+    }
+    if( k < tapCount )
+        sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( coefficients + k ), _mm_loadu_ps( samples + k ) ) );
+
+    _mm_storeu_ps( result, _mm_add_ps( sum0, sum1 ) );
+    return (result[0] + result[1]) + (result[2] + result[3]);
+#elif defined(PA_RESAMPLER_NEON_)
+    float32x4_t sum = vdupq_n_f32( 0.0f );
+
+    for( k = 0; k < tapCount; k += 4 )
+        sum = vmlaq_f32( sum, vld1q_f32( coefficients + k ), vld1q_f32( samples + k ) );
+
+    return vaddvq_f32( sum );
+#else
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+
+    for( k = 0; k < tapCount; k += 4 )
+    {
+        sum0 += coefficients[k] * samples[k];
+        sum1 += coefficients[k + 1] * samples[k + 1];
+        sum2 += coefficients[k + 2] * samples[k + 2];
+        sum3 += coefficients[k + 3] * samples[k + 3];
+    }
+
+    return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+
+unsigned long PaUtil_ReadResamplerOutput( PaUtilResampler *resampler,
+        float **channels, unsigned long frameCount )
+{
+    unsigned int tapCount = resampler->tapCount;
+    unsigned long i;
+    unsigned int c;
+
+    for( i = 0; i < frameCount; ++i )
+    {
+        double position;
+        unsigned int phase;
+        unsigned long advance;
+
+        if( resampler->readIndex + tapCount > resampler->historyFrames )
+            break;
+
+        position = resampler->fraction * resampler->phaseCount;
+        phase = (unsigned int)position;
+        InterpolateCoefficients( resampler->interpolatedCoefficients,
+                resampler->coefficients + phase * tapCount,
+                resampler->coefficients + (phase + 1) * tapCount,
+                (float)(position - phase), tapCount );
+
+        for( c = 0; c < resampler->channelCount; ++c )
+        {
+            const float *history = resampler->history + c * resampler->historyCapacity
+                    + resampler->readIndex;
+            channels[c][i] = DotProduct( resampler->interpolatedCoefficients, history, tapCount );
+        }
+
+        resampler->fraction += resampler->step;
+        advance = (unsigned long)resampler->fraction;
+        resampler->fraction -= advance;
+        resampler->readIndex += advance;
+    }
+
+    return i;
+}
+
+
+unsigned long PaUtil_GetResamplerInputFramesNeeded( PaUtilResampler *resampler,
+        unsigned long frameCount )
+{
+    unsigned long lastReadIndex, framesNeeded;
+
+    if( frameCount == 0 )
+        return 0;
+
+    lastReadIndex = resampler->readIndex
+            + (unsigned long)(resampler->fraction + (frameCount - 1) * resampler->step);
+    framesNeeded = lastReadIndex + resampler->tapCount;
+
+    return ( framesNeeded > resampler->historyFrames ) ? framesNeeded - resampler->historyFrames : 0;
+}
+
+
+unsigned long PaUtil_GetResamplerOutputFramesAvailable( PaUtilResampler *resampler )
+{
+    double span;
+
+    if( resampler->readIndex + resampler->tapCount > resampler->historyFrames )
+        return 0;
+
+    /* frame i can be computed while fraction + i * step < span */
+    span = (double)(resampler->historyFrames - resampler->tapCount - resampler->readIndex) + 1.0
+            - resampler->fraction;
+
+    return (unsigned long)ceil( span / resampler->step );
+}
+
+
+double PaUtil_GetResamplerLatencyFrames( PaUtilResampler *resampler )
+{
+    return resampler->tapCount / 2;
+}
@@ -0,0 +1,169 @@
+#ifndef PA_RESAMPLER_H
+#define PA_RESAMPLER_H
+/*
+ * $Id$
+ * Portable Audio I/O Library sample rate converter
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief Polyphase sample rate converter used by the buffer processor.
+
+ The converter is a windowed sinc interpolator. The filter is tabulated at a
+ number of fractional phases, and the coefficients for an arbitrary fractional
+ position are linearly interpolated between the two nearest phases, so any
+ ratio between the input and output sample rate is supported.
+
+ Samples are Float32 and non-interleaved. Input is written into a history
+ buffer with PaUtil_WriteResamplerInput() and output is read with
+ PaUtil_ReadResamplerOutput(), which produces as many frames as the buffered
+ input allows.
+*/
+
+#include "portaudio.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Trade off between the quality of the filter and the latency and CPU time
+ it costs. */
+typedef enum {
+    /** 16 taps at unity ratio: the shortest latency, with some aliasing near
+     the Nyquist frequency. */
+    paUtilResamplerQualityLow,
+    /** 32 taps at unity ratio */
+    paUtilResamplerQualityMedium,
+    /** 64 taps at unity ratio: a steep filter with negligible aliasing, at
+     twice the latency of paUtilResamplerQualityMedium. */
+    paUtilResamplerQualityHigh
+} PaUtilResamplerQuality;
+
+
+/** @brief State of a sample rate converter.
+ All fields are private, use the functions below. */
+typedef struct PaUtilResampler{
+    unsigned int channelCount;
+    double step;                /**< input frames advanced per output frame */
+    unsigned int phaseCount;
+    unsigned int tapCount;      /**< a multiple of 4 */
+    float *coefficients;        /**< (phaseCount + 1) rows of tapCount coefficients */
+    float *interpolatedCoefficients; /**< the coefficients for the current output frame */
+    float *history;             /**< channelCount buffers of historyCapacity samples */
+    unsigned long historyCapacity;
+    unsigned long historyFrames; /**< frames in each history buffer */
+    unsigned long readIndex;    /**< first history frame used by the next output frame */
+    double fraction;            /**< fractional input position of the next output frame */
+} PaUtilResampler;
+
+
+/** Initialize a sample rate converter.
+
+ @param resampler The converter to initialize.
+
+ @param channelCount The number of channels.
+
+ @param inputSampleRate The sample rate of the input.
+
+ @param outputSampleRate The sample rate of the output.
+
+ @param quality The filter quality.
+
+ @param maxFramesPerWrite The largest number of frames which will be written
+ with one call to PaUtil_WriteResamplerInput(). The history buffer is sized to
+ accept this many frames in addition to the filter length.
+
+ @return paInsufficientMemory if the tables could not be allocated,
+ paInvalidSampleRate if either rate is not positive, otherwise paNoError.
+*/
+PaError PaUtil_InitializeResampler( PaUtilResampler *resampler, unsigned int channelCount,
+        double inputSampleRate, double outputSampleRate, PaUtilResamplerQuality quality,
+        unsigned long maxFramesPerWrite );
+
+
+/** Release the memory allocated by PaUtil_InitializeResampler(). */
+void PaUtil_TerminateResampler( PaUtilResampler *resampler );
+
+
+/** Discard all buffered input, as if the converter had just been initialized. */
+void PaUtil_ResetResampler( PaUtilResampler *resampler );
+
+
+/** Append input frames to the history buffer.
+
+ @param channels An array of channelCount pointers to the input samples. If
+ channels is NULL silence is written.
+
+ @return The number of frames written, which is less than frameCount only if
+ the history buffer is full.
+*/
+unsigned long PaUtil_WriteResamplerInput( PaUtilResampler *resampler,
+        const float *const *channels, unsigned long frameCount );
+
+
+/** Compute output frames from the buffered input.
+
+ @param channels An array of channelCount pointers to the output buffers.
+
+ @return The number of frames computed, which is less than frameCount if there
+ isn't enough buffered input.
+*/
+unsigned long PaUtil_ReadResamplerOutput( PaUtilResampler *resampler,
+        float **channels, unsigned long frameCount );
+
+
+/** Retrieve the number of input frames which must be written before
+ frameCount output frames can be read. */
+unsigned long PaUtil_GetResamplerInputFramesNeeded( PaUtilResampler *resampler,
+        unsigned long frameCount );
+
+
+/** Retrieve the number of frames which can be read without writing more input. */
+unsigned long PaUtil_GetResamplerOutputFramesAvailable( PaUtilResampler *resampler );
+
+
+/** Retrieve the delay introduced by the filter, in input frames. */
+double PaUtil_GetResamplerLatencyFrames( PaUtilResampler *resampler );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_RESAMPLER_H */
@@ -52,34 +52,219 @@
  @ingroup common_src
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for syscall() and MAP_ANONYMOUS */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include "pa_ringbuffer.h"
 #include <string.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <linux/futex.h>
+#if defined(__NR_memfd_create)
+#define PA_RINGBUFFER_MIRRORING
+#endif
+#if defined(SYS_futex) && defined(__ATOMIC_SEQ_CST)
+#define PA_RINGBUFFER_WAITING
+#endif
+#endif
+
+/*
+    The indices are published with release stores and observed with acquire
+    loads: the writer's release of writeIndex makes the elements it wrote
+    visible to a reader which acquires it, and the reader's release of
+    readIndex ensures that it has finished reading elements before the writer
+    can overwrite them. GCC and Clang provide these as the __atomic builtins,
+    which have the semantics of the C11 atomic_load_explicit() and
+    atomic_store_explicit() functions but can be applied to the plain
+    ring_buffer_size_t fields. Other compilers fall back to full memory
+    barriers.
+*/
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+
+static ring_buffer_size_t LoadAcquire( const volatile ring_buffer_size_t *index )
+{
+    return __atomic_load_n( index, __ATOMIC_ACQUIRE );
+}
+
+static void StoreRelease( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+    __atomic_store_n( index, value, __ATOMIC_RELEASE );
+}
+
+#else /* no __atomic builtins */
+
 #include "pa_memorybarrier.h"
 
+static ring_buffer_size_t LoadAcquire( const volatile ring_buffer_size_t *index )
+{
+    ring_buffer_size_t result = *index;
+    PaUtil_FullMemoryBarrier();
+    return result;
+}
+
+static void StoreRelease( volatile ring_buffer_size_t *index, ring_buffer_size_t value )
+{
+    PaUtil_FullMemoryBarrier();
+    *index = value;
+}
+
+#endif /* __ATOMIC_ACQUIRE */
+
+/*
+    Indices run from 0 to 2*bufferSize-1, which distinguishes a full buffer
+    from an empty one. They are wrapped by comparing and subtracting rather
+    than masking, so bufferSize needn't be a power of 2.
+*/
+
+/* Return the number of elements from readIndex up to writeIndex. */
+static ring_buffer_size_t IndexDistance( const PaUtilRingBuffer *rbuf, ring_buffer_size_t writeIndex, ring_buffer_size_t readIndex )
+{
+    ring_buffer_size_t distance = writeIndex - readIndex;
+    if( distance < 0 ) distance += 2 * rbuf->bufferSize;
+    return distance;
+}
+
+/* Return index advanced by elementCount elements. */
+static ring_buffer_size_t AdvanceIndex( const PaUtilRingBuffer *rbuf, ring_buffer_size_t index, ring_buffer_size_t elementCount )
+{
+    index += elementCount;
+    if( index >= 2 * rbuf->bufferSize ) index -= 2 * rbuf->bufferSize;
+    return index;
+}
+
+/* Return the position in the buffer of the element at index. */
+static ring_buffer_size_t ElementPosition( const PaUtilRingBuffer *rbuf, ring_buffer_size_t index )
+{
+    return ( index >= rbuf->bufferSize ) ? index - rbuf->bufferSize : index;
+}
+
 /***************************************************************************
  * Initialize FIFO.
- * elementCount must be power of 2, returns -1 if not.
+ * elementCount must be greater than 0 and no more than
+ * PA_RINGBUFFER_MAX_ELEMENT_COUNT, returns -1 if not.
  */
 ring_buffer_size_t PaUtil_InitializeRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount, void *dataPtr )
 {
-    if( ((elementCount-1) & elementCount) != 0) return -1; /* Not Power of two. */
+    if( elementCount <= 0 || elementCount > PA_RINGBUFFER_MAX_ELEMENT_COUNT ) return -1;
     rbuf->bufferSize = elementCount;
     rbuf->buffer = (char *)dataPtr;
+    rbuf->isMirrored = 0;
+    rbuf->isWaitable = 0;
     PaUtil_FlushRingBuffer( rbuf );
-    rbuf->bigMask = (elementCount*2)-1;
-    rbuf->smallMask = (elementCount)-1;
     rbuf->elementSizeBytes = elementSizeBytes;
     return 0;
 }
 
+/***************************************************************************
+ * Initialize FIFO in memory which is mapped twice.
+ * The same memfd pages are mapped at buffer and at buffer + size, in a
+ * reservation of twice the size so that nothing else can be mapped between.
+ */
+ring_buffer_size_t PaUtil_InitializeMirroredRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount )
+{
+#if defined(PA_RINGBUFFER_MIRRORING)
+    size_t size = (size_t)elementCount * elementSizeBytes;
+    long pageSize = sysconf( _SC_PAGESIZE );
+    char *mapping;
+    int fd;
+
+    if( elementCount <= 0 || elementCount > PA_RINGBUFFER_MAX_ELEMENT_COUNT ) return -1;
+    /* the buffer is reserved twice over */
+    if( elementSizeBytes <= 0 || (size_t)elementSizeBytes > ((size_t)-1 / 2) / (size_t)elementCount ) return -1;
+    if( pageSize <= 0 || size % pageSize != 0 ) return -1;
+
+    fd = (int)syscall( __NR_memfd_create, "PaUtilRingBuffer", 1U /* MFD_CLOEXEC */ );
+    if( fd < 0 ) return -1;
+    if( ftruncate( fd, (off_t)size ) != 0 )
+    {
+        close( fd );
+        return -1;
+    }
+
+    mapping = (char *)mmap( NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( mapping == MAP_FAILED )
+    {
+        close( fd );
+        return -1;
+    }
+    if( mmap( mapping, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED
+            || mmap( mapping + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED )
+    {
+        munmap( mapping, size * 2 );
+        close( fd );
+        return -1;
+    }
+    close( fd ); /* the mappings keep the memory alive */
+
+    PaUtil_InitializeRingBuffer( rbuf, elementSizeBytes, elementCount, mapping );
+    rbuf->isMirrored = 1;
+    return 0;
+#else
+    (void)rbuf;
+    (void)elementSizeBytes;
+    (void)elementCount;
+    return -1;
+#endif
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_GetMirroredRingBufferElementCount( ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount )
+{
+#if defined(PA_RINGBUFFER_MIRRORING)
+    long pageSize = sysconf( _SC_PAGESIZE );
+    long a, b, t, step;
+
+    if( pageSize <= 0 || elementSizeBytes <= 0 || elementCount <= 0 ) return elementCount;
+
+    /* the smallest number of elements which fills whole pages */
+    a = pageSize;
+    b = elementSizeBytes;
+    while( b != 0 )
+    {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    step = pageSize / a;
+
+    if( elementCount > PA_RINGBUFFER_MAX_ELEMENT_COUNT - (step - 1) ) return elementCount;
+    return ((elementCount + step - 1) / step) * step;
+#else
+    (void)elementSizeBytes;
+    return elementCount;
+#endif
+}
+
+/***************************************************************************
+*/
+void PaUtil_TerminateMirroredRingBuffer( PaUtilRingBuffer *rbuf )
+{
+#if defined(PA_RINGBUFFER_MIRRORING)
+    if( rbuf->isMirrored )
+    {
+        munmap( rbuf->buffer, (size_t)rbuf->bufferSize * rbuf->elementSizeBytes * 2 );
+        rbuf->buffer = NULL;
+        rbuf->isMirrored = 0;
+    }
+#else
+    (void)rbuf;
+#endif
+}
+
 /***************************************************************************
 ** Return number of elements available for reading. */
 ring_buffer_size_t PaUtil_GetRingBufferReadAvailable( const PaUtilRingBuffer *rbuf )
 {
-    return ( (rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask );
+    return IndexDistance( rbuf, LoadAcquire( &rbuf->writeIndex ), LoadAcquire( &rbuf->readIndex ) );
 }
 /***************************************************************************
 ** Return number of elements available for writing. */
@@ -93,7 +278,32 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteAvailable( const PaUtilRingBuffer *r
 void PaUtil_FlushRingBuffer( PaUtilRingBuffer *rbuf )
 {
     rbuf->writeIndex = rbuf->readIndex = 0;
+    rbuf->cachedWriteIndex = rbuf->cachedReadIndex = 0;
+    rbuf->readWaitThreshold = rbuf->writeWaitThreshold = 0;
+}
+
+#if defined(PA_RINGBUFFER_WAITING)
+/*
+    A waiting thread stores the number of elements it needs in its threshold
+    and sleeps on it as a futex word. The other thread checks the threshold
+    after advancing its index, and only makes a system call to wake the
+    waiter once the threshold is reached. The fences order each thread's
+    store before its load of the other thread's store, so either the waiter
+    sees the new index or the other thread sees the threshold.
+*/
+static void WakeWaiter( volatile int *threshold, ring_buffer_size_t available )
+{
+    int waiting;
+
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    waiting = __atomic_load_n( threshold, __ATOMIC_RELAXED );
+    if( waiting != 0 && available >= waiting
+            && __atomic_compare_exchange_n( threshold, &waiting, 0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+    {
+        syscall( SYS_futex, (int *)threshold, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+    }
 }
+#endif /* PA_RINGBUFFER_WAITING */
 
 /***************************************************************************
 ** Get address of region(s) to which we can write data.
@@ -106,11 +316,18 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
                                        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
 {
     ring_buffer_size_t   index;
-    ring_buffer_size_t   available = PaUtil_GetRingBufferWriteAvailable( rbuf );
-    if( elementCount > available ) elementCount = available;
+    ring_buffer_size_t   writeIndex = rbuf->writeIndex; /* only changed by this thread */
+    ring_buffer_size_t   available = rbuf->bufferSize - IndexDistance( rbuf, writeIndex, rbuf->cachedReadIndex );
+    if( elementCount > available )
+    {
+        /* the cached read index is stale, the reader may have freed more room */
+        rbuf->cachedReadIndex = LoadAcquire( &rbuf->readIndex );
+        available = rbuf->bufferSize - IndexDistance( rbuf, writeIndex, rbuf->cachedReadIndex );
+        if( elementCount > available ) elementCount = available;
+    }
     /* Check to see if write is not contiguous. */
-    index = rbuf->writeIndex & rbuf->smallMask;
-    if( (index + elementCount) > rbuf->bufferSize )
+    index = ElementPosition( rbuf, writeIndex );
+    if( (index + elementCount) > rbuf->bufferSize && !rbuf->isMirrored )
     {
         /* Write data in two blocks that wrap the buffer. */
         ring_buffer_size_t   firstHalf = rbuf->bufferSize - index;
@@ -127,9 +344,6 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
         *sizePtr2 = 0;
     }
 
-    if( available )
-        PaUtil_FullMemoryBarrier(); /* (write-after-read) => full barrier */
-
     return elementCount;
 }
 
@@ -138,11 +352,15 @@ ring_buffer_size_t PaUtil_GetRingBufferWriteRegions( PaUtilRingBuffer *rbuf, rin
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferWriteIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount )
 {
-    /* ensure that previous writes are seen before we update the write index
-       (write after write)
-    */
-    PaUtil_WriteMemoryBarrier();
-    return rbuf->writeIndex = (rbuf->writeIndex + elementCount) & rbuf->bigMask;
+    /* the release store ensures that previous writes are seen before the
+       new write index (write after write) */
+    ring_buffer_size_t writeIndex = AdvanceIndex( rbuf, rbuf->writeIndex, elementCount );
+    StoreRelease( &rbuf->writeIndex, writeIndex );
+#if defined(PA_RINGBUFFER_WAITING)
+    if( rbuf->isWaitable )
+        WakeWaiter( &rbuf->readWaitThreshold, IndexDistance( rbuf, writeIndex, LoadAcquire( &rbuf->readIndex ) ) );
+#endif
+    return writeIndex;
 }
 
 /***************************************************************************
@@ -156,11 +374,18 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
                                 void **dataPtr2, ring_buffer_size_t *sizePtr2 )
 {
     ring_buffer_size_t   index;
-    ring_buffer_size_t   available = PaUtil_GetRingBufferReadAvailable( rbuf ); /* doesn't use memory barrier */
-    if( elementCount > available ) elementCount = available;
+    ring_buffer_size_t   readIndex = rbuf->readIndex; /* only changed by this thread */
+    ring_buffer_size_t   available = IndexDistance( rbuf, rbuf->cachedWriteIndex, readIndex );
+    if( elementCount > available )
+    {
+        /* the cached write index is stale, the writer may have added more data */
+        rbuf->cachedWriteIndex = LoadAcquire( &rbuf->writeIndex );
+        available = IndexDistance( rbuf, rbuf->cachedWriteIndex, readIndex );
+        if( elementCount > available ) elementCount = available;
+    }
     /* Check to see if read is not contiguous. */
-    index = rbuf->readIndex & rbuf->smallMask;
-    if( (index + elementCount) > rbuf->bufferSize )
+    index = ElementPosition( rbuf, readIndex );
+    if( (index + elementCount) > rbuf->bufferSize && !rbuf->isMirrored )
     {
         /* Write data in two blocks that wrap the buffer. */
         ring_buffer_size_t firstHalf = rbuf->bufferSize - index;
@@ -177,20 +402,22 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
         *sizePtr2 = 0;
     }
 
-    if( available )
-        PaUtil_ReadMemoryBarrier(); /* (read-after-read) => read barrier */
-
     return elementCount;
 }
 /***************************************************************************
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferReadIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount )
 {
-    /* ensure that previous reads (copies out of the ring buffer) are always completed before updating (writing) the read index.
-       (write-after-read) => full barrier
-    */
-    PaUtil_FullMemoryBarrier();
-    return rbuf->readIndex = (rbuf->readIndex + elementCount) & rbuf->bigMask;
+    /* the release store ensures that previous reads (copies out of the ring
+       buffer) are completed before the writer can see the new read index
+       (write-after-read) */
+    ring_buffer_size_t readIndex = AdvanceIndex( rbuf, rbuf->readIndex, elementCount );
+    StoreRelease( &rbuf->readIndex, readIndex );
+#if defined(PA_RINGBUFFER_WAITING)
+    if( rbuf->isWaitable )
+        WakeWaiter( &rbuf->writeWaitThreshold, rbuf->bufferSize - IndexDistance( rbuf, LoadAcquire( &rbuf->writeIndex ), readIndex ) );
+#endif
+    return readIndex;
 }
 
 /***************************************************************************
@@ -235,3 +462,98 @@ ring_buffer_size_t PaUtil_ReadRingBuffer( PaUtilRingBuffer *rbuf, void *data, ri
     PaUtil_AdvanceRingBufferReadIndex( rbuf, numRead );
     return numRead;
 }
+
+/***************************************************************************
+*/
+int PaUtil_EnableRingBufferWaiting( PaUtilRingBuffer *rbuf )
+{
+#if defined(PA_RINGBUFFER_WAITING)
+    rbuf->isWaitable = 1;
+    return 0;
+#else
+    (void)rbuf;
+    return -1;
+#endif
+}
+
+/***************************************************************************
+** Wait on threshold until getAvailable() returns at least elementCount.
+** Returns the number of elements available. */
+static ring_buffer_size_t WaitForAvailable( PaUtilRingBuffer *rbuf, volatile int *threshold,
+        ring_buffer_size_t (*getAvailable)( const PaUtilRingBuffer * ),
+        ring_buffer_size_t elementCount, long timeoutMs )
+{
+    ring_buffer_size_t available = getAvailable( rbuf );
+#if defined(PA_RINGBUFFER_WAITING)
+    struct timespec deadline, now, timeout;
+    int waiting;
+
+    if( !rbuf->isWaitable )
+        return available;
+    if( elementCount > rbuf->bufferSize )
+        elementCount = rbuf->bufferSize;
+
+    if( timeoutMs >= 0 )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &deadline );
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (timeoutMs % 1000) * 1000000L;
+        if( deadline.tv_nsec >= 1000000000L )
+        {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    while( available < elementCount )
+    {
+        if( timeoutMs >= 0 )
+        {
+            clock_gettime( CLOCK_MONOTONIC, &now );
+            timeout.tv_sec = deadline.tv_sec - now.tv_sec;
+            timeout.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if( timeout.tv_nsec < 0 )
+            {
+                timeout.tv_sec -= 1;
+                timeout.tv_nsec += 1000000000L;
+            }
+            if( timeout.tv_sec < 0 )
+                break;
+        }
+
+        __atomic_store_n( threshold, (int)elementCount, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST ); /* pairs with the fence in WakeWaiter() */
+        if( getAvailable( rbuf ) < elementCount )
+        {
+            /* returns early if the threshold was already cleared by WakeWaiter() */
+            syscall( SYS_futex, (int *)threshold, FUTEX_WAIT_PRIVATE, (int)elementCount,
+                    ( timeoutMs >= 0 ) ? &timeout : NULL, NULL, 0 );
+        }
+        waiting = (int)elementCount;
+        __atomic_compare_exchange_n( threshold, &waiting, 0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+
+        available = getAvailable( rbuf );
+    }
+#else
+    (void)threshold;
+    (void)elementCount;
+    (void)timeoutMs;
+#endif
+    return available;
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_WaitForRingBufferReadAvailable( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount, long timeoutMs )
+{
+    return WaitForAvailable( rbuf, &rbuf->readWaitThreshold, PaUtil_GetRingBufferReadAvailable,
+            elementCount, timeoutMs );
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_WaitForRingBufferWriteAvailable( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount, long timeoutMs )
+{
+    return WaitForAvailable( rbuf, &rbuf->writeWaitThreshold, PaUtil_GetRingBufferWriteAvailable,
+            elementCount, timeoutMs );
+}
@@ -59,7 +59,7 @@
  to the ring buffer, another thread or callback reads from it).
 
  The PaUtilRingBuffer structure manages a ring buffer containing N
- elements, where N must be a power of two. An element may be any size
+ elements, where N may be any positive number. An element may be any size
  (specified in bytes).
 
  The memory area used to store the buffer elements must be allocated by
@@ -90,15 +90,50 @@ extern "C"
 {
 #endif /* __cplusplus */
 
+/** The cache line size assumed when separating the reader's and writer's
+ fields of a PaUtilRingBuffer. Define it to override the default.
+*/
+#ifndef PA_RINGBUFFER_CACHE_LINE_SIZE
+#if defined(__APPLE__) && defined(__aarch64__)
+#define PA_RINGBUFFER_CACHE_LINE_SIZE (128)
+#else
+#define PA_RINGBUFFER_CACHE_LINE_SIZE (64)
+#endif
+#endif
+
+/** The largest number of elements a ring buffer may contain, less than 2^29.
+ The indices run up to twice the buffer size, and must stay well within a
+ 32-bit ring_buffer_size_t.
+*/
+#define PA_RINGBUFFER_MAX_ELEMENT_COUNT (0x1FFFFFFFL)
+
+/* The writer's and reader's indices are separated from each other and from
+ the shared read-only fields by a cache line of padding, so that advancing
+ one index doesn't invalidate the line the other thread is reading. Each side
+ also keeps a cached copy of the other side's index, and only reloads it when
+ the cached copy shows too few elements.
+*/
 typedef struct PaUtilRingBuffer
 {
-    ring_buffer_size_t  bufferSize; /**< Number of elements in FIFO. Power of 2. Set by PaUtil_InitRingBuffer. */
-    volatile ring_buffer_size_t  writeIndex; /**< Index of next writable element. Set by PaUtil_AdvanceRingBufferWriteIndex. */
-    volatile ring_buffer_size_t  readIndex;  /**< Index of next readable element. Set by PaUtil_AdvanceRingBufferReadIndex. */
-    ring_buffer_size_t  bigMask;    /**< Used for wrapping indices with extra bit to distinguish full/empty. */
-    ring_buffer_size_t  smallMask;  /**< Used for fitting indices to buffer. */
+    ring_buffer_size_t  bufferSize; /**< Number of elements in FIFO. Set by PaUtil_InitRingBuffer. */
     ring_buffer_size_t  elementSizeBytes; /**< Number of bytes per element. */
     char  *buffer;    /**< Pointer to the buffer containing the actual data. */
+    int  isMirrored;  /**< Non-zero if buffer is mapped a second time directly after itself. Set by PaUtil_InitializeMirroredRingBuffer. */
+    int  isWaitable;  /**< Non-zero if the reader and writer may wait for each other. Set by PaUtil_EnableRingBufferWaiting. */
+
+    char  writerPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  writeIndex; /**< Index of next writable element, from 0 to 2*bufferSize-1 to distinguish full/empty. Set by PaUtil_AdvanceRingBufferWriteIndex. */
+    ring_buffer_size_t  cachedReadIndex; /**< The writer's last observed readIndex. */
+
+    char  readerPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile ring_buffer_size_t  readIndex;  /**< Index of next readable element, from 0 to 2*bufferSize-1. Set by PaUtil_AdvanceRingBufferReadIndex. */
+    ring_buffer_size_t  cachedWriteIndex; /**< The reader's last observed writeIndex. */
+
+    char  waiterPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
+    volatile int  readWaitThreshold;  /**< Elements a waiting reader needs, or 0. */
+    volatile int  writeWaitThreshold; /**< Elements of space a waiting writer needs, or 0. */
+
+    char  endPad[PA_RINGBUFFER_CACHE_LINE_SIZE];
 }PaUtilRingBuffer;
 
 /** Initialize Ring Buffer to empty state ready to have elements written to it.
@@ -107,15 +142,61 @@ typedef struct PaUtilRingBuffer
 
  @param elementSizeBytes The size of a single data element in bytes.
 
- @param elementCount The number of elements in the buffer (must be a power of 2).
+ @param elementCount The number of elements in the buffer (must be greater than 0,
+ and no more than PA_RINGBUFFER_MAX_ELEMENT_COUNT).
 
  @param dataPtr A pointer to a previously allocated area where the data
  will be maintained.  It must be elementCount*elementSizeBytes long.
 
- @return -1 if elementCount is not a power of 2, otherwise 0.
+ @return -1 if elementCount is out of range, otherwise 0.
 */
 ring_buffer_size_t PaUtil_InitializeRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount, void *dataPtr );
 
+/** Initialize a ring buffer whose memory is mapped twice, back to back, so
+ that element bufferSize + i is element i. Regions returned by
+ PaUtil_GetRingBufferReadRegions() and PaUtil_GetRingBufferWriteRegions() are
+ then always contiguous, and their second size is always zero.
+
+ The memory is allocated by this function, filled with zeros, and must be
+ released with PaUtil_TerminateMirroredRingBuffer(). Mirroring is only
+ supported on Linux, and requires elementCount*elementSizeBytes to be a
+ multiple of the page size. Callers should fall back to
+ PaUtil_InitializeRingBuffer() when it fails.
+
+ @param rbuf The ring buffer.
+
+ @param elementSizeBytes The size of a single data element in bytes.
+
+ @param elementCount The number of elements in the buffer (must be greater than 0,
+ and no more than PA_RINGBUFFER_MAX_ELEMENT_COUNT).
+
+ @return 0 on success, or -1 if elementCount is out of range or the buffer
+ can't be mirrored.
+*/
+ring_buffer_size_t PaUtil_InitializeMirroredRingBuffer( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount );
+
+/** Round an element count up so that a ring buffer of that many elements can
+ be mirrored by PaUtil_InitializeMirroredRingBuffer(), ie. so that its size
+ in bytes is a multiple of the page size.
+
+ @param elementSizeBytes The size of a single data element in bytes.
+
+ @param elementCount The minimum number of elements in the buffer.
+
+ @return The rounded element count, or elementCount if mirroring is not
+ supported or the rounded count would be more than
+ PA_RINGBUFFER_MAX_ELEMENT_COUNT.
+*/
+ring_buffer_size_t PaUtil_GetMirroredRingBufferElementCount( ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount );
+
+/** Release the memory of a ring buffer initialized by
+ PaUtil_InitializeMirroredRingBuffer() and set its buffer to NULL. Does
+ nothing if the ring buffer is not mirrored.
+
+ @param rbuf The ring buffer.
+*/
+void PaUtil_TerminateMirroredRingBuffer( PaUtilRingBuffer *rbuf );
+
 /** Reset buffer to empty. Should only be called when buffer is NOT being read or written.
 
  @param rbuf The ring buffer.
@@ -230,6 +311,56 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferReadIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount );
 
+/** Allow the reader and writer to block in
+ PaUtil_WaitForRingBufferReadAvailable() and
+ PaUtil_WaitForRingBufferWriteAvailable(). Must be called after the ring
+ buffer is initialized and before it is used.
+
+ A waiting thread sleeps on a futex, which the other thread only wakes when
+ it advances its index past the waiter's threshold. Advancing an index
+ makes no system call unless a thread is waiting. Waiting is only supported
+ on Linux.
+
+ @param rbuf The ring buffer.
+
+ @return 0 on success, or -1 if waiting isn't supported on this platform.
+*/
+int PaUtil_EnableRingBufferWaiting( PaUtilRingBuffer *rbuf );
+
+/** Wait until at least elementCount elements can be read. May only be called
+ by the reader.
+
+ @param rbuf The ring buffer.
+
+ @param elementCount The number of elements to wait for. It is limited to
+ the size of the buffer.
+
+ @param timeoutMs The maximum time to wait in milliseconds, or a negative
+ value to wait indefinitely.
+
+ @return The number of elements available for reading. This is less than
+ elementCount if the wait timed out, or if waiting isn't enabled, in which
+ case the function returns immediately.
+*/
+ring_buffer_size_t PaUtil_WaitForRingBufferReadAvailable( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount, long timeoutMs );
+
+/** Wait until at least elementCount elements can be written. May only be
+ called by the writer.
+
+ @param rbuf The ring buffer.
+
+ @param elementCount The number of elements to wait for. It is limited to
+ the size of the buffer.
+
+ @param timeoutMs The maximum time to wait in milliseconds, or a negative
+ value to wait indefinitely.
+
+ @return The number of elements available for writing. This is less than
+ elementCount if the wait timed out, or if waiting isn't enabled, in which
+ case the function returns immediately.
+*/
+ring_buffer_size_t PaUtil_WaitForRingBufferWriteAvailable( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount, long timeoutMs );
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
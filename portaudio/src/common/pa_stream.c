@@ -74,6 +74,23 @@ void PaUtil_InitializeStreamInterface( PaUtilStreamInterface *streamInterface,
     streamInterface->Write = Write;
     streamInterface->GetReadAvailable = GetReadAvailable;
     streamInterface->GetWriteAvailable = GetWriteAvailable;
+    streamInterface->AcquireReadBuffer = 0;
+    streamInterface->ReleaseReadBuffer = 0;
+    streamInterface->AcquireWriteBuffer = 0;
+    streamInterface->CommitWriteBuffer = 0;
+}
+
+
+void PaUtil_SetStreamInterfaceBufferLending( PaUtilStreamInterface *streamInterface,
+        PaError (*AcquireReadBuffer)( PaStream*, const void **, unsigned long * ),
+        PaError (*ReleaseReadBuffer)( PaStream*, unsigned long ),
+        PaError (*AcquireWriteBuffer)( PaStream*, void **, unsigned long * ),
+        PaError (*CommitWriteBuffer)( PaStream*, unsigned long ) )
+{
+    streamInterface->AcquireReadBuffer = AcquireReadBuffer;
+    streamInterface->ReleaseReadBuffer = ReleaseReadBuffer;
+    streamInterface->AcquireWriteBuffer = AcquireWriteBuffer;
+    streamInterface->CommitWriteBuffer = CommitWriteBuffer;
 }
 
 
@@ -93,6 +110,11 @@ void PaUtil_InitializeStreamRepresentation( PaUtilStreamRepresentation *streamRe
     streamRepresentation->streamInfo.inputLatency = 0.;
     streamRepresentation->streamInfo.outputLatency = 0.;
     streamRepresentation->streamInfo.sampleRate = 0.;
+
+    streamRepresentation->bufferProcessor = 0;
+
+    streamRepresentation->framesLentForReading = 0;
+    streamRepresentation->framesLentForWriting = 0;
 }
 
 
@@ -77,6 +77,13 @@ typedef struct {
     PaError (*Write)( PaStream* stream, const void *buffer, unsigned long frames );
     signed long (*GetReadAvailable)( PaStream* stream );
     signed long (*GetWriteAvailable)( PaStream* stream );
+
+    /* buffer lending for blocking streams. NULL unless set with
+        PaUtil_SetStreamInterfaceBufferLending() */
+    PaError (*AcquireReadBuffer)( PaStream* stream, const void **buffer, unsigned long *frames );
+    PaError (*ReleaseReadBuffer)( PaStream* stream, unsigned long frames );
+    PaError (*AcquireWriteBuffer)( PaStream* stream, void **buffer, unsigned long *frames );
+    PaError (*CommitWriteBuffer)( PaStream* stream, unsigned long frames );
 } PaUtilStreamInterface;
 
 
@@ -97,6 +104,22 @@ void PaUtil_InitializeStreamInterface( PaUtilStreamInterface *streamInterface,
     signed long (*GetWriteAvailable)( PaStream* stream ) );
 
 
+/** Set the buffer lending functions of a PaUtilStreamInterface structure
+ previously initialized by PaUtil_InitializeStreamInterface, for host APIs
+ which implement Pa_AcquireReadBuffer() and friends. pa_front tracks the
+ number of frames lent, so AcquireReadBuffer and AcquireWriteBuffer are
+ called with a non-zero *frames and only when none of their frames are still
+ lent, and ReleaseReadBuffer and CommitWriteBuffer are only called with up to
+ the number of frames they lent. Either pair may be NULL if the host API
+ doesn't lend buffers in that direction.
+*/
+void PaUtil_SetStreamInterfaceBufferLending( PaUtilStreamInterface *streamInterface,
+    PaError (*AcquireReadBuffer)( PaStream* stream, const void **buffer, unsigned long *frames ),
+    PaError (*ReleaseReadBuffer)( PaStream* stream, unsigned long frames ),
+    PaError (*AcquireWriteBuffer)( PaStream* stream, void **buffer, unsigned long *frames ),
+    PaError (*CommitWriteBuffer)( PaStream* stream, unsigned long frames ) );
+
+
 /** Dummy Read function for use in interfaces to a callback based streams.
  Pass to the Read parameter of PaUtil_InitializeStreamInterface.
  @return An error code indicating that the function has no effect
@@ -152,6 +175,11 @@ typedef struct PaUtilStreamRepresentation {
     PaStreamFinishedCallback *streamFinishedCallback;
     void *userData;
     PaStreamInfo streamInfo;
+    struct PaUtilBufferProcessor *bufferProcessor; /**< the buffer processor used for the stream callback, set by
+                                                        the host API after initializing it. NULL if the host API
+                                                        doesn't use a buffer processor. Used by Pa_SetStreamChannelGain() */
+    unsigned long framesLentForReading; /**< frames lent by Pa_AcquireReadBuffer() and not yet released */
+    unsigned long framesLentForWriting; /**< frames lent by Pa_AcquireWriteBuffer() and not yet committed */
 } PaUtilStreamRepresentation;
 
 
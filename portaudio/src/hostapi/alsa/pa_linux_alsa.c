@@ -633,6 +633,10 @@ typedef struct
     StreamDirection streamDir;
 
     snd_pcm_channel_area_t *channelAreas;  /* Needed for channel adaption */
+
+    /* Buffer lending (blocking mode) */
+    void *lendBuffer;   /* framesPerPeriod frames in the user format, lent when the mmap area can't be */
+    int lentInPlace;    /* Were the lent frames the mmap area? */
 } PaAlsaStreamComponent;
 
 /* Implementation specific stream structure */
@@ -733,6 +737,10 @@ static signed long GetStreamReadAvailable( PaStream* s );
 static signed long GetStreamWriteAvailable( PaStream* s );
 static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames );
 static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
+static PaError AcquireReadBuffer( PaStream* stream, const void **buffer, unsigned long *frames );
+static PaError ReleaseReadBuffer( PaStream* stream, unsigned long frames );
+static PaError AcquireWriteBuffer( PaStream* stream, void **buffer, unsigned long *frames );
+static PaError CommitWriteBuffer( PaStream* stream, unsigned long frames );
 
 
 static const PaAlsaDeviceInfo *GetDeviceInfo( const PaUtilHostApiRepresentation *hostApi, int device )
@@ -795,6 +803,9 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
                                       ReadStream, WriteStream,
                                       GetStreamReadAvailable,
                                       GetStreamWriteAvailable );
+    PaUtil_SetStreamInterfaceBufferLending( &alsaHostApi->blockingStreamInterface,
+                                            AcquireReadBuffer, ReleaseReadBuffer,
+                                            AcquireWriteBuffer, CommitWriteBuffer );
 
     PA_ENSURE( PaUnixThreading_Initialize() );
 
@@ -1974,6 +1985,8 @@ static PaError PaAlsaStreamComponent_Initialize( PaAlsaStreamComponent *self, Pa
     self->canMmap = 0;
     self->nonMmapBuffer = NULL;
     self->nonMmapBufferSize = 0;
+    self->lendBuffer = NULL;
+    self->lentInPlace = 0;
 
     if( !callbackMode && !self->userInterleaved )
     {
@@ -1999,6 +2012,7 @@ static void PaAlsaStreamComponent_Terminate( PaAlsaStreamComponent *self )
     alsa_snd_pcm_close( self->pcm );
     PaUtil_FreeMemory( self->userBuffers ); /* (Ptr can be NULL; PaUtil_FreeMemory includes a NULL check) */
     PaUtil_FreeMemory( self->nonMmapBuffer );
+    PaUtil_FreeMemory( self->lendBuffer );
 }
 
 /*
@@ -2923,6 +2937,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                     numOutputChannels, outputSampleFormat, hostOutputSampleFormat,
                     sampleRate, streamFlags, framesPerBuffer, stream->maxFramesPerHostBuffer,
                     hostBufferSizeMode, callback, userData ) );
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     /* Ok, buffer processor is initialized, now we can deduce it's latency */
     if( numInputChannels > 0 )
@@ -4675,6 +4690,197 @@ error:
     return result;
 }
 
+/* Buffer lending. Only mmap capable pcms are supported, so that frames which
+ * aren't released or committed stay in the ALSA buffer */
+
+/** Lend the next frames of a component of a blocking stream.
+ *
+ * The mmap area is lent in place if it holds the frames in the user format, otherwise the
+ * frames are lent in lendBuffer, which is converted to or from the mmap area by the buffer processor.
+ *
+ * @param frames On entrance the number of frames wanted, on exit the number of frames lent
+ */
+static PaError PaAlsaStream_AcquireBuffer( PaAlsaStream *self, PaAlsaStreamComponent *component,
+        void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaUtilBufferProcessor *bp = &self->bufferProcessor;
+    int isCapture = component == &self->capture;
+    PaAlsaStreamComponent *other = isCapture ? &self->playback : &self->capture;
+    snd_pcm_t *save = other->pcm;
+    unsigned int bytesPerUserSample = isCapture ? bp->bytesPerUserInputSample : bp->bytesPerUserOutputSample;
+    unsigned long framesAvail, framesGot = 0;
+    void **channels = component->userBuffers;
+    int i;
+
+    PA_UNLESS( component->canMmap, paIncompatibleStreamHostApi );
+
+    /* Disregard the other direction */
+    other->pcm = NULL;
+
+    while( framesGot == 0 )
+    {
+        int xrun = 0;
+        PA_ENSURE( PaAlsaStream_WaitForFrames( self, &framesAvail, &xrun ) );
+        if( xrun )
+            continue;
+
+        framesGot = PA_MIN( framesAvail, *frames );
+        PA_ENSURE( PaAlsaStreamComponent_RegisterChannels( component, bp, &framesGot, &xrun ) );
+        if( xrun )
+            framesGot = 0;
+    }
+
+    component->lentInPlace = component->numUserChannels == component->numHostChannels
+            && component->userInterleaved == component->hostInterleaved
+            && ( isCapture ? bp->userInputSampleFormatIsEqualToHost
+                : bp->userOutputSampleFormatIsEqualToHost && !bp->outputGainIsEnabled );
+
+    if( component->lentInPlace )
+    {
+        if( component->userInterleaved )
+        {
+            *buffer = ExtractAddress( component->channelAreas, component->offset );
+        }
+        else
+        {
+            for( i = 0; i < component->numUserChannels; ++i )
+                channels[i] = ExtractAddress( component->channelAreas + i, component->offset );
+            *buffer = channels;
+        }
+    }
+    else
+    {
+        if( !component->lendBuffer )
+        {
+            PA_UNLESS( component->lendBuffer = PaUtil_AllocateZeroInitializedMemory( component->framesPerPeriod
+                        * component->numUserChannels * bytesPerUserSample ), paInsufficientMemory );
+        }
+        framesGot = PA_MIN( framesGot, component->framesPerPeriod );
+
+        if( !component->userInterleaved )
+        {
+            for( i = 0; i < component->numUserChannels; ++i )
+                channels[i] = (unsigned char *)component->lendBuffer + i * component->framesPerPeriod * bytesPerUserSample;
+        }
+
+        if( isCapture )
+        {
+            /* PaUtil_CopyInput advances the channel pointers, so they are reset below */
+            void *userBuffer = component->userInterleaved ? component->lendBuffer : (void *)channels;
+            PaUtil_SetInputFrameCount( bp, framesGot );
+            PaUtil_CopyInput( bp, &userBuffer, framesGot );
+
+            if( !component->userInterleaved )
+            {
+                for( i = 0; i < component->numUserChannels; ++i )
+                    channels[i] = (unsigned char *)component->lendBuffer + i * component->framesPerPeriod * bytesPerUserSample;
+            }
+        }
+
+        *buffer = component->userInterleaved ? component->lendBuffer : (void *)channels;
+    }
+
+    *frames = framesGot;
+
+end:
+    other->pcm = save;
+    return result;
+error:
+    goto end;
+}
+
+static PaError AcquireReadBuffer( PaStream* s, const void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    void *lent;
+
+    PA_UNLESS( stream->capture.pcm, paCanNotReadFromAnOutputOnlyStream );
+
+    /* Start stream if in prepared state */
+    if( alsa_snd_pcm_state( stream->capture.pcm ) == SND_PCM_STATE_PREPARED )
+    {
+        ENSURE_( alsa_snd_pcm_start( stream->capture.pcm ), paUnanticipatedHostError );
+    }
+
+    PA_ENSURE( PaAlsaStream_AcquireBuffer( stream, &stream->capture, &lent, frames ) );
+    *buffer = lent;
+
+    if( stream->overrun > 0. )
+    {
+        result = paInputOverflowed;
+        stream->overrun = 0.0;
+    }
+
+error:
+    return result;
+}
+
+static PaError ReleaseReadBuffer( PaStream* s, unsigned long frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    int xrun = 0;
+
+    PA_ENSURE( PaAlsaStreamComponent_EndProcessing( &stream->capture, frames, &xrun ) );
+
+error:
+    return result;
+}
+
+static PaError AcquireWriteBuffer( PaStream* s, void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+
+    PA_UNLESS( stream->playback.pcm, paCanNotWriteToAnInputOnlyStream );
+
+    PA_ENSURE( PaAlsaStream_AcquireBuffer( stream, &stream->playback, buffer, frames ) );
+    PaUtil_SetOutputFrameCount( &stream->bufferProcessor, *frames );
+
+    if( stream->underrun > 0. )
+    {
+        result = paOutputUnderflowed;
+        stream->underrun = 0.0;
+    }
+
+error:
+    return result;
+}
+
+static PaError CommitWriteBuffer( PaStream* s, unsigned long frames )
+{
+    PaError result = paNoError;
+    signed long err;
+    PaAlsaStream *stream = (PaAlsaStream*)s;
+    snd_pcm_uframes_t framesAvail, hwAvail;
+    int xrun = 0;
+
+    if( !stream->playback.lentInPlace && frames > 0 )
+    {
+        const void *userBuffer = stream->playback.userInterleaved
+                ? stream->playback.lendBuffer : (const void *)stream->playback.userBuffers;
+        frames = PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, frames );
+    }
+
+    PA_ENSURE( PaAlsaStreamComponent_EndProcessing( &stream->playback, frames, &xrun ) );
+
+    /* Start stream after one period of samples worth, as in WriteStream() */
+    PA_ENSURE( err = GetStreamWriteAvailable( stream ) );
+    framesAvail = err;
+    hwAvail = stream->playback.alsaBufferSize - framesAvail;
+
+    if( alsa_snd_pcm_state( stream->playback.pcm ) == SND_PCM_STATE_PREPARED &&
+            hwAvail >= stream->playback.framesPerPeriod )
+    {
+        ENSURE_( alsa_snd_pcm_start( stream->playback.pcm ), paUnanticipatedHostError );
+    }
+
+error:
+    return result;
+}
+
 /* Extensions */
 
 void PaAlsa_InitializeStreamInfo( PaAlsaStreamInfo *info )
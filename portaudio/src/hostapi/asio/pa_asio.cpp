@@ -190,6 +190,10 @@ static PaTime GetStreamTime( PaStream *stream );
 static double GetStreamCpuLoad( PaStream* stream );
 static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames );
 static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
+static PaError AcquireReadBuffer( PaStream* stream, const void **buffer, unsigned long *frames );
+static PaError ReleaseReadBuffer( PaStream* stream, unsigned long frames );
+static PaError AcquireWriteBuffer( PaStream* stream, void **buffer, unsigned long *frames );
+static PaError CommitWriteBuffer( PaStream* stream, unsigned long frames );
 static signed long GetStreamReadAvailable( PaStream* stream );
 static signed long GetStreamWriteAvailable( PaStream* stream );
 
@@ -343,9 +347,11 @@ static PaSampleFormat AsioSampleTypeToPaNativeSampleFormat(ASIOSampleType type)
 
         case ASIOSTFloat32MSB:
         case ASIOSTFloat32LSB:
+                return paFloat32;
+
         case ASIOSTFloat64MSB:
         case ASIOSTFloat64LSB:
-                return paFloat32;
+                return paFloat64;
 
         case ASIOSTInt32MSB:
         case ASIOSTInt32LSB:
@@ -523,68 +529,22 @@ static void ShiftRight32( void *buffer, long shift, long count )
 
 #define PA_SWAP_( x, y ) temp=x; x = y; y = temp;
 
-static void Swap64ConvertFloat64ToFloat32( void *buffer, long shift, long count )
+static void Swap64( void *buffer, long shift, long count )
 {
-    double *in = (double*)buffer;
-    float *out = (float*)buffer;
-    unsigned char *p;
-    unsigned char temp;
-    (void) shift; /* unused parameter */
-
-    while( count-- )
-    {
-        p = (unsigned char*)in;
-        PA_SWAP_( p[0], p[7] );
-        PA_SWAP_( p[1], p[6] );
-        PA_SWAP_( p[2], p[5] );
-        PA_SWAP_( p[3], p[4] );
-
-        *out++ = (float) (*in++);
-    }
-}
-
-static void ConvertFloat64ToFloat32( void *buffer, long shift, long count )
-{
-    double *in = (double*)buffer;
-    float *out = (float*)buffer;
-    (void) shift; /* unused parameter */
-
-    while( count-- )
-        *out++ = (float) (*in++);
-}
-
-static void ConvertFloat32ToFloat64Swap64( void *buffer, long shift, long count )
-{
-    float *in = ((float*)buffer) + (count-1);
-    double *out = ((double*)buffer) + (count-1);
-    unsigned char *p;
+    unsigned char *p = (unsigned char*)buffer;
     unsigned char temp;
     (void) shift; /* unused parameter */
 
     while( count-- )
     {
-        *out = *in--;
-
-        p = (unsigned char*)out;
         PA_SWAP_( p[0], p[7] );
         PA_SWAP_( p[1], p[6] );
         PA_SWAP_( p[2], p[5] );
         PA_SWAP_( p[3], p[4] );
-
-        out--;
+        p += 8;
     }
 }
 
-static void ConvertFloat32ToFloat64( void *buffer, long shift, long count )
-{
-    float *in = ((float*)buffer) + (count-1);
-    double *out = ((double*)buffer) + (count-1);
-    (void) shift; /* unused parameter */
-
-    while( count-- )
-        *out-- = *in--;
-}
-
 #ifdef MAC
 #define PA_MSB_IS_NATIVE_
 #undef PA_LSB_IS_NATIVE_
@@ -628,19 +588,15 @@ static void SelectAsioToPaConverter( ASIOSampleType type, PaAsioBufferConverter
             #endif
             break;
         case ASIOSTFloat64MSB:
-            /* dest: paFloat32, in-place conversion to/from float32, possible byte swap*/
+            /* dest: paFloat64, no conversion necessary, possible byte swap*/
             #ifdef PA_LSB_IS_NATIVE_
-                *converter = Swap64ConvertFloat64ToFloat32;
-            #else
-                *converter = ConvertFloat64ToFloat32;
+                *converter = Swap64;
             #endif
             break;
         case ASIOSTFloat64LSB:
-            /* dest: paFloat32, in-place conversion to/from float32, possible byte swap*/
+            /* dest: paFloat64, no conversion necessary, possible byte swap*/
             #ifdef PA_MSB_IS_NATIVE_
-                *converter = Swap64ConvertFloat64ToFloat32;
-            #else
-                *converter = ConvertFloat64ToFloat32;
+                *converter = Swap64;
             #endif
             break;
         case ASIOSTInt32MSB:
@@ -774,19 +730,15 @@ static void SelectPaToAsioConverter( ASIOSampleType type, PaAsioBufferConverter
             #endif
             break;
         case ASIOSTFloat64MSB:
-            /* src: paFloat32, in-place conversion to/from float32, possible byte swap*/
+            /* src: paFloat64, no conversion necessary, possible byte swap*/
             #ifdef PA_LSB_IS_NATIVE_
-                *converter = ConvertFloat32ToFloat64Swap64;
-            #else
-                *converter = ConvertFloat32ToFloat64;
+                *converter = Swap64;
             #endif
             break;
         case ASIOSTFloat64LSB:
-            /* src: paFloat32, in-place conversion to/from float32, possible byte swap*/
+            /* src: paFloat64, no conversion necessary, possible byte swap*/
             #ifdef PA_MSB_IS_NATIVE_
-                *converter = ConvertFloat32ToFloat64Swap64;
-            #else
-                *converter = ConvertFloat32ToFloat64;
+                *converter = Swap64;
             #endif
             break;
         case ASIOSTInt32MSB:
@@ -1358,6 +1310,9 @@ PaError PaAsio_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
                                       StopStream, AbortStream, IsStreamStopped, IsStreamActive,
                                       GetStreamTime, PaUtil_DummyGetCpuLoad,
                                       ReadStream, WriteStream, GetStreamReadAvailable, GetStreamWriteAvailable );
+    PaUtil_SetStreamInterfaceBufferLending( &asioHostApi->blockingStreamInterface,
+                                            AcquireReadBuffer, ReleaseReadBuffer,
+                                            AcquireWriteBuffer, CommitWriteBuffer );
 
     return result;
 
@@ -1604,15 +1559,6 @@ typedef struct PaAsioStream
 
     long inputChannelCount, outputChannelCount;
     bool postOutput;
-    
-    /* Channel mapping for output channels to support non-contiguous channel activation.
-       Maps logical PortAudio output channel index to physical ASIO output channel index. */
-    int *outputChannelMap;
-    
-    /* Output channel offset for default channel mapping.
-       When > 0, indicates the starting ASIO channel number for output.
-       For example, offset of 2 means output goes to ASIO channels 2/3 (physical 3/4). */
-    int outputChannelOffset;
 
     void **bufferPtrs; /* this is carved up for inputBufferPtrs and outputBufferPtrs */
     void **inputBufferPtrs[2];
@@ -1646,42 +1592,13 @@ static PaAsioStream *theAsioStream = 0; /* due to ASIO sdk limitations there can
 
 static void ZeroOutputBuffers( PaAsioStream *stream, long index )
 {
-    /* Zero out output buffers.
-       
-       With outputChannelOffset=2, we have 4 ASIO output buffers (channels 0, 1, 2, 3):
-       - Buffers 0, 1: DUMMY buffers → always zero to keep silent
-       - Buffers 2, 3: ACTUAL audio buffers → zero only at stream start
-       
-       At stream start: zero ALL buffers to ensure clean start
-       During callbacks: zero ONLY dummy buffers (preserve audio data)
-    */
-    
-    // At stream start (before playback begins), zero ALL buffers including audio channels
-    // During callbacks (when zeroOutput is true), only zero dummy buffers
-    int dummyBufferCount = stream->outputChannelOffset;
-    
-    if( !stream->zeroOutput )
+    for( int i=0; i < stream->outputChannelCount; ++i )
     {
-        // Stream start: zero ALL output buffers (including audio channels 2-3)
-        int totalOutputBuffers = stream->outputChannelOffset + stream->outputChannelCount;
-        for( int i=0; i < totalOutputBuffers; ++i )
-        {
-            int asioBufferIndex = stream->inputChannelCount + i;
-            void *buffer = stream->asioBufferInfos[ asioBufferIndex ].buffers[index];
-            int bytesPerSample = BytesPerAsioSample( stream->asioChannelInfos[ asioBufferIndex ].type );
-            memset( buffer, 0, stream->framesPerHostCallback * bytesPerSample );
-        }
-    }
-    else
-    {
-        // During callbacks with zeroOutput=true: zero ONLY dummy buffers
-        for( int i=0; i < dummyBufferCount; ++i )
-        {
-            int asioBufferIndex = stream->inputChannelCount + i;
-            void *buffer = stream->asioBufferInfos[ asioBufferIndex ].buffers[index];
-            int bytesPerSample = BytesPerAsioSample( stream->asioChannelInfos[ asioBufferIndex ].type );
-            memset( buffer, 0, stream->framesPerHostCallback * bytesPerSample );
-        }
+        void *buffer = stream->asioBufferInfos[ i + stream->inputChannelCount ].buffers[index];
+
+        int bytesPerSample = BytesPerAsioSample( stream->asioChannelInfos[ i + stream->inputChannelCount ].type );
+
+        memset( buffer, 0, stream->framesPerHostCallback * bytesPerSample );
     }
 }
 
@@ -2033,7 +1950,6 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     int usingBlockingIo = ( !streamCallback ) ? TRUE : FALSE;
     /* Blocking i/o stuff */
     long lBlockingBufferSize     = 0; /* Desired ring buffer size in samples. */
-    long lBlockingBufferSizePow2 = 0; /* Power-of-2 rounded ring buffer size. */
     long lBytesPerFrame          = 0; /* Number of bytes per input/output frame. */
     int blockingWriteBuffersReadyEventInitialized = 0; /* Event init flag. */
     int blockingReadFramesReadyEventInitialized   = 0; /* Event init flag. */
@@ -2219,85 +2135,18 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
 
 
-    /* CHANNEL MAPPING: This code maps PortAudio output channels to ASIO output channels starting
-       from channel 2 (physical 3/4) instead of the default channel 0 (physical 1/2).
-       
-       THE CORRECT APPROACH FOR DRIVERS THAT IGNORE channelNum:
-       
-       Many ASIO drivers (especially those wrapping DirectSound/WASAPI like ASIO4ALL) ignore
-       the channelNum field and use array index instead. For these drivers, we MUST allocate
-       ALL channels from 0 up to the target channel.
-       
-       Strategy:
-       1. Allocate buffers for ALL output channels from 0 to (outputChannelOffset + outputChannelCount - 1)
-       2. Set channelNum to the actual channel number (0, 1, 2, 3 for 4-channel output)
-       3. Only write audio to the buffers corresponding to the offset channels
-       4. Keep dummy buffers silent (zero them out)
-       
-       Array layout (outputChannelOffset=2, outputChannelCount=2):
-       ┌─────────────────────────────────────────────────────────────┐
-       │ Buffer Index:    0       1       2       3                  │
-       │ channelNum:      0       1       2       3                  │
-       │ Physical:        1       2       3       4                  │
-       │ Content:      SILENT  SILENT    AUDIO   AUDIO               │
-       └─────────────────────────────────────────────────────────────┘
-       
-       This works regardless of whether the driver honors channelNum:
-       - If driver honors channelNum: buffers 2/3 map to physical 3/4 ✓
-       - If driver ignores channelNum: array index 2/3 maps to physical 3/4 ✓
-       
-    /*
-       Determine channel offset:
-       - If outputChannelOffset parameter is 0: use default channels 1/2
-       - If outputChannelOffset parameter is > 0: offset to those channels (for multi-device routing)
-       
-       For 4-channel devices like EVO4:
-       - offset=0: use physical channels 1/2
-       - offset=2: use physical channels 3/4
-    */
-    int outputChannelOffset = 2;  /* FORCE: Always offset to channels 2/3 (physical 3/4) */
-    int totalAsioOutputChannels = outputChannelCount + outputChannelOffset;
-    
-    
-    
-    
-    
-    /* Validate that device has enough output channels for the offset mapping */
-    if( totalAsioOutputChannels > driverInfo->outputChannelCount )
-    {
-        /* Fall back to default mapping if not enough channels */
-        outputChannelOffset = 0;
-        totalAsioOutputChannels = outputChannelCount;
-    }
-    else
-    {
-    }
-    
-    
-    
-    
-    /* Store the output channel offset in the stream structure for use by other functions */
-    stream->outputChannelOffset = outputChannelOffset;
-    
-    /* Allocate buffer infos for ALL channels (inputs + all outputs up to target) */
+    /* The output starts at the first device channel, or at the channels
+       given by the output channel selectors. Other device channels can also
+       be selected with Pa_SetStreamRouting(), which maps the callback's
+       channels onto the channels the stream was opened with. */
     stream->asioBufferInfos = (ASIOBufferInfo*)PaUtil_AllocateZeroInitializedMemory(
-            sizeof(ASIOBufferInfo) * (inputChannelCount + totalAsioOutputChannels) );
+            sizeof(ASIOBufferInfo) * (inputChannelCount + outputChannelCount) );
     if( !stream->asioBufferInfos )
     {
         result = paInsufficientMemory;
         goto error;
     }
 
-    /* Allocate channel mapping array for output channels (initialized to 0 = no mapping) */
-    stream->outputChannelMap = (int*)PaUtil_AllocateZeroInitializedMemory(
-            sizeof(int) * outputChannelCount );
-    if( outputChannelCount > 0 && !stream->outputChannelMap )
-    {
-        result = paInsufficientMemory;
-        
-        goto error;
-    }
-
     for( int i=0; i < inputChannelCount; ++i )
     {
         ASIOBufferInfo *info = &stream->asioBufferInfos[i];
@@ -2315,30 +2164,21 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         info->buffers[0] = info->buffers[1] = 0;
     }
 
-    /* Initialize ALL output ASIOBufferInfo structures, including dummy channels.
-       This is critical because ASIOCreateBuffers expects all buffer infos to be properly initialized.
-       
-       For outputChannelCount=2 and outputChannelOffset=2 (totalAsioOutputChannels=4):
-       - Buffer 0: channelNum = 0 → physical channel 1 (DUMMY - kept silent)
-       - Buffer 1: channelNum = 1 → physical channel 2 (DUMMY - kept silent)
-       - Buffer 2: channelNum = 2 → physical channel 3 (ACTUAL AUDIO)
-       - Buffer 3: channelNum = 3 → physical channel 4 (ACTUAL AUDIO)
-    */
-    for( int i=0; i < totalAsioOutputChannels; ++i )
+    for( int i=0; i < outputChannelCount; ++i )
     {
-        ASIOBufferInfo *info = &stream->asioBufferInfos[inputChannelCount + i];
+        ASIOBufferInfo *info = &stream->asioBufferInfos[inputChannelCount+i];
+
         info->isInput = ASIOFalse;
-        /* Set channelNum to the actual ASIO channel number.
-           This is the array index, which some drivers use instead of channelNum field. */
-        info->channelNum = i;
-        info->buffers[0] = info->buffers[1] = 0;
-        
-        if( i < outputChannelOffset )
-        {
-        }
-        else
-        {
+
+        if( outputChannelSelectors ){
+            // outputChannelSelectors values have already been validated in
+            // ValidateAsioSpecificStreamInfo() above
+            info->channelNum = outputChannelSelectors[i];
+        }else{
+            info->channelNum = i;
         }
+
+        info->buffers[0] = info->buffers[1] = 0;
     }
 
 
@@ -2380,7 +2220,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
 
     asioError = ASIOCreateBuffers( stream->asioBufferInfos,
-            inputChannelCount + totalAsioOutputChannels,
+            inputChannelCount + outputChannelCount,
             framesPerHostBuffer, &asioCallbacks_ );
 
     if( asioError != ASE_OK
@@ -2398,7 +2238,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         
 
         ASIOError asioError2 = ASIOCreateBuffers( stream->asioBufferInfos,
-                inputChannelCount + totalAsioOutputChannels,
+                inputChannelCount + outputChannelCount,
                  framesPerHostBuffer, &asioCallbacks_ );
         if( asioError2 == ASE_OK )
             asioError = ASE_OK;
@@ -2414,9 +2254,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
     asioBuffersCreated = 1;
 
-    /* Allocate ASIOChannelInfo array for all created buffers */
     stream->asioChannelInfos = (ASIOChannelInfo*)PaUtil_AllocateZeroInitializedMemory(
-            sizeof(ASIOChannelInfo) * (inputChannelCount + totalAsioOutputChannels) );
+            sizeof(ASIOChannelInfo) * (inputChannelCount + outputChannelCount) );
     if( !stream->asioChannelInfos )
     {
         result = paInsufficientMemory;
@@ -2424,8 +2263,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto error;
     }
 
-    /* Get channel info for all created ASIO buffers */
-    for( int i=0; i < inputChannelCount + totalAsioOutputChannels; ++i )
+    for( int i=0; i < inputChannelCount + outputChannelCount; ++i )
     {
         stream->asioChannelInfos[i].channel = stream->asioBufferInfos[i].channelNum;
         stream->asioChannelInfos[i].isInput = stream->asioBufferInfos[i].isInput;
@@ -2440,7 +2278,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     }
 
     stream->bufferPtrs = (void**)PaUtil_AllocateZeroInitializedMemory(
-            2 * sizeof(void*) * (inputChannelCount + totalAsioOutputChannels) );
+            2 * sizeof(void*) * (inputChannelCount + outputChannelCount) );
     if( !stream->bufferPtrs )
     {
         result = paInsufficientMemory;
@@ -2467,48 +2305,19 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
     if( outputChannelCount > 0 )
     {
-        /* Set up outputBufferPtrs to point to the ACTUAL audio buffers (channels 2-3).
-           
-           bufferPtrs array layout (8 elements for 4 ASIO channels × 2 buffers):
-           Index:    0      1      2      3      4      5      6      7
-           Contains: ch0buf0 ch1buf0 ch2buf0 ch3buf0 ch0buf1 ch1buf1 ch2buf1 ch3buf1
-           
-           We want output to go to ASIO channels 2 and 3:
-           outputBufferPtrs[0][0] → ch2buf0 (index 2)
-           outputBufferPtrs[0][1] → ch3buf0 (index 3)
-           outputBufferPtrs[1][0] → ch2buf1 (index 6)
-           outputBufferPtrs[1][1] → ch3buf1 (index 7)
-           
-           So we need outputBufferPtrs[0] = &bufferPtrs[2] and outputBufferPtrs[1] = &bufferPtrs[6]
-        */
-        stream->outputBufferPtrs[0] = &stream->bufferPtrs[inputChannelCount + outputChannelOffset];
-        stream->outputBufferPtrs[1] = &stream->bufferPtrs[inputChannelCount * 2 + outputChannelCount + totalAsioOutputChannels];
+        stream->outputBufferPtrs[0] = &stream->bufferPtrs[inputChannelCount*2];
+        stream->outputBufferPtrs[1] = &stream->bufferPtrs[inputChannelCount*2 + outputChannelCount];
 
-        /* Set up channel mapping for each logical PortAudio output channel.
-           We map PA channel 0 → ASIO buffer at index inputChannelCount + outputChannelOffset (channelNum=2)
-           We map PA channel 1 → ASIO buffer at index inputChannelCount + outputChannelOffset + 1 (channelNum=3) */
         for( int i=0; i<outputChannelCount; ++i )
         {
-            /* The ASIO buffer index where audio data will be written */
-            int asioBufferIndex = inputChannelCount + outputChannelOffset + i;
-            
-            /* Store the mapping (which physical ASIO channel this PA output maps to) */
-            stream->outputChannelMap[i] = outputChannelOffset + i;  /* e.g., 2, 3 */
-            
-            /* Point the output buffer pointer to the correct ASIO buffer */
-            stream->outputBufferPtrs[0][i] = stream->asioBufferInfos[asioBufferIndex].buffers[0];
-            stream->outputBufferPtrs[1][i] = stream->asioBufferInfos[asioBufferIndex].buffers[1];
+            stream->outputBufferPtrs[0][i] = stream->asioBufferInfos[inputChannelCount+i].buffers[0];
+            stream->outputBufferPtrs[1][i] = stream->asioBufferInfos[inputChannelCount+i].buffers[1];
         }
     }
     else
     {
         stream->outputBufferPtrs[0] = 0;
         stream->outputBufferPtrs[1] = 0;
-        if( stream->outputChannelMap )
-        {
-            PaUtil_FreeMemory( stream->outputChannelMap );
-            stream->outputChannelMap = 0;
-        }
     }
 
     if( inputChannelCount > 0 )
@@ -2539,11 +2348,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             see: "ASIO devices with multiple sample formats are unsupported"
             http://www.portaudio.com/trac/ticket/106
         */
-        /* Get sample type from the FIRST ACTUAL output channel we're using.
-           When using channel offset, we need to skip dummy channels (0,1) and
-           get the type from channel 2 (physical 3). */
-        int firstOutputAsioIndex = inputChannelCount + outputChannelOffset;
-        ASIOSampleType outputType = stream->asioChannelInfos[firstOutputAsioIndex].type;
+        ASIOSampleType outputType = stream->asioChannelInfos[inputChannelCount].type;
 
         AsioSampleTypeLOG(outputType);
         hostOutputSampleFormat = AsioSampleTypeToPaNativeSampleFormat( outputType );
@@ -2610,6 +2415,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
         }
         callbackBufferProcessorInited = TRUE;
+        stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
         /* Initialize the blocking i/o buffer processor. */
         result = PaUtil_InitializeBufferProcessor(&stream->blockingState->bufferProcessor,
@@ -2664,18 +2470,12 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                   be stored in the buffer.
                4) Add one additional block for block processing and convert
                   to samples frames.
-               5) Get the next larger (or equal) power-of-two buffer size.
              */
             lBlockingBufferSize = suggestedInputLatencyFrames - stream->asioInputLatencyFrames;
             lBlockingBufferSize = (lBlockingBufferSize > 0) ? lBlockingBufferSize : 1;
             lBlockingBufferSize = (lBlockingBufferSize + framesPerBuffer - 1) / framesPerBuffer;
             lBlockingBufferSize = (lBlockingBufferSize + 1) * framesPerBuffer;
 
-            /* Get the next larger or equal power-of-two buffersize. */
-            lBlockingBufferSizePow2 = 1;
-            while( lBlockingBufferSize > (lBlockingBufferSizePow2<<=1) );
-            lBlockingBufferSize = lBlockingBufferSizePow2;
-
             /* Compute total input latency in seconds */
             stream->streamRepresentation.streamInfo.inputLatency =
                 (double)( PaUtil_GetBufferProcessorInputLatencyFrames(&stream->bufferProcessor               )
@@ -2734,7 +2534,6 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                   be stored in the buffer.
                4) Add one additional block for block processing and convert
                   to samples frames.
-               5) Get the next larger (or equal) power-of-two buffer size.
              */
             lBlockingBufferSize = suggestedOutputLatencyFrames - stream->asioOutputLatencyFrames;
             lBlockingBufferSize = (lBlockingBufferSize > 0) ? lBlockingBufferSize : 1;
@@ -2746,11 +2545,6 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                buffer. */
             stream->blockingState->writeRingBufferInitialFrames = lBlockingBufferSize - framesPerBuffer;
 
-            /* Get the next larger or equal power-of-two buffersize. */
-            lBlockingBufferSizePow2 = 1;
-            while( lBlockingBufferSize > (lBlockingBufferSizePow2<<=1) );
-            lBlockingBufferSize = lBlockingBufferSizePow2;
-
             /* Compute total output latency in seconds */
             stream->streamRepresentation.streamInfo.outputLatency =
                 (double)( PaUtil_GetBufferProcessorOutputLatencyFrames(&stream->bufferProcessor)
@@ -2794,6 +2588,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
         }
         callbackBufferProcessorInited = TRUE;
+        stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
         stream->streamRepresentation.streamInfo.inputLatency =
                 (double)( PaUtil_GetBufferProcessorInputLatencyFrames(&stream->bufferProcessor)
@@ -3945,6 +3740,138 @@ static PaError WriteStream( PaStream      *s     ,
 }
 
 
+/* Wait until the callback has made at least one frame available to
+   AcquireReadBuffer() or AcquireWriteBuffer(), in the same way as
+   ReadStream() and WriteStream() wait for a block. */
+static PaError WaitForBlockingFrame( PaAsioStream *stream, unsigned long *framesRequested,
+                                     int *framesRequestedFlag, HANDLE framesReadyEvent )
+{
+    /* About the time, needed to process 8 data blocks. */
+    DWORD timeout = (DWORD)( 8 * stream->bufferProcessor.framesPerUserBuffer * 1000 / stream->streamRepresentation.streamInfo.sampleRate );
+    DWORD waitResult;
+
+    *framesRequested = 1;
+    *framesRequestedFlag = TRUE;
+
+    waitResult = WaitForSingleObject( framesReadyEvent, timeout );
+    if( waitResult == WAIT_FAILED )
+    {
+        PA_ASIO_SET_LAST_SYSTEM_ERROR( GetLastError() );
+        return paUnanticipatedHostError;
+    }
+    else if( waitResult == WAIT_TIMEOUT )
+    {
+        /* If block processing has stopped, abort! */
+        return stream->blockingState->stopFlag ? paStreamIsStopped : paTimedOut;
+    }
+
+    return paNoError;
+}
+
+
+/* The blocking i/o ring buffers hold whole frames in the interleaved user
+   format, so they are lent in place. Non-interleaved user buffers can't be
+   lent. */
+static PaError AcquireReadBuffer( PaStream *s, const void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAsioStream *stream = (PaAsioStream*)s;
+    PaAsioStreamBlockingState *blockingState = stream->blockingState;
+    PaUtilRingBuffer *pRb = &blockingState->readRingBuffer;
+    void *pRingBufferData1st, *pRingBufferData2nd;
+    ring_buffer_size_t lRingBufferSize1st, lRingBufferSize2nd;
+
+    if( blockingState->stopFlag || !stream->isActive )
+        return paStreamIsStopped;
+    if( !stream->inputChannelCount )
+        return paCanNotReadFromAnOutputOnlyStream;
+    if( !blockingState->bufferProcessor.userInputIsInterleaved )
+        return paSampleFormatNotSupported;
+
+    if( PaUtil_GetRingBufferReadAvailable( pRb ) < 1 )
+    {
+        result = WaitForBlockingFrame( stream, &blockingState->readFramesRequested,
+                &blockingState->readFramesRequestedFlag, blockingState->readFramesReadyEvent );
+        if( result != paNoError )
+            return result;
+    }
+
+    PaUtil_GetRingBufferReadRegions( pRb, (ring_buffer_size_t)*frames,
+            &pRingBufferData1st, &lRingBufferSize1st, &pRingBufferData2nd, &lRingBufferSize2nd );
+    *buffer = pRingBufferData1st;
+    *frames = (unsigned long)lRingBufferSize1st;
+
+    /* If there has been an input overflow within the callback */
+    if( blockingState->inputOverflowFlag )
+    {
+        blockingState->inputOverflowFlag = FALSE;
+        result = paInputOverflowed;
+    }
+
+    return result;
+}
+
+
+static PaError ReleaseReadBuffer( PaStream *s, unsigned long frames )
+{
+    PaAsioStream *stream = (PaAsioStream*)s;
+
+    PaUtil_AdvanceRingBufferReadIndex( &stream->blockingState->readRingBuffer, (ring_buffer_size_t)frames );
+
+    return paNoError;
+}
+
+
+static PaError AcquireWriteBuffer( PaStream *s, void **buffer, unsigned long *frames )
+{
+    PaError result = paNoError;
+    PaAsioStream *stream = (PaAsioStream*)s;
+    PaAsioStreamBlockingState *blockingState = stream->blockingState;
+    PaUtilRingBuffer *pRb = &blockingState->writeRingBuffer;
+    void *pRingBufferData1st, *pRingBufferData2nd;
+    ring_buffer_size_t lRingBufferSize1st, lRingBufferSize2nd;
+
+    if( blockingState->stopFlag || !stream->isActive )
+        return paStreamIsStopped;
+    if( !stream->outputChannelCount )
+        return paCanNotWriteToAnInputOnlyStream;
+    if( !blockingState->bufferProcessor.userOutputIsInterleaved )
+        return paSampleFormatNotSupported;
+
+    if( PaUtil_GetRingBufferWriteAvailable( pRb ) < 1 )
+    {
+        result = WaitForBlockingFrame( stream, &blockingState->writeBuffersRequested,
+                &blockingState->writeBuffersRequestedFlag, blockingState->writeBuffersReadyEvent );
+        if( result != paNoError )
+            return result;
+    }
+
+    PaUtil_GetRingBufferWriteRegions( pRb, (ring_buffer_size_t)*frames,
+            &pRingBufferData1st, &lRingBufferSize1st, &pRingBufferData2nd, &lRingBufferSize2nd );
+    *buffer = pRingBufferData1st;
+    *frames = (unsigned long)lRingBufferSize1st;
+
+    /* If there has been an output underflow within the callback */
+    if( blockingState->outputUnderflowFlag )
+    {
+        blockingState->outputUnderflowFlag = FALSE;
+        result = paOutputUnderflowed;
+    }
+
+    return result;
+}
+
+
+static PaError CommitWriteBuffer( PaStream *s, unsigned long frames )
+{
+    PaAsioStream *stream = (PaAsioStream*)s;
+
+    PaUtil_AdvanceRingBufferWriteIndex( &stream->blockingState->writeRingBuffer, (ring_buffer_size_t)frames );
+
+    return paNoError;
+}
+
+
 static signed long GetStreamReadAvailable( PaStream* s )
 {
     PaAsioStream *stream = (PaAsioStream*)s;
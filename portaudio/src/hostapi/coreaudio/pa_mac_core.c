@@ -2041,6 +2041,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             goto error;
     }
     stream->bufferProcessorIsInitialized = TRUE;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     // Calculate actual latency from the sum of individual latencies.
     if( inputParameters )
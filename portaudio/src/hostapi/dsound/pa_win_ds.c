@@ -2078,6 +2078,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto error;
 
     bufferProcessorIsInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
 
 /* DirectSound specific initialization */
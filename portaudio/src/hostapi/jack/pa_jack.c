@@ -256,19 +256,34 @@ static int JackCallback( jack_nframes_t frames, void *userData );
 
 /* ---- blocking emulation layer ---- */
 
-/* Allocate buffer. */
+/* Allocate buffer. A mirrored buffer is used where possible, so that reads,
+ * writes and lent buffers never wrap. */
 static PaError BlockingInitFIFO( PaUtilRingBuffer *rbuf, long numFrames, long bytesPerFrame )
 {
-    long numBytes = numFrames * bytesPerFrame;
-    char *buffer = (char *) malloc( numBytes );
-    if( buffer == NULL ) return paInsufficientMemory;
-    memset( buffer, 0, numBytes );
-    return (PaError) PaUtil_InitializeRingBuffer( rbuf, 1, numBytes, buffer );
+    /* round up to whole pages, which can be mirrored */
+    long numBytes = PaUtil_GetMirroredRingBufferElementCount( bytesPerFrame, numFrames ) * bytesPerFrame;
+    char *buffer;
+    if( PaUtil_InitializeMirroredRingBuffer( rbuf, 1, numBytes ) != 0 )
+    {
+        buffer = (char *) malloc( numBytes );
+        if( buffer == NULL ) return paInsufficientMemory;
+        memset( buffer, 0, numBytes );
+        if( PaUtil_InitializeRingBuffer( rbuf, 1, numBytes, buffer ) != 0 )
+        {
+            free( buffer );
+            return paInternalError;
+        }
+    }
+    /* where possible the blocking functions sleep until the FIFO has enough
+     * data or space, rather than being woken by every callback */
+    PaUtil_EnableRingBufferWaiting( rbuf );
+    return paNoError;
 }
 
 /* Free buffer. */
 static PaError BlockingTermFIFO( PaUtilRingBuffer *rbuf )
 {
+    PaUtil_TerminateMirroredRingBuffer( rbuf );
     if( rbuf->buffer ) free( rbuf->buffer );
     rbuf->buffer = NULL;
     return paNoError;
@@ -297,7 +312,7 @@ BlockingCallback( const void                      *inputBuffer,
         memset( (char *)outputBuffer + numRead, 0, numBytes - numRead );
     }
 
-    if( !stream->data_available )
+    if( !stream->inFIFO.isWaitable && !stream->outFIFO.isWaitable && !stream->data_available )
     {
         stream->data_available = 1;
         sem_post( &stream->data_semaphore );
@@ -319,9 +334,8 @@ BlockingBegin( PaJackStream *stream, int minimum_buffer_size )
     stream->samplesPerFrame = 2;
     stream->bytesPerFrame = sizeof(float) * stream->samplesPerFrame;
     /* </FIXME> */
-    numFrames = 32;
-    while (numFrames < minimum_buffer_size)
-        numFrames *= 2;
+    /* ring buffers can be any size, so don't add latency by rounding up */
+    numFrames = minimum_buffer_size > 32 ? minimum_buffer_size : 32;
 
     if( doRead )
     {
@@ -333,8 +347,9 @@ BlockingBegin( PaJackStream *stream, int minimum_buffer_size )
 
         ENSURE_PA( BlockingInitFIFO( &stream->outFIFO, numFrames, stream->bytesPerFrame ) );
 
-        /* Make Write FIFO appear full initially. */
-        numBytes = PaUtil_GetRingBufferWriteAvailable( &stream->outFIFO );
+        /* Make Write FIFO appear full initially. Only the requested frames
+         * are filled, so the rounding of its size adds no latency. */
+        numBytes = numFrames * stream->bytesPerFrame;
         PaUtil_AdvanceRingBufferWriteIndex( &stream->outFIFO, numBytes );
     }
 
@@ -354,6 +369,30 @@ BlockingEnd( PaJackStream *stream )
     sem_destroy( &stream->data_semaphore );
 }
 
+/* Wait until numBytes can be read from the input FIFO, or for the next
+ * callback if the FIFO isn't waitable. */
+static void BlockingWaitForInput( PaJackStream *stream, long numBytes )
+{
+    if( stream->inFIFO.isWaitable )
+        PaUtil_WaitForRingBufferReadAvailable( &stream->inFIFO, numBytes, -1 );
+    else if( stream->data_available ) /* see write for an explanation */
+        stream->data_available = 0;
+    else
+        sem_wait( &stream->data_semaphore );
+}
+
+/* Wait until numBytes can be written to the output FIFO, or for the next
+ * callback if the FIFO isn't waitable. */
+static void BlockingWaitForOutput( PaJackStream *stream, long numBytes )
+{
+    if( stream->outFIFO.isWaitable )
+        PaUtil_WaitForRingBufferWriteAvailable( &stream->outFIFO, numBytes, -1 );
+    else if( stream->data_available ) /* see write for an explanation */
+        stream->data_available = 0;
+    else
+        sem_wait( &stream->data_semaphore );
+}
+
 static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFrames )
 {
     PaError result = paNoError;
@@ -368,13 +407,7 @@ static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFra
         numBytes -= bytesRead;
         p += bytesRead;
         if( numBytes > 0 )
-        {
-            /* see write for an explanation */
-            if( stream->data_available )
-                stream->data_available = 0;
-            else
-                sem_wait( &stream->data_semaphore );
-        }
+            BlockingWaitForInput( stream, numBytes );
     }
 
     return result;
@@ -407,17 +440,82 @@ static PaError BlockingWriteStream( PaStream* s, const void *data, unsigned long
              * if the algorithm bailed out in step (3) before, it leaks a count of 1
              * on the semaphore; however, it doesn't matter, because if we block in (4),
              * we also do it in a loop
+             *
+             * a waitable FIFO needs none of this, the callback wakes us once
+             * there is space for all of the remaining data
              */
-            if( stream->data_available )
-                stream->data_available = 0;
-            else
-                sem_wait( &stream->data_semaphore );
+            BlockingWaitForOutput( stream, numBytes );
         }
     }
 
     return result;
 }
 
+/* The FIFOs are lent in place. Their size is a multiple of bytesPerFrame,
+ * so a frame never straddles the end of a FIFO. Only the
+ * first region is lent, which for a mirrored FIFO is all that's available. */
+static PaError BlockingAcquireReadBuffer( PaStream* s, const void **buffer, unsigned long *frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+
+    if( !stream->local_input_ports )
+        return paCanNotReadFromAnOutputOnlyStream;
+    if( !stream->bufferProcessor.userInputIsInterleaved )
+        return paSampleFormatNotSupported;
+
+    while( PaUtil_GetRingBufferReadAvailable( &stream->inFIFO ) < stream->bytesPerFrame )
+        BlockingWaitForInput( stream, stream->bytesPerFrame );
+
+    PaUtil_GetRingBufferReadRegions( &stream->inFIFO, (ring_buffer_size_t)(*frames * stream->bytesPerFrame),
+            &data1, &size1, &data2, &size2 );
+    *buffer = data1;
+    *frames = size1 / stream->bytesPerFrame;
+
+    return paNoError;
+}
+
+static PaError BlockingReleaseReadBuffer( PaStream* s, unsigned long frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+
+    PaUtil_AdvanceRingBufferReadIndex( &stream->inFIFO, (ring_buffer_size_t)(frames * stream->bytesPerFrame) );
+
+    return paNoError;
+}
+
+static PaError BlockingAcquireWriteBuffer( PaStream* s, void **buffer, unsigned long *frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+
+    if( !stream->local_output_ports )
+        return paCanNotWriteToAnInputOnlyStream;
+    if( !stream->bufferProcessor.userOutputIsInterleaved )
+        return paSampleFormatNotSupported;
+
+    while( PaUtil_GetRingBufferWriteAvailable( &stream->outFIFO ) < stream->bytesPerFrame )
+        BlockingWaitForOutput( stream, stream->bytesPerFrame );
+
+    PaUtil_GetRingBufferWriteRegions( &stream->outFIFO, (ring_buffer_size_t)(*frames * stream->bytesPerFrame),
+            &data1, &size1, &data2, &size2 );
+    *buffer = data1;
+    *frames = size1 / stream->bytesPerFrame;
+
+    return paNoError;
+}
+
+static PaError BlockingCommitWriteBuffer( PaStream* s, unsigned long frames )
+{
+    PaJackStream *stream = (PaJackStream *)s;
+
+    PaUtil_AdvanceRingBufferWriteIndex( &stream->outFIFO, (ring_buffer_size_t)(frames * stream->bytesPerFrame) );
+
+    return paNoError;
+}
+
 static signed long
 BlockingGetStreamReadAvailable( PaStream* s )
 {
@@ -443,6 +541,11 @@ BlockingWaitEmpty( PaStream *s )
 
     while( PaUtil_GetRingBufferReadAvailable( &stream->outFIFO ) > 0 )
     {
+        if( stream->outFIFO.isWaitable )
+        {
+            PaUtil_WaitForRingBufferWriteAvailable( &stream->outFIFO, stream->outFIFO.bufferSize, -1 );
+            continue;
+        }
         stream->data_available = 0;
         sem_wait( &stream->data_semaphore );
     }
@@ -830,6 +933,9 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
                                       GetStreamTime, PaUtil_DummyGetCpuLoad,
                                       BlockingReadStream, BlockingWriteStream,
                                       BlockingGetStreamReadAvailable, BlockingGetStreamWriteAvailable );
+    PaUtil_SetStreamInterfaceBufferLending( &jackHostApi->blockingStreamInterface,
+                                            BlockingAcquireReadBuffer, BlockingReleaseReadBuffer,
+                                            BlockingAcquireWriteBuffer, BlockingCommitWriteBuffer );
 
     jackHostApi->inputBase = jackHostApi->outputBase = 0;
     jackHostApi->xrun = 0;
@@ -1371,6 +1477,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                   streamCallback,
                   userData ) );
     bpInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     if( stream->num_incoming_connections > 0 )
         stream->streamRepresentation.streamInfo.inputLatency =
@@ -1282,6 +1282,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
               outputHostFormat, sampleRate, streamFlags, framesPerBuffer, stream->framesPerHostBuffer,
               paUtilFixedHostBufferSize, streamCallback, userData ) );
     bpInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     *s = (PaStream*)stream;
 
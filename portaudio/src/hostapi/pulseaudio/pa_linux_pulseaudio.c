@@ -781,6 +781,10 @@ PaError PaPulseAudio_Initialize( PaUtilHostApiRepresentation ** hostApi,
                                       PaPulseAudio_WriteStreamBlock,
                                       PaPulseAudio_GetStreamReadAvailableBlock,
                                       PaUtil_DummyGetWriteAvailable );
+    PaUtil_SetStreamInterfaceBufferLending( &pulseaudioHostApi->blockingStreamInterface,
+                                            PaPulseAudio_AcquireReadBufferBlock,
+                                            PaPulseAudio_ReleaseReadBufferBlock,
+                                            NULL, NULL );
 
     PaPulseAudio_UnLock( pulseaudioHostApi->mainloop );
     lockTaken = 0;
@@ -961,9 +965,20 @@ PaError PaPulseAudio_ConvertPortaudioFormatToPaPulseAudio_( PaSampleFormat porta
 PaError PaPulseAudio_BlockingInitRingBuffer( PaUtilRingBuffer * rbuf,
                                              int size )
 {
-    char *ringbufferBuffer = (char *) malloc( size );
+    char *ringbufferBuffer = NULL;
     PaError ret = paNoError;
 
+    /* Prefer a mirrored buffer, which is never read in two parts. In either
+     * case blocking reads sleep until enough has been written, where that's
+     * supported */
+    if( PaUtil_InitializeMirroredRingBuffer( rbuf, 1, size ) == 0 )
+    {
+        PaUtil_EnableRingBufferWaiting( rbuf );
+        return paNoError;
+    }
+
+    ringbufferBuffer = (char *) malloc( size );
+
     if( ringbufferBuffer == NULL )
     {
         PA_PULSEAUDIO_SET_LAST_HOST_ERROR( 0,
@@ -991,6 +1006,8 @@ PaError PaPulseAudio_BlockingInitRingBuffer( PaUtilRingBuffer * rbuf,
         return paNotInitialized;
     }
 
+    PaUtil_EnableRingBufferWaiting( rbuf );
+
     return paNoError;
 }
 
@@ -1063,6 +1080,7 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     stream->isStopped = 1;
     stream->pulseaudioIsActive = 0;
     stream->pulseaudioIsStopped = 1;
+    stream->inputIsLent = 0;
 
     stream->inputStream = NULL;
     stream->outputStream = NULL;
@@ -1163,10 +1181,14 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         /*
          * This is too much as most of the time there is not much
          * stuff in buffer but it's enough if we are doing blocked
-         * and reading is somewhat slower than callback
+         * and reading is somewhat slower than callback.
+         * It holds whole frames, so that a lent frame never
+         * straddles its end, rounded up to whole pages so that
+         * it can be mirrored
          */
         result = PaPulseAudio_BlockingInitRingBuffer( &stream->inputRing,
-                                                      (65536 * 4) );
+                                                      PaUtil_GetMirroredRingBufferElementCount( stream->inputFrameSize,
+                                                              (65536 * 4) / stream->inputFrameSize ) * stream->inputFrameSize );
         if( result != paNoError )
         {
             goto openstream_error;
@@ -1337,6 +1359,8 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
         goto openstream_error;
     }
 
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+
     /* inputLatency is specified in _seconds_ */
     stream->streamRepresentation.streamInfo.inputLatency =
         (PaTime) PaUtil_GetBufferProcessorInputLatencyFrames(
@@ -1363,6 +1387,7 @@ PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     if( stream )
     {
         /* If the blocking input ring buffer was allocated, release it. */
+        PaUtil_TerminateMirroredRingBuffer( &stream->inputRing );
         if( stream->inputRing.buffer )
         {
             free( stream->inputRing.buffer );
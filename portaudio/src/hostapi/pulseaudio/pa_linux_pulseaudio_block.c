@@ -78,19 +78,103 @@ PaError PaPulseAudio_ReadStreamBlock( PaStream * s,
                                              bufferLeftToRead );
         readableBuffer += l_read;
         bufferLeftToRead -= l_read;
-        if( bufferLeftToRead > 0 )
+        if( bufferLeftToRead > 0 && !pulseaudioStream->inputRing.isWaitable )
             pa_threaded_mainloop_wait( pulseaudioStream->mainloop );
 
         PaPulseAudio_UnLock( pulseaudioStream->mainloop );
 
         if( bufferLeftToRead > 0 )
         {
-            /* Sleep small amount of time not burn CPU
-            * we block anyway so this is bearable
-            */
+            if( pulseaudioStream->inputRing.isWaitable )
+            {
+                /* Sleep until the read callback has written enough. Time
+                 * out now and then to check that the stream is still good.
+                 */
+                PaUtil_WaitForRingBufferReadAvailable( &pulseaudioStream->inputRing,
+                                                       bufferLeftToRead, 100 );
+            }
+            else
+            {
+                /* Sleep small amount of time not burn CPU
+                * we block anyway so this is bearable
+                */
+                usleep(100);
+            }
+        }
+    }
+    return paNoError;
+}
+
+
+/* The input ring is lent in place. It holds whole frames in the
+ * interleaved user format, so a frame never straddles its end. Only the
+ * first region is lent, which for a mirrored ring is all that's available.
+ * While frames are lent the read callback drops new data rather than the
+ * lent data when the ring is full.
+ */
+PaError PaPulseAudio_AcquireReadBufferBlock( PaStream * s,
+                                             const void **buffer,
+                                             unsigned long *frames )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+    PaUtilRingBuffer *inputRing = &pulseaudioStream->inputRing;
+    unsigned long maxFrames;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2;
+
+    if( pulseaudioStream->inputStream == NULL )
+    {
+        return paCanNotReadFromAnOutputOnlyStream;
+    }
+
+    maxFrames = inputRing->bufferSize / pulseaudioStream->inputFrameSize;
+    if( *frames > maxFrames )
+    {
+        *frames = maxFrames;
+    }
+
+    while( PaUtil_GetRingBufferReadAvailable( inputRing ) < pulseaudioStream->inputFrameSize )
+    {
+        PA_PULSEAUDIO_IS_ERROR( pulseaudioStream, paStreamIsStopped )
+
+        if( inputRing->isWaitable )
+        {
+            PaUtil_WaitForRingBufferReadAvailable( inputRing,
+                                                   pulseaudioStream->inputFrameSize, 100 );
+        }
+        else
+        {
             usleep(100);
         }
     }
+
+    /* The read callback may drop data from the ring, so the lent region
+     * is taken under the lock */
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+    PaUtil_GetRingBufferReadRegions( inputRing,
+                                     (ring_buffer_size_t)(*frames * pulseaudioStream->inputFrameSize),
+                                     &data1, &size1, &data2, &size2 );
+    pulseaudioStream->inputIsLent = 1;
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
+    *buffer = data1;
+    *frames = size1 / pulseaudioStream->inputFrameSize;
+
+    return paNoError;
+}
+
+
+PaError PaPulseAudio_ReleaseReadBufferBlock( PaStream * s,
+                                             unsigned long frames )
+{
+    PaPulseAudio_Stream *pulseaudioStream = (PaPulseAudio_Stream *) s;
+
+    PaPulseAudio_Lock( pulseaudioStream->mainloop );
+    PaUtil_AdvanceRingBufferReadIndex( &pulseaudioStream->inputRing,
+                                       (ring_buffer_size_t)(frames * pulseaudioStream->inputFrameSize) );
+    pulseaudioStream->inputIsLent = 0;
+    PaPulseAudio_UnLock( pulseaudioStream->mainloop );
+
     return paNoError;
 }
 
@@ -83,6 +83,13 @@ PaError PaPulseAudio_WriteStreamBlock( PaStream * stream,
 
 signed long PaPulseAudio_GetStreamReadAvailableBlock( PaStream * stream );
 
+PaError PaPulseAudio_AcquireReadBufferBlock( PaStream * stream,
+                                             const void **buffer,
+                                             unsigned long *frames );
+
+PaError PaPulseAudio_ReleaseReadBufferBlock( PaStream * stream,
+                                             unsigned long frames );
+
 #ifdef __cplusplus
 }
 #endif                          /* __cplusplus */
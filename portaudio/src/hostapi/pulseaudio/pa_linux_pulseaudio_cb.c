@@ -225,6 +225,12 @@ void _PaPulseAudio_Read( PaPulseAudio_Stream *stream,
         PA_DEBUG( ("Portaudio %s: Can't read audio!\n",
                   __FUNCTION__) );
     }
+    else if( stream->inputIsLent )
+    {
+        /* The oldest data is lent to the reader, so it can't be dropped
+         * to make room. Drop whatever of the new data doesn't fit instead */
+        PaUtil_WriteRingBuffer( &stream->inputRing, pulseaudioData, length );
+    }
     else
     {
         _PaPulseAudio_WriteRingBuffer( &stream->inputRing, pulseaudioData, length );
@@ -657,6 +663,7 @@ PaError PaPulseAudio_CloseStreamCb( PaStream * s )
     PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
     PaUtil_TerminateStreamRepresentation( &stream->streamRepresentation );
     /* Free any memory allocated for the blocking input ring buffer. */
+    PaUtil_TerminateMirroredRingBuffer( &stream->inputRing );
     if( stream->inputRing.buffer )
     {
         /* At this point input/output streams have been disconnected and unref\'d,
@@ -937,6 +944,7 @@ PaError PaPulseAudio_StartStreamCb( PaStream * s )
     /* Stream is now active */
     stream->isActive = 1;
     stream->isStopped = 0;
+    stream->inputIsLent = 0;
 
     /* Start callback here after we can be
      * sure that everything is correct
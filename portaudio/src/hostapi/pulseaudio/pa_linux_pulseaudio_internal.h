@@ -142,6 +142,9 @@ typedef struct PaPulseAudio_Stream
     char *inputStreamName;
 
     PaUtilRingBuffer inputRing;
+    /* Non-zero while frames of inputRing are lent by
+     * PaPulseAudio_AcquireReadBufferBlock(), so they must not be dropped */
+    volatile sig_atomic_t inputIsLent;
 
     /* Used in communication between threads
      *
@@ -512,6 +512,8 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     if( result != paNoError )
         goto error;
 
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
+
 
     /*
         IMPLEMENT ME: initialise the following fields with estimated or actual
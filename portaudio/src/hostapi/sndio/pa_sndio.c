@@ -382,6 +382,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi, PaStream
         sio_close( hdl );
         return err;
     }
+    sndioStream->base.bufferProcessor = &sndioStream->bufferProcessor;
     if( mode & SIO_REC )
     {
         sndioStream->rbuf = malloc( par.round * par.rchan * par.bps );
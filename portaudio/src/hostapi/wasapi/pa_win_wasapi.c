@@ -4197,6 +4197,10 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             LogPaError(result);
             goto error;
         }
+
+        // The output gain is applied by the buffer processor
+        if (useOutputBufferProcessor)
+            stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
     }
 
     // Set Input latency
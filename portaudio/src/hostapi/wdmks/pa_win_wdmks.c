@@ -4802,6 +4802,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
             max(stream->capture.framesPerBuffer, stream->render.framesPerBuffer));
         goto error;
     }
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     /* Allocate/get all the buffers for host I/O */
     if (stream->userInputChannels > 0)
@@ -2513,6 +2513,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     if( result != paNoError ) goto error;
 
     bufferProcessorIsInitialized = 1;
+    stream->streamRepresentation.bufferProcessor = &stream->bufferProcessor;
 
     /* stream info input latency is the minimum buffering latency (unlike suggested and default which are *maximums*) */
     stream->streamRepresentation.streamInfo.inputLatency =
@@ -0,0 +1,280 @@
+/** @file patest_adapting_benchmark.c
+    @ingroup test_src
+    @brief Measure the cost of adapting mismatched host and user buffer sizes
+    in the buffer processor.
+
+    A buffer processor is fed host buffers of one size while its callback
+    is called with user buffers of another size, without using an audio
+    device. For each pair of sizes, and for input, output and full duplex
+    streams, the number of sample converter calls and the time spent in
+    PaUtil_EndBufferProcessing() are printed per host buffer, as CSV. The
+    host buffers are paInt16 and the user buffers paFloat32, with two
+    channels, both either interleaved or non-interleaved; the callback does
+    nothing.
+
+    Usage: patest_adapting_benchmark [--min-time seconds]
+
+    Link with pa_process.c, pa_resampler.c, pa_converters.c,
+    pa_converters_simd.c and pa_dither.c
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_process.h"
+#include "pa_types.h"
+#include "pa_util.h"
+
+#define CHANNEL_COUNT           (2)
+#define MAX_HOST_FRAMES         (4096)
+#define SAMPLE_RATE             (48000.0)
+#define REPETITION_COUNT        (3)
+
+
+typedef struct SizePair
+{
+    unsigned long framesPerHostBuffer;
+    unsigned long framesPerUserBuffer;
+} SizePair;
+
+/* common host buffer sizes (10 ms at 48 and 44.1 kHz, power of two periods)
+    against common callback sizes */
+static const SizePair sizePairs_[] =
+{
+    { 480, 256 },
+    { 480, 512 },
+    { 441, 256 },
+    { 441, 512 },
+    { 1024, 480 },
+    { 256, 441 },
+    { 128, 96 },
+    { 960, 128 }
+};
+
+#define SIZE_PAIR_COUNT     ((int)(sizeof(sizePairs_) / sizeof(sizePairs_[0])))
+
+static const char *directionNames_[] = { "input", "output", "duplex" };
+static const char *layoutNames_[] = { "interleaved", "non-interleaved" };
+
+
+/* the converters used by the buffer processor are replaced by ones which
+    count their calls */
+static PaUtilConverter *int16ToFloat32_;
+static PaUtilConverter *float32ToInt16_;
+static long converterCallCount_;
+
+static void CountingInt16_To_Float32( void *destinationBuffer, signed int destinationStride,
+        void *sourceBuffer, signed int sourceStride,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    ++converterCallCount_;
+    (*int16ToFloat32_)( destinationBuffer, destinationStride, sourceBuffer, sourceStride,
+            count, ditherGenerator );
+}
+
+static void CountingFloat32_To_Int16( void *destinationBuffer, signed int destinationStride,
+        void *sourceBuffer, signed int sourceStride,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    ++converterCallCount_;
+    (*float32ToInt16_)( destinationBuffer, destinationStride, sourceBuffer, sourceStride,
+            count, ditherGenerator );
+}
+
+
+static int NullCallback( const void *input, void *output,
+        unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo,
+        PaStreamCallbackFlags statusFlags, void *userData )
+{
+    (void)input;
+    (void)output;
+    (void)frameCount;
+    (void)timeInfo;
+    (void)statusFlags;
+    (void)userData;
+    return paContinue;
+}
+
+
+/* Process the given number of host buffers. Returns the elapsed time in seconds. */
+static double RunBuffers( PaUtilBufferProcessor *bp, int direction, int isInterleaved,
+        PaInt16 *hostInput, PaInt16 *hostOutput, unsigned long framesPerHostBuffer,
+        long bufferCount )
+{
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    double startTime = PaUtil_GetTime();
+    int callbackResult = paContinue;
+    long i;
+    int c;
+
+    for( i = 0; i < bufferCount; ++i )
+    {
+        PaUtil_BeginBufferProcessing( bp, &timeInfo, 0 );
+
+        if( direction != 1 )
+        {
+            PaUtil_SetInputFrameCount( bp, framesPerHostBuffer );
+            if( isInterleaved )
+                PaUtil_SetInterleavedInputChannels( bp, 0, hostInput, CHANNEL_COUNT );
+            else
+                for( c = 0; c < CHANNEL_COUNT; ++c )
+                    PaUtil_SetNonInterleavedInputChannel( bp, c, hostInput + c * MAX_HOST_FRAMES );
+        }
+        if( direction != 0 )
+        {
+            PaUtil_SetOutputFrameCount( bp, framesPerHostBuffer );
+            if( isInterleaved )
+                PaUtil_SetInterleavedOutputChannels( bp, 0, hostOutput, CHANNEL_COUNT );
+            else
+                for( c = 0; c < CHANNEL_COUNT; ++c )
+                    PaUtil_SetNonInterleavedOutputChannel( bp, c, hostOutput + c * MAX_HOST_FRAMES );
+        }
+
+        PaUtil_EndBufferProcessing( bp, &callbackResult );
+    }
+
+    return PaUtil_GetTime() - startTime;
+}
+
+
+static int BenchmarkSizePair( const SizePair *sizePair, int direction, int isInterleaved,
+        double minimumTime, PaInt16 *hostInput, PaInt16 *hostOutput )
+{
+    PaSampleFormat layout = isInterleaved ? 0 : paNonInterleaved;
+    PaUtilBufferProcessor bp;
+    PaError result;
+    long bufferCount = 16;
+    double elapsed, bestTime;
+    int r;
+
+    result = PaUtil_InitializeBufferProcessor( &bp,
+            ( direction != 1 ) ? CHANNEL_COUNT : 0, paFloat32 | layout, paInt16 | layout,
+            ( direction != 0 ) ? CHANNEL_COUNT : 0, paFloat32 | layout, paInt16 | layout,
+            SAMPLE_RATE, paClipOff | paDitherOff,
+            sizePair->framesPerUserBuffer, sizePair->framesPerHostBuffer,
+            paUtilFixedHostBufferSize, NullCallback, NULL );
+    if( result != paNoError )
+    {
+        fprintf( stderr, "PaUtil_InitializeBufferProcessor failed: %s\n", Pa_GetErrorText( result ) );
+        return 1;
+    }
+
+    /* double the buffer count until a run takes long enough to time */
+    for( ;; )
+    {
+        converterCallCount_ = 0;
+        elapsed = RunBuffers( &bp, direction, isInterleaved, hostInput, hostOutput,
+                sizePair->framesPerHostBuffer, bufferCount );
+        if( elapsed >= minimumTime || bufferCount >= (1L << 24) )
+            break;
+        bufferCount *= 2;
+    }
+
+    printf( "%lu,%lu,%s,%s,%.2f,", sizePair->framesPerHostBuffer, sizePair->framesPerUserBuffer,
+            directionNames_[direction], layoutNames_[isInterleaved ? 0 : 1],
+            (double)converterCallCount_ / bufferCount );
+
+    bestTime = elapsed;
+    for( r = 1; r < REPETITION_COUNT; ++r )
+    {
+        elapsed = RunBuffers( &bp, direction, isInterleaved, hostInput, hostOutput,
+                sizePair->framesPerHostBuffer, bufferCount );
+        if( elapsed < bestTime )
+            bestTime = elapsed;
+    }
+
+    printf( "%.1f\n", (bestTime * 1e9) / bufferCount );
+    fflush( stdout );
+
+    PaUtil_TerminateBufferProcessor( &bp );
+    return 0;
+}
+
+
+int main( int argc, char **argv )
+{
+    static PaInt16 hostInput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    static PaInt16 hostOutput[MAX_HOST_FRAMES * CHANNEL_COUNT];
+    double minimumTime = 0.05;
+    int i, direction, isInterleaved;
+
+    for( i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+        {
+            minimumTime = atof( argv[++i] );
+        }
+        else
+        {
+            fprintf( stderr, "usage: patest_adapting_benchmark [--min-time seconds]\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    for( i = 0; i < MAX_HOST_FRAMES * CHANNEL_COUNT; ++i )
+        hostInput[i] = (PaInt16)((i * 7919) & 0x7FFF);
+
+    int16ToFloat32_ = paConverters.Int16_To_Float32;
+    float32ToInt16_ = paConverters.Float32_To_Int16;
+    paConverters.Int16_To_Float32 = CountingInt16_To_Float32;
+    paConverters.Float32_To_Int16 = CountingFloat32_To_Int16;
+
+    PaUtil_InitializeClock();
+
+    printf( "host_frames,user_frames,direction,layout,converter_calls_per_host_buffer,ns_per_host_buffer\n" );
+
+    for( i = 0; i < SIZE_PAIR_COUNT; ++i )
+    {
+        for( direction = 0; direction < 3; ++direction )
+        {
+            for( isInterleaved = 1; isInterleaved >= 0; --isInterleaved )
+            {
+                if( BenchmarkSizePair( &sizePairs_[i], direction, isInterleaved, minimumTime,
+                        hostInput, hostOutput ) != 0 )
+                    return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
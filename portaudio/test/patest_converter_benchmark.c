@@ -0,0 +1,759 @@
+/** @file patest_converter_benchmark.c
+    @ingroup test_src
+    @brief Measure the speed of every sample format converter in paConverters,
+    of the frame converters, and of the buffer zeroers returned by
+    PaUtil_SelectZeroer().
+
+    Each converter is timed for a range of channel counts, buffer sizes and
+    buffer alignments, without using an audio device. The channel count is
+    applied as it is by the buffer processor: the converter is called once
+    per channel with the channel count as the stride. The results are printed
+    in nanoseconds per sample and gigabytes per second (counting the bytes
+    read and written) as CSV, or as JSON if --json is given.
+
+    Conversions between non-interleaved and interleaved buffers are timed
+    twice: with the scalar frame converter from paInterleavingConverters or
+    paDeinterleavingConverters (Interleave_..._Frames), and with one call of
+    the converter from paConverters per channel (Interleave_..._Channels).
+    The row of the way the buffer processor converts with the tier in use,
+    as chosen by PaUtil_SelectFrameConverter(), has a _Selected suffix.
+
+    Usage: patest_converter_benchmark [--json] [--tier scalar|sse2|avx2|avx512|neon]
+                [--filter substring] [--min-time seconds]
+
+    Link with pa_converters.c, pa_converters_simd.c and pa_dither.c
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stddef.h> /* offsetof() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portaudio.h"
+#include "pa_converters.h"
+#include "pa_dither.h"
+#include "pa_types.h"
+#include "pa_util.h"
+
+#define MAX_FRAME_COUNT         (4096)
+#define MAX_CHANNEL_COUNT       (8)
+#define MAX_SAMPLE_SIZE         (8)
+#define BUFFER_ALIGNMENT        (64)
+/* room for the largest buffer, offset by up to one sample from an aligned address */
+#define BUFFER_BYTES            (MAX_FRAME_COUNT * MAX_CHANNEL_COUNT * MAX_SAMPLE_SIZE + BUFFER_ALIGNMENT * 2)
+
+#define REPETITION_COUNT        (3)
+
+
+typedef struct ConverterEntry
+{
+    const char *name;
+    PaSampleFormat sourceFormat;
+    PaSampleFormat destinationFormat;
+    size_t offset; /* of the converter in PaUtilConverterTable */
+} ConverterEntry;
+
+#define CONVERTER_ENTRY_( name, source, destination )\
+    { #name, source, destination, offsetof( PaUtilConverterTable, name ) }
+
+static const ConverterEntry converters_[] =
+{
+    CONVERTER_ENTRY_( Float32_To_Int32, paFloat32, paInt32 ),
+    CONVERTER_ENTRY_( Float32_To_Int32_Dither, paFloat32, paInt32 ),
+    CONVERTER_ENTRY_( Float32_To_Int32_Clip, paFloat32, paInt32 ),
+    CONVERTER_ENTRY_( Float32_To_Int32_DitherClip, paFloat32, paInt32 ),
+
+    CONVERTER_ENTRY_( Float32_To_Int24, paFloat32, paInt24 ),
+    CONVERTER_ENTRY_( Float32_To_Int24_Dither, paFloat32, paInt24 ),
+    CONVERTER_ENTRY_( Float32_To_Int24_Clip, paFloat32, paInt24 ),
+    CONVERTER_ENTRY_( Float32_To_Int24_DitherClip, paFloat32, paInt24 ),
+
+    CONVERTER_ENTRY_( Float32_To_Int16, paFloat32, paInt16 ),
+    CONVERTER_ENTRY_( Float32_To_Int16_Dither, paFloat32, paInt16 ),
+    CONVERTER_ENTRY_( Float32_To_Int16_Clip, paFloat32, paInt16 ),
+    CONVERTER_ENTRY_( Float32_To_Int16_DitherClip, paFloat32, paInt16 ),
+    CONVERTER_ENTRY_( Float32_To_Int16_NoiseShaped, paFloat32, paInt16 ),
+
+    CONVERTER_ENTRY_( Float32_To_Int8, paFloat32, paInt8 ),
+    CONVERTER_ENTRY_( Float32_To_Int8_Dither, paFloat32, paInt8 ),
+    CONVERTER_ENTRY_( Float32_To_Int8_Clip, paFloat32, paInt8 ),
+    CONVERTER_ENTRY_( Float32_To_Int8_DitherClip, paFloat32, paInt8 ),
+
+    CONVERTER_ENTRY_( Float32_To_UInt8, paFloat32, paUInt8 ),
+    CONVERTER_ENTRY_( Float32_To_UInt8_Dither, paFloat32, paUInt8 ),
+    CONVERTER_ENTRY_( Float32_To_UInt8_Clip, paFloat32, paUInt8 ),
+    CONVERTER_ENTRY_( Float32_To_UInt8_DitherClip, paFloat32, paUInt8 ),
+
+    CONVERTER_ENTRY_( Int32_To_Float32, paInt32, paFloat32 ),
+    CONVERTER_ENTRY_( Int32_To_Int24, paInt32, paInt24 ),
+    CONVERTER_ENTRY_( Int32_To_Int24_Dither, paInt32, paInt24 ),
+    CONVERTER_ENTRY_( Int32_To_Int16, paInt32, paInt16 ),
+    CONVERTER_ENTRY_( Int32_To_Int16_Dither, paInt32, paInt16 ),
+    CONVERTER_ENTRY_( Int32_To_Int16_NoiseShaped, paInt32, paInt16 ),
+    CONVERTER_ENTRY_( Int32_To_Int8, paInt32, paInt8 ),
+    CONVERTER_ENTRY_( Int32_To_Int8_Dither, paInt32, paInt8 ),
+    CONVERTER_ENTRY_( Int32_To_UInt8, paInt32, paUInt8 ),
+    CONVERTER_ENTRY_( Int32_To_UInt8_Dither, paInt32, paUInt8 ),
+
+    CONVERTER_ENTRY_( Int24_To_Float32, paInt24, paFloat32 ),
+    CONVERTER_ENTRY_( Int24_To_Int32, paInt24, paInt32 ),
+    CONVERTER_ENTRY_( Int24_To_Int16, paInt24, paInt16 ),
+    CONVERTER_ENTRY_( Int24_To_Int16_Dither, paInt24, paInt16 ),
+    CONVERTER_ENTRY_( Int24_To_Int16_NoiseShaped, paInt24, paInt16 ),
+    CONVERTER_ENTRY_( Int24_To_Int8, paInt24, paInt8 ),
+    CONVERTER_ENTRY_( Int24_To_Int8_Dither, paInt24, paInt8 ),
+    CONVERTER_ENTRY_( Int24_To_UInt8, paInt24, paUInt8 ),
+    CONVERTER_ENTRY_( Int24_To_UInt8_Dither, paInt24, paUInt8 ),
+
+    CONVERTER_ENTRY_( Int16_To_Float32, paInt16, paFloat32 ),
+    CONVERTER_ENTRY_( Int16_To_Int32, paInt16, paInt32 ),
+    CONVERTER_ENTRY_( Int16_To_Int24, paInt16, paInt24 ),
+    CONVERTER_ENTRY_( Int16_To_Int8, paInt16, paInt8 ),
+    CONVERTER_ENTRY_( Int16_To_Int8_Dither, paInt16, paInt8 ),
+    CONVERTER_ENTRY_( Int16_To_UInt8, paInt16, paUInt8 ),
+    CONVERTER_ENTRY_( Int16_To_UInt8_Dither, paInt16, paUInt8 ),
+
+    CONVERTER_ENTRY_( Int8_To_Float32, paInt8, paFloat32 ),
+    CONVERTER_ENTRY_( Int8_To_Int32, paInt8, paInt32 ),
+    CONVERTER_ENTRY_( Int8_To_Int24, paInt8, paInt24 ),
+    CONVERTER_ENTRY_( Int8_To_Int16, paInt8, paInt16 ),
+    CONVERTER_ENTRY_( Int8_To_UInt8, paInt8, paUInt8 ),
+
+    CONVERTER_ENTRY_( UInt8_To_Float32, paUInt8, paFloat32 ),
+    CONVERTER_ENTRY_( UInt8_To_Int32, paUInt8, paInt32 ),
+    CONVERTER_ENTRY_( UInt8_To_Int24, paUInt8, paInt24 ),
+    CONVERTER_ENTRY_( UInt8_To_Int16, paUInt8, paInt16 ),
+    CONVERTER_ENTRY_( UInt8_To_Int8, paUInt8, paInt8 ),
+
+    CONVERTER_ENTRY_( Float32_To_Float64, paFloat32, paFloat64 ),
+    CONVERTER_ENTRY_( Float64_To_Float32, paFloat64, paFloat32 ),
+
+    CONVERTER_ENTRY_( Float64_To_Int32, paFloat64, paInt32 ),
+    CONVERTER_ENTRY_( Float64_To_Int32_Dither, paFloat64, paInt32 ),
+    CONVERTER_ENTRY_( Float64_To_Int32_Clip, paFloat64, paInt32 ),
+    CONVERTER_ENTRY_( Float64_To_Int32_DitherClip, paFloat64, paInt32 ),
+
+    CONVERTER_ENTRY_( Float64_To_Int24, paFloat64, paInt24 ),
+    CONVERTER_ENTRY_( Float64_To_Int24_Dither, paFloat64, paInt24 ),
+    CONVERTER_ENTRY_( Float64_To_Int24_Clip, paFloat64, paInt24 ),
+    CONVERTER_ENTRY_( Float64_To_Int24_DitherClip, paFloat64, paInt24 ),
+
+    CONVERTER_ENTRY_( Float64_To_Int16, paFloat64, paInt16 ),
+    CONVERTER_ENTRY_( Float64_To_Int16_Dither, paFloat64, paInt16 ),
+    CONVERTER_ENTRY_( Float64_To_Int16_Clip, paFloat64, paInt16 ),
+    CONVERTER_ENTRY_( Float64_To_Int16_DitherClip, paFloat64, paInt16 ),
+    CONVERTER_ENTRY_( Float64_To_Int16_NoiseShaped, paFloat64, paInt16 ),
+
+    CONVERTER_ENTRY_( Float64_To_Int8, paFloat64, paInt8 ),
+    CONVERTER_ENTRY_( Float64_To_Int8_Dither, paFloat64, paInt8 ),
+    CONVERTER_ENTRY_( Float64_To_Int8_Clip, paFloat64, paInt8 ),
+    CONVERTER_ENTRY_( Float64_To_Int8_DitherClip, paFloat64, paInt8 ),
+
+    CONVERTER_ENTRY_( Float64_To_UInt8, paFloat64, paUInt8 ),
+    CONVERTER_ENTRY_( Float64_To_UInt8_Dither, paFloat64, paUInt8 ),
+    CONVERTER_ENTRY_( Float64_To_UInt8_Clip, paFloat64, paUInt8 ),
+    CONVERTER_ENTRY_( Float64_To_UInt8_DitherClip, paFloat64, paUInt8 ),
+
+    CONVERTER_ENTRY_( Int32_To_Float64, paInt32, paFloat64 ),
+    CONVERTER_ENTRY_( Int24_To_Float64, paInt24, paFloat64 ),
+    CONVERTER_ENTRY_( Int16_To_Float64, paInt16, paFloat64 ),
+    CONVERTER_ENTRY_( Int8_To_Float64, paInt8, paFloat64 ),
+    CONVERTER_ENTRY_( UInt8_To_Float64, paUInt8, paFloat64 ),
+
+    CONVERTER_ENTRY_( Copy_8_To_8, paInt8, paInt8 ),
+    CONVERTER_ENTRY_( Copy_16_To_16, paInt16, paInt16 ),
+    CONVERTER_ENTRY_( Copy_24_To_24, paInt24, paInt24 ),
+    CONVERTER_ENTRY_( Copy_32_To_32, paInt32, paInt32 ),
+    CONVERTER_ENTRY_( Copy_64_To_64, paFloat64, paFloat64 )
+};
+
+#define CONVERTER_COUNT     ((int)(sizeof(converters_) / sizeof(converters_[0])))
+
+
+typedef struct FrameConverterEntry
+{
+    const char *name;
+    PaSampleFormat sourceFormat;
+    PaSampleFormat destinationFormat;
+    PaStreamFlags flags; /* selecting the same converter with PaUtil_SelectFrameConverter() */
+    size_t frameConverterOffset; /* of the frame converter in PaUtilFrameConverterTable */
+    size_t converterOffset; /* of the converter with the same name in PaUtilConverterTable */
+} FrameConverterEntry;
+
+#define FRAME_CONVERTER_ENTRY_( name, source, destination, flags )\
+    { #name, source, destination, flags, offsetof( PaUtilFrameConverterTable, name ),\
+        offsetof( PaUtilConverterTable, name ) }
+
+static const FrameConverterEntry frameConverters_[] =
+{
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int32, paFloat32, paInt32, paClipOff | paDitherOff ),
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int32_DitherClip, paFloat32, paInt32, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int24, paFloat32, paInt24, paClipOff | paDitherOff ),
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int24_DitherClip, paFloat32, paInt24, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int16, paFloat32, paInt16, paClipOff | paDitherOff ),
+    FRAME_CONVERTER_ENTRY_( Float32_To_Int16_DitherClip, paFloat32, paInt16, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Int32_To_Float32, paInt32, paFloat32, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Int24_To_Float32, paInt24, paFloat32, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Int16_To_Float32, paInt16, paFloat32, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Copy_16_To_16, paInt16, paInt16, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Copy_24_To_24, paInt24, paInt24, paNoFlag ),
+    FRAME_CONVERTER_ENTRY_( Copy_32_To_32, paInt32, paInt32, paNoFlag )
+};
+
+#define FRAME_CONVERTER_COUNT   ((int)(sizeof(frameConverters_) / sizeof(frameConverters_[0])))
+
+/* the distance between the non-interleaved channels of the frame converter buffers */
+#define CHANNEL_BYTES           (MAX_FRAME_COUNT * MAX_SAMPLE_SIZE)
+
+
+/* The zeroers are named after the sample format passed to PaUtil_SelectZeroer() */
+static const PaSampleFormat zeroerFormats_[] = { paFloat64, paFloat32, paInt32, paInt24, paInt16, paInt8, paUInt8 };
+static const char *zeroerNames_[] = { "Zero_Float64", "Zero_Float32", "Zero_Int32", "Zero_Int24", "Zero_Int16", "Zero_Int8", "Zero_UInt8" };
+
+#define ZEROER_COUNT        ((int)(sizeof(zeroerFormats_) / sizeof(zeroerFormats_[0])))
+
+
+static const int channelCounts_[] = { 1, 2, 8 };
+static const int frameCounts_[] = { 64, 256, 1024, 4096 };
+
+/* an aligned buffer, and one which starts one sample past an aligned address */
+static const char *alignmentNames_[] = { "aligned", "offset" };
+#define ALIGNMENT_COUNT     (2)
+
+
+typedef struct BenchmarkOptions
+{
+    int json;
+    const char *filter;
+    double minimumTime;
+} BenchmarkOptions;
+
+
+static int GetSampleSize( PaSampleFormat format )
+{
+    switch( format )
+    {
+    case paFloat64:
+        return 8;
+    case paFloat32:
+    case paInt32:
+        return 4;
+    case paInt24:
+        return 3;
+    case paInt16:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+
+static const char *GetTierName( PaConverterTier tier )
+{
+    switch( tier )
+    {
+    case paConverterTierScalar: return "scalar";
+    case paConverterTierSSE2: return "sse2";
+    case paConverterTierAVX2: return "avx2";
+    case paConverterTierAVX512: return "avx512";
+    case paConverterTierNEON: return "neon";
+    default: return "default";
+    }
+}
+
+
+static unsigned char *AlignBuffer( unsigned char *buffer, int alignment, int sampleSize )
+{
+    unsigned char *result = buffer + BUFFER_ALIGNMENT - ((size_t)buffer % BUFFER_ALIGNMENT);
+
+    if( alignment != 0 )
+        result += sampleSize;
+
+    return result;
+}
+
+
+/* Fill the buffer with noise. Float samples stay within -1.0 to +1.0 so that
+ the measurements reflect the common, unclipped, case. */
+static void GenerateNoise( PaSampleFormat format, unsigned char *buffer, int sampleCount )
+{
+    PaUint32 seed = 22222;
+    int i;
+
+    if( format == paFloat32 )
+    {
+        float *samples = (float*)buffer;
+        for( i = 0; i < sampleCount; ++i )
+        {
+            seed = (seed * 196314165) + 907633515;
+            samples[i] = ((float)(seed >> 8) / (float)(1 << 24)) * 2.0f - 1.0f;
+        }
+    }
+    else if( format == paFloat64 )
+    {
+        double *samples = (double*)buffer;
+        for( i = 0; i < sampleCount; ++i )
+        {
+            seed = (seed * 196314165) + 907633515;
+            samples[i] = ((double)(seed >> 8) / (double)(1 << 24)) * 2.0 - 1.0;
+        }
+    }
+    else
+    {
+        for( i = 0; i < sampleCount * GetSampleSize( format ); ++i )
+        {
+            seed = (seed * 196314165) + 907633515;
+            buffer[i] = (unsigned char)(seed >> 24);
+        }
+    }
+}
+
+
+/* Convert (or zero if zeroer is non-NULL) one interleaved buffer, a channel
+ at a time, the given number of times. Returns the elapsed time in seconds. */
+static double RunConversions( PaUtilConverter *converter, PaUtilZeroer *zeroer,
+        unsigned char *destination, int destinationSampleSize,
+        unsigned char *source, int sourceSampleSize,
+        int channelCount, int frameCount, long iterations,
+        PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    double startTime = PaUtil_GetTime();
+    long i;
+    int channel;
+
+    for( i = 0; i < iterations; ++i )
+    {
+        for( channel = 0; channel < channelCount; ++channel )
+        {
+            if( zeroer )
+            {
+                (*zeroer)( destination + channel * destinationSampleSize, channelCount, frameCount );
+            }
+            else
+            {
+                (*converter)( destination + channel * destinationSampleSize, channelCount,
+                        source + channel * sourceSampleSize, channelCount,
+                        frameCount, ditherGenerator );
+            }
+        }
+    }
+
+    return PaUtil_GetTime() - startTime;
+}
+
+
+/* Convert between non-interleaved channels and an interleaved buffer the
+ given number of times, with frameConverter if it is non-NULL, or else with
+ one call of converter per channel. interleave is non-zero if the source is
+ non-interleaved. Returns the elapsed time in seconds. */
+static double RunFrameConversions( PaUtilFrameConverter *frameConverter, PaUtilConverter *converter,
+        int interleave, unsigned char *destination, int destinationSampleSize,
+        unsigned char *source, int sourceSampleSize,
+        int channelCount, int frameCount, long iterations,
+        PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    void *channels[MAX_CHANNEL_COUNT];
+    unsigned char *nonInterleaved = interleave ? source : destination;
+    double startTime;
+    long i;
+    int channel;
+
+    for( channel = 0; channel < channelCount; ++channel )
+        channels[channel] = nonInterleaved + channel * CHANNEL_BYTES;
+
+    startTime = PaUtil_GetTime();
+
+    for( i = 0; i < iterations; ++i )
+    {
+        if( frameConverter )
+        {
+            if( interleave )
+                (*frameConverter)( destination, channels, channelCount, frameCount, ditherGenerator );
+            else
+                (*frameConverter)( source, channels, channelCount, frameCount, ditherGenerator );
+        }
+        else
+        {
+            for( channel = 0; channel < channelCount; ++channel )
+            {
+                if( interleave )
+                {
+                    (*converter)( destination + channel * destinationSampleSize, channelCount,
+                            channels[channel], 1, frameCount, ditherGenerator );
+                }
+                else
+                {
+                    (*converter)( channels[channel], 1,
+                            source + channel * sourceSampleSize, channelCount,
+                            frameCount, ditherGenerator );
+                }
+            }
+        }
+    }
+
+    return PaUtil_GetTime() - startTime;
+}
+
+
+static void PrintHeader( const BenchmarkOptions *options )
+{
+    if( options->json )
+        printf( "[\n" );
+    else
+        printf( "tier,converter,channels,frames,alignment,ns_per_sample,gb_per_second\n" );
+}
+
+
+static void PrintResult( const BenchmarkOptions *options, int *first, const char *name,
+        int channelCount, int frameCount, int alignment, double nsPerSample, double gbPerSecond )
+{
+    const char *tierName = GetTierName( PaUtil_GetConverterTier() );
+
+    if( options->json )
+    {
+        printf( "%s  { \"tier\": \"%s\", \"converter\": \"%s\", \"channels\": %d, \"frames\": %d, "
+                "\"alignment\": \"%s\", \"ns_per_sample\": %.4f, \"gb_per_second\": %.4f }",
+                *first ? "" : ",\n", tierName, name, channelCount, frameCount,
+                alignmentNames_[alignment], nsPerSample, gbPerSecond );
+    }
+    else
+    {
+        printf( "%s,%s,%d,%d,%s,%.4f,%.4f\n", tierName, name, channelCount, frameCount,
+                alignmentNames_[alignment], nsPerSample, gbPerSecond );
+    }
+
+    *first = 0;
+    fflush( stdout );
+}
+
+
+static void PrintFooter( const BenchmarkOptions *options )
+{
+    if( options->json )
+        printf( "\n]\n" );
+}
+
+
+/* Time one converter or zeroer with every combination of channel count,
+ frame count and alignment. */
+static void BenchmarkEntry( const BenchmarkOptions *options, int *first, const char *name,
+        PaUtilConverter *converter, PaUtilZeroer *zeroer,
+        PaSampleFormat sourceFormat, PaSampleFormat destinationFormat,
+        unsigned char *sourceBuffer, unsigned char *destinationBuffer )
+{
+    int sourceSampleSize = GetSampleSize( sourceFormat );
+    int destinationSampleSize = GetSampleSize( destinationFormat );
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int c, f, a, r;
+
+    if( options->filter && strstr( name, options->filter ) == NULL )
+        return;
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+
+    for( c = 0; c < (int)(sizeof(channelCounts_) / sizeof(channelCounts_[0])); ++c )
+    {
+        for( f = 0; f < (int)(sizeof(frameCounts_) / sizeof(frameCounts_[0])); ++f )
+        {
+            for( a = 0; a < ALIGNMENT_COUNT; ++a )
+            {
+                int channelCount = channelCounts_[c];
+                int frameCount = frameCounts_[f];
+                long sampleCount = (long)channelCount * frameCount;
+                unsigned char *source = AlignBuffer( sourceBuffer, a, sourceSampleSize );
+                unsigned char *destination = AlignBuffer( destinationBuffer, a, destinationSampleSize );
+                long iterations = 1;
+                double elapsed, bestTime;
+
+                GenerateNoise( sourceFormat, source, (int)sampleCount );
+
+                /* double the iteration count until a run takes long enough to time */
+                for( ;; )
+                {
+                    elapsed = RunConversions( converter, zeroer, destination, destinationSampleSize,
+                            source, sourceSampleSize, channelCount, frameCount, iterations, &ditherGenerator );
+                    if( elapsed >= options->minimumTime || iterations >= (1L << 24) )
+                        break;
+                    iterations *= 2;
+                }
+
+                bestTime = elapsed;
+                for( r = 1; r < REPETITION_COUNT; ++r )
+                {
+                    elapsed = RunConversions( converter, zeroer, destination, destinationSampleSize,
+                            source, sourceSampleSize, channelCount, frameCount, iterations, &ditherGenerator );
+                    if( elapsed < bestTime )
+                        bestTime = elapsed;
+                }
+
+                if( bestTime <= 0. ) /* clock resolution too coarse */
+                    continue;
+
+                PrintResult( options, first, name, channelCount, frameCount, a,
+                        (bestTime * 1e9) / ((double)sampleCount * iterations),
+                        ((double)sampleCount * iterations * (zeroer ? 0 : sourceSampleSize) +
+                            (double)sampleCount * iterations * destinationSampleSize) / (bestTime * 1e9) );
+            }
+        }
+    }
+}
+
+
+/* Time one conversion between non-interleaved and interleaved buffers, with
+ frameConverter or converter, with every combination of channel count,
+ frame count and alignment. */
+static void BenchmarkFrameEntry( const BenchmarkOptions *options, int *first, const char *name,
+        PaUtilFrameConverter *frameConverter, PaUtilConverter *converter, int interleave,
+        PaSampleFormat sourceFormat, PaSampleFormat destinationFormat,
+        unsigned char *sourceBuffer, unsigned char *destinationBuffer )
+{
+    int sourceSampleSize = GetSampleSize( sourceFormat );
+    int destinationSampleSize = GetSampleSize( destinationFormat );
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int c, f, a, r;
+
+    if( options->filter && strstr( name, options->filter ) == NULL )
+        return;
+
+    PaUtil_InitializeTriangularDitherState( &ditherGenerator );
+
+    for( c = 0; c < (int)(sizeof(channelCounts_) / sizeof(channelCounts_[0])); ++c )
+    {
+        if( channelCounts_[c] < 2 ) /* the buffer processor only uses frame converters for several channels */
+            continue;
+
+        for( f = 0; f < (int)(sizeof(frameCounts_) / sizeof(frameCounts_[0])); ++f )
+        {
+            for( a = 0; a < ALIGNMENT_COUNT; ++a )
+            {
+                int channelCount = channelCounts_[c];
+                int frameCount = frameCounts_[f];
+                long sampleCount = (long)channelCount * frameCount;
+                unsigned char *source = AlignBuffer( sourceBuffer, a, sourceSampleSize );
+                unsigned char *destination = AlignBuffer( destinationBuffer, a, destinationSampleSize );
+                long iterations = 1;
+                double elapsed, bestTime;
+                int channel;
+
+                if( interleave )
+                {
+                    for( channel = 0; channel < channelCount; ++channel )
+                        GenerateNoise( sourceFormat, source + channel * CHANNEL_BYTES, frameCount );
+                }
+                else
+                {
+                    GenerateNoise( sourceFormat, source, (int)sampleCount );
+                }
+
+                /* double the iteration count until a run takes long enough to time */
+                for( ;; )
+                {
+                    elapsed = RunFrameConversions( frameConverter, converter, interleave,
+                            destination, destinationSampleSize, source, sourceSampleSize,
+                            channelCount, frameCount, iterations, &ditherGenerator );
+                    if( elapsed >= options->minimumTime || iterations >= (1L << 24) )
+                        break;
+                    iterations *= 2;
+                }
+
+                bestTime = elapsed;
+                for( r = 1; r < REPETITION_COUNT; ++r )
+                {
+                    elapsed = RunFrameConversions( frameConverter, converter, interleave,
+                            destination, destinationSampleSize, source, sourceSampleSize,
+                            channelCount, frameCount, iterations, &ditherGenerator );
+                    if( elapsed < bestTime )
+                        bestTime = elapsed;
+                }
+
+                if( bestTime <= 0. ) /* clock resolution too coarse */
+                    continue;
+
+                PrintResult( options, first, name, channelCount, frameCount, a,
+                        (bestTime * 1e9) / ((double)sampleCount * iterations),
+                        ((double)sampleCount * iterations * (sourceSampleSize + destinationSampleSize))
+                            / (bestTime * 1e9) );
+            }
+        }
+    }
+}
+
+
+static void PrintUsage( void )
+{
+    fprintf( stderr, "usage: patest_converter_benchmark [--json] [--tier scalar|sse2|avx2|avx512|neon]\n"
+            "            [--filter substring] [--min-time seconds]\n" );
+}
+
+
+int main( int argc, char **argv )
+{
+    static const PaConverterTier tiers[] = { paConverterTierScalar, paConverterTierSSE2,
+            paConverterTierAVX2, paConverterTierAVX512, paConverterTierNEON };
+    BenchmarkOptions options;
+    unsigned char *sourceBuffer, *destinationBuffer;
+    int first = 1;
+    int i;
+
+    options.json = 0;
+    options.filter = NULL;
+    options.minimumTime = 0.01;
+
+    for( i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--json" ) == 0 )
+        {
+            options.json = 1;
+        }
+        else if( strcmp( argv[i], "--tier" ) == 0 && i + 1 < argc )
+        {
+            int t;
+            PaError err = paConverterTierNotSupported;
+
+            ++i;
+            for( t = 0; t < (int)(sizeof(tiers) / sizeof(tiers[0])); ++t )
+            {
+                if( strcmp( argv[i], GetTierName( tiers[t] ) ) == 0 )
+                    err = PaUtil_SetConverterTier( tiers[t] );
+            }
+
+            if( err != paNoError )
+            {
+                fprintf( stderr, "converter tier %s is not supported\n", argv[i] );
+                return EXIT_FAILURE;
+            }
+        }
+        else if( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc )
+        {
+            options.filter = argv[++i];
+        }
+        else if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+        {
+            options.minimumTime = atof( argv[++i] );
+        }
+        else
+        {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    sourceBuffer = (unsigned char*)malloc( BUFFER_BYTES );
+    destinationBuffer = (unsigned char*)malloc( BUFFER_BYTES );
+    if( !sourceBuffer || !destinationBuffer )
+    {
+        fprintf( stderr, "out of memory\n" );
+        free( sourceBuffer );
+        free( destinationBuffer );
+        return EXIT_FAILURE;
+    }
+
+    PaUtil_InitializeClock();
+    fprintf( stderr, "using %s converters\n", GetTierName( PaUtil_GetConverterTier() ) );
+
+    PrintHeader( &options );
+
+    for( i = 0; i < CONVERTER_COUNT; ++i )
+    {
+        PaUtilConverter *converter =
+                *(PaUtilConverter**)((char*)&paConverters + converters_[i].offset);
+
+        if( converter ) /* entries may be NULL with PA_NO_STANDARD_CONVERTERS */
+        {
+            BenchmarkEntry( &options, &first, converters_[i].name, converter, NULL,
+                    converters_[i].sourceFormat, converters_[i].destinationFormat,
+                    sourceBuffer, destinationBuffer );
+        }
+    }
+
+    for( i = 0; i < FRAME_CONVERTER_COUNT; ++i )
+    {
+        static const char *directionNames[] = { "Deinterleave", "Interleave" };
+        const FrameConverterEntry *entry = &frameConverters_[i];
+        PaUtilConverter *converter =
+                *(PaUtilConverter**)((char*)&paConverters + entry->converterOffset);
+        char name[128];
+        int interleave;
+
+        for( interleave = 0; interleave < 2; ++interleave )
+        {
+            PaSampleFormat sourceFormat = entry->sourceFormat | (interleave ? paNonInterleaved : 0);
+            PaSampleFormat destinationFormat = entry->destinationFormat | (interleave ? 0 : paNonInterleaved);
+            int selected = PaUtil_SelectFrameConverter( sourceFormat, destinationFormat, entry->flags ) != NULL;
+            PaUtilFrameConverter *frameConverter = *(PaUtilFrameConverter**)((char*)
+                    (interleave ? &paInterleavingConverters : &paDeinterleavingConverters)
+                    + entry->frameConverterOffset );
+
+            if( frameConverter )
+            {
+                sprintf( name, "%s_%s_Frames%s", directionNames[interleave], entry->name,
+                        selected ? "_Selected" : "" );
+                BenchmarkFrameEntry( &options, &first, name, frameConverter, NULL, interleave,
+                        entry->sourceFormat, entry->destinationFormat, sourceBuffer, destinationBuffer );
+            }
+
+            if( converter )
+            {
+                sprintf( name, "%s_%s_Channels%s", directionNames[interleave], entry->name,
+                        selected ? "" : "_Selected" );
+                BenchmarkFrameEntry( &options, &first, name, NULL, converter, interleave,
+                        entry->sourceFormat, entry->destinationFormat, sourceBuffer, destinationBuffer );
+            }
+        }
+    }
+
+    for( i = 0; i < ZEROER_COUNT; ++i )
+    {
+        PaUtilZeroer *zeroer = PaUtil_SelectZeroer( zeroerFormats_[i] );
+
+        if( zeroer )
+        {
+            BenchmarkEntry( &options, &first, zeroerNames_[i], NULL, zeroer,
+                    zeroerFormats_[i], zeroerFormats_[i], sourceBuffer, destinationBuffer );
+        }
+    }
+
+    PrintFooter( &options );
+
+    free( sourceBuffer );
+    free( destinationBuffer );
+
+    return EXIT_SUCCESS;
+}
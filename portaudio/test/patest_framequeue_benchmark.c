@@ -0,0 +1,386 @@
+/** @file patest_framequeue_benchmark.c
+    @ingroup test_src
+    @brief Measure the throughput of PaUtilFrameQueue with many producer threads.
+
+    1 to 64 producer threads write frames into a queue while a single
+    consumer thread reads them back and checks that each producer's frames
+    arrive in order. The throughput of PaUtilFrameQueue, where each producer
+    writes directly into its own reservation, is compared with a
+    PaUtilRingBuffer whose producers are serialized by a mutex. The results
+    are printed as CSV, in millions of frames per second, for each number of
+    producers.
+
+    Producers which find the queue full, and a consumer which finds it
+    empty, yield the processor, so the results depend on the number of
+    CPUs available as well as on the queue.
+
+    Usage: patest_framequeue_benchmark [--chunk frames] [--min-time seconds]
+
+    Link with pa_framequeue.c and pa_ringbuffer.c
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "portaudio.h"
+#include "pa_framequeue.h"
+#include "pa_ringbuffer.h"
+#include "pa_util.h"
+
+#define ELEMENT_COUNT           (4096)
+#define MAX_PRODUCER_COUNT      (64)
+#define REPETITION_COUNT        (3)
+
+/* each frame carries its producer and a sequence number which the consumer checks */
+typedef struct Frame
+{
+    unsigned long sequence;
+    int producer;
+} Frame;
+
+#if defined(_WIN32)
+typedef CRITICAL_SECTION Mutex;
+#define MutexInitialize( m )    InitializeCriticalSection( m )
+#define MutexTerminate( m )     DeleteCriticalSection( m )
+#define MutexLock( m )          EnterCriticalSection( m )
+#define MutexUnlock( m )        LeaveCriticalSection( m )
+#define YieldThread()           SwitchToThread()
+#else
+typedef pthread_mutex_t Mutex;
+#define MutexInitialize( m )    pthread_mutex_init( m, NULL )
+#define MutexTerminate( m )     pthread_mutex_destroy( m )
+#define MutexLock( m )          pthread_mutex_lock( m )
+#define MutexUnlock( m )        pthread_mutex_unlock( m )
+#define YieldThread()           sched_yield()
+#endif
+
+typedef enum QueueType
+{
+    MUTEX_RING_BUFFER,
+    FRAME_QUEUE
+} QueueType;
+
+typedef struct Benchmark
+{
+    QueueType type;
+    PaUtilRingBuffer ringBuffer;
+    Mutex mutex;
+    PaUtilFrameQueue frameQueue;
+    ring_buffer_size_t chunkFrames;
+    unsigned long framesPerProducer;
+} Benchmark;
+
+typedef struct Producer
+{
+    Benchmark *benchmark;
+    int producer;
+} Producer;
+
+static void FillFrames( void *data, ring_buffer_size_t size, int producer, unsigned long *sequence )
+{
+    ring_buffer_size_t i;
+    for( i = 0; i < size; ++i )
+    {
+        ((Frame*)data)[i].sequence = (*sequence)++;
+        ((Frame*)data)[i].producer = producer;
+    }
+}
+
+static ring_buffer_size_t ChunkSize( const Benchmark *benchmark, unsigned long sequence )
+{
+    unsigned long remaining = benchmark->framesPerProducer - sequence;
+    return ( remaining < (unsigned long)benchmark->chunkFrames ) ? (ring_buffer_size_t)remaining : benchmark->chunkFrames;
+}
+
+static void Produce( Producer *producer )
+{
+    Benchmark *benchmark = producer->benchmark;
+    PaUtilFrameQueueReservation reservation;
+    unsigned long sequence = 0;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, written;
+
+    while( sequence < benchmark->framesPerProducer )
+    {
+        if( benchmark->type == FRAME_QUEUE )
+        {
+            written = PaUtil_ReserveFrameQueueWrite( &benchmark->frameQueue, ChunkSize( benchmark, sequence ),
+                    &reservation, &data1, &size1, &data2, &size2 );
+            FillFrames( data1, size1, producer->producer, &sequence );
+            FillFrames( data2, size2, producer->producer, &sequence );
+            PaUtil_CommitFrameQueueWrite( &benchmark->frameQueue, &reservation );
+        }
+        else
+        {
+            MutexLock( &benchmark->mutex );
+            written = PaUtil_GetRingBufferWriteRegions( &benchmark->ringBuffer, ChunkSize( benchmark, sequence ),
+                    &data1, &size1, &data2, &size2 );
+            FillFrames( data1, size1, producer->producer, &sequence );
+            FillFrames( data2, size2, producer->producer, &sequence );
+            PaUtil_AdvanceRingBufferWriteIndex( &benchmark->ringBuffer, written );
+            MutexUnlock( &benchmark->mutex );
+        }
+
+        if( written == 0 )
+            YieldThread();
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI ProducerThread( LPVOID userData )
+{
+    Produce( (Producer*)userData );
+    return 0;
+}
+#else
+static void *ProducerThread( void *userData )
+{
+    Produce( (Producer*)userData );
+    return NULL;
+}
+#endif
+
+/* Read all frames, checking that each producer's frames are in order.
+    Returns the number of frames out of order. */
+static unsigned long Consume( Benchmark *benchmark, int producerCount )
+{
+    unsigned long sequences[MAX_PRODUCER_COUNT];
+    unsigned long total = 0, errorCount = 0;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, available, i;
+    const Frame *frame;
+
+    memset( sequences, 0, sizeof(sequences) );
+
+    while( total < benchmark->framesPerProducer * producerCount )
+    {
+        if( benchmark->type == FRAME_QUEUE )
+            available = PaUtil_GetFrameQueueReadRegions( &benchmark->frameQueue, ELEMENT_COUNT,
+                    &data1, &size1, &data2, &size2 );
+        else
+            available = PaUtil_GetRingBufferReadRegions( &benchmark->ringBuffer, ELEMENT_COUNT,
+                    &data1, &size1, &data2, &size2 );
+        if( available == 0 )
+        {
+            YieldThread();
+            continue;
+        }
+
+        for( i = 0; i < available; ++i )
+        {
+            frame = ( i < size1 ) ? &((const Frame*)data1)[i] : &((const Frame*)data2)[i - size1];
+            if( frame->producer < 0 || frame->producer >= producerCount
+                    || frame->sequence != sequences[frame->producer] )
+                ++errorCount;
+            else
+                ++sequences[frame->producer];
+        }
+
+        if( benchmark->type == FRAME_QUEUE )
+            PaUtil_AdvanceFrameQueueReadIndex( &benchmark->frameQueue, available );
+        else
+            PaUtil_AdvanceRingBufferReadIndex( &benchmark->ringBuffer, available );
+        total += available;
+    }
+    return errorCount;
+}
+
+
+/* Transfer framesPerProducer frames from each producer. Returns the elapsed
+    time in seconds, or a negative value on error. */
+static double RunTransfer( QueueType type, int producerCount, unsigned long framesPerProducer,
+        ring_buffer_size_t chunkFrames, void *data, ring_buffer_size_t *commits )
+{
+    static Benchmark benchmark;
+    Producer producers[MAX_PRODUCER_COUNT];
+#if defined(_WIN32)
+    HANDLE threads[MAX_PRODUCER_COUNT];
+#else
+    pthread_t threads[MAX_PRODUCER_COUNT];
+#endif
+    double startTime, elapsed;
+    unsigned long errorCount;
+    int p, threadCount = 0;
+
+    benchmark.type = type;
+    benchmark.chunkFrames = chunkFrames;
+    benchmark.framesPerProducer = framesPerProducer;
+    PaUtil_InitializeRingBuffer( &benchmark.ringBuffer, sizeof(Frame), ELEMENT_COUNT, data );
+    PaUtil_InitializeFrameQueue( &benchmark.frameQueue, sizeof(Frame), ELEMENT_COUNT, data, commits );
+    MutexInitialize( &benchmark.mutex );
+
+    startTime = PaUtil_GetTime();
+
+    for( p = 0; p < producerCount; ++p )
+    {
+        producers[p].benchmark = &benchmark;
+        producers[p].producer = p;
+#if defined(_WIN32)
+        threads[p] = CreateThread( NULL, 0, ProducerThread, &producers[p], 0, NULL );
+        if( threads[p] == NULL )
+            break;
+#else
+        if( pthread_create( &threads[p], NULL, ProducerThread, &producers[p] ) != 0 )
+            break;
+#endif
+        ++threadCount;
+    }
+    /* if some producers failed to start, still drain the ones which did */
+    errorCount = Consume( &benchmark, threadCount );
+
+    for( p = 0; p < threadCount; ++p )
+    {
+#if defined(_WIN32)
+        WaitForSingleObject( threads[p], INFINITE );
+        CloseHandle( threads[p] );
+#else
+        pthread_join( threads[p], NULL );
+#endif
+    }
+
+    elapsed = PaUtil_GetTime() - startTime;
+    MutexTerminate( &benchmark.mutex );
+
+    if( threadCount < producerCount )
+    {
+        fprintf( stderr, "failed to start %d producer threads\n", producerCount );
+        return -1.;
+    }
+    if( errorCount != 0 )
+    {
+        fprintf( stderr, "%lu frames out of order\n", errorCount );
+        return -1.;
+    }
+    return elapsed;
+}
+
+
+static int BenchmarkProducerCount( int producerCount, ring_buffer_size_t chunkFrames, double minimumTime,
+        void *data, ring_buffer_size_t *commits )
+{
+    static const QueueType types[2] = { MUTEX_RING_BUFFER, FRAME_QUEUE };
+    double throughput[2];
+    unsigned long framesPerProducer = (1UL << 16) / producerCount;
+    double elapsed, bestTime;
+    int t, r;
+
+    /* double the frame count until a run of the mutex implementation takes
+        long enough to time */
+    for( ;; )
+    {
+        elapsed = RunTransfer( MUTEX_RING_BUFFER, producerCount, framesPerProducer, chunkFrames, data, commits );
+        if( elapsed < 0. )
+            return 1;
+        if( elapsed >= minimumTime || framesPerProducer * producerCount >= (1UL << 30) )
+            break;
+        framesPerProducer *= 2;
+    }
+
+    for( t = 0; t < 2; ++t )
+    {
+        bestTime = -1.;
+        for( r = 0; r < REPETITION_COUNT; ++r )
+        {
+            elapsed = RunTransfer( types[t], producerCount, framesPerProducer, chunkFrames, data, commits );
+            if( elapsed < 0. )
+                return 1;
+            if( bestTime < 0. || elapsed < bestTime )
+                bestTime = elapsed;
+        }
+        throughput[t] = (framesPerProducer * producerCount / bestTime) * 1e-6;
+    }
+
+    printf( "%d,%.1f,%.1f,%.2f\n", producerCount, throughput[0], throughput[1],
+            throughput[1] / throughput[0] );
+    fflush( stdout );
+    return 0;
+}
+
+
+int main( int argc, char **argv )
+{
+    static Frame data[ELEMENT_COUNT];
+    static ring_buffer_size_t commits[ELEMENT_COUNT];
+    double minimumTime = 0.2;
+    ring_buffer_size_t chunkFrames = 64;
+    int producerCount, i;
+
+    for( i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--chunk" ) == 0 && i + 1 < argc )
+        {
+            chunkFrames = atol( argv[++i] );
+        }
+        else if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+        {
+            minimumTime = atof( argv[++i] );
+        }
+        else
+        {
+            fprintf( stderr, "usage: patest_framequeue_benchmark [--chunk frames] [--min-time seconds]\n" );
+            return EXIT_FAILURE;
+        }
+    }
+    if( chunkFrames <= 0 || chunkFrames > ELEMENT_COUNT )
+    {
+        fprintf( stderr, "the chunk size must be from 1 to %d frames\n", ELEMENT_COUNT );
+        return EXIT_FAILURE;
+    }
+
+    PaUtil_InitializeClock();
+
+    printf( "producers,mutex_mframes_per_second,framequeue_mframes_per_second,speedup\n" );
+
+    for( producerCount = 1; producerCount <= MAX_PRODUCER_COUNT; producerCount *= 2 )
+    {
+        if( BenchmarkProducerCount( producerCount, chunkFrames, minimumTime, data, commits ) != 0 )
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,459 @@
+/** @file patest_ringbuffer_benchmark.c
+    @ingroup test_src
+    @brief Measure the throughput of PaUtilRingBuffer between two threads.
+
+    A producer thread writes elements into a ring buffer while a consumer
+    thread reads them back and checks their order. The throughput of
+    PaUtilRingBuffer is compared with a copy of the previous implementation,
+    which kept both indices on one cache line and issued a memory barrier on
+    every call. The results are printed as CSV, in millions of elements per
+    second, for several transfer sizes.
+
+    On Linux and Windows the two threads are pinned to separate CPUs,
+    0 and 1 unless other CPUs are given.
+
+    Usage: patest_ringbuffer_benchmark [--cpus producer consumer] [--min-time seconds]
+
+    Link with pa_ringbuffer.c
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for pthread_setaffinity_np() */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+#include "portaudio.h"
+#include "pa_ringbuffer.h"
+#include "pa_memorybarrier.h"
+#include "pa_util.h"
+
+#define ELEMENT_COUNT           (4096)
+#define REPETITION_COUNT        (3)
+
+/* each element carries a sequence number which the consumer checks */
+typedef struct Element
+{
+    unsigned long sequence;
+    float pad;
+} Element;
+
+static const ring_buffer_size_t transferSizes_[] = { 1, 16, 64, 256, 1024 };
+
+#define TRANSFER_SIZE_COUNT     ((int)(sizeof(transferSizes_) / sizeof(transferSizes_[0])))
+
+
+/* The previous implementation of PaUtilRingBuffer: both indices share a cache
+    line and each call issues a memory barrier. */
+typedef struct LegacyRingBuffer
+{
+    ring_buffer_size_t  bufferSize;
+    volatile ring_buffer_size_t  writeIndex;
+    volatile ring_buffer_size_t  readIndex;
+    ring_buffer_size_t  bigMask;
+    ring_buffer_size_t  smallMask;
+    ring_buffer_size_t  elementSizeBytes;
+    char  *buffer;
+} LegacyRingBuffer;
+
+static void *LegacyInitialize( void *data )
+{
+    static LegacyRingBuffer rbuf;
+    rbuf.bufferSize = ELEMENT_COUNT;
+    rbuf.writeIndex = rbuf.readIndex = 0;
+    rbuf.bigMask = (ELEMENT_COUNT * 2) - 1;
+    rbuf.smallMask = ELEMENT_COUNT - 1;
+    rbuf.elementSizeBytes = sizeof(Element);
+    rbuf.buffer = (char *)data;
+    return &rbuf;
+}
+
+static ring_buffer_size_t LegacyGetRegions( LegacyRingBuffer *rbuf, ring_buffer_size_t index,
+        ring_buffer_size_t available, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    if( elementCount > available ) elementCount = available;
+    index &= rbuf->smallMask;
+    *dataPtr1 = &rbuf->buffer[index*rbuf->elementSizeBytes];
+    if( (index + elementCount) > rbuf->bufferSize )
+    {
+        *sizePtr1 = rbuf->bufferSize - index;
+        *dataPtr2 = &rbuf->buffer[0];
+        *sizePtr2 = elementCount - *sizePtr1;
+    }
+    else
+    {
+        *sizePtr1 = elementCount;
+        *dataPtr2 = NULL;
+        *sizePtr2 = 0;
+    }
+    return elementCount;
+}
+
+static ring_buffer_size_t LegacyGetWriteRegions( void *ringBuffer, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    LegacyRingBuffer *rbuf = (LegacyRingBuffer*)ringBuffer;
+    ring_buffer_size_t available = rbuf->bufferSize - ((rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask);
+    elementCount = LegacyGetRegions( rbuf, rbuf->writeIndex, available, elementCount,
+            dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    if( available )
+        PaUtil_FullMemoryBarrier();
+    return elementCount;
+}
+
+static void LegacyAdvanceWriteIndex( void *ringBuffer, ring_buffer_size_t elementCount )
+{
+    LegacyRingBuffer *rbuf = (LegacyRingBuffer*)ringBuffer;
+    PaUtil_WriteMemoryBarrier();
+    rbuf->writeIndex = (rbuf->writeIndex + elementCount) & rbuf->bigMask;
+}
+
+static ring_buffer_size_t LegacyGetReadRegions( void *ringBuffer, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    LegacyRingBuffer *rbuf = (LegacyRingBuffer*)ringBuffer;
+    ring_buffer_size_t available = (rbuf->writeIndex - rbuf->readIndex) & rbuf->bigMask;
+    elementCount = LegacyGetRegions( rbuf, rbuf->readIndex, available, elementCount,
+            dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    if( available )
+        PaUtil_ReadMemoryBarrier();
+    return elementCount;
+}
+
+static void LegacyAdvanceReadIndex( void *ringBuffer, ring_buffer_size_t elementCount )
+{
+    LegacyRingBuffer *rbuf = (LegacyRingBuffer*)ringBuffer;
+    PaUtil_FullMemoryBarrier();
+    rbuf->readIndex = (rbuf->readIndex + elementCount) & rbuf->bigMask;
+}
+
+
+static void *CurrentInitialize( void *data )
+{
+    static PaUtilRingBuffer rbuf;
+    PaUtil_InitializeRingBuffer( &rbuf, sizeof(Element), ELEMENT_COUNT, data );
+    return &rbuf;
+}
+
+static ring_buffer_size_t CurrentGetWriteRegions( void *ringBuffer, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    return PaUtil_GetRingBufferWriteRegions( (PaUtilRingBuffer*)ringBuffer, elementCount,
+            dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+}
+
+static void CurrentAdvanceWriteIndex( void *ringBuffer, ring_buffer_size_t elementCount )
+{
+    PaUtil_AdvanceRingBufferWriteIndex( (PaUtilRingBuffer*)ringBuffer, elementCount );
+}
+
+static ring_buffer_size_t CurrentGetReadRegions( void *ringBuffer, ring_buffer_size_t elementCount,
+        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    return PaUtil_GetRingBufferReadRegions( (PaUtilRingBuffer*)ringBuffer, elementCount,
+            dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+}
+
+static void CurrentAdvanceReadIndex( void *ringBuffer, ring_buffer_size_t elementCount )
+{
+    PaUtil_AdvanceRingBufferReadIndex( (PaUtilRingBuffer*)ringBuffer, elementCount );
+}
+
+
+typedef struct Implementation
+{
+    const char *name;
+    void *(*initialize)( void *data );
+    ring_buffer_size_t (*getWriteRegions)( void *ringBuffer, ring_buffer_size_t elementCount,
+            void **dataPtr1, ring_buffer_size_t *sizePtr1,
+            void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+    void (*advanceWriteIndex)( void *ringBuffer, ring_buffer_size_t elementCount );
+    ring_buffer_size_t (*getReadRegions)( void *ringBuffer, ring_buffer_size_t elementCount,
+            void **dataPtr1, ring_buffer_size_t *sizePtr1,
+            void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+    void (*advanceReadIndex)( void *ringBuffer, ring_buffer_size_t elementCount );
+} Implementation;
+
+static const Implementation implementations_[] =
+{
+    { "legacy", LegacyInitialize, LegacyGetWriteRegions, LegacyAdvanceWriteIndex,
+            LegacyGetReadRegions, LegacyAdvanceReadIndex },
+    { "current", CurrentInitialize, CurrentGetWriteRegions, CurrentAdvanceWriteIndex,
+            CurrentGetReadRegions, CurrentAdvanceReadIndex }
+};
+
+#define IMPLEMENTATION_COUNT    ((int)(sizeof(implementations_) / sizeof(implementations_[0])))
+
+
+typedef struct Transfer
+{
+    const Implementation *implementation;
+    void *ringBuffer;
+    ring_buffer_size_t transferSize;
+    unsigned long elementCount;
+    int cpu;
+    unsigned long errorCount;
+} Transfer;
+
+static void PinCurrentThread( int cpu )
+{
+#if defined(_WIN32)
+    SetThreadAffinityMask( GetCurrentThread(), ((DWORD_PTR)1) << cpu );
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO( &cpuSet );
+    CPU_SET( cpu, &cpuSet );
+    pthread_setaffinity_np( pthread_self(), sizeof(cpuSet), &cpuSet );
+#else
+    (void)cpu; /* no portable way to pin threads */
+#endif
+}
+
+static void Produce( Transfer *transfer )
+{
+    const Implementation *implementation = transfer->implementation;
+    unsigned long sequence = 0;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, i;
+
+    PinCurrentThread( transfer->cpu );
+
+    while( sequence < transfer->elementCount )
+    {
+        if( implementation->getWriteRegions( transfer->ringBuffer, transfer->transferSize,
+                &data1, &size1, &data2, &size2 ) == 0 )
+            continue;
+
+        for( i = 0; i < size1; ++i )
+            ((Element*)data1)[i].sequence = sequence++;
+        for( i = 0; i < size2; ++i )
+            ((Element*)data2)[i].sequence = sequence++;
+
+        implementation->advanceWriteIndex( transfer->ringBuffer, size1 + size2 );
+    }
+}
+
+static void Consume( Transfer *transfer )
+{
+    const Implementation *implementation = transfer->implementation;
+    unsigned long sequence = 0;
+    void *data1, *data2;
+    ring_buffer_size_t size1, size2, i;
+
+    PinCurrentThread( transfer->cpu );
+
+    while( sequence < transfer->elementCount )
+    {
+        if( implementation->getReadRegions( transfer->ringBuffer, transfer->transferSize,
+                &data1, &size1, &data2, &size2 ) == 0 )
+            continue;
+
+        for( i = 0; i < size1; ++i )
+            if( ((Element*)data1)[i].sequence != sequence++ )
+                ++transfer->errorCount;
+        for( i = 0; i < size2; ++i )
+            if( ((Element*)data2)[i].sequence != sequence++ )
+                ++transfer->errorCount;
+
+        implementation->advanceReadIndex( transfer->ringBuffer, size1 + size2 );
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI ProducerThread( LPVOID userData )
+{
+    Produce( (Transfer*)userData );
+    return 0;
+}
+#else
+static void *ProducerThread( void *userData )
+{
+    Produce( (Transfer*)userData );
+    return NULL;
+}
+#endif
+
+
+/* Transfer the given number of elements. Returns the elapsed time in seconds,
+    or a negative value on error. */
+static double RunTransfer( const Implementation *implementation, void *data,
+        ring_buffer_size_t transferSize, unsigned long elementCount,
+        int producerCpu, int consumerCpu )
+{
+    Transfer producer, consumer;
+    double startTime, elapsed;
+#if defined(_WIN32)
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+
+    producer.implementation = consumer.implementation = implementation;
+    producer.ringBuffer = consumer.ringBuffer = implementation->initialize( data );
+    producer.transferSize = consumer.transferSize = transferSize;
+    producer.elementCount = consumer.elementCount = elementCount;
+    producer.errorCount = consumer.errorCount = 0;
+    producer.cpu = producerCpu;
+    consumer.cpu = consumerCpu;
+
+    startTime = PaUtil_GetTime();
+
+#if defined(_WIN32)
+    thread = CreateThread( NULL, 0, ProducerThread, &producer, 0, NULL );
+    if( thread == NULL )
+        return -1.;
+    Consume( &consumer );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+#else
+    if( pthread_create( &thread, NULL, ProducerThread, &producer ) != 0 )
+        return -1.;
+    Consume( &consumer );
+    pthread_join( thread, NULL );
+#endif
+
+    elapsed = PaUtil_GetTime() - startTime;
+
+    if( consumer.errorCount != 0 )
+    {
+        fprintf( stderr, "%s: %lu elements out of order\n", implementation->name, consumer.errorCount );
+        return -1.;
+    }
+    return elapsed;
+}
+
+
+static int BenchmarkTransferSize( ring_buffer_size_t transferSize, double minimumTime,
+        int producerCpu, int consumerCpu, void *data )
+{
+    double throughput[IMPLEMENTATION_COUNT];
+    unsigned long elementCount = 1L << 16;
+    double elapsed, bestTime;
+    int i, r;
+
+    /* double the element count until a run of the legacy implementation takes
+        long enough to time */
+    for( ;; )
+    {
+        elapsed = RunTransfer( &implementations_[0], data, transferSize, elementCount,
+                producerCpu, consumerCpu );
+        if( elapsed < 0. )
+            return 1;
+        if( elapsed >= minimumTime || elementCount >= (1UL << 30) )
+            break;
+        elementCount *= 2;
+    }
+
+    for( i = 0; i < IMPLEMENTATION_COUNT; ++i )
+    {
+        bestTime = -1.;
+        for( r = 0; r < REPETITION_COUNT; ++r )
+        {
+            elapsed = RunTransfer( &implementations_[i], data, transferSize, elementCount,
+                    producerCpu, consumerCpu );
+            if( elapsed < 0. )
+                return 1;
+            if( bestTime < 0. || elapsed < bestTime )
+                bestTime = elapsed;
+        }
+        throughput[i] = (elementCount / bestTime) * 1e-6;
+    }
+
+    printf( "%ld,%.1f,%.1f,%.2f\n", (long)transferSize, throughput[0], throughput[1],
+            throughput[1] / throughput[0] );
+    fflush( stdout );
+    return 0;
+}
+
+
+int main( int argc, char **argv )
+{
+    static Element data[ELEMENT_COUNT];
+    double minimumTime = 0.2;
+    int producerCpu = 0, consumerCpu = 1;
+    int i;
+
+    for( i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--cpus" ) == 0 && i + 2 < argc )
+        {
+            producerCpu = atoi( argv[++i] );
+            consumerCpu = atoi( argv[++i] );
+        }
+        else if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+        {
+            minimumTime = atof( argv[++i] );
+        }
+        else
+        {
+            fprintf( stderr, "usage: patest_ringbuffer_benchmark [--cpus producer consumer] [--min-time seconds]\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    PaUtil_InitializeClock();
+
+    printf( "transfer_elements,legacy_melements_per_second,current_melements_per_second,speedup\n" );
+
+    for( i = 0; i < TRANSFER_SIZE_COUNT; ++i )
+    {
+        if( BenchmarkTransferSize( transferSizes_[i], minimumTime, producerCpu, consumerCpu, data ) != 0 )
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}